@@ -37,8 +37,10 @@ XCAM_XCORE_SRC_FILES := \
     xcore/buffer_pool.cpp \
     xcore/calibration_parser.cpp \
     xcore/file_handle.cpp \
+    xcore/geo_map_table_cache.cpp \
     xcore/image_file_handle.cpp \
     xcore/image_handler.cpp \
+    xcore/image_projector.cpp \
     xcore/surview_fisheye_dewarp.cpp \
     xcore/thread_pool.cpp \
     xcore/video_buffer.cpp \
@@ -55,14 +57,26 @@ XCAM_XCORE_SRC_FILES := \
     $(NULL)
 
 XCAM_SOFT_SRC_FILES := \
+    modules/soft/soft_3a_stats_handler.cpp \
+    modules/soft/soft_3a_stats_tasks_priv.cpp \
+    modules/soft/soft_3d_denoise_handler.cpp \
+    modules/soft/soft_3d_denoise_tasks_priv.cpp \
+    modules/soft/soft_bayer_pipe_handler.cpp \
+    modules/soft/soft_bayer_tasks_priv.cpp \
     modules/soft/soft_blender.cpp \
     modules/soft/soft_blender_tasks_priv.cpp \
     modules/soft/soft_copy_task.cpp \
+    modules/soft/soft_csc_handler.cpp \
+    modules/soft/soft_csc_tasks_priv.cpp \
     modules/soft/soft_geo_mapper.cpp \
     modules/soft/soft_geo_tasks_priv.cpp \
     modules/soft/soft_handler.cpp \
+    modules/soft/soft_image_warp_handler.cpp \
+    modules/soft/soft_image_warp_tasks_priv.cpp \
+    modules/soft/soft_seam_finder.cpp \
     modules/soft/soft_stitcher.cpp \
     modules/soft/soft_video_buf_allocator.cpp \
+    modules/soft/soft_video_stabilizer.cpp \
     modules/soft/soft_worker.cpp \
     $(NULL)
 
@@ -19,7 +19,14 @@
  */
 
 #include "context_priv.h"
+#include <calibration_parser.h>
+#include <soft/soft_video_buf_allocator.h>
+#include <soft/soft_blender.h>
+#include <soft/soft_geo_mapper.h>
+#include <soft/soft_stitcher.h>
+#if HAVE_LIBCL
 #include <ocl/cl_device.h>
+#include <ocl/cl_video_buffer.h>
 #include <ocl/cl_image_handler.h>
 #include <ocl/cl_tonemapping_handler.h>
 #include <ocl/cl_gauss_handler.h>
@@ -31,10 +38,20 @@
 #include <ocl/cl_fisheye_handler.h>
 #include <ocl/cl_image_360_stitch.h>
 #include <ocl/cl_utils.h>
+#endif
+#include <sys/eventfd.h>
+#include <unistd.h>
 
 using namespace XCam;
 
 #define DEFAULT_INPUT_BUFFER_POOL_COUNT  20
+#define DEFAULT_ASYNC_DEPTH  2
+#define DEFAULT_SOFT_POOL_SIZE  4
+
+// default soft stitcher rig, same as front/right/rear/left calibration files of tests
+#define SOFT_STITCH_CAMERA_NUM  4
+#define SOFT_STITCH_POSITION_OFFSET_X  2000.0f
+
 static const char *HandleNames[] = {
     "None",
     "3DNR",
@@ -43,6 +60,9 @@ static const char *HandleNames[] = {
     "Defog",
     "DVS",
     "Stitch",
+    "SoftStitch",
+    "SoftBlend",
+    "SoftGeoMap",
 };
 
 bool
@@ -57,16 +77,23 @@ ContextBase::ContextBase (HandleType type)
     , _image_width (0)
     , _image_height (0)
     , _alloc_out_buf (false)
+    , _async_depth (DEFAULT_ASYNC_DEPTH)
+    , _in_flight (0)
+    , _event_fd (-1)
+    , _done_cb (NULL)
+    , _done_cb_data (NULL)
 {
-    if (!_inbuf_pool.ptr()) {
-        SmartPtr<BufferPool> pool = new CLVideoBufferPool ();
-        XCAM_ASSERT (pool.ptr ());
-        _inbuf_pool = pool;
-    }
+    // semaphore mode, each read takes one done job
+    _event_fd = eventfd (0, EFD_NONBLOCK | EFD_CLOEXEC | EFD_SEMAPHORE);
+    if (_event_fd < 0)
+        XCAM_LOG_WARNING ("context (%s) create event fd failed", get_type_name ());
 }
 
 ContextBase::~ContextBase ()
 {
+    stop_async ();
+    if (_event_fd >= 0)
+        close (_event_fd);
     xcam_free (_usage);
 }
 
@@ -108,6 +135,7 @@ ContextBase::set_parameters (ContextParams &param_list)
     }
 
     buf_info.init (image_format, _image_width, _image_height);
+    XCAM_ASSERT (_inbuf_pool.ptr ());
     _inbuf_pool->set_video_info (buf_info);
     if (!_inbuf_pool->reserve (DEFAULT_INPUT_BUFFER_POOL_COUNT)) {
         XCAM_LOG_ERROR ("init buffer pool failed");
@@ -120,31 +148,242 @@ ContextBase::set_parameters (ContextParams &param_list)
     } else {
         _alloc_out_buf = false;
     }
+
+    const char *depth = find_value (param_list, "async-depth");
+    if (depth) {
+        _async_depth = atoi (depth);
+        if (_async_depth == 0) {
+            XCAM_LOG_ERROR ("illegal async depth:%s", depth);
+            return XCAM_RETURN_ERROR_PARAM;
+        }
+    }
     return XCAM_RETURN_NO_ERROR;
 }
 
 XCamReturn
-ContextBase::init_handler ()
+ContextBase::uinit_handler ()
+{
+    stop_async ();
+    return XCAM_RETURN_NO_ERROR;
+}
+
+bool
+ContextBase::check_out_buf (const SmartPtr<VideoBuffer> &buf_out) const
+{
+    if (!_alloc_out_buf) {
+        XCAM_FAIL_RETURN (
+            ERROR, buf_out.ptr (), false,
+            "context (%s) execute failed, buf_out need set.", get_type_name ());
+    } else {
+        XCAM_FAIL_RETURN (
+            ERROR, !buf_out.ptr (), false,
+            "context (%s) execute failed, buf_out need NULL.", get_type_name ());
+    }
+    return true;
+}
+
+XCamReturn
+ContextBase::run_job (const SmartPtr<ContextJob> &job)
+{
+    XCamReturn ret = execute (job->in_bufs, job->out_buf);
+    XCAM_FAIL_RETURN (
+        ERROR, ret == XCAM_RETURN_NO_ERROR || ret == XCAM_RETURN_BYPASS, ret,
+        "context (%s) failed, handler execute failed", get_type_name ());
+
+    // output is written in place, map synchronizes results into caller's memory
+    if (job->host_out && job->out_buf.ptr ()) {
+        XCAM_FAIL_RETURN (
+            ERROR, job->out_buf->map (), XCAM_RETURN_ERROR_MEM,
+            "context (%s) failed, sync host out buffer failed", get_type_name ());
+        job->out_buf->unmap ();
+    }
+
+    if (!job->ext_out && job->out_buf.ptr ()) {
+        job->ext_out = convert_to_external_buffer (job->out_buf);
+        XCAM_FAIL_RETURN (
+            ERROR, job->ext_out, XCAM_RETURN_ERROR_MEM,
+            "context (%s) failed, out buffer can't convert to external buffer", get_type_name ());
+        job->out_allocated = true;
+    }
+    return ret;
+}
+
+bool
+ContextAsyncThread::loop ()
+{
+    return _context->run_async_job ();
+}
+
+XCamReturn
+ContextBase::set_done_callback (XCamHandleDoneCallback callback, void *user_data)
+{
+    SmartLock locker (_async_mutex);
+    XCAM_FAIL_RETURN (
+        ERROR, !_async_thread.ptr (), XCAM_RETURN_ERROR_ORDER,
+        "context (%s) set done callback failed, set it before the first submit", get_type_name ());
+
+    _done_cb = callback;
+    _done_cb_data = user_data;
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+ContextBase::submit (const SmartPtr<ContextJob> &job)
+{
+    XCAM_ASSERT (job.ptr ());
+    XCAM_FAIL_RETURN (
+        ERROR, is_handler_ready (), XCAM_RETURN_ERROR_PARAM,
+        "context (%s) submit failed, handler was not initialized", get_type_name ());
+
+    {
+        SmartLock locker (_async_mutex);
+        if (!_async_thread.ptr ()) {
+            _pending_jobs.resume_pop ();
+            _async_thread = new ContextAsyncThread (this);
+            XCAM_ASSERT (_async_thread.ptr ());
+            if (!_async_thread->start ()) {
+                _async_thread.release ();
+                XCAM_LOG_ERROR ("context (%s) submit failed, start async thread failed", get_type_name ());
+                return XCAM_RETURN_ERROR_THREAD;
+            }
+        }
+
+        while (_in_flight >= _async_depth)
+            _async_cond.wait (_async_mutex);
+        ++_in_flight;
+    }
+
+    _pending_jobs.push (job);
+    return XCAM_RETURN_NO_ERROR;
+}
+
+bool
+ContextBase::run_async_job ()
+{
+    SmartPtr<ContextJob> job = _pending_jobs.pop (-1);
+    if (!job.ptr ())
+        return false;
+
+    job->error = run_job (job);
+    job->in_bufs.clear ();
+
+    {
+        SmartLock locker (_async_mutex);
+        --_in_flight;
+        _async_cond.broadcast ();
+
+        if (!_done_cb) {
+            // poll reads event fd under the same lock, the count never runs behind done jobs
+            _done_jobs.push (job);
+            notify_event_fd ();
+            return true;
+        }
+    }
+
+    // slot of this job is released, callback can submit again
+    _done_cb (HANDLE_CAST (this), job->ext_in, job->ext_out, job->error, _done_cb_data);
+    return true;
+}
+
+void
+ContextBase::notify_event_fd ()
+{
+    uint64_t count = 1;
+    if (_event_fd >= 0 && write (_event_fd, &count, sizeof (count)) != sizeof (count))
+        XCAM_LOG_WARNING ("context (%s) notify event fd failed", get_type_name ());
+}
+
+void
+ContextBase::consume_event_fd ()
+{
+    uint64_t count = 0;
+    if (_event_fd >= 0 && read (_event_fd, &count, sizeof (count)) != sizeof (count))
+        XCAM_LOG_WARNING ("context (%s) consume event fd failed", get_type_name ());
+}
+
+XCamReturn
+ContextBase::poll (SmartPtr<ContextJob> &job, int32_t timeout_ms)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, !_done_cb, XCAM_RETURN_ERROR_ORDER,
+        "context (%s) poll failed, done jobs go to callback", get_type_name ());
+
+    job = _done_jobs.pop (timeout_ms < 0 ? -1 : timeout_ms * 1000);
+    if (!job.ptr ())
+        return XCAM_RETURN_ERROR_TIMEOUT;
+
+    SmartLock locker (_async_mutex);
+    consume_event_fd ();
+    return XCAM_RETURN_NO_ERROR;
+}
+
+void
+ContextBase::stop_async ()
+{
+    if (!_async_thread.ptr ())
+        return;
+
+    {
+        SmartLock locker (_async_mutex);
+        while (_in_flight)
+            _async_cond.wait (_async_mutex);
+    }
+    _pending_jobs.pause_pop ();
+    _async_thread->stop ();
+    _async_thread.release ();
+
+    // outputs never polled are dropped
+    SmartLock locker (_async_mutex);
+    for (SmartPtr<ContextJob> job = _done_jobs.pop (0); job.ptr (); job = _done_jobs.pop (0)) {
+        if (job->out_allocated)
+            xcam_video_buffer_unref (job->ext_out);
+        consume_event_fd ();
+    }
+}
+
+SmartPtr<VideoBuffer>
+ContextBase::import_host_buffer (XCamVideoBuffer *buf)
+{
+    SmartPtr<VideoBuffer> host_buf = external_buf_to_once_map_buf (buf);
+    XCAM_FAIL_RETURN (
+        WARNING, host_buf.ptr (), NULL,
+        "context (%s) import host buffer failed", get_type_name ());
+
+    return host_buf;
+}
+
+#if HAVE_LIBCL
+CLContextBase::CLContextBase (HandleType type)
+    : ContextBase (type)
+{
+    SmartPtr<BufferPool> pool = new CLVideoBufferPool ();
+    XCAM_ASSERT (pool.ptr ());
+    _inbuf_pool = pool;
+}
+
+XCamReturn
+CLContextBase::init_handler ()
 {
     SmartPtr<CLContext> cl_context = CLDevice::instance()->get_context ();
     XCAM_FAIL_RETURN (
         ERROR, cl_context.ptr (), XCAM_RETURN_ERROR_UNKNOWN,
-        "ContextBase::init_handler(%s) failed since cl-context is NULL",
+        "CLContextBase::init_handler(%s) failed since cl-context is NULL",
         get_type_name ());
 
     SmartPtr<CLImageHandler> handler = create_handler (cl_context);
     XCAM_FAIL_RETURN (
         ERROR, handler.ptr (), XCAM_RETURN_ERROR_UNKNOWN,
-        "ContextBase::init_handler(%s) create handler failed", get_type_name ());
+        "CLContextBase::init_handler(%s) create handler failed", get_type_name ());
 
     handler->disable_buf_pool (!_alloc_out_buf);
-    set_handler (handler);
+    _handler = handler;
     return XCAM_RETURN_NO_ERROR;
 }
 
 XCamReturn
-ContextBase::uinit_handler ()
+CLContextBase::uinit_handler ()
 {
+    ContextBase::uinit_handler ();
     if (!_handler.ptr ())
         return XCAM_RETURN_NO_ERROR;
 
@@ -154,21 +393,39 @@ ContextBase::uinit_handler ()
 }
 
 XCamReturn
-ContextBase::execute (SmartPtr<VideoBuffer> &buf_in, SmartPtr<VideoBuffer> &buf_out)
+CLContextBase::execute (VideoBufferList &bufs_in, SmartPtr<VideoBuffer> &buf_out)
 {
-    if (!_alloc_out_buf) {
-        XCAM_FAIL_RETURN (
-            ERROR, buf_out.ptr (), XCAM_RETURN_ERROR_MEM,
-            "context (%s) execute failed, buf_out need set.", get_type_name ());
-    } else {
-        XCAM_FAIL_RETURN (
-            ERROR, !buf_out.ptr (), XCAM_RETURN_ERROR_MEM,
-            "context (%s) execute failed, buf_out need NULL.", get_type_name ());
-    }
+    XCAM_FAIL_RETURN (
+        ERROR, check_out_buf (buf_out), XCAM_RETURN_ERROR_MEM,
+        "context (%s) execute failed, buf_out mismatch alloc-out-buf", get_type_name ());
+    XCAM_FAIL_RETURN (
+        ERROR, bufs_in.size () == 1, XCAM_RETURN_ERROR_PARAM,
+        "context (%s) execute failed, it takes one input but got %d", get_type_name (), (int)bufs_in.size ());
 
+    SmartPtr<VideoBuffer> buf_in = bufs_in.front ();
     return _handler->execute (buf_in, buf_out);
 }
 
+SmartPtr<VideoBuffer>
+CLContextBase::import_host_buffer (XCamVideoBuffer *buf)
+{
+    SmartPtr<VideoBuffer> host_buf = ContextBase::import_host_buffer (buf);
+    if (!host_buf.ptr ())
+        return NULL;
+
+    SmartPtr<CLContext> cl_context = CLDevice::instance()->get_context ();
+    XCAM_FAIL_RETURN (
+        ERROR, cl_context.ptr (), NULL,
+        "context (%s) import host buffer failed since cl-context is NULL", get_type_name ());
+
+    SmartPtr<VideoBuffer> cl_buf = convert_host_buf_to_cl_buf (cl_context, host_buf);
+    XCAM_FAIL_RETURN (
+        WARNING, cl_buf.ptr (), NULL,
+        "context (%s) import host buffer failed, wrap to cl buffer failed", get_type_name ());
+
+    return cl_buf;
+}
+
 SmartPtr<CLImageHandler>
 NR3DContext::create_handler (SmartPtr<CLContext> &context)
 {
@@ -229,4 +486,423 @@ StitchContext::create_handler (SmartPtr<CLContext> &context)
 
     return image_360;
 }
+#endif
+
+SoftContextBase::SoftContextBase (HandleType type, uint32_t input_num)
+    : ContextBase (type)
+    , _input_num (input_num)
+    , _out_width (0)
+    , _out_height (0)
+    , _pool_size (DEFAULT_SOFT_POOL_SIZE)
+{
+    SmartPtr<BufferPool> pool = new SoftVideoBufAllocator ();
+    XCAM_ASSERT (pool.ptr ());
+    _inbuf_pool = pool;
+}
+
+SoftContextBase::~SoftContextBase ()
+{
+    uinit_handler ();
+}
+
+XCamReturn
+SoftContextBase::set_parameters (ContextParams &param_list)
+{
+    XCamReturn ret = ContextBase::set_parameters (param_list);
+    if (!xcam_ret_is_ok (ret))
+        return ret;
+
+    _out_width = _image_width;
+    _out_height = _image_height;
+    const char *width = find_value (param_list, "out-width");
+    if (width)
+        _out_width = atoi (width);
+    const char *height = find_value (param_list, "out-height");
+    if (height)
+        _out_height = atoi (height);
+    XCAM_FAIL_RETURN (
+        ERROR, _out_width && _out_height, XCAM_RETURN_ERROR_PARAM,
+        "context (%s) illegal output size width:%d height:%d", get_type_name (), _out_width, _out_height);
+
+    const char *pool_size = find_value (param_list, "pool-size");
+    if (pool_size) {
+        _pool_size = atoi (pool_size);
+        XCAM_FAIL_RETURN (
+            ERROR, _pool_size, XCAM_RETURN_ERROR_PARAM,
+            "context (%s) illegal pool size:%s", get_type_name (), pool_size);
+    }
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+SoftContextBase::init_handler ()
+{
+    SmartPtr<ImageHandler> handler = create_handler ();
+    XCAM_FAIL_RETURN (
+        ERROR, handler.ptr (), XCAM_RETURN_ERROR_UNKNOWN,
+        "SoftContextBase::init_handler(%s) create handler failed", get_type_name ());
+
+    // outputs are taken from handler allocator only if caller doesn't set them
+    if (_alloc_out_buf) {
+        VideoBufferInfo out_info;
+        out_info.init (V4L2_PIX_FMT_NV12, _out_width, _out_height);
+        handler->set_out_video_info (out_info);
+        handler->enable_allocator (true, _pool_size);
+    } else {
+        handler->enable_allocator (false);
+    }
+
+    _handler = handler;
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+SoftContextBase::uinit_handler ()
+{
+    ContextBase::uinit_handler ();
+    if (!_handler.ptr ())
+        return XCAM_RETURN_NO_ERROR;
+
+    _handler->terminate ();
+    _handler.release ();
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+SoftContextBase::execute (VideoBufferList &bufs_in, SmartPtr<VideoBuffer> &buf_out)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, check_out_buf (buf_out), XCAM_RETURN_ERROR_MEM,
+        "context (%s) execute failed, buf_out mismatch alloc-out-buf", get_type_name ());
+    XCAM_FAIL_RETURN (
+        ERROR, bufs_in.size () == _input_num, XCAM_RETURN_ERROR_PARAM,
+        "context (%s) execute failed, it takes %d inputs but got %d",
+        get_type_name (), _input_num, (int)bufs_in.size ());
+
+    return execute_handler (bufs_in, buf_out);
+}
+
+XCamReturn
+SoftContextBase::execute_handler (VideoBufferList &bufs_in, SmartPtr<VideoBuffer> &buf_out)
+{
+    SmartPtr<ImageHandler::Parameters> param;
+    if (_input_num == 2) {
+        param = new SoftBlender::BlenderParam (bufs_in.front (), bufs_in.back (), buf_out);
+    } else {
+        param = new ImageHandler::Parameters (bufs_in.front (), buf_out);
+    }
+    XCAM_ASSERT (param.ptr ());
 
+    XCamReturn ret = _handler->execute_buffer (param, true);
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "context (%s) execute failed, handler execute buffer failed", get_type_name ());
+
+    buf_out = param->out_buf;
+    return ret;
+}
+
+SoftStitchContext::~SoftStitchContext ()
+{
+    xcam_free (_calib_path);
+}
+
+XCamReturn
+SoftStitchContext::set_parameters (ContextParams &param_list)
+{
+    XCamReturn ret = SoftContextBase::set_parameters (param_list);
+    if (!xcam_ret_is_ok (ret))
+        return ret;
+
+    // default output is a 2:1 panorama of input width
+    if (!find_value (param_list, "out-width") && !find_value (param_list, "out-height")) {
+        _out_width = _image_width;
+        _out_height = XCAM_ALIGN_UP (_image_width / 2, 16);
+    }
+
+    const char *camera_num = find_value (param_list, "camera-num");
+    _input_num = camera_num ? atoi (camera_num) : SOFT_STITCH_CAMERA_NUM;
+    XCAM_FAIL_RETURN (
+        ERROR, _input_num >= 2 && _input_num <= XCAM_STITCH_MAX_CAMERAS, XCAM_RETURN_ERROR_PARAM,
+        "context (%s) illegal camera num:%d, should be in [2, %d]",
+        get_type_name (), _input_num, XCAM_STITCH_MAX_CAMERAS);
+
+    const char *path = find_value (param_list, "calib-path");
+    XCAM_FAIL_RETURN (
+        ERROR, path, XCAM_RETURN_ERROR_PARAM,
+        "context (%s) needs calib-path of calibration files", get_type_name ());
+    xcam_free (_calib_path);
+    _calib_path = strndup (path, XCAM_MAX_STR_SIZE);
+
+    const char *engine = find_value (param_list, "engine");
+    if (engine && !strcasecmp (engine, "tiles"))
+        _engine = StitchEngineFusedTiles;
+    else
+        _engine = StitchEngineStaged;
+
+    const char *seam = find_value (param_list, "seam");
+    _need_seam = (seam && !strcasecmp (seam, "true"));
+
+    const char *scale_mode = find_value (param_list, "scale-mode");
+    if (scale_mode && !strcasecmp (scale_mode, "dualconst"))
+        _scale_mode = ScaleDualConst;
+    else if (scale_mode && !strcasecmp (scale_mode, "dualcurve"))
+        _scale_mode = ScaleDualCurve;
+    else
+        _scale_mode = ScaleSingleConst;
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+// calibration files are intrinsic_camera_<idx>.txt and extrinsic_camera_<idx>.txt,
+// 4 camera rigs also take front/right/rear/left names
+static bool
+parse_stitch_camera_info (const char *path, uint32_t idx, uint32_t camera_num, CameraInfo &info)
+{
+    static const char *intrinsic_names[] = {
+        "intrinsic_camera_front.txt", "intrinsic_camera_right.txt",
+        "intrinsic_camera_rear.txt", "intrinsic_camera_left.txt"
+    };
+    static const char *extrinsic_names[] = {
+        "extrinsic_camera_front.txt", "extrinsic_camera_right.txt",
+        "extrinsic_camera_rear.txt", "extrinsic_camera_left.txt"
+    };
+    static const float viewpoints_range[] = {64.0f, 160.0f, 64.0f, 160.0f};
+
+    char intrinsic_path[XCAM_MAX_STR_SIZE] = {'\0'};
+    char extrinsic_path[XCAM_MAX_STR_SIZE] = {'\0'};
+    snprintf (intrinsic_path, XCAM_MAX_STR_SIZE, "%s/intrinsic_camera_%d.txt", path, idx);
+    snprintf (extrinsic_path, XCAM_MAX_STR_SIZE, "%s/extrinsic_camera_%d.txt", path, idx);
+    if (camera_num == SOFT_STITCH_CAMERA_NUM && access (intrinsic_path, F_OK) != 0) {
+        snprintf (intrinsic_path, XCAM_MAX_STR_SIZE, "%s/%s", path, intrinsic_names[idx]);
+        snprintf (extrinsic_path, XCAM_MAX_STR_SIZE, "%s/%s", path, extrinsic_names[idx]);
+    }
+
+    CalibrationParser parser;
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (parser.parse_intrinsic_file (intrinsic_path, info.calibration.intrinsic)), false,
+        "parse intrinsic params (%s) failed", intrinsic_path);
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (parser.parse_extrinsic_file (extrinsic_path, info.calibration.extrinsic)), false,
+        "parse extrinsic params (%s) failed", extrinsic_path);
+    info.calibration.extrinsic.trans_x += SOFT_STITCH_POSITION_OFFSET_X;
+
+    // cameras of other rigs overlap half of their share with neighbors
+    if (camera_num == SOFT_STITCH_CAMERA_NUM)
+        info.angle_range = viewpoints_range[idx];
+    else
+        info.angle_range = 360.0f / camera_num * 1.5f;
+    info.round_angle_start = (idx * 360.0f / camera_num) - info.angle_range / 2.0f;
+    return true;
+}
+
+SmartPtr<ImageHandler>
+SoftStitchContext::create_handler ()
+{
+    SmartPtr<Stitcher> stitcher = Stitcher::create_soft_stitcher (_engine);
+    XCAM_FAIL_RETURN (ERROR, stitcher.ptr (), NULL, "create soft stitcher failed");
+
+    std::vector<CameraInfo> cam_info (_input_num);
+    for (uint32_t i = 0; i < _input_num; ++i) {
+        XCAM_FAIL_RETURN (
+            ERROR, parse_stitch_camera_info (_calib_path, i, _input_num, cam_info[i]), NULL,
+            "context (%s) parse camera(idx:%d) info failed", get_type_name (), i);
+    }
+
+    PointFloat3 bowl_coord_offset;
+    if (_input_num == SOFT_STITCH_CAMERA_NUM) {
+        centralize_bowl_coord_from_cameras (
+            cam_info[0].calibration.extrinsic, cam_info[1].calibration.extrinsic,
+            cam_info[2].calibration.extrinsic, cam_info[3].calibration.extrinsic,
+            bowl_coord_offset);
+    } else {
+        // bowl center is the center of all cameras
+        for (uint32_t i = 0; i < _input_num; ++i) {
+            bowl_coord_offset.x += cam_info[i].calibration.extrinsic.trans_x / _input_num;
+            bowl_coord_offset.y += cam_info[i].calibration.extrinsic.trans_y / _input_num;
+        }
+        for (uint32_t i = 0; i < _input_num; ++i) {
+            cam_info[i].calibration.extrinsic.trans_x -= bowl_coord_offset.x;
+            cam_info[i].calibration.extrinsic.trans_y -= bowl_coord_offset.y;
+        }
+    }
+
+    stitcher->set_camera_num (_input_num);
+    for (uint32_t i = 0; i < _input_num; ++i) {
+        stitcher->set_camera_info (i, cam_info[i]);
+    }
+
+    BowlDataConfig bowl;
+    bowl.wall_height = 3000.0f;
+    bowl.ground_length = 2000.0f;
+    bowl.angle_start = 0.0f;
+    bowl.angle_end = 360.0f;
+    stitcher->set_bowl_config (bowl);
+    stitcher->set_output_size (_out_width, _out_height);
+    stitcher->set_scale_mode (_scale_mode);
+    stitcher->set_need_seam (_need_seam);
+    XCAM_LOG_INFO ("soft stitch output size width:%d height:%d", _out_width, _out_height);
+
+    return stitcher.dynamic_cast_ptr<ImageHandler> ();
+}
+
+XCamReturn
+SoftStitchContext::execute_handler (VideoBufferList &bufs_in, SmartPtr<VideoBuffer> &buf_out)
+{
+    SmartPtr<Stitcher> stitcher = _handler.dynamic_cast_ptr<Stitcher> ();
+    XCAM_ASSERT (stitcher.ptr ());
+
+    XCamReturn ret = stitcher->stitch_buffers (bufs_in, buf_out);
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "context (%s) execute failed, stitch buffers failed", get_type_name ());
+    return ret;
+}
+
+XCamReturn
+SoftBlendContext::set_parameters (ContextParams &param_list)
+{
+    XCamReturn ret = SoftContextBase::set_parameters (param_list);
+    if (!xcam_ret_is_ok (ret))
+        return ret;
+
+    // two inputs side by side, overlapped in merge-width columns
+    _merge_width = _image_width / 4;
+    const char *merge_width = find_value (param_list, "merge-width");
+    if (merge_width)
+        _merge_width = atoi (merge_width);
+    XCAM_FAIL_RETURN (
+        ERROR, _merge_width && _merge_width < _image_width, XCAM_RETURN_ERROR_PARAM,
+        "context (%s) illegal merge width:%d", get_type_name (), _merge_width);
+
+    if (!find_value (param_list, "out-width"))
+        _out_width = _image_width * 2 - _merge_width;
+    if (!find_value (param_list, "out-height"))
+        _out_height = _image_height;
+    XCAM_FAIL_RETURN (
+        ERROR, _out_width >= _image_width * 2 - _merge_width, XCAM_RETURN_ERROR_PARAM,
+        "context (%s) out width:%d can't hold both inputs", get_type_name (), _out_width);
+    return XCAM_RETURN_NO_ERROR;
+}
+
+SmartPtr<ImageHandler>
+SoftBlendContext::create_handler ()
+{
+    SmartPtr<Blender> blender = Blender::create_soft_blender ();
+    XCAM_FAIL_RETURN (ERROR, blender.ptr (), NULL, "create soft blender failed");
+
+    uint32_t left_start = _image_width - _merge_width;
+    uint32_t out_start = (_out_width - (_image_width * 2 - _merge_width)) / 2 + left_start;
+    blender->set_output_size (_out_width, _out_height);
+    blender->set_merge_window (Rect (out_start, 0, _merge_width, _image_height));
+    blender->set_input_valid_area (Rect (0, 0, _image_width, _image_height), 0);
+    blender->set_input_valid_area (Rect (0, 0, _image_width, _image_height), 1);
+    blender->set_input_merge_area (Rect (left_start, 0, _merge_width, _image_height), 0);
+    blender->set_input_merge_area (Rect (0, 0, _merge_width, _image_height), 1);
+
+    return blender.dynamic_cast_ptr<ImageHandler> ();
+}
+
+// copies width columns of all planes, x positions are in pixels of luma
+static bool
+copy_columns (
+    const SmartPtr<VideoBuffer> &in, uint32_t in_x,
+    const SmartPtr<VideoBuffer> &out, uint32_t out_x, uint32_t width)
+{
+    const VideoBufferInfo &in_info = in->get_video_info ();
+    const VideoBufferInfo &out_info = out->get_video_info ();
+    uint8_t *in_ptr = in->map ();
+    uint8_t *out_ptr = out->map ();
+    bool ret = (in_ptr && out_ptr);
+
+    for (uint32_t i = 0; ret && i < in_info.components; ++i) {
+        VideoBufferPlanarInfo in_planar, out_planar;
+        in_info.get_planar_info (in_planar, i);
+        out_info.get_planar_info (out_planar, i);
+
+        uint32_t scale = in_info.width / in_planar.width;
+        uint32_t bytes = width / scale * in_planar.pixel_bytes;
+        uint8_t *src = in_ptr + in_info.offsets[i] + in_x / scale * in_planar.pixel_bytes;
+        uint8_t *dest = out_ptr + out_info.offsets[i] + out_x / scale * out_planar.pixel_bytes;
+        uint32_t rows = XCAM_MIN (in_planar.height, out_planar.height);
+        for (uint32_t y = 0; y < rows; ++y) {
+            memcpy (dest + y * out_info.strides[i], src + y * in_info.strides[i], bytes);
+        }
+    }
+
+    if (in_ptr)
+        in->unmap ();
+    if (out_ptr)
+        out->unmap ();
+    return ret;
+}
+
+XCamReturn
+SoftBlendContext::execute_handler (VideoBufferList &bufs_in, SmartPtr<VideoBuffer> &buf_out)
+{
+    XCamReturn ret = SoftContextBase::execute_handler (bufs_in, buf_out);
+    if (!xcam_ret_is_ok (ret))
+        return ret;
+
+    // blender only writes merge window, the rest of both inputs is copied beside it
+    uint32_t left_start = (_out_width - (_image_width * 2 - _merge_width)) / 2;
+    uint32_t copy_width = _image_width - _merge_width;
+    XCAM_FAIL_RETURN (
+        ERROR,
+        copy_columns (bufs_in.front (), 0, buf_out, left_start, copy_width) &&
+        copy_columns (bufs_in.back (), _merge_width, buf_out, left_start + _image_width, copy_width),
+        XCAM_RETURN_ERROR_MEM,
+        "context (%s) execute failed, copy inputs out of merge window failed", get_type_name ());
+    return ret;
+}
+
+XCamReturn
+SoftGeoMapContext::set_parameters (ContextParams &param_list)
+{
+    XCamReturn ret = SoftContextBase::set_parameters (param_list);
+    if (!xcam_ret_is_ok (ret))
+        return ret;
+
+    const char *table_width = find_value (param_list, "table-width");
+    const char *table_height = find_value (param_list, "table-height");
+    const char *table_file = find_value (param_list, "table-file");
+    XCAM_FAIL_RETURN (
+        ERROR, table_width && table_height && table_file, XCAM_RETURN_ERROR_PARAM,
+        "context (%s) needs table-file, table-width and table-height", get_type_name ());
+
+    _table_width = atoi (table_width);
+    _table_height = atoi (table_height);
+    XCAM_FAIL_RETURN (
+        ERROR, _table_width && _table_height, XCAM_RETURN_ERROR_PARAM,
+        "context (%s) illegal table size width:%d height:%d", get_type_name (), _table_width, _table_height);
+
+    // table file is PointFloat2 of input coordinates in rows
+    FILE *fp = fopen (table_file, "rb");
+    XCAM_FAIL_RETURN (
+        ERROR, fp, XCAM_RETURN_ERROR_FILE,
+        "context (%s) open table file(%s) failed", get_type_name (), table_file);
+
+    _table.resize (_table_width * _table_height);
+    size_t count = fread (_table.data (), sizeof (PointFloat2), _table.size (), fp);
+    fclose (fp);
+    XCAM_FAIL_RETURN (
+        ERROR, count == _table.size (), XCAM_RETURN_ERROR_FILE,
+        "context (%s) table file(%s) is shorter than %dx%d", get_type_name (), table_file,
+        _table_width, _table_height);
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+SmartPtr<ImageHandler>
+SoftGeoMapContext::create_handler ()
+{
+    SmartPtr<GeoMapper> mapper = GeoMapper::create_soft_geo_mapper ();
+    XCAM_FAIL_RETURN (ERROR, mapper.ptr (), NULL, "create soft geo mapper failed");
+
+    mapper->set_output_size (_out_width, _out_height);
+    XCAM_FAIL_RETURN (
+        ERROR, mapper->set_lookup_table (_table.data (), _table_width, _table_height), NULL,
+        "context (%s) set lookup table failed", get_type_name ());
+
+    return mapper.dynamic_cast_ptr<ImageHandler> ();
+}
@@ -22,11 +22,18 @@
 #define XCAM_CONTEXT_PRIV_H
 
 #include <xcam_utils.h>
+#include <xcam_thread.h>
+#include <safe_list.h>
+#include <xcam_handle.h>
 #include <string.h>
+#include <map>
+#include <image_handler.h>
+#include <interface/stitcher.h>
+#if HAVE_LIBCL
 #include <ocl/cl_image_handler.h>
 #include <ocl/cl_context.h>
 #include <ocl/cl_blender.h>
-#include <interface/stitcher.h>
+#endif
 
 using namespace XCam;
 
@@ -38,6 +45,9 @@ enum HandleType {
     HandleTypeDefog,
     HandleTypeDVS,
     HandleTypeStitch,
+    HandleTypeSoftStitch,
+    HandleTypeSoftBlend,
+    HandleTypeSoftGeoMap,
 };
 
 #define CONTEXT_CAST(Type, handle) (Type*)(handle)
@@ -54,7 +64,50 @@ typedef struct _CompareStr {
 
 typedef std::map<const char*, const char*, CompareStr> ContextParams;
 
+struct ContextJob {
+    // first input is returned by poll
+    XCamVideoBuffer          *ext_in;
+    // NULL if output is allocated inside, set to the allocated one after run
+    XCamVideoBuffer          *ext_out;
+    // inputs of one frame, only stitcher and blender take more than one
+    VideoBufferList           in_bufs;
+    SmartPtr<VideoBuffer>     out_buf;
+    // out_buf wraps caller's host memory, synchronized after run
+    bool                      host_out;
+    // ext_out was allocated inside, caller unrefs it
+    bool                      out_allocated;
+    XCamReturn                error;
+
+    ContextJob ()
+        : ext_in (NULL)
+        , ext_out (NULL)
+        , host_out (false)
+        , out_allocated (false)
+        , error (XCAM_RETURN_NO_ERROR)
+    {}
+};
+
+class ContextBase;
+
+class ContextAsyncThread
+    : public Thread
+{
+public:
+    ContextAsyncThread (ContextBase *context)
+        : Thread ("ContextAsyncThread")
+        , _context (context)
+    {}
+
+protected:
+    virtual bool loop ();
+
+private:
+    ContextBase     *_context;
+};
+
 class ContextBase {
+    friend class ContextAsyncThread;
+
 public:
     virtual ~ContextBase ();
 
@@ -62,14 +115,27 @@ public:
     virtual const char* get_usage () const {
         return _usage;
     }
-    XCamReturn init_handler ();
-    XCamReturn uinit_handler ();
+    virtual XCamReturn init_handler () = 0;
+    virtual XCamReturn uinit_handler ();
+    virtual bool is_handler_ready () const = 0;
+
+    virtual XCamReturn execute (VideoBufferList &bufs_in, SmartPtr<VideoBuffer> &buf_out) = 0;
 
-    XCamReturn execute (SmartPtr<VideoBuffer> &buf_in, SmartPtr<VideoBuffer> &buf_out);
+    // wraps caller's host memory without copy, buf is referenced until the returned buffer is released
+    virtual SmartPtr<VideoBuffer> import_host_buffer (XCamVideoBuffer *buf);
 
-    SmartPtr<CLImageHandler> get_handler() const {
-        return  _handler;
+    // executes job and converts its output for caller
+    XCamReturn run_job (const SmartPtr<ContextJob> &job);
+
+    // jobs run in a worker thread in submission order, submit waits if async depth jobs are in flight,
+    // done jobs go to the callback if set, else they are queued for poll and counted on event fd
+    XCamReturn set_done_callback (XCamHandleDoneCallback callback, void *user_data);
+    XCamReturn submit (const SmartPtr<ContextJob> &job);
+    XCamReturn poll (SmartPtr<ContextJob> &job, int32_t timeout_ms);
+    int get_event_fd () const {
+        return _event_fd;
     }
+
     SmartPtr<BufferPool> get_input_buffer_pool() const {
         return  _inbuf_pool;
     }
@@ -80,88 +146,122 @@ public:
 
 protected:
     ContextBase (HandleType type);
-    void set_handler (const SmartPtr<CLImageHandler> &ptr) {
-        _handler = ptr;
-    }
-
-    virtual SmartPtr<CLImageHandler> create_handler (SmartPtr<CLContext> &context) = 0;
+    bool check_out_buf (const SmartPtr<VideoBuffer> &buf_out) const;
 
 private:
+    bool run_async_job ();
+    void stop_async ();
+    void notify_event_fd ();
+    void consume_event_fd ();
+
     XCAM_DEAD_COPY (ContextBase);
 
 protected:
     HandleType                       _type;
     char                            *_usage;
-    SmartPtr<CLImageHandler>         _handler;
     SmartPtr<BufferPool>             _inbuf_pool;
 
     //parameters
     uint32_t                         _image_width;
     uint32_t                         _image_height;
     bool                             _alloc_out_buf;
+    uint32_t                         _async_depth;
+
+    //asynchronous execution
+    SmartPtr<ContextAsyncThread>     _async_thread;
+    SafeList<ContextJob>             _pending_jobs;
+    SafeList<ContextJob>             _done_jobs;
+    Mutex                            _async_mutex;
+    Cond                             _async_cond;
+    uint32_t                         _in_flight;
+    int                              _event_fd;
+    XCamHandleDoneCallback           _done_cb;
+    void                            *_done_cb_data;
 };
 
-class NR3DContext
+#if HAVE_LIBCL
+class CLContextBase
     : public ContextBase
 {
+public:
+    virtual XCamReturn init_handler ();
+    virtual XCamReturn uinit_handler ();
+    virtual bool is_handler_ready () const {
+        return _handler.ptr ();
+    }
+    virtual XCamReturn execute (VideoBufferList &bufs_in, SmartPtr<VideoBuffer> &buf_out);
+    virtual SmartPtr<VideoBuffer> import_host_buffer (XCamVideoBuffer *buf);
+
+protected:
+    CLContextBase (HandleType type);
+
+    virtual SmartPtr<CLImageHandler> create_handler (SmartPtr<CLContext> &context) = 0;
+
+protected:
+    SmartPtr<CLImageHandler>         _handler;
+};
+
+class NR3DContext
+    : public CLContextBase
+{
 public:
     NR3DContext ()
-        : ContextBase (HandleType3DNR)
+        : CLContextBase (HandleType3DNR)
     {}
 
     virtual SmartPtr<CLImageHandler> create_handler (SmartPtr<CLContext> &context);
 };
 
 class NRWaveletContext
-    : public ContextBase
+    : public CLContextBase
 {
 public:
     NRWaveletContext ()
-        : ContextBase (HandleTypeWaveletNR)
+        : CLContextBase (HandleTypeWaveletNR)
     {}
 
     virtual SmartPtr<CLImageHandler> create_handler (SmartPtr<CLContext> &context);
 };
 
 class FisheyeContext
-    : public ContextBase
+    : public CLContextBase
 {
 public:
     FisheyeContext ()
-        : ContextBase (HandleTypeFisheye)
+        : CLContextBase (HandleTypeFisheye)
     {}
 
     virtual SmartPtr<CLImageHandler> create_handler (SmartPtr<CLContext> &context);
 };
 
 class DefogContext
-    : public ContextBase
+    : public CLContextBase
 {
 public:
     DefogContext ()
-        : ContextBase (HandleTypeDefog)
+        : CLContextBase (HandleTypeDefog)
     {}
 
     virtual SmartPtr<CLImageHandler> create_handler (SmartPtr<CLContext> &context);
 };
 
 class DVSContext
-    : public ContextBase
+    : public CLContextBase
 {
 public:
     DVSContext ()
-        : ContextBase (HandleTypeDVS)
+        : CLContextBase (HandleTypeDVS)
     {}
 
     virtual SmartPtr<CLImageHandler> create_handler (SmartPtr<CLContext> &context);
 };
 
 class StitchContext
-    : public ContextBase
+    : public CLContextBase
 {
 public:
     StitchContext ()
-        : ContextBase (HandleTypeStitch)
+        : CLContextBase (HandleTypeStitch)
         , _need_seam (false)
         , _fisheye_map (false)
         , _need_lsc (false)
@@ -181,4 +281,102 @@ private:
     StitchResMode         _res_mode;
 };
 
+#endif
+
+class SoftContextBase
+    : public ContextBase
+{
+public:
+    virtual ~SoftContextBase ();
+
+    virtual XCamReturn set_parameters (ContextParams &param_list);
+    virtual XCamReturn init_handler ();
+    virtual XCamReturn uinit_handler ();
+    virtual bool is_handler_ready () const {
+        return _handler.ptr ();
+    }
+    virtual XCamReturn execute (VideoBufferList &bufs_in, SmartPtr<VideoBuffer> &buf_out);
+
+protected:
+    SoftContextBase (HandleType type, uint32_t input_num);
+
+    virtual SmartPtr<ImageHandler> create_handler () = 0;
+    virtual XCamReturn execute_handler (VideoBufferList &bufs_in, SmartPtr<VideoBuffer> &buf_out);
+
+protected:
+    SmartPtr<ImageHandler>           _handler;
+    uint32_t                         _input_num;
+
+    //parameters
+    uint32_t                         _out_width;
+    uint32_t                         _out_height;
+    uint32_t                         _pool_size;
+};
+
+class SoftStitchContext
+    : public SoftContextBase
+{
+public:
+    SoftStitchContext ()
+        : SoftContextBase (HandleTypeSoftStitch, 4)
+        , _calib_path (NULL)
+        , _engine (StitchEngineStaged)
+        , _need_seam (false)
+        , _scale_mode (ScaleSingleConst)
+    {}
+    virtual ~SoftStitchContext ();
+
+    virtual XCamReturn set_parameters (ContextParams &param_list);
+
+protected:
+    virtual SmartPtr<ImageHandler> create_handler ();
+    virtual XCamReturn execute_handler (VideoBufferList &bufs_in, SmartPtr<VideoBuffer> &buf_out);
+
+private:
+    char                 *_calib_path;
+    StitchEngine          _engine;
+    bool                  _need_seam;
+    GeoMapScaleMode       _scale_mode;
+};
+
+class SoftBlendContext
+    : public SoftContextBase
+{
+public:
+    SoftBlendContext ()
+        : SoftContextBase (HandleTypeSoftBlend, 2)
+        , _merge_width (0)
+    {}
+
+    virtual XCamReturn set_parameters (ContextParams &param_list);
+
+protected:
+    virtual SmartPtr<ImageHandler> create_handler ();
+    virtual XCamReturn execute_handler (VideoBufferList &bufs_in, SmartPtr<VideoBuffer> &buf_out);
+
+private:
+    uint32_t              _merge_width;
+};
+
+class SoftGeoMapContext
+    : public SoftContextBase
+{
+public:
+    SoftGeoMapContext ()
+        : SoftContextBase (HandleTypeSoftGeoMap, 1)
+        , _table_width (0)
+        , _table_height (0)
+    {}
+
+    virtual XCamReturn set_parameters (ContextParams &param_list);
+
+protected:
+    virtual SmartPtr<ImageHandler> create_handler ();
+
+private:
+    std::vector<PointFloat2>  _table;
+    uint32_t                  _table_width;
+    uint32_t                  _table_height;
+};
+
 #endif //XCAM_CONTEXT_PRIV_H
@@ -34,7 +34,14 @@ xcam_create_handle (const char *name)
 {
     ContextBase *context = NULL;
 
-    if (handle_name_equal (name, HandleType3DNR)) {
+    if (handle_name_equal (name, HandleTypeSoftStitch)) {
+        context = new SoftStitchContext;
+    } else if (handle_name_equal (name, HandleTypeSoftBlend)) {
+        context = new SoftBlendContext;
+    } else if (handle_name_equal (name, HandleTypeSoftGeoMap)) {
+        context = new SoftGeoMapContext;
+#if HAVE_LIBCL
+    } else if (handle_name_equal (name, HandleType3DNR)) {
         context = new NR3DContext;
     } else if (handle_name_equal (name, HandleTypeWaveletNR)) {
         context = new NRWaveletContext;
@@ -46,6 +53,7 @@ xcam_create_handle (const char *name)
         context = new DVSContext;
     } else if (handle_name_equal (name, HandleTypeStitch)) {
         context = new StitchContext;
+#endif
     } else {
         XCAM_LOG_ERROR ("create handle failed with unsupported type:%s", name);
         return NULL;
@@ -65,7 +73,6 @@ XCamReturn
 xcam_handle_init (XCamHandle *handle)
 {
     ContextBase *context = CONTEXT_BASE_CAST (handle);
-    SmartPtr<CLImageHandler> handler_ptr;
     XCamReturn ret = XCAM_RETURN_NO_ERROR;
 
     XCAM_FAIL_RETURN (
@@ -220,52 +227,166 @@ copy_external_buf_to_drm_buf (XCamHandle *handle, XCamVideoBuffer *buf)
     return video_buf;
 }
 
-XCamReturn
-xcam_handle_execute (XCamHandle *handle, XCamVideoBuffer *buf_in, XCamVideoBuffer **buf_out)
+static SmartPtr<VideoBuffer>
+import_input_buf (XCamHandle *handle, XCamVideoBuffer *buf_in)
 {
     ContextBase *context = CONTEXT_BASE_CAST (handle);
-    SmartPtr<VideoBuffer> input, output;
+    SmartPtr<VideoBuffer> in_buf;
 
-    XCAM_FAIL_RETURN (
-        ERROR, context && buf_in && buf_out, XCAM_RETURN_ERROR_PARAM,
-        "xcam_handle_execute failed, either of handle/buf_in/buf_out can NOT be NULL");
+    if (buf_in->mem_type == XCAM_MEM_TYPE_GPU) {
+        in_buf = external_buf_to_drm_buf (buf_in);
+    } else if (buf_in->mem_type == XCAM_MEM_TYPE_CPU) {
+        // host memory is shared with handler, copy only if it can't be wrapped
+        in_buf = context->import_host_buffer (buf_in);
+        if (!in_buf.ptr ())
+            in_buf = copy_external_buf_to_drm_buf (handle, buf_in);
+    } else {
+        in_buf = copy_external_buf_to_drm_buf (handle, buf_in);
+    }
+    return in_buf;
+}
 
+static XCamReturn
+create_job (
+    XCamHandle *handle, XCamVideoBuffer **bufs_in, uint32_t count, XCamVideoBuffer *buf_out,
+    SmartPtr<ContextJob> &job)
+{
+    ContextBase *context = CONTEXT_BASE_CAST (handle);
     XCAM_FAIL_RETURN (
-        ERROR, context->get_handler().ptr (), XCAM_RETURN_ERROR_PARAM,
+        ERROR, context->is_handler_ready (), XCAM_RETURN_ERROR_PARAM,
         "context (%s) failed, handler was not initialized", context->get_type_name ());
 
-    if (buf_in->mem_type == XCAM_MEM_TYPE_GPU) {
-        input = external_buf_to_drm_buf (buf_in);
-    } else {
-        input = copy_external_buf_to_drm_buf (handle, buf_in);
+    job = new ContextJob;
+    XCAM_ASSERT (job.ptr ());
+    job->ext_in = bufs_in[0];
+    job->ext_out = buf_out;
+
+    for (uint32_t i = 0; i < count; ++i) {
+        XCAM_FAIL_RETURN (
+            ERROR, bufs_in[i], XCAM_RETURN_ERROR_PARAM,
+            "xcam_handle(%s) execute failed, buf_in(idx:%d) is NULL", context->get_type_name (), i);
+
+        SmartPtr<VideoBuffer> in_buf = import_input_buf (handle, bufs_in[i]);
+        XCAM_FAIL_RETURN (
+            ERROR, in_buf.ptr (), XCAM_RETURN_ERROR_MEM,
+            "xcam_handle(%s) execute failed, buf_in(idx:%d) convert to DRM buffer failed.",
+            context->get_type_name (), i);
+        job->in_bufs.push_back (in_buf);
     }
-    XCAM_FAIL_RETURN (
-        ERROR, input.ptr (), XCAM_RETURN_ERROR_MEM,
-        "xcam_handle(%s) execute failed, buf_in convert to DRM buffer failed.",
-        context->get_type_name ());
 
-    if (*buf_out) {
-        output = external_buf_to_drm_buf (*buf_out);
+    if (buf_out) {
+        job->host_out = (buf_out->mem_type == XCAM_MEM_TYPE_CPU);
+        if (job->host_out)
+            job->out_buf = context->import_host_buffer (buf_out);
+        else
+            job->out_buf = external_buf_to_drm_buf (buf_out);
         XCAM_FAIL_RETURN (
-            ERROR, output.ptr (), XCAM_RETURN_ERROR_MEM,
-            "xcam_handle(%s) execute failed, buf_out set but convert to DRM buffer failed.",
-            context->get_type_name ());
+            ERROR, job->out_buf.ptr (), XCAM_RETURN_ERROR_MEM,
+            "xcam_handle(%s) execute failed, buf_out set but convert to %s buffer failed.",
+            context->get_type_name (), job->host_out ? "host" : "DRM");
     }
 
-    XCamReturn ret = context->execute (input, output);
+    return XCAM_RETURN_NO_ERROR;
+}
 
+XCamReturn
+xcam_handle_execute (XCamHandle *handle, XCamVideoBuffer *buf_in, XCamVideoBuffer **buf_out)
+{
     XCAM_FAIL_RETURN (
-        ERROR, ret == XCAM_RETURN_NO_ERROR || ret == XCAM_RETURN_BYPASS,
-        ret,
-        "context (%s) failed, handler execute failed", context->get_type_name ());
+        ERROR, handle && buf_in && buf_out, XCAM_RETURN_ERROR_PARAM,
+        "xcam_handle_execute failed, either of handle/buf_in/buf_out can NOT be NULL");
 
-    if (*buf_out == NULL && output.ptr ()) {
-        XCamVideoBuffer *new_buf = convert_to_external_buffer (output);
-        XCAM_FAIL_RETURN (
-            ERROR, new_buf, XCAM_RETURN_ERROR_MEM,
-            "xcam_handle(%s) execute failed, out buffer can't convert to external buffer.",
-            context->get_type_name ());
-        *buf_out = new_buf;
-    }
+    return xcam_handle_execute_multi (handle, &buf_in, 1, buf_out);
+}
+
+XCamReturn
+xcam_handle_execute_multi (
+    XCamHandle *handle, XCamVideoBuffer **bufs_in, uint32_t count, XCamVideoBuffer **buf_out)
+{
+    ContextBase *context = CONTEXT_BASE_CAST (handle);
+    SmartPtr<ContextJob> job;
+
+    XCAM_FAIL_RETURN (
+        ERROR, context && bufs_in && count && buf_out, XCAM_RETURN_ERROR_PARAM,
+        "xcam_handle_execute_multi failed, either of handle/bufs_in/count/buf_out can NOT be NULL");
+
+    XCamReturn ret = create_job (handle, bufs_in, count, *buf_out, job);
+    if (!xcam_ret_is_ok (ret))
+        return ret;
+
+    ret = context->run_job (job);
+    if (!xcam_ret_is_ok (ret))
+        return ret;
+
+    *buf_out = job->ext_out;
     return ret;
 }
+
+XCamReturn
+xcam_handle_set_done_callback (XCamHandle *handle, XCamHandleDoneCallback callback, void *user_data)
+{
+    ContextBase *context = CONTEXT_BASE_CAST (handle);
+    XCAM_FAIL_RETURN (
+        ERROR, context, XCAM_RETURN_ERROR_PARAM,
+        "xcam_handle_set_done_callback failed, handle can NOT be NULL");
+
+    return context->set_done_callback (callback, user_data);
+}
+
+XCamReturn
+xcam_handle_submit (XCamHandle *handle, XCamVideoBuffer *buf_in, XCamVideoBuffer *buf_out)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, handle && buf_in, XCAM_RETURN_ERROR_PARAM,
+        "xcam_handle_submit failed, either of handle/buf_in can NOT be NULL");
+
+    return xcam_handle_submit_multi (handle, &buf_in, 1, buf_out);
+}
+
+XCamReturn
+xcam_handle_submit_multi (
+    XCamHandle *handle, XCamVideoBuffer **bufs_in, uint32_t count, XCamVideoBuffer *buf_out)
+{
+    ContextBase *context = CONTEXT_BASE_CAST (handle);
+    SmartPtr<ContextJob> job;
+
+    XCAM_FAIL_RETURN (
+        ERROR, context && bufs_in && count, XCAM_RETURN_ERROR_PARAM,
+        "xcam_handle_submit_multi failed, either of handle/bufs_in/count can NOT be NULL");
+
+    XCamReturn ret = create_job (handle, bufs_in, count, buf_out, job);
+    if (!xcam_ret_is_ok (ret))
+        return ret;
+
+    return context->submit (job);
+}
+
+XCamReturn
+xcam_handle_poll (XCamHandle *handle, XCamVideoBuffer **buf_in, XCamVideoBuffer **buf_out, int32_t timeout_ms)
+{
+    ContextBase *context = CONTEXT_BASE_CAST (handle);
+    SmartPtr<ContextJob> job;
+
+    XCAM_FAIL_RETURN (
+        ERROR, context && buf_in && buf_out, XCAM_RETURN_ERROR_PARAM,
+        "xcam_handle_poll failed, either of handle/buf_in/buf_out can NOT be NULL");
+
+    XCamReturn ret = context->poll (job, timeout_ms);
+    if (ret != XCAM_RETURN_NO_ERROR)
+        return ret;
+
+    *buf_in = job->ext_in;
+    *buf_out = job->ext_out;
+    return job->error;
+}
+
+int
+xcam_handle_get_event_fd (XCamHandle *handle)
+{
+    ContextBase *context = CONTEXT_BASE_CAST (handle);
+    XCAM_FAIL_RETURN (
+        ERROR, context, -1,
+        "xcam_handle_get_event_fd failed, handle can NOT be NULL");
+
+    return context->get_event_fd ();
+}
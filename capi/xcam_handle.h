@@ -78,13 +78,92 @@ XCamReturn xcam_handle_uinit (XCamHandle *handle);
 /*! \brief    xcam handle process buffer
  *
  * \params[in]        handle       xcam handle
- * \params[in]        buf_in       input buffer
+ * \params[in]        buf_in       input buffer, XCAM_MEM_TYPE_CPU memory is used in place without copy
+ *                                 and is referenced until processing is done
  * \params[in,out]    buf_out      output buffer, can be allocated outside or inside,
  *                                 if set param "alloc-out-buf" "true", allocate outside; else inside.
+ *                                 XCAM_MEM_TYPE_CPU buf_out allocated outside is written in place.
  * \return            XCamReturn   XCAM_RETURN_NO_ERROR on sucess; others on errors.
  */
 XCamReturn xcam_handle_execute (XCamHandle *handle, XCamVideoBuffer *buf_in, XCamVideoBuffer **buf_out);
 
+/*! \brief    xcam handle process buffers of one frame, for handles taking more than one input,
+ *            "SoftStitch" takes param "camera-num" (default 4) camera inputs in calibration index order,
+ *            front/right/rear/left for 4 cameras, "SoftBlend" takes 2
+ *
+ * \params[in]        handle       xcam handle
+ * \params[in]        bufs_in      input buffers, same memory rules as buf_in of xcam_handle_execute
+ * \params[in]        count        input buffer count
+ * \params[in,out]    buf_out      output buffer, same as buf_out of xcam_handle_execute
+ * \return            XCamReturn   XCAM_RETURN_NO_ERROR on sucess; others on errors.
+ */
+XCamReturn xcam_handle_execute_multi (
+    XCamHandle *handle, XCamVideoBuffer **bufs_in, uint32_t count, XCamVideoBuffer **buf_out);
+
+/*! \brief    callback of asynchronous processing, called in handle's worker thread in submission order,
+ *            the processing slot of buf_in is already released, callback can submit again
+ *
+ * \params[in]        handle       xcam handle
+ * \params[in]        buf_in       input buffer of xcam_handle_submit
+ * \params[in]        buf_out      output buffer of xcam_handle_submit, or allocated inside and caller unrefs it
+ * \params[in]        error        XCAM_RETURN_NO_ERROR on sucess; others on errors.
+ * \params[in]        user_data    user data of xcam_handle_set_done_callback
+ */
+typedef void (*XCamHandleDoneCallback) (
+    XCamHandle *handle, XCamVideoBuffer *buf_in, XCamVideoBuffer *buf_out, XCamReturn error, void *user_data);
+
+/*! \brief    set callback of asynchronous processing before the first submit,
+ *            done buffers go to callback instead of xcam_handle_poll
+ *
+ * \params[in]        handle       xcam handle
+ * \params[in]        callback     callback, NULL to use xcam_handle_poll
+ * \params[in]        user_data    user data passed to callback
+ * \return            XCamReturn   XCAM_RETURN_NO_ERROR on sucess; others on errors.
+ */
+XCamReturn xcam_handle_set_done_callback (XCamHandle *handle, XCamHandleDoneCallback callback, void *user_data);
+
+/*! \brief    xcam handle submits buffer to process asynchronously,
+ *            waits if param "async-depth" (default 2) buffers are in processing
+ *
+ * \params[in]        handle       xcam handle
+ * \params[in]        buf_in       input buffer, referenced until processing is done
+ * \params[in]        buf_out      output buffer allocated outside, or NULL if param "alloc-out-buf" is "true"
+ * \return            XCamReturn   XCAM_RETURN_NO_ERROR on sucess; others on errors.
+ */
+XCamReturn xcam_handle_submit (XCamHandle *handle, XCamVideoBuffer *buf_in, XCamVideoBuffer *buf_out);
+
+/*! \brief    xcam handle submits buffers of one frame to process asynchronously,
+ *            the first input is returned as buf_in by xcam_handle_poll and done callback
+ *
+ * \params[in]        handle       xcam handle
+ * \params[in]        bufs_in      input buffers, referenced until processing is done
+ * \params[in]        count        input buffer count
+ * \params[in]        buf_out      output buffer allocated outside, or NULL if param "alloc-out-buf" is "true"
+ * \return            XCamReturn   XCAM_RETURN_NO_ERROR on sucess; others on errors.
+ */
+XCamReturn xcam_handle_submit_multi (
+    XCamHandle *handle, XCamVideoBuffer **bufs_in, uint32_t count, XCamVideoBuffer *buf_out);
+
+/*! \brief    xcam handle polls the next processed buffers in submission order
+ *
+ * \params[in]        handle       xcam handle
+ * \params[out]       buf_in       input buffer of the submission
+ * \params[out]       buf_out      output buffer of the submission, or allocated inside and caller unrefs it
+ * \params[in]        timeout_ms   wait time in milliseconds, -1 waits until one is done
+ * \return            XCamReturn   XCAM_RETURN_NO_ERROR on sucess; XCAM_RETURN_ERROR_TIMEOUT if none is done;
+ *                                 others are processing errors of the submission.
+ */
+XCamReturn xcam_handle_poll (
+    XCamHandle *handle, XCamVideoBuffer **buf_in, XCamVideoBuffer **buf_out, int32_t timeout_ms);
+
+/*! \brief    event fd of xcam handle, readable while processed buffers wait for xcam_handle_poll,
+ *            can be added to caller's poll or epoll loop, don't read or close it
+ *
+ * \params[in]        handle       xcam handle
+ * \return            int          event fd on sucess; -1 on errors.
+ */
+int xcam_handle_get_event_fd (XCamHandle *handle);
+
 XCAM_END_DECLARE
 
 #endif //C_XCAM_HANDLE_H
@@ -37,6 +37,8 @@ CLVideoBufferData::~CLVideoBufferData ()
 {
     unmap ();
     _buf.release ();
+    if (_host_buf.ptr ())
+        _host_buf->unmap ();
 }
 
 cl_mem &
@@ -134,6 +136,32 @@ CLVideoBufferPool::allocate_data (const VideoBufferInfo &buffer_info)
     return new CLVideoBufferData (buf);
 }
 
+SmartPtr<CLVideoBuffer>
+convert_host_buf_to_cl_buf (const SmartPtr<CLContext> &context, const SmartPtr<VideoBuffer> &buf)
+{
+    XCAM_ASSERT (context.ptr () && buf.ptr ());
+    const VideoBufferInfo &info = buf->get_video_info ();
+
+    uint8_t *ptr = buf->map ();
+    XCAM_FAIL_RETURN (
+        ERROR, ptr, NULL,
+        "convert host buf to cl buf failed, map buffer failed");
+
+    SmartPtr<CLBuffer> cl_buf = new CLBuffer (context, info.size, CL_MEM_READ_WRITE | CL_MEM_USE_HOST_PTR, ptr);
+    XCAM_FAIL_RETURN (
+        ERROR, cl_buf.ptr () && cl_buf->is_valid (), NULL,
+        "convert host buf to cl buf failed, create cl buffer(size:%d) failed", info.size);
+
+    SmartPtr<CLVideoBufferData> data = new CLVideoBufferData (cl_buf);
+    XCAM_ASSERT (data.ptr ());
+    data->_host_buf = buf;
+
+    SmartPtr<CLVideoBuffer> cl_video_buf = new CLVideoBuffer (context, info, data);
+    XCAM_ASSERT (cl_video_buf.ptr ());
+    cl_video_buf->set_timestamp (buf->get_timestamp ());
+    return cl_video_buf;
+}
+
 SmartPtr<BufferProxy>
 CLVideoBufferPool::create_buffer_from_data (SmartPtr<BufferData> &data)
 {
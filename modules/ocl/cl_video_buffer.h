@@ -30,6 +30,7 @@
 namespace XCam {
 
 class CLBuffer;
+class CLVideoBuffer;
 class CLVideoBufferPool;
 class X3aStats;
 
@@ -37,6 +38,8 @@ class CLVideoBufferData
     : public BufferData
 {
     friend class CLVideoBufferPool;
+    friend SmartPtr<CLVideoBuffer> convert_host_buf_to_cl_buf (
+        const SmartPtr<CLContext> &context, const SmartPtr<VideoBuffer> &buf);
 
 public:
     ~CLVideoBufferData ();
@@ -59,6 +62,8 @@ private:
 private:
     uint8_t                *_buf_ptr;
     SmartPtr<CLBuffer>      _buf;
+    // host memory of CL_MEM_USE_HOST_PTR buffer
+    SmartPtr<VideoBuffer>   _host_buf;
 };
 
 class CLVideoBuffer
@@ -101,6 +106,12 @@ private:
     XCAM_DEAD_COPY (CLVideoBufferPool);
 };
 
+// wraps mapped memory of buf by CL_MEM_USE_HOST_PTR, buf is held until the CL buffer is released,
+// kernels access it in place if driver supports (page aligned on Intel GPU), otherwise driver copies.
+// map the returned buffer to read back results written by kernels
+SmartPtr<CLVideoBuffer>
+convert_host_buf_to_cl_buf (const SmartPtr<CLContext> &context, const SmartPtr<VideoBuffer> &buf);
+
 };
 
 #endif // XCAM_CL_VIDEO_BUFFER_H
@@ -332,92 +332,4 @@ create_cl_video_stab_handler (const SmartPtr<CLContext> &context)
     return video_stab;
 }
 
-MotionFilter::MotionFilter (uint32_t radius, float stdev)
-    : _radius (radius),
-      _stdev (stdev)
-{
-    set_filters (radius, stdev);
-}
-
-MotionFilter::~MotionFilter ()
-{
-    _weight.clear ();
-}
-
-void
-MotionFilter::set_filters (uint32_t radius, float stdev)
-{
-    _radius = radius;
-    _stdev = stdev > 0.f ? stdev : std::sqrt (static_cast<float>(radius));
-
-    int scale = 2 * _radius + 1;
-    float dis = 0.0f;
-    float sum = 0.0f;
-
-    _weight.resize (2 * _radius + 1);
-
-    for (int i = 0; i < scale; i++) {
-        dis = ((float)i - radius) * ((float)i - radius);
-        _weight[i] = exp(-dis / (_stdev * _stdev));
-        sum += _weight[i];
-    }
-
-    for (int i = 0; i <= scale; i++) {
-        _weight[i] /= sum;
-    }
-
-}
-
-Mat3d
-MotionFilter::cumulate_motion (uint32_t index, uint32_t from, std::list<Mat3d> &motions)
-{
-    Mat3d motion;
-    motion.eye ();
-
-    uint32_t id = 0;
-    std::list<Mat3d>::iterator it;
-
-    if (from < index) {
-        for (id = 0, it = motions.begin (); it != motions.end (); id++, ++it) {
-            if (from <= id && id < index) {
-                motion = (*it) * motion;
-            }
-        }
-        motion = motion.inverse ();
-    } else if (from > index) {
-        for (id = 0, it = motions.begin (); it != motions.end (); id++, ++it) {
-            if (index <= id && id < from) {
-                motion = (*it) * motion;
-            }
-        }
-    }
-
-    return motion;
-}
-
-Mat3d
-MotionFilter::stabilize (int32_t index,
-                         std::list<Mat3d> &motions,
-                         int32_t max)
-{
-    Mat3d res;
-    res.zeros ();
-
-    double sum = 0.0f;
-    int32_t idx_min = XCAM_MAX ((index - _radius), 0);
-    int32_t idx_max = XCAM_MIN ((index + _radius), max);
-
-    for (int32_t i = idx_min; i <= idx_max; ++i)
-    {
-        res = res + cumulate_motion (index, i, motions) * _weight[i];
-        sum += _weight[i];
-    }
-    if (sum > 0.0f) {
-        return res * (1 / sum);
-    }
-    else {
-        return Mat3d ();
-    }
-}
-
 }
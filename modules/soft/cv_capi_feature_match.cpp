@@ -42,22 +42,28 @@ CVCapiFeatureMatch::CVCapiFeatureMatch ()
 
 bool
 CVCapiFeatureMatch::get_crop_image (
-    const SmartPtr<VideoBuffer> &buffer, const Rect &crop_rect, std::vector<char> &crop_image, CvMat &img)
+    const SmartPtr<VideoBuffer> &buffer, const Rect &crop_rect, CvMat &img)
 {
     VideoBufferInfo info = buffer->get_video_info ();
+    XCAM_FAIL_RETURN (
+        ERROR,
+        crop_rect.pos_x >= 0 && crop_rect.pos_y >= 0 && crop_rect.width > 0 && crop_rect.height > 0 &&
+        crop_rect.pos_x + crop_rect.width <= (int)info.width &&
+        crop_rect.pos_y + crop_rect.height <= (int)info.height,
+        false,
+        "FeatureMatch(idx:%d): crop rect(%d, %d, %d, %d) is out of image(%dx%d)", _fm_idx,
+        crop_rect.pos_x, crop_rect.pos_y, crop_rect.width, crop_rect.height, info.width, info.height);
 
     uint8_t* image_buffer = buffer->map();
-    int offset = info.strides[NV12PlaneYIdx] * crop_rect.pos_y + crop_rect.pos_x;
+    XCAM_FAIL_RETURN (
+        ERROR, image_buffer, false,
+        "FeatureMatch(idx:%d): map buffer failed", _fm_idx);
 
-    crop_image.resize (crop_rect.width * crop_rect.height);
-    for (int i = 0; i < crop_rect.height; i++) {
-        for (int j = 0; j < crop_rect.width; j++) {
-            crop_image[i * crop_rect.width + j] =
-                image_buffer[offset + i * info.strides[NV12PlaneYIdx] + j];
-        }
-    }
-
-    img = cvMat (crop_rect.height, crop_rect.width, CV_8UC1, (void*)&crop_image[0]);
+    // header on luma of buffer with its stride, no copy
+    int offset = info.offsets[NV12PlaneYIdx] + info.strides[NV12PlaneYIdx] * crop_rect.pos_y + crop_rect.pos_x;
+    cvInitMatHeader (
+        &img, crop_rect.height, crop_rect.width, CV_8UC1,
+        (void*)(image_buffer + offset), info.strides[NV12PlaneYIdx]);
 
     return true;
 }
@@ -225,8 +231,8 @@ CVCapiFeatureMatch::optical_flow_feature_match (
 {
     CvMat left_img, right_img;
 
-    if (!get_crop_image (left_buf, left_crop_rect, _left_crop_image, left_img)
-            || !get_crop_image (right_buf, right_crop_rect, _right_crop_image, right_img))
+    if (!get_crop_image (left_buf, left_crop_rect, left_img)
+            || !get_crop_image (right_buf, right_crop_rect, right_img))
         return;
 
     detect_and_match ((CvArr*)(&left_img), (CvArr*)(&right_img), _valid_count, _mean_offset, _x_offset);
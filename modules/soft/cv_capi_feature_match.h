@@ -53,8 +53,8 @@ public:
     }
 
 protected:
-    bool get_crop_image (const SmartPtr<VideoBuffer> &buffer, const Rect &crop_rect,
-                         std::vector<char> &crop_image, CvMat &img);
+    // img refers to luma of buffer directly, buffer must be kept until img is used up
+    bool get_crop_image (const SmartPtr<VideoBuffer> &buffer, const Rect &crop_rect, CvMat &img);
 
     void add_detected_data (CvArr* image, std::vector<CvPoint2D32f> &corners);
     void get_valid_offsets (std::vector<CvPoint2D32f> &corner0, std::vector<CvPoint2D32f> &corner1,
@@ -72,9 +72,6 @@ protected:
 
 private:
     XCAM_DEAD_COPY (CVCapiFeatureMatch);
-
-    std::vector<char> _left_crop_image;
-    std::vector<char> _right_crop_image;
 };
 
 }
@@ -0,0 +1,225 @@
+/*
+ * soft_3a_stats_handler.cpp - soft 3a statistics handler implementation
+ *
+ *  Copyright (c) 2017 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#include "soft_3a_stats_handler.h"
+#include "soft_3a_stats_tasks_priv.h"
+
+#define XCAM_SOFT_STATS_BIT_DEPTH 8
+
+namespace XCam {
+
+using namespace XCamSoftTasks;
+
+DECLARE_WORK_CALLBACK (CbStatsTask, Soft3aStatsHandler, stats_task_done);
+
+// same as CL3AStatsCalculatorContext::fill_histogram
+static void
+fill_histogram (XCam3AStats *stats)
+{
+    const XCam3AStatsInfo &stats_info = stats->info;
+    XCamHistogram *hist_rgb = stats->hist_rgb;
+    uint32_t *hist_y = stats->hist_y;
+
+    memset (hist_rgb, 0, sizeof (XCamHistogram) * stats_info.histogram_bins);
+    memset (hist_y, 0, sizeof (uint32_t) * stats_info.histogram_bins);
+    for (uint32_t j = 0; j < stats_info.height; j++) {
+        const XCamGridStat *grid_line = &stats->stats[j * stats_info.aligned_width];
+        for (uint32_t i = 0; i < stats_info.width; i++) {
+            const XCamGridStat &grid = grid_line[i];
+            hist_rgb[grid.avg_r].r++;
+            hist_rgb[grid.avg_gr].gr++;
+            hist_rgb[grid.avg_gb].gb++;
+            hist_rgb[grid.avg_b].b++;
+            hist_y[grid.avg_y]++;
+        }
+    }
+}
+
+Soft3aStatsHandler::Soft3aStatsHandler (const char *name)
+    : SoftHandler (name)
+    , _sample_step (1)
+    , _in_format (0)
+    , _in_bits (0)
+{
+}
+
+Soft3aStatsHandler::~Soft3aStatsHandler ()
+{
+}
+
+bool
+Soft3aStatsHandler::set_sample_step (uint32_t step)
+{
+    XCAM_FAIL_RETURN (
+        ERROR,
+        step > 0 && step <= XCAM_SOFT_STATS_MAX_SAMPLE_STEP && (step & (step - 1)) == 0,
+        false,
+        "Soft3aStatsHandler(%s) sample step(%d) should be power of 2 and not larger than %d",
+        XCAM_STR (get_name ()), step, XCAM_SOFT_STATS_MAX_SAMPLE_STEP);
+
+    _sample_step = step;
+    return true;
+}
+
+XCamReturn
+Soft3aStatsHandler::calculate (
+    const SmartPtr<VideoBuffer> &in,
+    SmartPtr<X3aStats> &stats)
+{
+    SmartPtr<ImageHandler::Parameters> param = new ImageHandler::Parameters (in, stats);
+    XCamReturn ret = execute_buffer (param, true);
+    if (xcam_ret_is_ok (ret) && !stats.ptr ()) {
+        stats = param->out_buf.dynamic_cast_ptr<X3aStats> ();
+    }
+
+    return ret;
+}
+
+SmartPtr<BufferPool>
+Soft3aStatsHandler::create_allocator ()
+{
+    SmartPtr<X3aStatsPool> pool = new X3aStatsPool;
+    XCAM_ASSERT (pool.ptr ());
+    pool->set_bit_depth (XCAM_SOFT_STATS_BIT_DEPTH);
+    return pool;
+}
+
+XCamReturn
+Soft3aStatsHandler::configure_resource (const SmartPtr<Parameters> &param)
+{
+    const VideoBufferInfo &in_info = param->in_buf->get_video_info ();
+    uint32_t channel_map[2][2];
+    bool is_bayer = get_bayer_channel_map (in_info.format, channel_map);
+
+    XCAM_FAIL_RETURN (
+        ERROR, in_info.format == V4L2_PIX_FMT_NV12 || is_bayer, XCAM_RETURN_ERROR_PARAM,
+        "Soft3aStatsHandler(%s) unsupported input format:%s",
+        XCAM_STR (get_name ()), xcam_fourcc_to_string (in_info.format));
+    XCAM_FAIL_RETURN (
+        ERROR, in_info.width >= XCAM_SOFT_STATS_GRID_SIZE && in_info.height >= XCAM_SOFT_STATS_GRID_SIZE,
+        XCAM_RETURN_ERROR_PARAM,
+        "Soft3aStatsHandler(%s) input size(%dx%d) is smaller than a grid",
+        XCAM_STR (get_name ()), in_info.width, in_info.height);
+
+    // X3aStatsPool calculates grid size from image size
+    set_out_video_info (in_info);
+
+    _in_format = in_info.format;
+    _in_bits = is_bayer ? in_info.color_bits : 8;
+    XCAM_ASSERT (!_stats_task.ptr ());
+    if (is_bayer)
+        _stats_task = new BayerStatsTask (new CbStatsTask (this));
+    else
+        _stats_task = new NV12StatsTask (new CbStatsTask (this));
+    XCAM_ASSERT (_stats_task.ptr ());
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+Soft3aStatsHandler::start_work (const SmartPtr<ImageHandler::Parameters> &param)
+{
+    XCAM_ASSERT (_stats_task.ptr ());
+    XCAM_ASSERT (param->in_buf.ptr () && param->out_buf.ptr ());
+
+    SmartPtr<VideoBuffer> in_buf = param->in_buf;
+    SmartPtr<X3aStats> stats = param->out_buf.dynamic_cast_ptr<X3aStats> ();
+    XCAM_FAIL_RETURN (
+        ERROR, stats.ptr () && stats->get_stats (), XCAM_RETURN_ERROR_PARAM,
+        "Soft3aStatsHandler(%s) output buffer is not X3aStats", XCAM_STR (get_name ()));
+
+    SmartPtr<StatsTask::Args> args;
+    if (_in_format == V4L2_PIX_FMT_NV12) {
+        SmartPtr<NV12StatsTask::Args> nv12_args = new NV12StatsTask::Args (param);
+        nv12_args->in_luma = new UcharImage (in_buf, 0);
+        nv12_args->in_uv = new UcharImage (in_buf, 1);
+        args = nv12_args;
+    } else {
+        SmartPtr<BayerStatsTask::Args> bayer_args = new BayerStatsTask::Args (param);
+        bayer_args->in_raw = new UcharImage (in_buf, 0);
+        get_bayer_channel_map (_in_format, bayer_args->channel_map);
+        bayer_args->in_bytes = (_in_bits > 8 ? 2 : 1);
+        bayer_args->in_shift = (_in_bits > XCAM_SOFT_STATS_BIT_DEPTH ? _in_bits - XCAM_SOFT_STATS_BIT_DEPTH : 0);
+        args = bayer_args;
+    }
+    args->stats = stats->get_stats ();
+    args->sample_step = _sample_step;
+    stats->set_timestamp (in_buf->get_timestamp ());
+
+    const XCam3AStatsInfo &stats_info = args->stats->info;
+    WorkSize global_size (1, stats_info.aligned_height);
+    WorkSize local_size (1, xcam_ceil (stats_info.aligned_height, 4) / 4);
+    _stats_task->set_local_size (local_size);
+    _stats_task->set_global_size (global_size);
+
+    param->in_buf.release ();
+    XCamReturn ret = _stats_task->work (args);
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "Soft3aStatsHandler(%s) start_work failed", XCAM_STR (get_name ()));
+
+    return ret;
+}
+
+XCamReturn
+Soft3aStatsHandler::terminate ()
+{
+    if (_stats_task.ptr ()) {
+        _stats_task->stop ();
+        _stats_task.release ();
+    }
+    return SoftHandler::terminate ();
+}
+
+void
+Soft3aStatsHandler::stats_task_done (
+    const SmartPtr<Worker> &worker, const SmartPtr<Worker::Arguments> &base, const XCamReturn error)
+{
+    XCAM_UNUSED (worker);
+    XCAM_ASSERT (worker.ptr () == _stats_task.ptr ());
+
+    SmartPtr<StatsTask::Args> args = base.dynamic_cast_ptr<StatsTask::Args> ();
+    XCAM_ASSERT (args.ptr ());
+
+    const SmartPtr<ImageHandler::Parameters> param = args->get_param ();
+    if (!check_work_continue (param, error))
+        return;
+
+    fill_histogram (args->stats);
+
+    if (_stats_callback.ptr ()) {
+        SmartPtr<X3aStats> stats = param->out_buf.dynamic_cast_ptr<X3aStats> ();
+        XCAM_ASSERT (stats.ptr ());
+        _stats_callback->x3a_stats_ready (stats);
+    }
+
+    work_well_done (param, error);
+}
+
+SmartPtr<SoftHandler>
+create_soft_3a_stats_handler ()
+{
+    SmartPtr<Soft3aStatsHandler> stats = new Soft3aStatsHandler ();
+    XCAM_ASSERT (stats.ptr ());
+
+    return stats;
+}
+
+}
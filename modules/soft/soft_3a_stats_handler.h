@@ -0,0 +1,86 @@
+/*
+ * soft_3a_stats_handler.h - soft 3a statistics handler class
+ *
+ *  Copyright (c) 2017 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#ifndef XCAM_SOFT_3A_STATS_HANDLER_H
+#define XCAM_SOFT_3A_STATS_HANDLER_H
+
+#include <xcam_std.h>
+#include <x3a_stats_pool.h>
+#include <stats_callback_interface.h>
+#include <soft/soft_handler.h>
+
+namespace XCam {
+
+namespace XCamSoftTasks {
+class StatsTask;
+};
+
+/* 8 bits AE/AWB grid statistics of NV12 or bayer(8~16 bits) buffers.
+ * output buffers are allocated from X3aStatsPool, tasks write grids directly into them,
+ * histograms are filled from grids as CL3AStatsCalculatorContext does.
+ */
+class Soft3aStatsHandler
+    : public SoftHandler
+{
+public:
+    Soft3aStatsHandler (const char *name = "Soft3aStatsHandler");
+    ~Soft3aStatsHandler ();
+
+    // sample every step 2x2 blocks in both directions, step in {1, 2, 4, 8}
+    bool set_sample_step (uint32_t step);
+    uint32_t get_sample_step () const {
+        return _sample_step;
+    }
+
+    void set_stats_callback (const SmartPtr<StatsCallback> &callback) {
+        _stats_callback = callback;
+    }
+
+    XCamReturn calculate (
+        const SmartPtr<VideoBuffer> &in,
+        SmartPtr<X3aStats> &stats);
+
+    //derived from SoftHandler
+    virtual XCamReturn terminate ();
+
+    void stats_task_done (
+        const SmartPtr<Worker> &worker, const SmartPtr<Worker::Arguments> &args, const XCamReturn error);
+
+protected:
+    //derived from SoftHandler
+    virtual SmartPtr<BufferPool> create_allocator ();
+    XCamReturn configure_resource (const SmartPtr<Parameters> &param);
+    XCamReturn start_work (const SmartPtr<Parameters> &param);
+
+private:
+    XCAM_DEAD_COPY (Soft3aStatsHandler);
+
+private:
+    uint32_t                                _sample_step;
+    uint32_t                                _in_format;
+    uint32_t                                _in_bits;
+    SmartPtr<StatsCallback>                 _stats_callback;
+    SmartPtr<XCamSoftTasks::StatsTask>      _stats_task;
+};
+
+extern SmartPtr<SoftHandler> create_soft_3a_stats_handler ();
+
+}
+#endif //XCAM_SOFT_3A_STATS_HANDLER_H
@@ -0,0 +1,186 @@
+/*
+ * soft_3a_stats_tasks_priv.cpp - soft 3a statistics tasks implementation
+ *
+ *  Copyright (c) 2017 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#include "soft_3a_stats_tasks_priv.h"
+
+#define GRID_SIZE XCAM_SOFT_STATS_GRID_SIZE
+
+namespace XCam {
+
+namespace XCamSoftTasks {
+
+static inline uint32_t
+clamp_to_byte (const int32_t v)
+{
+    return (uint32_t)(v < 0 ? 0 : (v > 255 ? 255 : v));
+}
+
+static inline uint32_t
+average (const uint32_t sum, const uint32_t count)
+{
+    return (sum + count / 2) / count;
+}
+
+// same luma weights as kernel_bayer_basic, in Q8
+static inline uint32_t
+rgb_to_y (const uint32_t r, const uint32_t gr, const uint32_t gb, const uint32_t b)
+{
+    return clamp_to_byte ((77 * r + 75 * gr + 75 * gb + 29 * b + 128) >> 8);
+}
+
+// horizontal sums of sampled 2x2 blocks in one grid, even and odd columns separately
+template <typename T>
+static inline void
+sum_line (const T *line, const uint32_t step, const uint32_t shift, uint32_t &even, uint32_t &odd)
+{
+    uint32_t sum_even = 0, sum_odd = 0;
+    for (uint32_t x = 0; x < GRID_SIZE; x += step) {
+        sum_even += line[x] >> shift;
+        sum_odd += line[x + 1] >> shift;
+    }
+    even += sum_even;
+    odd += sum_odd;
+}
+
+static void
+clear_grid_line (XCamGridStat *grid_line, const uint32_t begin, const uint32_t end)
+{
+    if (end > begin)
+        memset (grid_line + begin, 0, sizeof (XCamGridStat) * (end - begin));
+}
+
+XCamReturn
+NV12StatsTask::work_range (const SmartPtr<Arguments> &base, const WorkRange &range)
+{
+    SmartPtr<NV12StatsTask::Args> args = base.dynamic_cast_ptr<NV12StatsTask::Args> ();
+    XCAM_ASSERT (args.ptr ());
+    UcharImage *in_luma = args->in_luma.ptr (), *in_uv = args->in_uv.ptr ();
+    XCam3AStats *stats = args->stats;
+    XCAM_ASSERT (in_luma && in_uv && stats);
+
+    const XCam3AStatsInfo &info = stats->info;
+    const uint32_t step = args->sample_step * 2;
+    const uint32_t samples = (GRID_SIZE / step) * (GRID_SIZE / step);
+    std::vector<uint32_t> sums (info.width * 3);
+
+    for (uint32_t gy = range.pos[1]; gy < range.pos[1] + range.pos_len[1]; ++gy) {
+        XCamGridStat *grid_line = &stats->stats[gy * info.aligned_width];
+        if (gy >= info.height) {
+            clear_grid_line (grid_line, 0, info.aligned_width);
+            continue;
+        }
+
+        std::fill (sums.begin (), sums.end (), 0);
+        for (uint32_t y = 0; y < GRID_SIZE; y += step) {
+            const Uchar *luma0 = in_luma->get_buf_ptr (0, gy * GRID_SIZE + y);
+            const Uchar *luma1 = in_luma->get_buf_ptr (0, gy * GRID_SIZE + y + 1);
+            const Uchar *uv = in_uv->get_buf_ptr (0, (gy * GRID_SIZE + y) / 2);
+            for (uint32_t gx = 0; gx < info.width; ++gx) {
+                uint32_t *sum = &sums[gx * 3];
+                uint32_t offset = gx * GRID_SIZE;
+                sum_line (luma0 + offset, step, 0, sum[0], sum[0]);
+                sum_line (luma1 + offset, step, 0, sum[0], sum[0]);
+                sum_line (uv + offset, step, 0, sum[1], sum[2]);
+            }
+        }
+
+        for (uint32_t gx = 0; gx < info.width; ++gx) {
+            const uint32_t *sum = &sums[gx * 3];
+            int32_t y = average (sum[0], samples * 4);
+            int32_t u = (int32_t)average (sum[1], samples) - 128;
+            int32_t v = (int32_t)average (sum[2], samples) - 128;
+            uint32_t g = clamp_to_byte (y + ((-88 * u - 183 * v + 128) >> 8));
+
+            XCamGridStat &grid = grid_line[gx];
+            grid.avg_y = y;
+            grid.avg_r = clamp_to_byte (y + ((359 * v + 128) >> 8));
+            grid.avg_gr = g;
+            grid.avg_gb = g;
+            grid.avg_b = clamp_to_byte (y + ((454 * u + 128) >> 8));
+            grid.valid_wb_count = samples;
+            grid.f_value1 = 0;
+            grid.f_value2 = 0;
+        }
+        clear_grid_line (grid_line, info.width, info.aligned_width);
+    }
+
+    XCAM_LOG_DEBUG ("NV12StatsTask work on range:[y:%d, height:%d]", range.pos[1], range.pos_len[1]);
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+BayerStatsTask::work_range (const SmartPtr<Arguments> &base, const WorkRange &range)
+{
+    SmartPtr<BayerStatsTask::Args> args = base.dynamic_cast_ptr<BayerStatsTask::Args> ();
+    XCAM_ASSERT (args.ptr ());
+    UcharImage *in_raw = args->in_raw.ptr ();
+    XCam3AStats *stats = args->stats;
+    XCAM_ASSERT (in_raw && stats);
+
+    const XCam3AStatsInfo &info = stats->info;
+    const uint32_t step = args->sample_step * 2;
+    const uint32_t samples = (GRID_SIZE / step) * (GRID_SIZE / step);
+    const uint32_t shift = args->in_shift;
+    std::vector<uint32_t> sums (info.width * BayerChannelMax);
+
+    for (uint32_t gy = range.pos[1]; gy < range.pos[1] + range.pos_len[1]; ++gy) {
+        XCamGridStat *grid_line = &stats->stats[gy * info.aligned_width];
+        if (gy >= info.height) {
+            clear_grid_line (grid_line, 0, info.aligned_width);
+            continue;
+        }
+
+        std::fill (sums.begin (), sums.end (), 0);
+        for (uint32_t y = 0; y < GRID_SIZE; y += step) {
+            for (uint32_t i = 0; i < 2; ++i) {
+                const uint32_t ch_even = args->channel_map[i][0], ch_odd = args->channel_map[i][1];
+                const Uchar *line = in_raw->get_buf_ptr (0, gy * GRID_SIZE + y + i);
+                for (uint32_t gx = 0; gx < info.width; ++gx) {
+                    uint32_t *sum = &sums[gx * BayerChannelMax];
+                    if (args->in_bytes == 1)
+                        sum_line (line + gx * GRID_SIZE, step, 0, sum[ch_even], sum[ch_odd]);
+                    else
+                        sum_line ((const uint16_t *)line + gx * GRID_SIZE, step, shift, sum[ch_even], sum[ch_odd]);
+                }
+            }
+        }
+
+        for (uint32_t gx = 0; gx < info.width; ++gx) {
+            const uint32_t *sum = &sums[gx * BayerChannelMax];
+            XCamGridStat &grid = grid_line[gx];
+            grid.avg_r = clamp_to_byte (average (sum[BayerChannelR], samples));
+            grid.avg_gr = clamp_to_byte (average (sum[BayerChannelGr], samples));
+            grid.avg_gb = clamp_to_byte (average (sum[BayerChannelGb], samples));
+            grid.avg_b = clamp_to_byte (average (sum[BayerChannelB], samples));
+            grid.avg_y = rgb_to_y (grid.avg_r, grid.avg_gr, grid.avg_gb, grid.avg_b);
+            grid.valid_wb_count = samples;
+            grid.f_value1 = 0;
+            grid.f_value2 = 0;
+        }
+        clear_grid_line (grid_line, info.width, info.aligned_width);
+    }
+
+    XCAM_LOG_DEBUG ("BayerStatsTask work on range:[y:%d, height:%d]", range.pos[1], range.pos_len[1]);
+    return XCAM_RETURN_NO_ERROR;
+}
+
+}
+
+}
@@ -0,0 +1,119 @@
+/*
+ * soft_3a_stats_tasks_priv.h - soft 3a statistics tasks
+ *
+ *  Copyright (c) 2017 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#ifndef XCAM_SOFT_3A_STATS_TASKS_PRIV_H
+#define XCAM_SOFT_3A_STATS_TASKS_PRIV_H
+
+#include <xcam_std.h>
+#include <base/xcam_3a_stats.h>
+#include <soft/soft_worker.h>
+#include <soft/soft_image.h>
+#include <soft/soft_handler.h>
+#include <soft/soft_bayer_tasks_priv.h>
+
+// grid size is fixed by X3aStatsPool
+#define XCAM_SOFT_STATS_GRID_SIZE 16
+#define XCAM_SOFT_STATS_MAX_SAMPLE_STEP (XCAM_SOFT_STATS_GRID_SIZE / 2)
+
+namespace XCam {
+
+namespace XCamSoftTasks {
+
+/* each work unit reduces one row of grids and writes XCamGridStat directly into stats buffer.
+ * samples are 2x2 pixel blocks on a lattice of sample_step blocks, grids out of the
+ * valid stats width/height are cleared.
+ */
+class StatsTask
+    : public SoftWorker
+{
+public:
+    struct Args : SoftArgs {
+        XCam3AStats                *stats;
+        uint32_t                    sample_step;
+
+        Args (const SmartPtr<ImageHandler::Parameters> &param)
+            : SoftArgs (param)
+            , stats (NULL)
+            , sample_step (1)
+        {}
+    };
+
+public:
+    explicit StatsTask (const char *name, const SmartPtr<Worker::Callback> &cb)
+        : SoftWorker (name, cb)
+    {
+        set_work_uint (XCAM_SOFT_STATS_GRID_SIZE, XCAM_SOFT_STATS_GRID_SIZE);
+    }
+};
+
+class NV12StatsTask
+    : public StatsTask
+{
+public:
+    struct Args : StatsTask::Args {
+        SmartPtr<UcharImage>        in_luma, in_uv;
+
+        Args (const SmartPtr<ImageHandler::Parameters> &param)
+            : StatsTask::Args (param)
+        {}
+    };
+
+public:
+    explicit NV12StatsTask (const SmartPtr<Worker::Callback> &cb)
+        : StatsTask ("NV12StatsTask", cb)
+    {}
+
+private:
+    virtual XCamReturn work_range (const SmartPtr<Arguments> &args, const WorkRange &range);
+};
+
+class BayerStatsTask
+    : public StatsTask
+{
+public:
+    struct Args : StatsTask::Args {
+        SmartPtr<UcharImage>        in_raw;
+        uint32_t                    channel_map[2][2];
+        uint32_t                    in_bytes;
+        uint32_t                    in_shift;
+
+        Args (const SmartPtr<ImageHandler::Parameters> &param)
+            : StatsTask::Args (param)
+            , in_bytes (1)
+            , in_shift (0)
+        {
+            xcam_mem_clear (channel_map);
+        }
+    };
+
+public:
+    explicit BayerStatsTask (const SmartPtr<Worker::Callback> &cb)
+        : StatsTask ("BayerStatsTask", cb)
+    {}
+
+private:
+    virtual XCamReturn work_range (const SmartPtr<Arguments> &args, const WorkRange &range);
+};
+
+}
+
+}
+
+#endif //XCAM_SOFT_3A_STATS_TASKS_PRIV_H
@@ -0,0 +1,196 @@
+/*
+ * soft_3d_denoise_handler.cpp - soft 3D denoise handler implementation
+ *
+ *  Copyright (c) 2017 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#include "soft_3d_denoise_handler.h"
+#include "soft_3d_denoise_tasks_priv.h"
+
+#define XCAM_SOFT_3D_DENOISE_ALIGNMENT_X 8
+#define XCAM_SOFT_3D_DENOISE_ALIGNMENT_Y 4
+#define XCAM_SOFT_3D_DENOISE_DEFAULT_REF_COUNT 1
+
+namespace XCam {
+
+DECLARE_WORK_CALLBACK (CbDenoise3DTask, Soft3DDenoiseHandler, denoise_task_done);
+
+Soft3DDenoiseHandler::Soft3DDenoiseHandler (const char *name)
+    : SoftHandler (name)
+    , _ref_count (XCAM_SOFT_3D_DENOISE_DEFAULT_REF_COUNT)
+{
+    xcam_mem_clear (_config);
+    _config.gain = 1.0f;
+    _config.threshold[0] = 0.05f;
+    _config.threshold[1] = 0.05f;
+}
+
+Soft3DDenoiseHandler::~Soft3DDenoiseHandler ()
+{
+}
+
+bool
+Soft3DDenoiseHandler::set_ref_framecount (const uint8_t count)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, count >= 1 && count <= XCAM_SOFT_3D_DENOISE_MAX_REF_COUNT, false,
+        "Soft3DDenoiseHandler(%s) reference count(%d) should be in [1, %d]",
+        XCAM_STR (get_name ()), count, XCAM_SOFT_3D_DENOISE_MAX_REF_COUNT);
+
+    _ref_count = count;
+    return true;
+}
+
+bool
+Soft3DDenoiseHandler::set_denoise_config (const XCam3aResultTemporalNoiseReduction& config)
+{
+    _config = config;
+    return true;
+}
+
+XCamReturn
+Soft3DDenoiseHandler::denoise (
+    const SmartPtr<VideoBuffer> &in,
+    SmartPtr<VideoBuffer> &out_buf)
+{
+    SmartPtr<ImageHandler::Parameters> param = new ImageHandler::Parameters (in, out_buf);
+    XCamReturn ret = execute_buffer (param, true);
+    if (xcam_ret_is_ok (ret) && !out_buf.ptr ()) {
+        out_buf = param->out_buf;
+    }
+
+    return ret;
+}
+
+XCamReturn
+Soft3DDenoiseHandler::configure_resource (const SmartPtr<Parameters> &param)
+{
+    const VideoBufferInfo &in_info = param->in_buf->get_video_info ();
+    XCAM_FAIL_RETURN (
+        ERROR, in_info.format == V4L2_PIX_FMT_NV12, XCAM_RETURN_ERROR_PARAM,
+        "Soft3DDenoiseHandler(%s) only support format(NV12) but input format is %s",
+        XCAM_STR (get_name ()), xcam_fourcc_to_string (in_info.format));
+    XCAM_FAIL_RETURN (
+        ERROR,
+        in_info.width >= XCAM_SOFT_3D_DENOISE_BLOCK_SIZE && in_info.height >= XCAM_SOFT_3D_DENOISE_BLOCK_SIZE &&
+        in_info.width % 2 == 0 && in_info.height % 2 == 0,
+        XCAM_RETURN_ERROR_PARAM,
+        "Soft3DDenoiseHandler(%s) unsupported input size(%dx%d)",
+        XCAM_STR (get_name ()), in_info.width, in_info.height);
+
+    VideoBufferInfo out_info;
+    out_info.init (
+        in_info.format, in_info.width, in_info.height,
+        XCAM_ALIGN_UP (in_info.width, XCAM_SOFT_3D_DENOISE_ALIGNMENT_X),
+        XCAM_ALIGN_UP (in_info.height, XCAM_SOFT_3D_DENOISE_ALIGNMENT_Y));
+    set_out_video_info (out_info);
+
+    XCAM_ASSERT (!_denoise_task.ptr ());
+    _denoise_task = new XCamSoftTasks::Denoise3DTask (new CbDenoise3DTask (this));
+    XCAM_ASSERT (_denoise_task.ptr ());
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+Soft3DDenoiseHandler::start_work (const SmartPtr<ImageHandler::Parameters> &param)
+{
+    XCAM_ASSERT (_denoise_task.ptr ());
+    XCAM_ASSERT (param->in_buf.ptr () && param->out_buf.ptr ());
+
+    SmartPtr<VideoBuffer> in_buf = param->in_buf, out_buf = param->out_buf;
+    SmartPtr<XCamSoftTasks::Denoise3DTask::Args> args = new XCamSoftTasks::Denoise3DTask::Args (param);
+    args->in_luma = new UcharImage (in_buf, 0);
+    args->in_uv = new UcharImage (in_buf, 1);
+    args->out_luma = new UcharImage (out_buf, 0);
+    args->out_uv = new UcharImage (out_buf, 1);
+    args->gain = 5.0f / (_config.gain + 0.0001f);
+    args->threshold = 2.0f * _config.threshold[0];
+
+    uint32_t idx = 0;
+    for (VideoBufferRing::iterator i = _ref_bufs.begin (); i != _ref_bufs.end () && idx < _ref_count; ++i, ++idx) {
+        args->ref_luma[idx] = new UcharImage (*i, 0);
+        args->ref_uv[idx] = new UcharImage (*i, 1);
+    }
+    args->ref_count = idx;
+
+    // newest reference first, the input buffer itself is kept as next reference
+    _ref_bufs.push_front (in_buf);
+    while (_ref_bufs.size () > _ref_count)
+        _ref_bufs.pop_back ();
+
+    WorkSize work_unit = _denoise_task->get_work_uint ();
+    WorkSize global_size (
+        xcam_ceil (in_buf->get_video_info ().width, work_unit.value[0]) / work_unit.value[0],
+        xcam_ceil (in_buf->get_video_info ().height, work_unit.value[1]) / work_unit.value[1]);
+    WorkSize local_size (
+        xcam_ceil (global_size.value[0], 2) / 2,
+        xcam_ceil (global_size.value[1], 2) / 2);
+    _denoise_task->set_local_size (local_size);
+    _denoise_task->set_global_size (global_size);
+
+    param->in_buf.release ();
+    XCamReturn ret = _denoise_task->work (args);
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "Soft3DDenoiseHandler(%s) start_work failed", XCAM_STR (get_name ()));
+
+    return ret;
+}
+
+XCamReturn
+Soft3DDenoiseHandler::terminate ()
+{
+    if (_denoise_task.ptr ()) {
+        _denoise_task->stop ();
+        _denoise_task.release ();
+    }
+    _ref_bufs.clear ();
+    return SoftHandler::terminate ();
+}
+
+void
+Soft3DDenoiseHandler::denoise_task_done (
+    const SmartPtr<Worker> &worker, const SmartPtr<Worker::Arguments> &base, const XCamReturn error)
+{
+    XCAM_UNUSED (worker);
+    XCAM_ASSERT (worker.ptr () == _denoise_task.ptr ());
+
+    SmartPtr<XCamSoftTasks::Denoise3DTask::Args> args = base.dynamic_cast_ptr<XCamSoftTasks::Denoise3DTask::Args> ();
+    XCAM_ASSERT (args.ptr ());
+
+    const SmartPtr<ImageHandler::Parameters> param = args->get_param ();
+    if (!check_work_continue (param, error))
+        return;
+
+    work_well_done (param, error);
+}
+
+SmartPtr<SoftHandler>
+create_soft_3d_denoise_handler (uint8_t ref_count)
+{
+    SmartPtr<Soft3DDenoiseHandler> denoise = new Soft3DDenoiseHandler ();
+    XCAM_ASSERT (denoise.ptr ());
+
+    XCAM_FAIL_RETURN (
+        ERROR, denoise->set_ref_framecount (ref_count), NULL,
+        "create soft 3d denoise handler failed with reference count:%d", ref_count);
+
+    return denoise;
+}
+
+}
@@ -0,0 +1,85 @@
+/*
+ * soft_3d_denoise_handler.h - soft 3D denoise handler class
+ *
+ *  Copyright (c) 2017 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#ifndef XCAM_SOFT_3D_DENOISE_HANDLER_H
+#define XCAM_SOFT_3D_DENOISE_HANDLER_H
+
+#include <xcam_std.h>
+#include <base/xcam_3a_result.h>
+#include <soft/soft_handler.h>
+
+namespace XCam {
+
+namespace XCamSoftTasks {
+class Denoise3DTask;
+};
+
+/* NV12 spatio-temporal denoise.
+ * previous input buffers are held as references directly(no copy), so upstream buffer pool
+ * needs at least ref_count more buffers than usual.
+ */
+class Soft3DDenoiseHandler
+    : public SoftHandler
+{
+    typedef std::list<SmartPtr<VideoBuffer>> VideoBufferRing;
+
+public:
+    Soft3DDenoiseHandler (const char *name = "Soft3DDenoiseHandler");
+    ~Soft3DDenoiseHandler ();
+
+    bool set_ref_framecount (const uint8_t count);
+    uint8_t get_ref_framecount () const {
+        return _ref_count;
+    };
+
+    bool set_denoise_config (const XCam3aResultTemporalNoiseReduction& config);
+    const XCam3aResultTemporalNoiseReduction& get_denoise_config () const {
+        return _config;
+    };
+
+    XCamReturn denoise (
+        const SmartPtr<VideoBuffer> &in,
+        SmartPtr<VideoBuffer> &out_buf);
+
+    //derived from SoftHandler
+    virtual XCamReturn terminate ();
+
+    void denoise_task_done (
+        const SmartPtr<Worker> &worker, const SmartPtr<Worker::Arguments> &args, const XCamReturn error);
+
+protected:
+    //derived from SoftHandler
+    XCamReturn configure_resource (const SmartPtr<Parameters> &param);
+    XCamReturn start_work (const SmartPtr<Parameters> &param);
+
+private:
+    XCAM_DEAD_COPY (Soft3DDenoiseHandler);
+
+private:
+    uint8_t                                 _ref_count;
+    XCam3aResultTemporalNoiseReduction      _config;
+    VideoBufferRing                         _ref_bufs;
+    SmartPtr<XCamSoftTasks::Denoise3DTask>  _denoise_task;
+};
+
+extern SmartPtr<SoftHandler> create_soft_3d_denoise_handler (uint8_t ref_count);
+
+}
+#endif //XCAM_SOFT_3D_DENOISE_HANDLER_H
@@ -0,0 +1,154 @@
+/*
+ * soft_3d_denoise_tasks_priv.cpp - soft 3D denoise tasks implementation
+ *
+ *  Copyright (c) 2017 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#include "soft_3d_denoise_tasks_priv.h"
+#include <math.h>
+
+#define BLOCK_SIZE XCAM_SOFT_3D_DENOISE_BLOCK_SIZE
+#define LUMA_PIXELS (BLOCK_SIZE * BLOCK_SIZE)
+#define UV_PIXELS (BLOCK_SIZE * BLOCK_SIZE / 2)
+
+// reference blocks are shifted by -2, 0, +2 pixels, even offsets keep UV pairs aligned
+#define REF_OFFSET_STEP 2
+
+namespace XCam {
+
+namespace XCamSoftTasks {
+
+static inline void
+read_block (
+    const UcharImage *luma, const UcharImage *uv, uint32_t x, uint32_t y,
+    float *luma_block, float *uv_block)
+{
+    for (uint32_t j = 0; j < BLOCK_SIZE; ++j) {
+        const Uchar *src = luma->get_buf_ptr (x, y + j);
+        for (uint32_t i = 0; i < BLOCK_SIZE; ++i)
+            luma_block[j * BLOCK_SIZE + i] = src[i];
+    }
+    for (uint32_t j = 0; j < BLOCK_SIZE / 2; ++j) {
+        const Uchar *src = uv->get_buf_ptr (x, y / 2 + j);
+        for (uint32_t i = 0; i < BLOCK_SIZE; ++i)
+            uv_block[j * BLOCK_SIZE + i] = src[i];
+    }
+}
+
+static inline void
+write_block (
+    UcharImage *luma, UcharImage *uv, uint32_t x, uint32_t y,
+    const float *luma_block, const float *uv_block)
+{
+    for (uint32_t j = 0; j < BLOCK_SIZE; ++j) {
+        Uchar *dst = luma->get_buf_ptr (x, y + j);
+        convert_to_uchar_N<float, BLOCK_SIZE> (luma_block + j * BLOCK_SIZE, dst);
+    }
+    for (uint32_t j = 0; j < BLOCK_SIZE / 2; ++j) {
+        Uchar *dst = uv->get_buf_ptr (x, y / 2 + j);
+        convert_to_uchar_N<float, BLOCK_SIZE> (uv_block + j * BLOCK_SIZE, dst);
+    }
+}
+
+// same measures as kernel_3d_denoise, squared distance and gradient are normalized to [0, 1]
+static inline float
+block_weight (const float *observe, const float *ref, const float gain, const float threshold)
+{
+    float dist = 0.0f, grad = 0.0f;
+    for (uint32_t i = 0; i < LUMA_PIXELS; ++i) {
+        float diff = (observe[i] - ref[i]) * (1.0f / 255.0f);
+        dist += diff * diff;
+        grad += fabsf (ref[i] - ref[i ^ 1]);
+    }
+    grad *= 1.0f / (LUMA_PIXELS * 255.0f);
+
+    float g = (grad < threshold) ? gain : 2.0f * gain;
+    return expf (-g * dist);
+}
+
+static inline uint32_t
+clamp_pos (int32_t pos, uint32_t max_pos)
+{
+    return pos < 0 ? 0 : (pos > (int32_t)max_pos ? max_pos : pos);
+}
+
+XCamReturn
+Denoise3DTask::work_range (const SmartPtr<Arguments> &base, const WorkRange &range)
+{
+    SmartPtr<Denoise3DTask::Args> args = base.dynamic_cast_ptr<Denoise3DTask::Args> ();
+    XCAM_ASSERT (args.ptr ());
+    UcharImage *in_luma = args->in_luma.ptr (), *in_uv = args->in_uv.ptr ();
+    UcharImage *out_luma = args->out_luma.ptr (), *out_uv = args->out_uv.ptr ();
+    XCAM_ASSERT (in_luma && in_uv && out_luma && out_uv);
+    XCAM_ASSERT (args->ref_count <= XCAM_SOFT_3D_DENOISE_MAX_REF_COUNT);
+
+    const uint32_t max_x = in_luma->get_width () - BLOCK_SIZE;
+    const uint32_t max_y = in_luma->get_height () - BLOCK_SIZE;
+
+    float observe[LUMA_PIXELS], observe_uv[UV_PIXELS];
+    float ref[LUMA_PIXELS], ref_uv[UV_PIXELS];
+    float restore[LUMA_PIXELS], restore_uv[UV_PIXELS];
+
+    for (uint32_t by = range.pos[1]; by < range.pos[1] + range.pos_len[1]; ++by)
+        for (uint32_t bx = range.pos[0]; bx < range.pos[0] + range.pos_len[0]; ++bx) {
+            uint32_t x = XCAM_MIN (bx * BLOCK_SIZE, max_x);
+            uint32_t y = XCAM_MIN (by * BLOCK_SIZE, max_y);
+
+            read_block (in_luma, in_uv, x, y, observe, observe_uv);
+            memcpy (restore, observe, sizeof (restore));
+            memcpy (restore_uv, observe_uv, sizeof (restore_uv));
+            float sum_weight = 1.0f;
+
+            for (uint32_t r = 0; r < args->ref_count; ++r) {
+                const UcharImage *ref_luma_img = args->ref_luma[r].ptr ();
+                const UcharImage *ref_uv_img = args->ref_uv[r].ptr ();
+                XCAM_ASSERT (ref_luma_img && ref_uv_img);
+
+                for (int32_t dy = -REF_OFFSET_STEP; dy <= REF_OFFSET_STEP; dy += REF_OFFSET_STEP)
+                    for (int32_t dx = -REF_OFFSET_STEP; dx <= REF_OFFSET_STEP; dx += REF_OFFSET_STEP) {
+                        uint32_t ref_x = clamp_pos ((int32_t)x + dx, max_x);
+                        uint32_t ref_y = clamp_pos ((int32_t)y + dy, max_y);
+                        read_block (ref_luma_img, ref_uv_img, ref_x, ref_y, ref, ref_uv);
+
+                        float weight = block_weight (observe, ref, args->gain, args->threshold);
+                        for (uint32_t i = 0; i < LUMA_PIXELS; ++i)
+                            restore[i] += weight * ref[i];
+                        for (uint32_t i = 0; i < UV_PIXELS; ++i)
+                            restore_uv[i] += weight * ref_uv[i];
+                        sum_weight += weight;
+                    }
+            }
+
+            float inv_weight = 1.0f / sum_weight;
+            for (uint32_t i = 0; i < LUMA_PIXELS; ++i)
+                restore[i] *= inv_weight;
+            for (uint32_t i = 0; i < UV_PIXELS; ++i)
+                restore_uv[i] *= inv_weight;
+
+            write_block (out_luma, out_uv, x, y, restore, restore_uv);
+        }
+
+    XCAM_LOG_DEBUG (
+        "Denoise3DTask work on range:[x:%d, width:%d, y:%d, height:%d]",
+        range.pos[0], range.pos_len[0], range.pos[1], range.pos_len[1]);
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+}
+
+}
@@ -0,0 +1,78 @@
+/*
+ * soft_3d_denoise_tasks_priv.h - soft 3D denoise tasks
+ *
+ *  Copyright (c) 2017 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#ifndef XCAM_SOFT_3D_DENOISE_TASKS_PRIV_H
+#define XCAM_SOFT_3D_DENOISE_TASKS_PRIV_H
+
+#include <xcam_std.h>
+#include <soft/soft_worker.h>
+#include <soft/soft_image.h>
+#include <soft/soft_handler.h>
+
+#define XCAM_SOFT_3D_DENOISE_MAX_REF_COUNT 3
+
+// luma block size, chroma block is half size in NV12
+#define XCAM_SOFT_3D_DENOISE_BLOCK_SIZE 4
+
+namespace XCam {
+
+namespace XCamSoftTasks {
+
+/* each work unit restores one 4x4 luma block and its 2x2 UV block.
+ * reference blocks are searched around the same position of each reference frame,
+ * weights are calculated on luma only and reused on chroma.
+ */
+class Denoise3DTask
+    : public SoftWorker
+{
+public:
+    struct Args : SoftArgs {
+        SmartPtr<UcharImage>        in_luma, in_uv;
+        SmartPtr<UcharImage>        out_luma, out_uv;
+        SmartPtr<UcharImage>        ref_luma[XCAM_SOFT_3D_DENOISE_MAX_REF_COUNT];
+        SmartPtr<UcharImage>        ref_uv[XCAM_SOFT_3D_DENOISE_MAX_REF_COUNT];
+        uint32_t                    ref_count;
+        float                       gain;
+        float                       threshold;
+
+        Args (const SmartPtr<ImageHandler::Parameters> &param)
+            : SoftArgs (param)
+            , ref_count (0)
+            , gain (0.0f)
+            , threshold (0.0f)
+        {}
+    };
+
+public:
+    explicit Denoise3DTask (const SmartPtr<Worker::Callback> &cb)
+        : SoftWorker ("Denoise3DTask", cb)
+    {
+        set_work_uint (XCAM_SOFT_3D_DENOISE_BLOCK_SIZE, XCAM_SOFT_3D_DENOISE_BLOCK_SIZE);
+    }
+
+private:
+    virtual XCamReturn work_range (const SmartPtr<Arguments> &args, const WorkRange &range);
+};
+
+}
+
+}
+
+#endif //XCAM_SOFT_3D_DENOISE_TASKS_PRIV_H
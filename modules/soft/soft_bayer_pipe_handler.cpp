@@ -0,0 +1,369 @@
+/*
+ * soft_bayer_pipe_handler.cpp - soft bayer pipe handler implementation
+ *
+ *  Copyright (c) 2017 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#include "soft_bayer_pipe_handler.h"
+#include "soft_bayer_tasks_priv.h"
+
+#define XCAM_SOFT_BAYER_ALIGNMENT_X 8
+#define XCAM_SOFT_BAYER_ALIGNMENT_Y 2
+#define XCAM_SOFT_BAYER_THREADS 4
+
+namespace XCam {
+
+using namespace XCamSoftTasks;
+
+DECLARE_WORK_CALLBACK (CbBayerPipeTask, SoftBayerPipeHandler, bayer_task_done);
+
+static const double default_rgb_to_yuv_matrix[XCAM_COLOR_MATRIX_SIZE] = {
+    0.299, 0.587, 0.114,
+    -0.14713, -0.28886, 0.436,
+    0.615, -0.51499, -0.10001
+};
+
+static inline int32_t
+double_to_fixed (const double v, const uint32_t bits)
+{
+    double fixed = v * (1 << bits);
+    return (int32_t)(fixed < 0.0 ? fixed - 0.5 : fixed + 0.5);
+}
+
+SoftBayerPipeHandler::SoftBayerPipeHandler (const char *name)
+    : SoftHandler (name)
+    , _config_dirty (true)
+    , _demosaic_mode (SoftDemosaicBilinear)
+    , _in_format (0)
+    , _in_bits (0)
+{
+    xcam_mem_clear (_blc);
+    _blc.r_level = XCAM_SOFT_BLC_DEFAULT_LEVEL;
+    _blc.gr_level = XCAM_SOFT_BLC_DEFAULT_LEVEL;
+    _blc.gb_level = XCAM_SOFT_BLC_DEFAULT_LEVEL;
+    _blc.b_level = XCAM_SOFT_BLC_DEFAULT_LEVEL;
+
+    xcam_mem_clear (_wb);
+    _wb.r_gain = 1.0;
+    _wb.gr_gain = 1.0;
+    _wb.gb_gain = 1.0;
+    _wb.b_gain = 1.0;
+
+    xcam_mem_clear (_gamma);
+    for (int i = 0; i < XCAM_GAMMA_TABLE_SIZE; ++i)
+        _gamma.table[i] = (double)i;
+
+    xcam_mem_clear (_ccm);
+    _ccm.matrix[0] = _ccm.matrix[4] = _ccm.matrix[8] = 1.0;
+
+    xcam_mem_clear (_rgb2yuv);
+    for (int i = 0; i < XCAM_COLOR_MATRIX_SIZE; ++i)
+        _rgb2yuv.matrix[i] = default_rgb_to_yuv_matrix[i];
+}
+
+SoftBayerPipeHandler::~SoftBayerPipeHandler ()
+{
+}
+
+bool
+SoftBayerPipeHandler::set_blc_config (const XCam3aResultBlackLevel &blc)
+{
+    SmartLock locker (_config_mutex);
+    _blc = blc;
+    _config_dirty = true;
+    return true;
+}
+
+bool
+SoftBayerPipeHandler::set_wb_config (const XCam3aResultWhiteBalance &wb)
+{
+    SmartLock locker (_config_mutex);
+    _wb = wb;
+    _config_dirty = true;
+    return true;
+}
+
+bool
+SoftBayerPipeHandler::set_gamma_table (const XCam3aResultGammaTable &gamma)
+{
+    SmartLock locker (_config_mutex);
+    _gamma = gamma;
+    _config_dirty = true;
+    return true;
+}
+
+bool
+SoftBayerPipeHandler::set_color_matrix (const XCam3aResultColorMatrix &ccm)
+{
+    SmartLock locker (_config_mutex);
+    _ccm = ccm;
+    _config_dirty = true;
+    return true;
+}
+
+bool
+SoftBayerPipeHandler::set_rgbtoyuv_matrix (const XCam3aResultColorMatrix &matrix)
+{
+    SmartLock locker (_config_mutex);
+    _rgb2yuv = matrix;
+    _config_dirty = true;
+    return true;
+}
+
+void
+SoftBayerPipeHandler::set_demosaic_mode (SoftDemosaicMode mode)
+{
+    SmartLock locker (_config_mutex);
+    _demosaic_mode = mode;
+    _config_dirty = true;
+}
+
+XCamReturn
+SoftBayerPipeHandler::apply_3a_results (X3aResultList &results)
+{
+    XCamReturn ret = XCAM_RETURN_NO_ERROR;
+
+    for (X3aResultList::iterator iter = results.begin (); iter != results.end (); ++iter)
+    {
+        SmartPtr<X3aResult> &result = *iter;
+        ret = apply_3a_result (result);
+        if (ret != XCAM_RETURN_NO_ERROR)
+            break;
+    }
+    return ret;
+}
+
+XCamReturn
+SoftBayerPipeHandler::apply_3a_result (SmartPtr<X3aResult> &result)
+{
+    if (result.ptr() == NULL)
+        return XCAM_RETURN_BYPASS;
+
+    uint32_t res_type = result->get_type ();
+
+    switch (res_type) {
+    case XCAM_3A_RESULT_WHITE_BALANCE: {
+        SmartPtr<X3aWhiteBalanceResult> wb_res = result.dynamic_cast_ptr<X3aWhiteBalanceResult> ();
+        XCAM_ASSERT (wb_res.ptr ());
+        set_wb_config (wb_res->get_standard_result ());
+        break;
+    }
+
+    case XCAM_3A_RESULT_BLACK_LEVEL: {
+        SmartPtr<X3aBlackLevelResult> bl_res = result.dynamic_cast_ptr<X3aBlackLevelResult> ();
+        XCAM_ASSERT (bl_res.ptr ());
+        set_blc_config (bl_res->get_standard_result ());
+        break;
+    }
+
+    case XCAM_3A_RESULT_RGB2YUV_MATRIX: {
+        SmartPtr<X3aColorMatrixResult> csc_res = result.dynamic_cast_ptr<X3aColorMatrixResult> ();
+        XCAM_ASSERT (csc_res.ptr ());
+        set_rgbtoyuv_matrix (csc_res->get_standard_result ());
+        break;
+    }
+
+    case XCAM_3A_RESULT_R_GAMMA:
+    case XCAM_3A_RESULT_B_GAMMA:
+        break;
+
+    case XCAM_3A_RESULT_G_GAMMA:
+    case XCAM_3A_RESULT_Y_GAMMA: {
+        SmartPtr<X3aGammaTableResult> gamma_res = result.dynamic_cast_ptr<X3aGammaTableResult> ();
+        XCAM_ASSERT (gamma_res.ptr ());
+        set_gamma_table (gamma_res->get_standard_result ());
+        break;
+    }
+
+    default:
+        XCAM_LOG_DEBUG ("SoftBayerPipeHandler(%s) ignored 3a result type:%d", XCAM_STR (get_name ()), res_type);
+        break;
+    }
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+SoftBayerPipeHandler::process (
+    const SmartPtr<VideoBuffer> &in,
+    SmartPtr<VideoBuffer> &out_buf)
+{
+    SmartPtr<ImageHandler::Parameters> param = new ImageHandler::Parameters (in, out_buf);
+    XCamReturn ret = execute_buffer (param, true);
+    if (xcam_ret_is_ok (ret) && !out_buf.ptr ()) {
+        out_buf = param->out_buf;
+    }
+
+    return ret;
+}
+
+XCamReturn
+SoftBayerPipeHandler::configure_resource (const SmartPtr<Parameters> &param)
+{
+    const VideoBufferInfo &in_info = param->in_buf->get_video_info ();
+    uint32_t channel_map[2][2];
+
+    XCAM_FAIL_RETURN (
+        ERROR, get_bayer_channel_map (in_info.format, channel_map), XCAM_RETURN_ERROR_PARAM,
+        "SoftBayerPipeHandler(%s) unsupported input format:%s",
+        XCAM_STR (get_name ()), xcam_fourcc_to_string (in_info.format));
+    XCAM_FAIL_RETURN (
+        ERROR, in_info.width % 2 == 0 && in_info.height % 2 == 0 && in_info.height >= 2,
+        XCAM_RETURN_ERROR_PARAM,
+        "SoftBayerPipeHandler(%s) input size(%dx%d) must be even",
+        XCAM_STR (get_name ()), in_info.width, in_info.height);
+
+    VideoBufferInfo out_info;
+    out_info.init (
+        V4L2_PIX_FMT_NV12, in_info.width, in_info.height,
+        XCAM_ALIGN_UP (in_info.width, XCAM_SOFT_BAYER_ALIGNMENT_X),
+        XCAM_ALIGN_UP (in_info.height, XCAM_SOFT_BAYER_ALIGNMENT_Y));
+    set_out_video_info (out_info);
+
+    {
+        SmartLock locker (_config_mutex);
+        _in_format = in_info.format;
+        _in_bits = in_info.color_bits;
+        _config_dirty = true;
+    }
+
+    XCAM_ASSERT (!_bayer_task.ptr ());
+    _bayer_task = new BayerPipeTask (new CbBayerPipeTask (this));
+    XCAM_ASSERT (_bayer_task.ptr ());
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+SmartPtr<BayerPipeConfig>
+SoftBayerPipeHandler::create_config ()
+{
+    SmartPtr<BayerPipeConfig> config = new BayerPipeConfig;
+    XCAM_ASSERT (config.ptr ());
+
+    get_bayer_channel_map (_in_format, config->channel_map);
+    config->in_bytes = (_in_bits > 8 ? 2 : 1);
+    uint32_t lut_bits = XCAM_MIN (_in_bits, (uint32_t)XCAM_SOFT_BAYER_LINEAR_BITS);
+    uint32_t lut_size = 1 << lut_bits;
+    config->in_shift = _in_bits - lut_bits;
+    config->in_mask = lut_size - 1;
+    config->edge_aware = (_demosaic_mode == SoftDemosaicEdgeAware);
+
+    const double levels[BayerChannelMax] = {_blc.r_level, _blc.gr_level, _blc.gb_level, _blc.b_level};
+    const double gains[BayerChannelMax] = {_wb.r_gain, _wb.gr_gain, _wb.gb_gain, _wb.b_gain};
+    for (uint32_t c = 0; c < BayerChannelMax; ++c) {
+        for (uint32_t i = 0; i < lut_size; ++i) {
+            double v = ((double)i / (lut_size - 1) - levels[c]) * gains[c];
+            v = XCAM_CLAMP (v, 0.0, 1.0);
+            config->pre_lut[c][i] = (uint16_t)(v * XCAM_SOFT_BAYER_LINEAR_MAX + 0.5);
+        }
+    }
+
+    for (uint32_t i = 0; i < XCAM_SOFT_BAYER_LINEAR_SIZE; ++i) {
+        double pos = (double)i * (XCAM_GAMMA_TABLE_SIZE - 1) / XCAM_SOFT_BAYER_LINEAR_MAX;
+        uint32_t idx = (uint32_t)pos;
+        uint32_t next = XCAM_MIN (idx + 1, (uint32_t)(XCAM_GAMMA_TABLE_SIZE - 1));
+        double frac = pos - idx;
+        double v = _gamma.table[idx] * (1.0 - frac) + _gamma.table[next] * frac;
+        v = XCAM_CLAMP (v, 0.0, 255.0);
+        config->gamma_lut[i] = (Uchar)(v + 0.5);
+    }
+
+    for (uint32_t i = 0; i < XCAM_COLOR_MATRIX_SIZE; ++i) {
+        config->ccm[i] = double_to_fixed (_ccm.matrix[i], XCAM_SOFT_BAYER_CCM_FIX_BITS);
+        config->rgb2yuv[i] = double_to_fixed (_rgb2yuv.matrix[i], XCAM_SOFT_BAYER_CSC_FIX_BITS);
+    }
+
+    return config;
+}
+
+SmartPtr<BayerPipeConfig>
+SoftBayerPipeHandler::get_config ()
+{
+    SmartLock locker (_config_mutex);
+
+    // frames in flight keep their own snapshot, rebuild only when settings changed
+    if (_config_dirty || !_config.ptr ()) {
+        _config = create_config ();
+        _config_dirty = false;
+    }
+    return _config;
+}
+
+XCamReturn
+SoftBayerPipeHandler::start_work (const SmartPtr<ImageHandler::Parameters> &param)
+{
+    XCAM_ASSERT (_bayer_task.ptr ());
+    XCAM_ASSERT (param->in_buf.ptr () && param->out_buf.ptr ());
+
+    SmartPtr<BayerPipeTask::Args> args = new BayerPipeTask::Args (param);
+    args->in_raw = new UcharImage (param->in_buf, 0);
+    args->out_luma = new UcharImage (param->out_buf, 0);
+    args->out_uv = new UcharImage (param->out_buf, 1);
+    args->config = get_config ();
+
+    WorkSize work_unit = _bayer_task->get_work_uint ();
+    WorkSize global_size (1, xcam_ceil (args->out_luma->get_height (), work_unit.value[1]) / work_unit.value[1]);
+    WorkSize local_size (1, xcam_ceil (global_size.value[1], XCAM_SOFT_BAYER_THREADS) / XCAM_SOFT_BAYER_THREADS);
+    _bayer_task->set_local_size (local_size);
+    _bayer_task->set_global_size (global_size);
+
+    param->in_buf.release ();
+    XCamReturn ret = _bayer_task->work (args);
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "SoftBayerPipeHandler(%s) start_work failed", XCAM_STR (get_name ()));
+
+    return ret;
+}
+
+XCamReturn
+SoftBayerPipeHandler::terminate ()
+{
+    if (_bayer_task.ptr ()) {
+        _bayer_task->stop ();
+        _bayer_task.release ();
+    }
+    return SoftHandler::terminate ();
+}
+
+void
+SoftBayerPipeHandler::bayer_task_done (
+    const SmartPtr<Worker> &worker, const SmartPtr<Worker::Arguments> &base, const XCamReturn error)
+{
+    XCAM_UNUSED (worker);
+    XCAM_ASSERT (worker.ptr () == _bayer_task.ptr ());
+
+    SmartPtr<BayerPipeTask::Args> args = base.dynamic_cast_ptr<BayerPipeTask::Args> ();
+    XCAM_ASSERT (args.ptr ());
+
+    const SmartPtr<ImageHandler::Parameters> param = args->get_param ();
+    if (!check_work_continue (param, error))
+        return;
+
+    work_well_done (param, error);
+}
+
+SmartPtr<SoftHandler>
+create_soft_bayer_pipe_handler ()
+{
+    SmartPtr<SoftHandler> bayer_pipe = new SoftBayerPipeHandler ();
+    XCAM_ASSERT (bayer_pipe.ptr ());
+
+    return bayer_pipe;
+}
+
+}
@@ -0,0 +1,103 @@
+/*
+ * soft_bayer_pipe_handler.h - soft bayer pipe handler class
+ *
+ *  Copyright (c) 2017 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#ifndef XCAM_SOFT_BAYER_PIPE_HANDLER_H
+#define XCAM_SOFT_BAYER_PIPE_HANDLER_H
+
+#include <xcam_std.h>
+#include <xcam_mutex.h>
+#include <x3a_result.h>
+#include <soft/soft_handler.h>
+
+#define XCAM_SOFT_BLC_DEFAULT_LEVEL 0.06
+
+namespace XCam {
+
+namespace XCamSoftTasks {
+class BayerPipeTask;
+struct BayerPipeConfig;
+};
+
+enum SoftDemosaicMode {
+    SoftDemosaicBilinear = 0,
+    SoftDemosaicEdgeAware,
+};
+
+/* raw bayer(8/10/12/16 bits) to NV12 in one pass:
+ * black level -> white balance -> demosaic -> color correction -> gamma -> rgb to yuv
+ */
+class SoftBayerPipeHandler
+    : public SoftHandler
+{
+public:
+    SoftBayerPipeHandler (const char *name = "SoftBayerPipeHandler");
+    ~SoftBayerPipeHandler ();
+
+    bool set_blc_config (const XCam3aResultBlackLevel &blc);
+    bool set_wb_config (const XCam3aResultWhiteBalance &wb);
+    bool set_gamma_table (const XCam3aResultGammaTable &gamma);
+    bool set_color_matrix (const XCam3aResultColorMatrix &ccm);
+    bool set_rgbtoyuv_matrix (const XCam3aResultColorMatrix &matrix);
+    void set_demosaic_mode (SoftDemosaicMode mode);
+
+    XCamReturn apply_3a_results (X3aResultList &results);
+    XCamReturn apply_3a_result (SmartPtr<X3aResult> &result);
+
+    XCamReturn process (
+        const SmartPtr<VideoBuffer> &in,
+        SmartPtr<VideoBuffer> &out_buf);
+
+    //derived from SoftHandler
+    virtual XCamReturn terminate ();
+
+    void bayer_task_done (
+        const SmartPtr<Worker> &worker, const SmartPtr<Worker::Arguments> &args, const XCamReturn error);
+
+protected:
+    //derived from SoftHandler
+    XCamReturn configure_resource (const SmartPtr<Parameters> &param);
+    XCamReturn start_work (const SmartPtr<Parameters> &param);
+
+private:
+    SmartPtr<XCamSoftTasks::BayerPipeConfig> get_config ();
+    SmartPtr<XCamSoftTasks::BayerPipeConfig> create_config ();
+
+private:
+    XCAM_DEAD_COPY (SoftBayerPipeHandler);
+
+private:
+    Mutex                                       _config_mutex;
+    bool                                        _config_dirty;
+    XCam3aResultBlackLevel                      _blc;
+    XCam3aResultWhiteBalance                    _wb;
+    XCam3aResultGammaTable                      _gamma;
+    XCam3aResultColorMatrix                     _ccm;
+    XCam3aResultColorMatrix                     _rgb2yuv;
+    SoftDemosaicMode                            _demosaic_mode;
+    uint32_t                                    _in_format;
+    uint32_t                                    _in_bits;
+    SmartPtr<XCamSoftTasks::BayerPipeConfig>    _config;
+    SmartPtr<XCamSoftTasks::BayerPipeTask>      _bayer_task;
+};
+
+extern SmartPtr<SoftHandler> create_soft_bayer_pipe_handler ();
+
+}
+#endif //XCAM_SOFT_BAYER_PIPE_HANDLER_H
@@ -0,0 +1,308 @@
+/*
+ * soft_bayer_tasks_priv.cpp - soft bayer pipe tasks implementation
+ *
+ *  Copyright (c) 2017 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#include "soft_bayer_tasks_priv.h"
+
+#define BAYER_RING_LINES 4
+
+namespace XCam {
+
+namespace XCamSoftTasks {
+
+BayerPipeConfig::BayerPipeConfig ()
+    : in_bytes (1)
+    , in_shift (0)
+    , in_mask (0)
+    , edge_aware (false)
+{
+    xcam_mem_clear (channel_map);
+    xcam_mem_clear (pre_lut);
+    xcam_mem_clear (ccm);
+    xcam_mem_clear (rgb2yuv);
+    xcam_mem_clear (gamma_lut);
+}
+
+bool
+get_bayer_channel_map (uint32_t format, uint32_t map[2][2])
+{
+    switch (format) {
+    case V4L2_PIX_FMT_SBGGR8:
+    case V4L2_PIX_FMT_SBGGR10:
+    case V4L2_PIX_FMT_SBGGR12:
+    case V4L2_PIX_FMT_SBGGR16:
+        map[0][0] = BayerChannelB;
+        map[0][1] = BayerChannelGb;
+        map[1][0] = BayerChannelGr;
+        map[1][1] = BayerChannelR;
+        break;
+    case V4L2_PIX_FMT_SGBRG8:
+    case V4L2_PIX_FMT_SGBRG10:
+    case V4L2_PIX_FMT_SGBRG12:
+        map[0][0] = BayerChannelGb;
+        map[0][1] = BayerChannelB;
+        map[1][0] = BayerChannelR;
+        map[1][1] = BayerChannelGr;
+        break;
+    case V4L2_PIX_FMT_SGRBG8:
+    case V4L2_PIX_FMT_SGRBG10:
+    case V4L2_PIX_FMT_SGRBG12:
+    case XCAM_PIX_FMT_SGRBG16:
+        map[0][0] = BayerChannelGr;
+        map[0][1] = BayerChannelR;
+        map[1][0] = BayerChannelB;
+        map[1][1] = BayerChannelGb;
+        break;
+    case V4L2_PIX_FMT_SRGGB8:
+    case V4L2_PIX_FMT_SRGGB10:
+    case V4L2_PIX_FMT_SRGGB12:
+        map[0][0] = BayerChannelR;
+        map[0][1] = BayerChannelGr;
+        map[1][0] = BayerChannelGb;
+        map[1][1] = BayerChannelB;
+        break;
+    default:
+        return false;
+    }
+    return true;
+}
+
+static inline int32_t
+clamp_linear (const int32_t v)
+{
+    return v < 0 ? 0 : (v > XCAM_SOFT_BAYER_LINEAR_MAX ? XCAM_SOFT_BAYER_LINEAR_MAX : v);
+}
+
+static inline Uchar
+clamp_to_uchar (const int32_t v)
+{
+    return (Uchar)(v < 0 ? 0 : (v > 255 ? 255 : v));
+}
+
+static inline int32_t
+abs_diff (const int32_t a, const int32_t b)
+{
+    return a > b ? a - b : b - a;
+}
+
+// mirror keeps bayer parity, -1 -> 1, len -> len - 2
+static inline uint32_t
+mirror_pos (const int32_t pos, const uint32_t len)
+{
+    if (pos < 0)
+        return -pos;
+    if (pos >= (int32_t)len)
+        return 2 * len - 2 - pos;
+    return pos;
+}
+
+// line has 1 pixel border on both sides
+static void
+preprocess_line (
+    const BayerPipeConfig &config, const Uchar *raw, const uint32_t parity,
+    uint16_t *line, const uint32_t width)
+{
+    const uint16_t *lut_even = config.pre_lut[config.channel_map[parity][0]];
+    const uint16_t *lut_odd = config.pre_lut[config.channel_map[parity][1]];
+    uint16_t *out = line + 1;
+
+    if (config.in_bytes == 1) {
+        for (uint32_t x = 0; x < width; x += 2) {
+            out[x] = lut_even[raw[x]];
+            out[x + 1] = lut_odd[raw[x + 1]];
+        }
+    } else {
+        const uint16_t *raw16 = (const uint16_t *)raw;
+        const uint32_t shift = config.in_shift, mask = config.in_mask;
+        for (uint32_t x = 0; x < width; x += 2) {
+            out[x] = lut_even[(raw16[x] >> shift) & mask];
+            out[x + 1] = lut_odd[(raw16[x + 1] >> shift) & mask];
+        }
+    }
+
+    out[-1] = out[1];
+    out[width] = out[width - 2];
+}
+
+static inline void
+green_pixel (
+    const uint16_t *above, const uint16_t *cur, const uint16_t *below, const int32_t x,
+    const bool red_line, int32_t &r, int32_t &g, int32_t &b)
+{
+    int32_t h = (cur[x - 1] + cur[x + 1] + 1) >> 1;
+    int32_t v = (above[x] + below[x] + 1) >> 1;
+    g = cur[x];
+    r = red_line ? h : v;
+    b = red_line ? v : h;
+}
+
+static inline void
+color_pixel (
+    const uint16_t *above, const uint16_t *cur, const uint16_t *below, const int32_t x,
+    const bool is_red, const bool edge_aware, int32_t &r, int32_t &g, int32_t &b)
+{
+    int32_t green = (cur[x - 1] + cur[x + 1] + above[x] + below[x] + 2) >> 2;
+    if (edge_aware) {
+        int32_t dh = abs_diff (cur[x - 1], cur[x + 1]);
+        int32_t dv = abs_diff (above[x], below[x]);
+        if (dh < dv)
+            green = (cur[x - 1] + cur[x + 1] + 1) >> 1;
+        else if (dv < dh)
+            green = (above[x] + below[x] + 1) >> 1;
+    }
+    int32_t cross = (above[x - 1] + above[x + 1] + below[x - 1] + below[x + 1] + 2) >> 2;
+
+    g = green;
+    r = is_red ? cur[x] : cross;
+    b = is_red ? cross : cur[x];
+}
+
+static void
+demosaic_line (
+    const BayerPipeConfig &config, const uint32_t parity,
+    const uint16_t *above, const uint16_t *cur, const uint16_t *below,
+    int32_t *r, int32_t *g, int32_t *b, const uint32_t width)
+{
+    const uint32_t ch_even = config.channel_map[parity][0];
+    const uint32_t ch_odd = config.channel_map[parity][1];
+    const bool edge_aware = config.edge_aware;
+
+    // skip left border
+    ++above;
+    ++cur;
+    ++below;
+
+    if (ch_even == BayerChannelGr || ch_even == BayerChannelGb) {
+        const bool red_line = (ch_odd == BayerChannelR);
+        for (uint32_t x = 0; x < width; x += 2) {
+            green_pixel (above, cur, below, x, red_line, r[x], g[x], b[x]);
+            color_pixel (above, cur, below, x + 1, red_line, edge_aware, r[x + 1], g[x + 1], b[x + 1]);
+        }
+    } else {
+        const bool red_line = (ch_even == BayerChannelR);
+        for (uint32_t x = 0; x < width; x += 2) {
+            color_pixel (above, cur, below, x, red_line, edge_aware, r[x], g[x], b[x]);
+            green_pixel (above, cur, below, x + 1, red_line, r[x + 1], g[x + 1], b[x + 1]);
+        }
+    }
+}
+
+static void
+ccm_gamma_line (
+    const BayerPipeConfig &config,
+    const int32_t *r, const int32_t *g, const int32_t *b,
+    Uchar *r8, Uchar *g8, Uchar *b8, const uint32_t width)
+{
+    const int32_t *m = config.ccm;
+    const int32_t round = 1 << (XCAM_SOFT_BAYER_CCM_FIX_BITS - 1);
+
+    for (uint32_t x = 0; x < width; ++x) {
+        int32_t rr = (m[0] * r[x] + m[1] * g[x] + m[2] * b[x] + round) >> XCAM_SOFT_BAYER_CCM_FIX_BITS;
+        int32_t gg = (m[3] * r[x] + m[4] * g[x] + m[5] * b[x] + round) >> XCAM_SOFT_BAYER_CCM_FIX_BITS;
+        int32_t bb = (m[6] * r[x] + m[7] * g[x] + m[8] * b[x] + round) >> XCAM_SOFT_BAYER_CCM_FIX_BITS;
+        r8[x] = config.gamma_lut[clamp_linear (rr)];
+        g8[x] = config.gamma_lut[clamp_linear (gg)];
+        b8[x] = config.gamma_lut[clamp_linear (bb)];
+    }
+}
+
+static void
+rgb_to_nv12_lines (
+    const BayerPipeConfig &config, const Uchar *rgb0[3], const Uchar *rgb1[3],
+    Uchar *luma0, Uchar *luma1, Uchar *uv, const uint32_t width)
+{
+    const int32_t *m = config.rgb2yuv;
+    const int32_t round = 1 << (XCAM_SOFT_BAYER_CSC_FIX_BITS - 1);
+
+    for (uint32_t x = 0; x < width; ++x) {
+        luma0[x] = clamp_to_uchar (
+                       (m[0] * rgb0[0][x] + m[1] * rgb0[1][x] + m[2] * rgb0[2][x] + round) >> XCAM_SOFT_BAYER_CSC_FIX_BITS);
+        luma1[x] = clamp_to_uchar (
+                       (m[0] * rgb1[0][x] + m[1] * rgb1[1][x] + m[2] * rgb1[2][x] + round) >> XCAM_SOFT_BAYER_CSC_FIX_BITS);
+    }
+
+    for (uint32_t x = 0; x < width; x += 2) {
+        int32_t sum_r = rgb0[0][x] + rgb0[0][x + 1] + rgb1[0][x] + rgb1[0][x + 1];
+        int32_t sum_g = rgb0[1][x] + rgb0[1][x + 1] + rgb1[1][x] + rgb1[1][x + 1];
+        int32_t sum_b = rgb0[2][x] + rgb0[2][x + 1] + rgb1[2][x] + rgb1[2][x + 1];
+        // sums are 4x of average, shift 2 more bits
+        uv[x] = clamp_to_uchar (
+                    ((m[3] * sum_r + m[4] * sum_g + m[5] * sum_b + (round << 2)) >> (XCAM_SOFT_BAYER_CSC_FIX_BITS + 2)) + 128);
+        uv[x + 1] = clamp_to_uchar (
+                        ((m[6] * sum_r + m[7] * sum_g + m[8] * sum_b + (round << 2)) >> (XCAM_SOFT_BAYER_CSC_FIX_BITS + 2)) + 128);
+    }
+}
+
+XCamReturn
+BayerPipeTask::work_range (const SmartPtr<Arguments> &base, const WorkRange &range)
+{
+    SmartPtr<BayerPipeTask::Args> args = base.dynamic_cast_ptr<BayerPipeTask::Args> ();
+    XCAM_ASSERT (args.ptr ());
+    UcharImage *in_raw = args->in_raw.ptr ();
+    UcharImage *out_luma = args->out_luma.ptr (), *out_uv = args->out_uv.ptr ();
+    XCAM_ASSERT (in_raw && out_luma && out_uv);
+    XCAM_ASSERT (args->config.ptr ());
+    const BayerPipeConfig &config = *args->config.ptr ();
+
+    const uint32_t width = out_luma->get_width ();
+    const uint32_t height = out_luma->get_height ();
+    XCAM_ASSERT (width % 2 == 0 && height % 2 == 0);
+
+    const uint32_t line_len = width + 2;
+    std::vector<uint16_t> ring (line_len * BAYER_RING_LINES);
+    std::vector<int32_t> linear (width * 3);
+    std::vector<Uchar> rgb8 (width * 3 * 2);
+
+    int32_t *r = &linear[0], *g = r + width, *b = g + width;
+    const Uchar *rgb0[3] = {&rgb8[0], &rgb8[width], &rgb8[width * 2]};
+    const Uchar *rgb1[3] = {&rgb8[width * 3], &rgb8[width * 4], &rgb8[width * 5]};
+
+    int32_t next_line = (int32_t)range.pos[1] * 2 - 1;
+    for (uint32_t y = range.pos[1]; y < range.pos[1] + range.pos_len[1]; ++y) {
+        // lines from 2y-1 to 2y+2 are needed by this line pair
+        for (; next_line <= (int32_t)y * 2 + 2; ++next_line) {
+            uint32_t src_y = mirror_pos (next_line, height);
+            uint16_t *line = &ring[((next_line + BAYER_RING_LINES) % BAYER_RING_LINES) * line_len];
+            preprocess_line (config, in_raw->get_buf_ptr (0, src_y), src_y % 2, line, width);
+        }
+
+        for (uint32_t i = 0; i < 2; ++i) {
+            int32_t cur_y = y * 2 + i;
+            const uint16_t *above = &ring[((cur_y - 1 + BAYER_RING_LINES) % BAYER_RING_LINES) * line_len];
+            const uint16_t *cur = &ring[(cur_y % BAYER_RING_LINES) * line_len];
+            const uint16_t *below = &ring[((cur_y + 1) % BAYER_RING_LINES) * line_len];
+            Uchar *out_rgb = &rgb8[width * 3 * i];
+
+            demosaic_line (config, cur_y % 2, above, cur, below, r, g, b, width);
+            ccm_gamma_line (config, r, g, b, out_rgb, out_rgb + width, out_rgb + width * 2, width);
+        }
+
+        rgb_to_nv12_lines (
+            config, rgb0, rgb1,
+            out_luma->get_buf_ptr (0, y * 2), out_luma->get_buf_ptr (0, y * 2 + 1),
+            out_uv->get_buf_ptr (0, y), width);
+    }
+
+    XCAM_LOG_DEBUG ("BayerPipeTask work on range:[y:%d, height:%d]", range.pos[1], range.pos_len[1]);
+    return XCAM_RETURN_NO_ERROR;
+}
+
+}
+
+}
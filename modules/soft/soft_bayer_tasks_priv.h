@@ -0,0 +1,104 @@
+/*
+ * soft_bayer_tasks_priv.h - soft bayer pipe tasks
+ *
+ *  Copyright (c) 2017 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#ifndef XCAM_SOFT_BAYER_TASKS_PRIV_H
+#define XCAM_SOFT_BAYER_TASKS_PRIV_H
+
+#include <xcam_std.h>
+#include <soft/soft_worker.h>
+#include <soft/soft_image.h>
+#include <soft/soft_handler.h>
+
+// linear domain bits after black level and white balance
+#define XCAM_SOFT_BAYER_LINEAR_BITS 12
+#define XCAM_SOFT_BAYER_LINEAR_SIZE (1 << XCAM_SOFT_BAYER_LINEAR_BITS)
+#define XCAM_SOFT_BAYER_LINEAR_MAX (XCAM_SOFT_BAYER_LINEAR_SIZE - 1)
+
+#define XCAM_SOFT_BAYER_CCM_FIX_BITS 10
+#define XCAM_SOFT_BAYER_CSC_FIX_BITS 14
+
+namespace XCam {
+
+namespace XCamSoftTasks {
+
+enum BayerChannel {
+    BayerChannelR = 0,
+    BayerChannelGr,
+    BayerChannelGb,
+    BayerChannelB,
+    BayerChannelMax
+};
+
+// map[line parity][column parity] to BayerChannel, false if format is not bayer
+bool get_bayer_channel_map (uint32_t format, uint32_t map[2][2]);
+
+/* immutable snapshot of all pipe settings, built by handler and shared by all work items of a frame.
+ * pre_lut merges black level and white balance gain of each bayer channel,
+ * gamma_lut maps linear domain to 8 bits.
+ */
+struct BayerPipeConfig {
+    uint32_t        channel_map[2][2];
+    uint32_t        in_bytes;
+    uint32_t        in_shift;
+    uint32_t        in_mask;
+    bool            edge_aware;
+    uint16_t        pre_lut[BayerChannelMax][XCAM_SOFT_BAYER_LINEAR_SIZE];
+    int32_t         ccm[9];
+    int32_t         rgb2yuv[9];
+    Uchar           gamma_lut[XCAM_SOFT_BAYER_LINEAR_SIZE];
+
+    BayerPipeConfig ();
+};
+
+/* each work item takes a band of line pairs, bayer lines are pre-processed once into a 4-line ring,
+ * then demosaic, ccm, gamma and rgb to nv12 are done line by line on per-band buffers,
+ * no full frame intermediate buffer is used.
+ */
+class BayerPipeTask
+    : public SoftWorker
+{
+public:
+    struct Args : SoftArgs {
+        SmartPtr<UcharImage>        in_raw;
+        SmartPtr<UcharImage>        out_luma;
+        SmartPtr<UcharImage>        out_uv;
+        SmartPtr<BayerPipeConfig>   config;
+
+        Args (const SmartPtr<ImageHandler::Parameters> &param)
+            : SoftArgs (param)
+        {}
+    };
+
+public:
+    explicit BayerPipeTask (const SmartPtr<Worker::Callback> &cb)
+        : SoftWorker ("BayerPipeTask", cb)
+    {
+        set_work_uint (1, 2);
+    }
+
+private:
+    virtual XCamReturn work_range (const SmartPtr<Arguments> &args, const WorkRange &range);
+};
+
+}
+
+}
+
+#endif //XCAM_SOFT_BAYER_TASKS_PRIV_H
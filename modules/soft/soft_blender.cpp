@@ -25,10 +25,16 @@
 #include "soft_blender_tasks_priv.h"
 #include "image_file_handle.h"
 #include "soft_video_buf_allocator.h"
+#include "soft_seam_finder.h"
 #include <map>
 
 #define OVERLAP_POOL_SIZE 6
 #define LAP_POOL_SIZE 4
+// gauss buffers of both inputs and blended buffer kept by output level
+#define OUTPUT_LEVEL_BUF_COUNT 3
+
+// width of blend band around the seam, in full level
+#define SEAM_BAND_WIDTH 32
 
 #define DUMP_BLENDER 0
 
@@ -69,26 +75,37 @@ blend[N] = blend (Ga[N)], Gb[N)])
  */
 class BlenderPrivConfig {
 public:
-    PyramidResource        pyr_layer[XCAM_SOFT_PYRAMID_MAX_LEVEL];
+    // sized by pyr_levels in configure_resource
+    std::vector<PyramidResource>  pyr_layer;
     uint32_t               pyr_levels;
+    uint32_t               blend_width;
     SmartPtr<BlendTask>    last_level_blend;
     SmartPtr<BufferPool>   first_lap_pool;
     SmartPtr<UcharImage>   orig_mask;
+    uint32_t               output_level;
 
     Mutex                  map_args_mutex;
     MapBlendArgs           blend_args;
 
+    // masks are replaced(not modified) on seam update, read them with mask_mutex
+    SmartPtr<SoftSeamFinder>  seam_finder;
+    Mutex                     mask_mutex;
+
 private:
     SoftBlender           *_blender;
 
 public:
     BlenderPrivConfig (SoftBlender *blender, uint32_t level)
         : pyr_levels (level)
+        , blend_width (0)
+        , output_level (0)
         , _blender (blender)
     {}
 
     XCamReturn init_first_masks (uint32_t width, uint32_t height);
     XCamReturn scale_down_masks (uint32_t level, uint32_t width, uint32_t height);
+    XCamReturn update_seam_masks (const SmartPtr<UcharImage> &luma0, const SmartPtr<UcharImage> &luma1);
+    SmartPtr<UcharImage> get_mask (uint32_t level);
 
     XCamReturn start_scaler (
         const SmartPtr<ImageHandler::Parameters> &param,
@@ -181,6 +198,43 @@ SoftBlender::~SoftBlender ()
 {
 }
 
+bool
+SoftBlender::enable_seam (bool enable)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, !_priv_config->last_level_blend.ptr (), false,
+        "blender:%s enable_seam failed, blender was already configured", XCAM_STR (get_name ()));
+
+    if (enable)
+        _priv_config->seam_finder = new SoftSeamFinder (SEAM_BAND_WIDTH);
+    else
+        _priv_config->seam_finder.release ();
+    return true;
+}
+
+bool
+SoftBlender::is_seam_enabled () const
+{
+    return _priv_config->seam_finder.ptr () != NULL;
+}
+
+bool
+SoftBlender::set_output_level (uint32_t level)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, !_priv_config->last_level_blend.ptr (), false,
+        "blender:%s set_output_level failed, blender was already configured", XCAM_STR (get_name ()));
+
+    _priv_config->output_level = level;
+    return true;
+}
+
+uint32_t
+SoftBlender::get_output_level () const
+{
+    return _priv_config->output_level;
+}
+
 bool
 SoftBlender::set_pyr_levels (uint32_t num)
 {
@@ -188,11 +242,37 @@ SoftBlender::set_pyr_levels (uint32_t num)
     XCAM_FAIL_RETURN (
         ERROR, num > 0, false,
         "blender:%s set_pyr_levels failed, level(%d) must > 0", XCAM_STR (get_name ()), num);
+    XCAM_FAIL_RETURN (
+        ERROR, !_priv_config->last_level_blend.ptr (), false,
+        "blender:%s set_pyr_levels failed, blender was already configured", XCAM_STR (get_name ()));
 
     _priv_config->pyr_levels = num;
     return true;
 }
 
+uint32_t
+SoftBlender::get_pyr_levels () const
+{
+    return _priv_config->pyr_levels;
+}
+
+bool
+SoftBlender::set_blend_width (uint32_t width)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, !_priv_config->last_level_blend.ptr (), false,
+        "blender:%s set_blend_width failed, blender was already configured", XCAM_STR (get_name ()));
+
+    _priv_config->blend_width = width;
+    return true;
+}
+
+uint32_t
+SoftBlender::get_blend_width () const
+{
+    return _priv_config->blend_width;
+}
+
 XCamReturn
 SoftBlender::terminate ()
 {
@@ -217,7 +297,7 @@ SoftBlender::blend (
 XCamReturn
 SoftBlenderPriv::BlenderPrivConfig::stop ()
 {
-    for (uint32_t i = 0; i < pyr_levels; ++i) {
+    for (uint32_t i = 0; i < pyr_layer.size (); ++i) {
         if (pyr_layer[i].scale_task[SoftBlender::Idx0].ptr ()) {
             pyr_layer[i].scale_task[SoftBlender::Idx0]->stop ();
             pyr_layer[i].scale_task[SoftBlender::Idx0].release ();
@@ -264,8 +344,12 @@ SoftBlenderPriv::BlenderPrivConfig::init_first_masks (uint32_t width, uint32_t h
     std::vector<Uchar> mask_line;
     uint32_t i = 0, j = 0;
 
-    uint32_t quater = width / 4;
-    XCAM_ASSERT (quater > 1);
+    // gauss ramp of 2 * quater + 1 pixels in the middle of mask
+    uint32_t quater = blend_width ? XCAM_MIN (blend_width / 2, (width - 1) / 2) : width / 4;
+    XCAM_FAIL_RETURN (
+        ERROR, quater > 1, XCAM_RETURN_ERROR_PARAM,
+        "blender:(%s) blend width(%d) of merge window(w:%d) is too small",
+        XCAM_STR (_blender->get_name ()), blend_width, width);
     get_gauss_table (quater, (quater + 1) / 4.0f, gauss_table, false);
     for (i = 0; i < gauss_table.size (); ++i) {
         float value = ((i < quater) ? (128.0f * (2.0f - gauss_table[i])) : (128.0f * gauss_table[i]));
@@ -295,6 +379,19 @@ SoftBlenderPriv::BlenderPrivConfig::init_first_masks (uint32_t width, uint32_t h
     return XCAM_RETURN_NO_ERROR;
 }
 
+static XCamReturn
+scale_down_mask (const SmartPtr<UcharImage> &in, const SmartPtr<UcharImage> &out)
+{
+    SmartPtr<GaussScaleGray::Args> args = new GaussScaleGray::Args;
+    args->in_luma = in;
+    args->out_luma = out;
+    SmartPtr<GaussScaleGray> worker = new GaussScaleGray;
+    WorkSize size ((args->out_luma->get_width () + 1) / 2, (args->out_luma->get_height () + 1) / 2);
+    worker->set_local_size (size);
+    worker->set_global_size (size);
+    return worker->work (args);
+}
+
 XCamReturn
 SoftBlenderPriv::BlenderPrivConfig::scale_down_masks (uint32_t level, uint32_t width, uint32_t height)
 {
@@ -304,23 +401,70 @@ SoftBlenderPriv::BlenderPrivConfig::scale_down_masks (uint32_t level, uint32_t w
     pyr_layer[level].coef_mask = new UcharImage (width, height);
     XCAM_ASSERT (pyr_layer[level].coef_mask.ptr ());
 
-    SmartPtr<GaussScaleGray::Args> args = new GaussScaleGray::Args;
-    if (level == 0) {
-        args->in_luma = orig_mask;
-    } else {
-        args->in_luma = pyr_layer[level - 1].coef_mask;
-    }
-    args->out_luma = pyr_layer[level].coef_mask;
-    SmartPtr<GaussScaleGray> worker = new GaussScaleGray;
-    WorkSize size ((args->out_luma->get_width () + 1) / 2, (args->out_luma->get_height () + 1) / 2);
-    worker->set_local_size (size);
-    worker->set_global_size (size);
-    XCamReturn ret = worker->work (args);
+    XCamReturn ret = scale_down_mask (
+        (level == 0) ? orig_mask : pyr_layer[level - 1].coef_mask, pyr_layer[level].coef_mask);
 
     dump_soft (pyr_layer[level].coef_mask, "mask", (int32_t)level);
     return ret;
 }
 
+SmartPtr<UcharImage>
+SoftBlenderPriv::BlenderPrivConfig::get_mask (uint32_t level)
+{
+    XCAM_ASSERT (level <= pyr_levels);
+    SmartLock locker (mask_mutex);
+    if (level == 0)
+        return orig_mask;
+    return pyr_layer[level - 1].coef_mask;
+}
+
+/* seam is found on luma of the last gauss level, only orig mask rows whose seam moved are rewritten,
+ * then all levels are scaled down again into new masks, frames in processing keep the old ones.
+ */
+XCamReturn
+SoftBlenderPriv::BlenderPrivConfig::update_seam_masks (
+    const SmartPtr<UcharImage> &luma0, const SmartPtr<UcharImage> &luma1)
+{
+    XCAM_ASSERT (seam_finder.ptr ());
+
+    Rect merge_window = _blender->get_merge_window ();
+    uint32_t width = merge_window.width, height = merge_window.height;
+    for (uint32_t i = 0; i < pyr_levels; ++i) {
+        width = (width + 1) / 2;
+        height = (height + 1) / 2;
+    }
+
+    // one update at a time, seam finder keeps state of last frame
+    SmartLock locker (mask_mutex);
+    XCamReturn ret = seam_finder->find_seam (luma0.ptr (), luma1.ptr (), width, height, 1 << pyr_levels);
+    XCAM_FAIL_RETURN (
+        WARNING, xcam_ret_is_ok (ret), ret,
+        "blender:(%s) find seam failed", XCAM_STR (_blender->get_name ()));
+
+    SmartPtr<UcharImage> new_orig;
+    uint32_t changed = seam_finder->update_mask (orig_mask, new_orig);
+    if (!changed)
+        return XCAM_RETURN_NO_ERROR;
+
+    std::vector<SmartPtr<UcharImage> > new_masks (pyr_levels);
+    for (uint32_t i = 0; i < pyr_levels; ++i) {
+        const SmartPtr<UcharImage> &last = pyr_layer[i].coef_mask;
+        new_masks[i] = new UcharImage (last->get_width (), last->get_height ());
+        ret = scale_down_mask ((i == 0) ? new_orig : new_masks[i - 1], new_masks[i]);
+        XCAM_FAIL_RETURN (
+            WARNING, xcam_ret_is_ok (ret), ret,
+            "blender:(%s) scale down seam mask failed, level:%d", XCAM_STR (_blender->get_name ()), i);
+    }
+
+    orig_mask = new_orig;
+    for (uint32_t i = 0; i < pyr_levels; ++i)
+        pyr_layer[i].coef_mask = new_masks[i];
+
+    XCAM_LOG_DEBUG (
+        "blender:(%s) seam masks updated, changed rows:%d", XCAM_STR (_blender->get_name ()), changed);
+    return XCAM_RETURN_NO_ERROR;
+}
+
 XCamReturn
 SoftBlenderPriv::BlenderPrivConfig::start_scaler (
     const SmartPtr<ImageHandler::Parameters> &param,
@@ -444,7 +588,7 @@ SoftBlenderPriv::BlenderPrivConfig::start_blend_task (
         SmartLock locker (map_args_mutex);
         MapBlendArgs::iterator i = blend_args.find (param.ptr ());
         if (i == blend_args.end ()) {
-            args = new BlendTask::Args (param, pyr_layer[last_level].coef_mask);
+            args = new BlendTask::Args (param, NULL);
             XCAM_ASSERT (args.ptr ());
             blend_args.insert (std::make_pair((void*)param.ptr (), args));
             XCAM_LOG_DEBUG ("soft_blender:%s init blender args", XCAM_STR (_blender->get_name ()));
@@ -464,6 +608,12 @@ SoftBlenderPriv::BlenderPrivConfig::start_blend_task (
     XCAM_ASSERT (args.ptr ());
     XCAM_ASSERT (args->in_luma[SoftBlender::Idx0]->get_width () == args->in_luma[SoftBlender::Idx1]->get_width ());
 
+    if (seam_finder.ptr ()) {
+        // keep blending with last masks if seam update failed
+        update_seam_masks (args->in_luma[SoftBlender::Idx0], args->in_luma[SoftBlender::Idx1]);
+    }
+    args->mask = get_mask (pyr_levels);
+
     XCAM_ASSERT (pyr_layer[last_level].overlap_pool.ptr ());
     SmartPtr<VideoBuffer> out_buf = pyr_layer[last_level].overlap_pool->get_buffer ();
     XCAM_FAIL_RETURN (
@@ -504,7 +654,7 @@ SoftBlenderPriv::BlenderPrivConfig::start_reconstruct_task (
     if (level == 0) {
         out_buf = args->get_param ()->out_buf;
         XCAM_ASSERT (out_buf.ptr ());
-        args->mask = orig_mask;
+        args->mask = get_mask (0);
 
         Rect out_area = _blender->get_merge_window ();
         const VideoBufferInfo &out_info = out_buf->get_video_info ();
@@ -525,7 +675,7 @@ SoftBlenderPriv::BlenderPrivConfig::start_reconstruct_task (
         XCAM_FAIL_RETURN (
             ERROR, out_buf.ptr (), XCAM_RETURN_ERROR_MEM,
             "blender:(%s) start_reconstruct_task failed, out buffer is empty.", XCAM_STR (_blender->get_name ()));
-        args->mask = pyr_layer[level - 1].coef_mask;
+        args->mask = get_mask (level);
         args->out_luma = new UcharImage (out_buf, 0);
         args->out_uv = new Uchar2Image (out_buf, 1);
     }
@@ -646,7 +796,11 @@ SoftBlender::start_work (const SmartPtr<ImageHandler::Parameters> &base)
 XCamReturn
 SoftBlender::configure_resource (const SmartPtr<Parameters> &param)
 {
-    XCAM_ASSERT (_priv_config->pyr_levels <= XCAM_SOFT_PYRAMID_MAX_LEVEL);
+    XCAM_FAIL_RETURN (
+        ERROR, _priv_config->output_level <= _priv_config->pyr_levels, XCAM_RETURN_ERROR_PARAM,
+        "blender:%s output level(%d) is larger than pyramid levels(%d)",
+        XCAM_STR(get_name ()), _priv_config->output_level, _priv_config->pyr_levels);
+
     const VideoBufferInfo &in0_info = param->in_buf->get_video_info ();
     XCAM_FAIL_RETURN (
         ERROR, in0_info.format == V4L2_PIX_FMT_NV12, XCAM_RETURN_ERROR_PARAM,
@@ -680,6 +834,13 @@ SoftBlender::configure_resource (const SmartPtr<Parameters> &param)
 
     VideoBufferInfo overlap_info;
     Rect merge_size = get_merge_window ();
+    XCAM_FAIL_RETURN (
+        ERROR,
+        (merge_size.width >> _priv_config->pyr_levels) > 0 && (merge_size.height >> _priv_config->pyr_levels) > 0,
+        XCAM_RETURN_ERROR_PARAM,
+        "blender:%s pyramid levels(%d) are too many for merge window(w:%d,h:%d)",
+        XCAM_STR(get_name ()), _priv_config->pyr_levels, merge_size.width, merge_size.height);
+    _priv_config->pyr_layer.resize (_priv_config->pyr_levels);
     //overlap_info.init (in0_info.format, merge_size.width, merge_size.height);
     XCAM_ASSERT (merge_size.width % SOFT_BLENDER_ALIGNMENT_X == 0);
 
@@ -710,8 +871,12 @@ SoftBlender::configure_resource (const SmartPtr<Parameters> &param)
         SmartPtr<BufferPool> pool = new SoftVideoBufAllocator (overlap_info);
         XCAM_ASSERT (pool.ptr ());
         _priv_config->pyr_layer[i].overlap_pool = pool;
+        // buffers of output level are held by users until next blend
+        uint32_t pool_size = OVERLAP_POOL_SIZE;
+        if (i + 1 == _priv_config->output_level)
+            pool_size += OUTPUT_LEVEL_BUF_COUNT;
         XCAM_FAIL_RETURN (
-            ERROR, _priv_config->pyr_layer[i].overlap_pool->reserve (OVERLAP_POOL_SIZE), XCAM_RETURN_ERROR_MEM,
+            ERROR, _priv_config->pyr_layer[i].overlap_pool->reserve (pool_size), XCAM_RETURN_ERROR_MEM,
             "blender:%s reserve buffer pool(w:%d,h:%d) failed",
             XCAM_STR(get_name ()), overlap_info.width, overlap_info.height);
 
@@ -760,6 +925,13 @@ SoftBlender::gauss_scale_done (
 
     dump_level_buf (args->out_buf, "gauss-scale", level, idx);
 
+    // gauss buffer of level is scaled down by 2^(level + 1)
+    if (next_level == _priv_config->output_level) {
+        SmartPtr<BlenderParam> blender_param = param.dynamic_cast_ptr<BlenderParam> ();
+        XCAM_ASSERT (blender_param.ptr ());
+        blender_param->gauss_bufs[idx] = args->out_buf;
+    }
+
     ret = _priv_config->start_lap_task (param, level, idx, args);//args->in_buf, args->out_buf);
     if (!xcam_ret_is_ok (ret)) {
         work_broken (param, ret);
@@ -819,6 +991,12 @@ SoftBlender::blend_task_done (
         return;
 
     dump_buf (args->out_buf, "blend-last");
+
+    if (_priv_config->output_level == _priv_config->pyr_levels) {
+        SmartPtr<BlenderParam> blender_param = param.dynamic_cast_ptr<BlenderParam> ();
+        XCAM_ASSERT (blender_param.ptr ());
+        blender_param->blended_buf = args->out_buf;
+    }
     ret = _priv_config->start_reconstruct_task_by_gauss (param, args->out_buf, _priv_config->pyr_levels - 1);
 
     if (!xcam_ret_is_ok (ret)) {
@@ -845,6 +1023,13 @@ SoftBlender::reconstruct_done (
 
     dump_level_buf (args->out_buf, "reconstruct", level, 0);
 
+    // reconstructed buffer of level(> 0) is scaled down by 2^level
+    if (level && level == _priv_config->output_level) {
+        SmartPtr<BlenderParam> blender_param = param.dynamic_cast_ptr<BlenderParam> ();
+        XCAM_ASSERT (blender_param.ptr ());
+        blender_param->blended_buf = args->out_buf;
+    }
+
     if (level == 0) {
         work_well_done (param, error);
         return;
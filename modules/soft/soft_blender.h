@@ -25,7 +25,6 @@
 #include <interface/blender.h>
 #include <soft/soft_handler.h>
 
-#define XCAM_SOFT_PYRAMID_MAX_LEVEL 4
 #define XCAM_SOFT_PYRAMID_DEFAULT_LEVEL 3
 
 namespace XCam {
@@ -40,8 +39,18 @@ class SoftBlender
     friend class SoftBlenderPriv::BlenderPrivConfig;
     friend SmartPtr<SoftHandler> create_soft_blender ();
 public:
+    enum BufIdx {
+        Idx0 = 0,
+        Idx1,
+        BufIdxCount,
+    };
+
     struct BlenderParam : ImageHandler::Parameters {
         SmartPtr<VideoBuffer> in1_buf;
+        // set by blender if output level is enabled, read only, scaled down by 2^level,
+        // gauss levels of both inputs and blended merge window
+        SmartPtr<VideoBuffer> gauss_bufs[BufIdxCount];
+        SmartPtr<VideoBuffer> blended_buf;
 
         BlenderParam (
             const SmartPtr<VideoBuffer> &in0,
@@ -52,16 +61,27 @@ public:
         {}
     };
 
-    enum BufIdx {
-        Idx0 = 0,
-        Idx1,
-        BufIdxCount,
-    };
-
 public:
     ~SoftBlender ();
 
+    // pyramid levels are only limited by merge window size, set before the first blend
     bool set_pyr_levels (uint32_t num);
+    uint32_t get_pyr_levels () const;
+
+    // width of transition band in mask of merge window, 0 means half of merge window width,
+    // set before the first blend
+    bool set_blend_width (uint32_t width);
+    uint32_t get_blend_width () const;
+
+    // blend in a narrow band around a seam found per frame instead of the whole overlap,
+    // set before the first blend
+    bool enable_seam (bool enable);
+    bool is_seam_enabled () const;
+
+    // keep pyramid buffers of level in BlenderParam instead of scaling again for other users,
+    // level is in [1, pyramid levels], 0 disables, set before the first blend
+    bool set_output_level (uint32_t level);
+    uint32_t get_output_level () const;
 
     //derived from SoftHandler
     virtual XCamReturn terminate ();
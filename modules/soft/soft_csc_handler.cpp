@@ -0,0 +1,233 @@
+/*
+ * soft_csc_handler.cpp - soft color space conversion handler implementation
+ *
+ *  Copyright (c) 2017 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#include "soft_csc_handler.h"
+#include "soft_csc_tasks_priv.h"
+
+#define XCAM_SOFT_CSC_ALIGNMENT_X 8
+#define XCAM_SOFT_CSC_ALIGNMENT_Y 2
+#define XCAM_SOFT_CSC_THREADS 4
+
+namespace XCam {
+
+DECLARE_WORK_CALLBACK (CbCscTask, SoftCscHandler, csc_task_done);
+
+static const double default_rgb_to_yuv_matrix[XCAM_COLOR_MATRIX_SIZE] = {
+    0.299, 0.587, 0.114,
+    -0.14713, -0.28886, 0.436,
+    0.615, -0.51499, -0.10001
+};
+
+static void
+matrix_to_fixed_point (const double *matrix, int32_t *coeffs)
+{
+    for (uint32_t i = 0; i < XCAM_COLOR_MATRIX_SIZE; ++i) {
+        double v = matrix[i] * (1 << XCAM_SOFT_CSC_FIX_BITS);
+        coeffs[i] = (int32_t)(v < 0.0 ? v - 0.5 : v + 0.5);
+    }
+}
+
+SoftCscHandler::SoftCscHandler (SoftCscType type, const char *name)
+    : SoftHandler (name)
+    , _type (type)
+{
+    matrix_to_fixed_point (default_rgb_to_yuv_matrix, _coeffs);
+}
+
+SoftCscHandler::~SoftCscHandler ()
+{
+}
+
+bool
+SoftCscHandler::set_matrix (const XCam3aResultColorMatrix &matrix)
+{
+    XCAM_FAIL_RETURN (
+        WARNING, _type == SoftCscTypeRGBAToNV12, false,
+        "SoftCscHandler(%s) set matrix only works on RGBA to NV12", XCAM_STR (get_name ()));
+
+    matrix_to_fixed_point (matrix.matrix, _coeffs);
+    return true;
+}
+
+XCamReturn
+SoftCscHandler::convert (
+    const SmartPtr<VideoBuffer> &in,
+    SmartPtr<VideoBuffer> &out_buf)
+{
+    SmartPtr<ImageHandler::Parameters> param = new ImageHandler::Parameters (in, out_buf);
+    XCamReturn ret = execute_buffer (param, true);
+    if (xcam_ret_is_ok (ret) && !out_buf.ptr ()) {
+        out_buf = param->out_buf;
+    }
+
+    return ret;
+}
+
+XCamReturn
+SoftCscHandler::configure_resource (const SmartPtr<Parameters> &param)
+{
+    const VideoBufferInfo &in_info = param->in_buf->get_video_info ();
+    uint32_t in_format = 0, out_format = 0;
+
+    switch (_type) {
+    case SoftCscTypeNV12ToRGBA:
+        in_format = V4L2_PIX_FMT_NV12;
+        out_format = V4L2_PIX_FMT_RGBA32;
+        break;
+    case SoftCscTypeRGBAToNV12:
+        in_format = V4L2_PIX_FMT_RGBA32;
+        out_format = V4L2_PIX_FMT_NV12;
+        break;
+    case SoftCscTypeYUYVToNV12:
+        in_format = V4L2_PIX_FMT_YUYV;
+        out_format = V4L2_PIX_FMT_NV12;
+        break;
+    case SoftCscTypeNV12ToYUV420:
+        in_format = V4L2_PIX_FMT_NV12;
+        out_format = V4L2_PIX_FMT_YUV420;
+        break;
+    default:
+        XCAM_LOG_ERROR ("SoftCscHandler(%s) unknown csc type:%d", XCAM_STR (get_name ()), _type);
+        return XCAM_RETURN_ERROR_PARAM;
+    }
+
+    XCAM_FAIL_RETURN (
+        ERROR, in_info.format == in_format, XCAM_RETURN_ERROR_PARAM,
+        "SoftCscHandler(%s) only support input format(%s) but input format is %s",
+        XCAM_STR (get_name ()), xcam_fourcc_to_string (in_format), xcam_fourcc_to_string (in_info.format));
+    XCAM_FAIL_RETURN (
+        ERROR, in_info.width % 2 == 0 && in_info.height % 2 == 0, XCAM_RETURN_ERROR_PARAM,
+        "SoftCscHandler(%s) input size(%dx%d) must be even",
+        XCAM_STR (get_name ()), in_info.width, in_info.height);
+
+    VideoBufferInfo out_info;
+    out_info.init (
+        out_format, in_info.width, in_info.height,
+        XCAM_ALIGN_UP (in_info.width, XCAM_SOFT_CSC_ALIGNMENT_X),
+        XCAM_ALIGN_UP (in_info.height, XCAM_SOFT_CSC_ALIGNMENT_Y));
+    set_out_video_info (out_info);
+
+    XCAM_ASSERT (!_csc_task.ptr ());
+    _csc_task = create_csc_task ();
+    XCAM_ASSERT (_csc_task.ptr ());
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+SmartPtr<XCamSoftTasks::CscTask>
+SoftCscHandler::create_csc_task ()
+{
+    SmartPtr<Worker::Callback> cb = new CbCscTask (this);
+    SmartPtr<XCamSoftTasks::CscTask> task;
+
+    switch (_type) {
+    case SoftCscTypeNV12ToRGBA:
+        task = new XCamSoftTasks::CscNV12ToRGBATask (cb);
+        break;
+    case SoftCscTypeRGBAToNV12:
+        task = new XCamSoftTasks::CscRGBAToNV12Task (cb);
+        break;
+    case SoftCscTypeYUYVToNV12:
+        task = new XCamSoftTasks::CscYUYVToNV12Task (cb);
+        break;
+    case SoftCscTypeNV12ToYUV420:
+        task = new XCamSoftTasks::CscNV12ToYUV420Task (cb);
+        break;
+    }
+
+    return task;
+}
+
+void
+SoftCscHandler::set_work_size (uint32_t thread_y, uint32_t luma_height)
+{
+    WorkSize work_unit = _csc_task->get_work_uint ();
+    WorkSize global_size (1, xcam_ceil (luma_height, work_unit.value[1]) / work_unit.value[1]);
+    WorkSize local_size (1, xcam_ceil (global_size.value[1], thread_y) / thread_y);
+
+    _csc_task->set_local_size (local_size);
+    _csc_task->set_global_size (global_size);
+}
+
+XCamReturn
+SoftCscHandler::start_work (const SmartPtr<ImageHandler::Parameters> &param)
+{
+    XCAM_ASSERT (_csc_task.ptr ());
+    XCAM_ASSERT (param->in_buf.ptr () && param->out_buf.ptr ());
+
+    SmartPtr<VideoBuffer> in_buf = param->in_buf, out_buf = param->out_buf;
+    const VideoBufferInfo &in_info = in_buf->get_video_info ();
+    const VideoBufferInfo &out_info = out_buf->get_video_info ();
+
+    SmartPtr<XCamSoftTasks::CscTask::Args> args = new XCamSoftTasks::CscTask::Args (param);
+    for (uint32_t i = 0; i < in_info.components; ++i)
+        args->in_plane[i] = new UcharImage (in_buf, i);
+    for (uint32_t i = 0; i < out_info.components; ++i)
+        args->out_plane[i] = new UcharImage (out_buf, i);
+    args->coeffs = _coeffs;
+
+    set_work_size (XCAM_SOFT_CSC_THREADS, in_info.height);
+
+    param->in_buf.release ();
+    XCamReturn ret = _csc_task->work (args);
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "SoftCscHandler(%s) start_work failed", XCAM_STR (get_name ()));
+
+    return ret;
+}
+
+XCamReturn
+SoftCscHandler::terminate ()
+{
+    if (_csc_task.ptr ()) {
+        _csc_task->stop ();
+        _csc_task.release ();
+    }
+    return SoftHandler::terminate ();
+}
+
+void
+SoftCscHandler::csc_task_done (
+    const SmartPtr<Worker> &worker, const SmartPtr<Worker::Arguments> &base, const XCamReturn error)
+{
+    XCAM_UNUSED (worker);
+    XCAM_ASSERT (worker.ptr () == _csc_task.ptr ());
+
+    SmartPtr<XCamSoftTasks::CscTask::Args> args = base.dynamic_cast_ptr<XCamSoftTasks::CscTask::Args> ();
+    XCAM_ASSERT (args.ptr ());
+
+    const SmartPtr<ImageHandler::Parameters> param = args->get_param ();
+    if (!check_work_continue (param, error))
+        return;
+
+    work_well_done (param, error);
+}
+
+SmartPtr<SoftHandler>
+create_soft_csc_handler (SoftCscType type)
+{
+    SmartPtr<SoftHandler> csc = new SoftCscHandler (type);
+    XCAM_ASSERT (csc.ptr ());
+
+    return csc;
+}
+
+}
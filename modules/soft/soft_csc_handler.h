@@ -0,0 +1,85 @@
+/*
+ * soft_csc_handler.h - soft color space conversion handler class
+ *
+ *  Copyright (c) 2017 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#ifndef XCAM_SOFT_CSC_HANDLER_H
+#define XCAM_SOFT_CSC_HANDLER_H
+
+#include <xcam_std.h>
+#include <base/xcam_3a_result.h>
+#include <soft/soft_handler.h>
+
+namespace XCam {
+
+namespace XCamSoftTasks {
+class CscTask;
+};
+
+enum SoftCscType {
+    SoftCscTypeNV12ToRGBA = 0,
+    SoftCscTypeRGBAToNV12,
+    SoftCscTypeYUYVToNV12,
+    SoftCscTypeNV12ToYUV420,
+};
+
+class SoftCscHandler
+    : public SoftHandler
+{
+public:
+    SoftCscHandler (SoftCscType type, const char *name = "SoftCscHandler");
+    ~SoftCscHandler ();
+
+    SoftCscType get_csc_type () const {
+        return _type;
+    }
+    // rgb to yuv matrix, only used by SoftCscTypeRGBAToNV12
+    bool set_matrix (const XCam3aResultColorMatrix &matrix);
+
+    XCamReturn convert (
+        const SmartPtr<VideoBuffer> &in,
+        SmartPtr<VideoBuffer> &out_buf);
+
+    //derived from SoftHandler
+    virtual XCamReturn terminate ();
+
+    void csc_task_done (
+        const SmartPtr<Worker> &worker, const SmartPtr<Worker::Arguments> &args, const XCamReturn error);
+
+protected:
+    //derived from SoftHandler
+    XCamReturn configure_resource (const SmartPtr<Parameters> &param);
+    XCamReturn start_work (const SmartPtr<Parameters> &param);
+
+private:
+    SmartPtr<XCamSoftTasks::CscTask> create_csc_task ();
+    void set_work_size (uint32_t thread_y, uint32_t luma_height);
+
+private:
+    XCAM_DEAD_COPY (SoftCscHandler);
+
+private:
+    SoftCscType                         _type;
+    int32_t                             _coeffs[XCAM_COLOR_MATRIX_SIZE];
+    SmartPtr<XCamSoftTasks::CscTask>    _csc_task;
+};
+
+extern SmartPtr<SoftHandler> create_soft_csc_handler (SoftCscType type);
+
+}
+#endif //XCAM_SOFT_CSC_HANDLER_H
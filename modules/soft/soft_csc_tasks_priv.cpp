@@ -0,0 +1,273 @@
+/*
+ * soft_csc_tasks_priv.cpp - soft color space conversion tasks implementation
+ *
+ *  Copyright (c) 2017 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#include "soft_csc_tasks_priv.h"
+
+#define CSC_FIX_ROUND (1 << (XCAM_SOFT_CSC_FIX_BITS - 1))
+#define CSC_BLOCK_SIZE 8
+
+namespace XCam {
+
+namespace XCamSoftTasks {
+
+// same coefficients as kernel_csc_nv12torgba, 1.13983, 0.39465, 0.5806, 2.03211
+static const int32_t yuv_to_rgb_coeffs[4] = {18675, 6466, 9513, 33294};
+
+static inline Uchar
+clamp_to_uchar (const int32_t v)
+{
+    return (Uchar)(v < 0 ? 0 : (v > 255 ? 255 : v));
+}
+
+static inline void
+yuv_to_rgba (const Uchar *luma, const int32_t *u, const int32_t *v, Uchar *rgba, const uint32_t n)
+{
+    int32_t r[CSC_BLOCK_SIZE], g[CSC_BLOCK_SIZE], b[CSC_BLOCK_SIZE];
+    XCAM_ASSERT (n <= CSC_BLOCK_SIZE);
+
+    for (uint32_t i = 0; i < n; ++i) {
+        int32_t y = ((int32_t)luma[i] << XCAM_SOFT_CSC_FIX_BITS) + CSC_FIX_ROUND;
+        r[i] = (y + yuv_to_rgb_coeffs[0] * v[i]) >> XCAM_SOFT_CSC_FIX_BITS;
+        g[i] = (y - yuv_to_rgb_coeffs[1] * u[i] - yuv_to_rgb_coeffs[2] * v[i]) >> XCAM_SOFT_CSC_FIX_BITS;
+        b[i] = (y + yuv_to_rgb_coeffs[3] * u[i]) >> XCAM_SOFT_CSC_FIX_BITS;
+    }
+    for (uint32_t i = 0; i < n; ++i) {
+        rgba[i * 4] = clamp_to_uchar (r[i]);
+        rgba[i * 4 + 1] = clamp_to_uchar (g[i]);
+        rgba[i * 4 + 2] = clamp_to_uchar (b[i]);
+        rgba[i * 4 + 3] = 255;
+    }
+}
+
+static inline void
+read_uv (const Uchar *uv, int32_t *u, int32_t *v, const uint32_t n)
+{
+    for (uint32_t i = 0; i < n; ++i) {
+        u[i] = (int32_t)uv[i & ~1u] - 128;
+        v[i] = (int32_t)uv[(i & ~1u) + 1] - 128;
+    }
+}
+
+XCamReturn
+CscNV12ToRGBATask::work_range (const SmartPtr<Arguments> &base, const WorkRange &range)
+{
+    SmartPtr<CscTask::Args> args = base.dynamic_cast_ptr<CscTask::Args> ();
+    XCAM_ASSERT (args.ptr ());
+    UcharImage *in_luma = args->in_plane[0].ptr (), *in_uv = args->in_plane[1].ptr ();
+    UcharImage *out = args->out_plane[0].ptr ();
+    XCAM_ASSERT (in_luma && in_uv && out);
+
+    uint32_t width = in_luma->get_width ();
+    int32_t u[CSC_BLOCK_SIZE], v[CSC_BLOCK_SIZE];
+
+    for (uint32_t y = range.pos[1]; y < range.pos[1] + range.pos_len[1]; ++y) {
+        const Uchar *luma0 = in_luma->get_buf_ptr (0, y * 2);
+        const Uchar *luma1 = in_luma->get_buf_ptr (0, y * 2 + 1);
+        const Uchar *uv = in_uv->get_buf_ptr (0, y);
+        Uchar *out0 = out->get_buf_ptr (0, y * 2);
+        Uchar *out1 = out->get_buf_ptr (0, y * 2 + 1);
+
+        uint32_t x = 0;
+        for (; x + CSC_BLOCK_SIZE <= width; x += CSC_BLOCK_SIZE) {
+            read_uv (uv + x, u, v, CSC_BLOCK_SIZE);
+            yuv_to_rgba (luma0 + x, u, v, out0 + x * 4, CSC_BLOCK_SIZE);
+            yuv_to_rgba (luma1 + x, u, v, out1 + x * 4, CSC_BLOCK_SIZE);
+        }
+        if (x < width) {
+            read_uv (uv + x, u, v, width - x);
+            yuv_to_rgba (luma0 + x, u, v, out0 + x * 4, width - x);
+            yuv_to_rgba (luma1 + x, u, v, out1 + x * 4, width - x);
+        }
+    }
+
+    XCAM_LOG_DEBUG ("CscNV12ToRGBATask work on range:[y:%d, height:%d]", range.pos[1], range.pos_len[1]);
+    return XCAM_RETURN_NO_ERROR;
+}
+
+/*
+ * coeffs: 3x3 rgb to yuv matrix in fixed-point, row order Y, U, V
+ * 2x2 pixels share one UV pair which is calculated from the averaged RGB.
+ */
+static inline void
+rgba_to_nv12 (
+    const Uchar *rgba0, const Uchar *rgba1, const int32_t *coeffs,
+    Uchar *luma0, Uchar *luma1, Uchar *uv, const uint32_t n)
+{
+    int32_t sum_r[CSC_BLOCK_SIZE / 2], sum_g[CSC_BLOCK_SIZE / 2], sum_b[CSC_BLOCK_SIZE / 2];
+    XCAM_ASSERT (n <= CSC_BLOCK_SIZE && n % 2 == 0);
+
+    for (uint32_t i = 0; i < n; ++i) {
+        const Uchar *p0 = rgba0 + i * 4, *p1 = rgba1 + i * 4;
+        luma0[i] = clamp_to_uchar (
+                       (coeffs[0] * p0[0] + coeffs[1] * p0[1] + coeffs[2] * p0[2] + CSC_FIX_ROUND) >> XCAM_SOFT_CSC_FIX_BITS);
+        luma1[i] = clamp_to_uchar (
+                       (coeffs[0] * p1[0] + coeffs[1] * p1[1] + coeffs[2] * p1[2] + CSC_FIX_ROUND) >> XCAM_SOFT_CSC_FIX_BITS);
+    }
+
+    for (uint32_t i = 0; i < n / 2; ++i) {
+        const Uchar *p0 = rgba0 + i * 8, *p1 = rgba1 + i * 8;
+        sum_r[i] = p0[0] + p0[4] + p1[0] + p1[4];
+        sum_g[i] = p0[1] + p0[5] + p1[1] + p1[5];
+        sum_b[i] = p0[2] + p0[6] + p1[2] + p1[6];
+    }
+    for (uint32_t i = 0; i < n / 2; ++i) {
+        // sums are 4x of average, shift 2 more bits
+        uv[i * 2] = clamp_to_uchar (
+                        ((coeffs[3] * sum_r[i] + coeffs[4] * sum_g[i] + coeffs[5] * sum_b[i] +
+                          (CSC_FIX_ROUND << 2)) >> (XCAM_SOFT_CSC_FIX_BITS + 2)) + 128);
+        uv[i * 2 + 1] = clamp_to_uchar (
+                            ((coeffs[6] * sum_r[i] + coeffs[7] * sum_g[i] + coeffs[8] * sum_b[i] +
+                              (CSC_FIX_ROUND << 2)) >> (XCAM_SOFT_CSC_FIX_BITS + 2)) + 128);
+    }
+}
+
+XCamReturn
+CscRGBAToNV12Task::work_range (const SmartPtr<Arguments> &base, const WorkRange &range)
+{
+    SmartPtr<CscTask::Args> args = base.dynamic_cast_ptr<CscTask::Args> ();
+    XCAM_ASSERT (args.ptr ());
+    UcharImage *in = args->in_plane[0].ptr ();
+    UcharImage *out_luma = args->out_plane[0].ptr (), *out_uv = args->out_plane[1].ptr ();
+    XCAM_ASSERT (in && out_luma && out_uv);
+    XCAM_ASSERT (args->coeffs);
+
+    uint32_t width = out_luma->get_width ();
+    XCAM_ASSERT (width % 2 == 0);
+
+    for (uint32_t y = range.pos[1]; y < range.pos[1] + range.pos_len[1]; ++y) {
+        const Uchar *rgba0 = in->get_buf_ptr (0, y * 2);
+        const Uchar *rgba1 = in->get_buf_ptr (0, y * 2 + 1);
+        Uchar *luma0 = out_luma->get_buf_ptr (0, y * 2);
+        Uchar *luma1 = out_luma->get_buf_ptr (0, y * 2 + 1);
+        Uchar *uv = out_uv->get_buf_ptr (0, y);
+
+        uint32_t x = 0;
+        for (; x + CSC_BLOCK_SIZE <= width; x += CSC_BLOCK_SIZE) {
+            rgba_to_nv12 (
+                rgba0 + x * 4, rgba1 + x * 4, args->coeffs,
+                luma0 + x, luma1 + x, uv + x, CSC_BLOCK_SIZE);
+        }
+        if (x < width) {
+            rgba_to_nv12 (
+                rgba0 + x * 4, rgba1 + x * 4, args->coeffs,
+                luma0 + x, luma1 + x, uv + x, width - x);
+        }
+    }
+
+    XCAM_LOG_DEBUG ("CscRGBAToNV12Task work on range:[y:%d, height:%d]", range.pos[1], range.pos_len[1]);
+    return XCAM_RETURN_NO_ERROR;
+}
+
+// YUYV: Y0 U Y1 V, vertical UV subsample by averaging two lines
+static inline void
+yuyv_to_nv12 (
+    const Uchar *yuyv0, const Uchar *yuyv1,
+    Uchar *luma0, Uchar *luma1, Uchar *uv, const uint32_t n)
+{
+    XCAM_ASSERT (n <= CSC_BLOCK_SIZE && n % 2 == 0);
+
+    for (uint32_t i = 0; i < n; ++i) {
+        luma0[i] = yuyv0[i * 2];
+        luma1[i] = yuyv1[i * 2];
+    }
+    for (uint32_t i = 0; i < n; i += 2) {
+        uv[i] = (Uchar)(((uint32_t)yuyv0[i * 2 + 1] + yuyv1[i * 2 + 1] + 1) >> 1);
+        uv[i + 1] = (Uchar)(((uint32_t)yuyv0[i * 2 + 3] + yuyv1[i * 2 + 3] + 1) >> 1);
+    }
+}
+
+XCamReturn
+CscYUYVToNV12Task::work_range (const SmartPtr<Arguments> &base, const WorkRange &range)
+{
+    SmartPtr<CscTask::Args> args = base.dynamic_cast_ptr<CscTask::Args> ();
+    XCAM_ASSERT (args.ptr ());
+    UcharImage *in = args->in_plane[0].ptr ();
+    UcharImage *out_luma = args->out_plane[0].ptr (), *out_uv = args->out_plane[1].ptr ();
+    XCAM_ASSERT (in && out_luma && out_uv);
+
+    uint32_t width = out_luma->get_width ();
+    XCAM_ASSERT (width % 2 == 0);
+
+    for (uint32_t y = range.pos[1]; y < range.pos[1] + range.pos_len[1]; ++y) {
+        const Uchar *yuyv0 = in->get_buf_ptr (0, y * 2);
+        const Uchar *yuyv1 = in->get_buf_ptr (0, y * 2 + 1);
+        Uchar *luma0 = out_luma->get_buf_ptr (0, y * 2);
+        Uchar *luma1 = out_luma->get_buf_ptr (0, y * 2 + 1);
+        Uchar *uv = out_uv->get_buf_ptr (0, y);
+
+        uint32_t x = 0;
+        for (; x + CSC_BLOCK_SIZE <= width; x += CSC_BLOCK_SIZE) {
+            yuyv_to_nv12 (yuyv0 + x * 2, yuyv1 + x * 2, luma0 + x, luma1 + x, uv + x, CSC_BLOCK_SIZE);
+        }
+        if (x < width) {
+            yuyv_to_nv12 (yuyv0 + x * 2, yuyv1 + x * 2, luma0 + x, luma1 + x, uv + x, width - x);
+        }
+    }
+
+    XCAM_LOG_DEBUG ("CscYUYVToNV12Task work on range:[y:%d, height:%d]", range.pos[1], range.pos_len[1]);
+    return XCAM_RETURN_NO_ERROR;
+}
+
+static inline void
+split_uv (const Uchar *uv, Uchar *u, Uchar *v, const uint32_t n)
+{
+    XCAM_ASSERT (n <= CSC_BLOCK_SIZE);
+    for (uint32_t i = 0; i < n; ++i) {
+        u[i] = uv[i * 2];
+        v[i] = uv[i * 2 + 1];
+    }
+}
+
+XCamReturn
+CscNV12ToYUV420Task::work_range (const SmartPtr<Arguments> &base, const WorkRange &range)
+{
+    SmartPtr<CscTask::Args> args = base.dynamic_cast_ptr<CscTask::Args> ();
+    XCAM_ASSERT (args.ptr ());
+    UcharImage *in_luma = args->in_plane[0].ptr (), *in_uv = args->in_plane[1].ptr ();
+    UcharImage *out_y = args->out_plane[0].ptr (), *out_u = args->out_plane[1].ptr (), *out_v = args->out_plane[2].ptr ();
+    XCAM_ASSERT (in_luma && in_uv);
+    XCAM_ASSERT (out_y && out_u && out_v);
+
+    uint32_t luma_bytes = in_luma->get_width ();
+    uint32_t chroma_width = out_u->get_width ();
+
+    for (uint32_t y = range.pos[1]; y < range.pos[1] + range.pos_len[1]; ++y) {
+        memcpy (out_y->get_buf_ptr (0, y * 2), in_luma->get_buf_ptr (0, y * 2), luma_bytes);
+        memcpy (out_y->get_buf_ptr (0, y * 2 + 1), in_luma->get_buf_ptr (0, y * 2 + 1), luma_bytes);
+
+        const Uchar *uv = in_uv->get_buf_ptr (0, y);
+        Uchar *u = out_u->get_buf_ptr (0, y);
+        Uchar *v = out_v->get_buf_ptr (0, y);
+        uint32_t x = 0;
+        for (; x + CSC_BLOCK_SIZE <= chroma_width; x += CSC_BLOCK_SIZE) {
+            split_uv (uv + x * 2, u + x, v + x, CSC_BLOCK_SIZE);
+        }
+        if (x < chroma_width) {
+            split_uv (uv + x * 2, u + x, v + x, chroma_width - x);
+        }
+    }
+
+    XCAM_LOG_DEBUG ("CscNV12ToYUV420Task work on range:[y:%d, height:%d]", range.pos[1], range.pos_len[1]);
+    return XCAM_RETURN_NO_ERROR;
+}
+
+}
+
+}
@@ -0,0 +1,115 @@
+/*
+ * soft_csc_tasks_priv.h - soft color space conversion tasks
+ *
+ *  Copyright (c) 2017 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#ifndef XCAM_SOFT_CSC_TASKS_PRIV_H
+#define XCAM_SOFT_CSC_TASKS_PRIV_H
+
+#include <xcam_std.h>
+#include <soft/soft_worker.h>
+#include <soft/soft_image.h>
+#include <soft/soft_handler.h>
+
+// fixed-point fraction bits of csc coefficients
+#define XCAM_SOFT_CSC_FIX_BITS 14
+
+namespace XCam {
+
+namespace XCamSoftTasks {
+
+/* every task works on 2 lines per work unit, each line is processed by 8-pixel blocks
+ * with fixed-point integer arithmetic so the inner loops can be vectorized by compiler.
+ * Images are bound on caller's buffers with their own strides, no temporary buffer used.
+ */
+class CscTask
+    : public SoftWorker
+{
+public:
+    struct Args : SoftArgs {
+        SmartPtr<UcharImage>        in_plane[3];
+        SmartPtr<UcharImage>        out_plane[3];
+        const int32_t              *coeffs;
+
+        Args (const SmartPtr<ImageHandler::Parameters> &param)
+            : SoftArgs (param)
+            , coeffs (NULL)
+        {}
+    };
+
+protected:
+    explicit CscTask (const char *name, const SmartPtr<Worker::Callback> &cb)
+        : SoftWorker (name, cb)
+    {
+        set_work_uint (1, 2);
+    }
+};
+
+class CscNV12ToRGBATask
+    : public CscTask
+{
+public:
+    explicit CscNV12ToRGBATask (const SmartPtr<Worker::Callback> &cb)
+        : CscTask ("CscNV12ToRGBATask", cb)
+    {}
+
+private:
+    virtual XCamReturn work_range (const SmartPtr<Arguments> &args, const WorkRange &range);
+};
+
+class CscRGBAToNV12Task
+    : public CscTask
+{
+public:
+    explicit CscRGBAToNV12Task (const SmartPtr<Worker::Callback> &cb)
+        : CscTask ("CscRGBAToNV12Task", cb)
+    {}
+
+private:
+    virtual XCamReturn work_range (const SmartPtr<Arguments> &args, const WorkRange &range);
+};
+
+class CscYUYVToNV12Task
+    : public CscTask
+{
+public:
+    explicit CscYUYVToNV12Task (const SmartPtr<Worker::Callback> &cb)
+        : CscTask ("CscYUYVToNV12Task", cb)
+    {}
+
+private:
+    virtual XCamReturn work_range (const SmartPtr<Arguments> &args, const WorkRange &range);
+};
+
+class CscNV12ToYUV420Task
+    : public CscTask
+{
+public:
+    explicit CscNV12ToYUV420Task (const SmartPtr<Worker::Callback> &cb)
+        : CscTask ("CscNV12ToYUV420Task", cb)
+    {}
+
+private:
+    virtual XCamReturn work_range (const SmartPtr<Arguments> &args, const WorkRange &range);
+};
+
+}
+
+}
+
+#endif //XCAM_SOFT_CSC_TASKS_PRIV_H
@@ -422,6 +422,14 @@ SoftDualCurveGeoMapper::start_remap_task (const SmartPtr<ImageHandler::Parameter
 
     prepare_arguments (args, param);
 
+    // row factors are prepared once per frame here instead of in each work item
+    SmartPtr<XCamSoftTasks::GeoMapDualCurveTask> curve_task =
+        map_task.dynamic_cast_ptr<XCamSoftTasks::GeoMapDualCurveTask> ();
+    XCAM_ASSERT (curve_task.ptr ());
+    XCAM_FAIL_RETURN (
+        ERROR, curve_task->update_row_factors (args, args->out_luma->get_height ()), XCAM_RETURN_ERROR_PARAM,
+        "SoftGeoMapper(%s) update row factors failed", XCAM_STR (get_name ()));
+
     return map_task->work (args);
 }
 
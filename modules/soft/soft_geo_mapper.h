@@ -42,6 +42,9 @@ public:
     ~SoftGeoMapper ();
 
     bool set_lookup_table (const PointFloat2 *data, uint32_t width, uint32_t height);
+    const SmartPtr<Float2Image> &get_lookup_table () const {
+        return _lookup_table;
+    }
 
     //derived from SoftHandler
     virtual XCamReturn terminate ();
@@ -63,9 +66,6 @@ protected:
     SmartPtr<XCamSoftTasks::GeoMapTask> &get_map_task () {
         return _map_task;
     }
-    SmartPtr<Float2Image> &get_lookup_table () {
-        return _lookup_table;
-    }
 
 protected:
     virtual bool init_factors ();
@@ -19,6 +19,7 @@
  */
 
 #include "soft_geo_tasks_priv.h"
+#include <math.h>
 
 namespace XCam {
 
@@ -164,6 +165,46 @@ GeoMapTask::work_range (const SmartPtr<Arguments> &base, const WorkRange &range)
     return XCAM_RETURN_NO_ERROR;
 }
 
+void
+GeoMapTask::map_area (
+    const UcharImage *in_luma, const Uchar2Image *in_uv,
+    UcharImage *out_luma, Uchar2Image *out_uv,
+    const Float2Image *lut, const Float2 &factors,
+    const Rect &area, uint32_t view_width, uint32_t view_height)
+{
+    static const Uchar zero_luma_byte[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+    static const Uchar2 zero_uv_byte[4] = {{128, 128}, {128, 128}, {128, 128}, {128, 128}};
+    XCAM_ASSERT (in_luma && in_uv && out_luma && out_uv && lut);
+    XCAM_ASSERT (area.pos_x % 2 == 0 && area.pos_y % 2 == 0);
+    XCAM_ASSERT (!XCAM_DOUBLE_EQUAL_AROUND (factors.x, 0.0f) && !XCAM_DOUBLE_EQUAL_AROUND (factors.y, 0.0f));
+
+    Float2 step = Float2(1.0f, 1.0f) / factors;
+
+    Float2 out_center ((view_width - 1.0f ) / 2.0f, (view_height - 1.0f ) / 2.0f);
+    Float2 lut_center ((lut->get_width () - 1.0f) / 2.0f, (lut->get_height () - 1.0f) / 2.0f);
+
+    uint32_t luma_w = in_luma->get_width ();
+    uint32_t luma_h = in_luma->get_height ();
+    uint32_t uv_w = in_uv->get_width ();
+    uint32_t uv_h = in_uv->get_height ();
+    uint32_t blocks_x = xcam_ceil (area.width, 8) / 8;
+    uint32_t blocks_y = xcam_ceil (area.height, 2) / 2;
+
+    for (uint32_t y = 0; y < blocks_y; ++y)
+        for (uint32_t x = 0; x < blocks_x; ++x)
+        {
+            uint32_t out_x = x * 8, out_y = y * 2;
+
+            Float2 out_pos (area.pos_x + out_x, area.pos_y + out_y);
+            out_pos -= out_center;
+            Float2 first = out_pos / factors;
+            first += lut_center;
+
+            map_image (in_luma, in_uv, out_luma, out_uv, lut, luma_w, luma_h, uv_w, uv_h,
+                       x, y, out_x, out_y, first, step, zero_luma_byte, zero_uv_byte);
+        }
+}
+
 XCamReturn
 GeoMapDualConstTask::work_range (const SmartPtr<Arguments> &base, const WorkRange &range)
 {
@@ -221,31 +262,11 @@ GeoMapDualCurveTask::GeoMapDualCurveTask (const SmartPtr<Worker::Callback> &cb)
     , _scaled_height (0.0f)
     , _left_std_factor (0.0f, 0.0f)
     , _right_std_factor (0.0f, 0.0f)
-    , _left_factors (NULL)
-    , _right_factors (NULL)
-    , _left_steps (NULL)
-    , _right_steps (NULL)
 {
     set_work_uint (8, 2);
 }
 
 GeoMapDualCurveTask::~GeoMapDualCurveTask () {
-    if (_left_factors) {
-        delete [] _left_factors;
-        _left_factors = NULL;
-    }
-    if (_right_factors) {
-        delete [] _right_factors;
-        _right_factors = NULL;
-    }
-    if (_left_steps) {
-        delete [] _left_steps;
-        _left_steps = NULL;
-    }
-    if (_right_steps) {
-        delete [] _right_steps;
-        _right_steps = NULL;
-    }
 }
 
 void
@@ -278,50 +299,75 @@ static void calc_cur_row_factor (
     cur_row_factor.y = factor.y;
 }
 
-void
-GeoMapDualCurveTask::set_factors (SmartPtr<GeoMapDualCurveTask::Args> args, uint32_t size) {
-    if (_left_factors == NULL) {
-        _left_factors = new Float2[size];
-        XCAM_ASSERT (_left_factors);
-    }
-    if (_right_factors == NULL) {
-        _right_factors = new Float2[size];
-        XCAM_ASSERT (_right_factors);
+SmartPtr<GeoMapDualCurveTask::RowFactors>
+GeoMapDualCurveTask::calc_row_factors (
+    const SmartPtr<RowFactors> &last, const Float2 &std_factor, const Float2 &factor, uint32_t height)
+{
+    XCAM_FAIL_RETURN (
+        ERROR,
+        !XCAM_DOUBLE_EQUAL_AROUND (std_factor.x, 0.0f) && !XCAM_DOUBLE_EQUAL_AROUND (std_factor.y, 0.0f) &&
+        !XCAM_DOUBLE_EQUAL_AROUND (factor.x, 0.0f) && !XCAM_DOUBLE_EQUAL_AROUND (factor.y, 0.0f),
+        NULL,
+        "GeoMapDualCurveTask invalid factor(x:%f, y:%f) std_factor(x:%f, y:%f)",
+        factor.x, factor.y, std_factor.x, std_factor.y);
+
+    SmartPtr<RowFactors> rows = new RowFactors;
+    XCAM_ASSERT (rows.ptr ());
+    rows->factor = factor;
+
+    // rows from scaled_height keep std_factor, only rows above depend on factor
+    uint32_t start_y = 0;
+    uint32_t end_y = height;
+    if (last.ptr () && last->factors.size () == height &&
+            XCAM_DOUBLE_EQUAL_AROUND (last->factor.y, factor.y)) {
+        rows->factors = last->factors;
+        rows->steps = last->steps;
+        end_y = XCAM_MIN (height, (uint32_t)ceilf (_scaled_height));
+    } else {
+        rows->factors.resize (height);
+        rows->steps.resize (height);
     }
 
     float ym = _scaled_height * 0.5f;
-    for (uint32_t y = 0; y < size; ++y) {
-        calc_cur_row_factor (y, ym, _left_std_factor, _scaled_height, args->left_factor, _left_factors[y]);
-        calc_cur_row_factor (y, ym, _right_std_factor, _scaled_height, args->right_factor, _right_factors[y]);
+    for (uint32_t y = start_y; y < end_y; ++y) {
+        calc_cur_row_factor (y, ym, std_factor, _scaled_height, factor, rows->factors[y]);
+        XCAM_FAIL_RETURN (
+            ERROR, !XCAM_DOUBLE_EQUAL_AROUND (rows->factors[y].x, 0.0f), NULL,
+            "GeoMapDualCurveTask invalid factor(row:%d): factor(x:%f, y:%f)",
+            y, rows->factors[y].x, rows->factors[y].y);
+        rows->steps[y] = Float2(1.0f, 1.0f) / rows->factors[y];
     }
+
+    return rows;
+}
+
+static inline bool
+is_same_factor (const Float2 &a, const Float2 &b)
+{
+    return XCAM_DOUBLE_EQUAL_AROUND (a.x, b.x) && XCAM_DOUBLE_EQUAL_AROUND (a.y, b.y);
 }
 
 bool
-GeoMapDualCurveTask::set_steps (uint32_t size) {
-    if (_left_steps == NULL) {
-        _left_steps =  new Float2[size];
-        XCAM_ASSERT (_left_steps);
-    }
-    if (_right_steps == NULL) {
-        _right_steps =  new Float2[size];
-        XCAM_ASSERT (_right_steps);
+GeoMapDualCurveTask::update_row_factors (const SmartPtr<GeoMapDualCurveTask::Args> &args, uint32_t height)
+{
+    XCAM_ASSERT (args.ptr ());
+
+    if (!_left_rows.ptr () || _left_rows->factors.size () != height ||
+            !is_same_factor (_left_rows->factor, args->left_factor)) {
+        SmartPtr<RowFactors> rows = calc_row_factors (_left_rows, _left_std_factor, args->left_factor, height);
+        XCAM_FAIL_RETURN (ERROR, rows.ptr (), false, "GeoMapDualCurveTask update left row factors failed");
+        _left_rows = rows;
     }
 
-    for (uint32_t y = 0; y < size; ++y) {
-        XCAM_FAIL_RETURN (
-            ERROR,
-            !XCAM_DOUBLE_EQUAL_AROUND (_left_factors[y].x, 0.0f) &&
-            !XCAM_DOUBLE_EQUAL_AROUND (_left_factors[y].y, 0.0f) &&
-            !XCAM_DOUBLE_EQUAL_AROUND (_right_factors[y].x, 0.0f) &&
-            !XCAM_DOUBLE_EQUAL_AROUND (_right_factors[y].y, 0.0f),
-            false,
-            "GeoMapDualCurveTask invalid factor(row:%d): left_factor(x:%f, y:%f) right_factor(x:%f, y:%f)",
-            y, _left_factors[y].x, _left_factors[y].y, _right_factors[y].x, _right_factors[y].y);
-
-        _left_steps[y] = Float2(1.0f, 1.0f) / _left_factors[y];
-        _right_steps[y] = Float2(1.0f, 1.0f) / _right_factors[y];
+    if (!_right_rows.ptr () || _right_rows->factors.size () != height ||
+            !is_same_factor (_right_rows->factor, args->right_factor)) {
+        SmartPtr<RowFactors> rows = calc_row_factors (_right_rows, _right_std_factor, args->right_factor, height);
+        XCAM_FAIL_RETURN (ERROR, rows.ptr (), false, "GeoMapDualCurveTask update right row factors failed");
+        _right_rows = rows;
     }
 
+    args->left_rows = _left_rows;
+    args->right_rows = _right_rows;
     return true;
 }
 
@@ -343,8 +389,10 @@ GeoMapDualCurveTask::work_range (const SmartPtr<Arguments> &base, const WorkRang
     XCAM_ASSERT (out_luma && out_uv);
     XCAM_ASSERT (lut);
 
-    set_factors (args, out_luma->get_height ());
-    set_steps (out_luma->get_height ());
+    const RowFactors *left_rows = args->left_rows.ptr (), *right_rows = args->right_rows.ptr ();
+    XCAM_ASSERT (left_rows && right_rows);
+    XCAM_ASSERT (left_rows->factors.size () >= out_luma->get_height ());
+    XCAM_ASSERT (right_rows->factors.size () >= out_luma->get_height ());
 
     Float2 out_center ((out_luma->get_width () - 1.0f ) / 2.0f, (out_luma->get_height () - 1.0f ) / 2.0f);
     Float2 lut_center ((lut->get_width () - 1.0f) / 2.0f, (lut->get_height () - 1.0f) / 2.0f);
@@ -358,8 +406,9 @@ GeoMapDualCurveTask::work_range (const SmartPtr<Arguments> &base, const WorkRang
         for (uint32_t x = range.pos[0]; x < range.pos[0] + range.pos_len[0]; ++x)
         {
             uint32_t out_x = x * 8, out_y = y * 2;
-            Float2 &factor = (out_x + 4 < out_center.x) ? _left_factors[out_y] : _right_factors[out_y];
-            Float2 &step = (out_x + 4 < out_center.x) ? _left_steps[out_y] : _right_steps[out_y];
+            const RowFactors *rows = (out_x + 4 < out_center.x) ? left_rows : right_rows;
+            const Float2 &factor = rows->factors[out_y];
+            const Float2 &step = rows->steps[out_y];
 
             // calculate 8x2 luma, center aligned
             Float2 out_pos (out_x, out_y);
@@ -374,6 +423,25 @@ GeoMapDualCurveTask::work_range (const SmartPtr<Arguments> &base, const WorkRang
     return XCAM_RETURN_NO_ERROR;
 }
 
+XCamReturn
+FisheyeTableTask::work_range (const SmartPtr<Arguments> &base, const WorkRange &range)
+{
+    SmartPtr<FisheyeTableTask::Args> args = base.dynamic_cast_ptr<FisheyeTableTask::Args> ();
+    XCAM_ASSERT (args.ptr () && args->dewarp.ptr ());
+    XCAM_ASSERT (args->table.size () >= args->table_width * args->table_height);
+
+    args->dewarp->fisheye_dewarp_rows (
+        args->table, args->table_width, args->table_height,
+        args->image_width, args->image_height, args->bowl,
+        range.pos[1], range.pos_len[1]);
+
+    XCAM_LOG_DEBUG (
+        "FisheyeTableTask(idx:%d) work on rows:[%d, %d)",
+        args->idx, range.pos[1], range.pos[1] + range.pos_len[1]);
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
 }
 
 }
@@ -25,6 +25,7 @@
 #include <soft/soft_worker.h>
 #include <soft/soft_image.h>
 #include <soft/soft_handler.h>
+#include <surview_fisheye_dewarp.h>
 
 namespace XCam {
 
@@ -53,6 +54,14 @@ public:
         set_work_uint (8, 2);
     }
 
+    // remap area of a view_width x view_height output view into out images starting at area position,
+    // out images need to hold area width aligned to 8 and height aligned to 2
+    static void map_area (
+        const UcharImage *in_luma, const Uchar2Image *in_uv,
+        UcharImage *out_luma, Uchar2Image *out_uv,
+        const Float2Image *lut, const Float2 &factors,
+        const Rect &area, uint32_t view_width, uint32_t view_height);
+
 private:
     virtual XCamReturn work_range (const SmartPtr<Arguments> &args, const WorkRange &range);
 };
@@ -86,7 +95,17 @@ class GeoMapDualCurveTask
     : public GeoMapDualConstTask
 {
 public:
+    // per output row factors and steps of one side, read only once passed to work items
+    struct RowFactors {
+        Float2                factor;
+        std::vector<Float2>   factors;
+        std::vector<Float2>   steps;
+    };
+
     struct Args : GeoMapDualConstTask::Args {
+        SmartPtr<RowFactors>  left_rows;
+        SmartPtr<RowFactors>  right_rows;
+
         Args (
             const SmartPtr<ImageHandler::Parameters> &param)
             : GeoMapDualConstTask::Args (param)
@@ -105,22 +124,57 @@ public:
     void set_left_std_factor (float x, float y);
     void set_right_std_factor (float x, float y);
 
+    // call before work(), only the side whose factor changed is recalculated,
+    // into a new RowFactors, frames still in processing keep the previous one
+    bool update_row_factors (const SmartPtr<GeoMapDualCurveTask::Args> &args, uint32_t height);
+
 private:
-    void set_factors (SmartPtr<GeoMapDualCurveTask::Args> args, uint32_t size);
-    bool set_steps (uint32_t size);
+    SmartPtr<RowFactors> calc_row_factors (
+        const SmartPtr<RowFactors> &last, const Float2 &std_factor, const Float2 &factor, uint32_t height);
 
     virtual XCamReturn work_range (const SmartPtr<Arguments> &args, const WorkRange &range);
 
     XCAM_DEAD_COPY (GeoMapDualCurveTask);
 
 private:
-    float        _scaled_height;
-    Float2       _left_std_factor;
-    Float2       _right_std_factor;
-    Float2       *_left_factors;
-    Float2       *_right_factors;
-    Float2       *_left_steps;
-    Float2       *_right_steps;
+    float                 _scaled_height;
+    Float2                _left_std_factor;
+    Float2                _right_std_factor;
+    SmartPtr<RowFactors>  _left_rows;
+    SmartPtr<RowFactors>  _right_rows;
+};
+
+/* generate fisheye dewarp lookup table, each work unit fills one table row.
+ * table needs to be allocated in table_width x table_height before work.
+ */
+class FisheyeTableTask
+    : public SoftWorker
+{
+public:
+    struct Args : SoftArgs {
+        SmartPtr<SurViewFisheyeDewarp>    dewarp;
+        SurViewFisheyeDewarp::MapTable    table;
+        uint32_t                          table_width, table_height;
+        uint32_t                          image_width, image_height;
+        BowlDataConfig                    bowl;
+        uint32_t                          idx;
+
+        Args (uint32_t i)
+            : table_width (0), table_height (0)
+            , image_width (0), image_height (0)
+            , idx (i)
+        {}
+    };
+
+public:
+    explicit FisheyeTableTask (const SmartPtr<Worker::Callback> &cb)
+        : SoftWorker ("FisheyeTableTask", cb)
+    {
+        set_work_uint (1, 1);
+    }
+
+private:
+    virtual XCamReturn work_range (const SmartPtr<Arguments> &args, const WorkRange &range);
 };
 
 }
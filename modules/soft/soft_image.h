@@ -24,7 +24,7 @@
 #include <xcam_std.h>
 #include <video_buffer.h>
 #include <vec_mat.h>
-#include <file_handle.h>
+#include <image_file_handle.h>
 
 namespace XCam {
 
@@ -295,16 +295,19 @@ typedef SoftImage<Float2> Float2Image;
 
 template <class SoftImageT>
 class SoftImageFile
-    : public FileHandle
+    : public ImageFileHandle
 {
 public:
     SoftImageFile () {}
     explicit SoftImageFile (const char *name, const char *option)
-        : FileHandle (name, option)
+        : ImageFileHandle (name, option)
     {}
 
     inline XCamReturn read_buf (const SmartPtr<SoftImageT> &buf);
     inline XCamReturn write_buf (const SmartPtr<SoftImageT> &buf);
+
+    // image aliasing file pages, file must be mapped by map_file
+    inline XCamReturn read_mapped_buf (SmartPtr<SoftImageT> &buf, uint32_t width, uint32_t height);
 };
 
 template <class SoftImageT>
@@ -323,6 +326,21 @@ SoftImageFile<SoftImageT>::read_buf (const SmartPtr<SoftImageT> &buf)
     uint32_t height = buf->get_height ();
     uint32_t line_bytes = buf->get_width () * buf->pixel_size ();
 
+    if (is_mapped ()) {
+        uint8_t *src = NULL;
+        XCAM_FAIL_RETURN (
+            WARNING, map_next_bytes (line_bytes * height, src) == XCAM_RETURN_NO_ERROR, XCAM_RETURN_ERROR_FILE,
+            "soft image file(%s) read buf failed, file size doesn't match", XCAM_STR (get_file_name ()));
+
+        if (buf->get_pitch () == line_bytes) {
+            memcpy (buf->get_buf_ptr (0, 0), src, line_bytes * height);
+        } else {
+            for (uint32_t index = 0; index < height; index++)
+                memcpy (buf->get_buf_ptr (0, index), src + index * line_bytes, line_bytes);
+        }
+        return XCAM_RETURN_NO_ERROR;
+    }
+
     for (uint32_t index = 0; index < height; index++) {
         uint8_t *line_ptr = buf->get_buf_ptr (0, index);
         XCAM_FAIL_RETURN (
@@ -332,6 +350,26 @@ SoftImageFile<SoftImageT>::read_buf (const SmartPtr<SoftImageT> &buf)
     return XCAM_RETURN_NO_ERROR;
 }
 
+template <class SoftImageT>
+inline XCamReturn
+SoftImageFile<SoftImageT>::read_mapped_buf (SmartPtr<SoftImageT> &buf, uint32_t width, uint32_t height)
+{
+    XCAM_FAIL_RETURN (
+        WARNING, is_mapped (), XCAM_RETURN_ERROR_ORDER,
+        "soft image file(%s) read mapped buf failed, file is not mapped", XCAM_STR (get_file_name ()));
+
+    uint32_t line_bytes = width * sizeof (typename SoftImageT::Type);
+    uint8_t *src = NULL;
+    XCamReturn ret = map_next_bytes (line_bytes * height, src);
+    if (ret != XCAM_RETURN_NO_ERROR)
+        return ret;
+
+    VideoBufferInfo info;
+    info.init (V4L2_PIX_FMT_GREY, line_bytes, height, line_bytes, height);
+    buf = new SoftImageT (create_mapped_buf (info, src), width, height, line_bytes, 0);
+    return XCAM_RETURN_NO_ERROR;
+}
+
 template <class SoftImageT>
 inline XCamReturn
 SoftImageFile<SoftImageT>::write_buf (const SmartPtr<SoftImageT> &buf)
@@ -0,0 +1,252 @@
+/*
+ * soft_image_warp_handler.cpp - soft image warp handler implementation
+ *
+ *  Copyright (c) 2017 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#include "soft_image_warp_handler.h"
+#include "soft_image_warp_tasks_priv.h"
+
+#define XCAM_SOFT_WARP_ALIGNMENT_X 8
+#define XCAM_SOFT_WARP_ALIGNMENT_Y 2
+#define XCAM_SOFT_WARP_DEFAULT_TRIM_RATIO 0.05f
+
+namespace XCam {
+
+DECLARE_WORK_CALLBACK (CbImageWarpTask, SoftImageWarpHandler, warp_task_done);
+
+static void
+init_identity_config (XCamDVSResult &config)
+{
+    xcam_mem_clear (config);
+    config.frame_id = -1;
+    config.proj_mat[0] = 1.0;
+    config.proj_mat[4] = 1.0;
+    config.proj_mat[8] = 1.0;
+}
+
+/* same adjustments as CLImageWarpKernel
+ * H(uv) = [0.5, 0, 0; 0, 0.5, 0; 0, 0, 1] * H(y) * [2, 0, 0; 0, 2, 0; 0, 0, 1]
+ * TMat = [scale_x, 0, shift_x; 0, scale_y, shift_y; 0, 0, 1], warp matrix = TMat * HMat
+ */
+static void
+calc_plane_matrix (
+    const XCamDVSResult &config, const float trim_ratio,
+    const uint32_t in_width, const uint32_t in_height,
+    const uint32_t plane_width, const uint32_t plane_height, const bool is_uv,
+    float *mat)
+{
+    double m[9];
+    for (uint32_t i = 0; i < 9; ++i)
+        m[i] = config.proj_mat[i];
+
+    double sample_rate_x = config.frame_width > 0 ? (double)config.frame_width / in_width : 1.0;
+    double sample_rate_y = config.frame_height > 0 ? (double)config.frame_height / in_height : 1.0;
+    m[2] /= sample_rate_x;
+    m[5] /= sample_rate_y;
+    m[6] *= sample_rate_x;
+    m[7] *= sample_rate_y;
+
+    if (is_uv) {
+        m[2] *= 0.5;
+        m[5] *= 0.5;
+        m[6] *= 2.0;
+        m[7] *= 2.0;
+    }
+
+    double shift_x = trim_ratio * plane_width;
+    double shift_y = trim_ratio * plane_height;
+    double scale = 1.0 - 2.0 * trim_ratio;
+    for (uint32_t i = 0; i < 3; ++i) {
+        mat[i] = scale * m[i] + shift_x * m[6 + i];
+        mat[3 + i] = scale * m[3 + i] + shift_y * m[6 + i];
+        mat[6 + i] = m[6 + i];
+    }
+}
+
+SoftImageWarpHandler::SoftImageWarpHandler (const char *name)
+    : SoftHandler (name)
+    , _trim_ratio (XCAM_SOFT_WARP_DEFAULT_TRIM_RATIO)
+{
+    init_identity_config (_cur_config);
+}
+
+SoftImageWarpHandler::~SoftImageWarpHandler ()
+{
+}
+
+bool
+SoftImageWarpHandler::set_warp_config (const XCamDVSResult &config)
+{
+    XCAM_LOG_DEBUG ("SoftImageWarpHandler(%s) warp_mat{%d}=[%f, %f, %f; %f, %f, %f; %f, %f, %f]",
+                    XCAM_STR (get_name ()), config.frame_id,
+                    config.proj_mat[0], config.proj_mat[1], config.proj_mat[2],
+                    config.proj_mat[3], config.proj_mat[4], config.proj_mat[5],
+                    config.proj_mat[6], config.proj_mat[7], config.proj_mat[8]);
+
+    SmartLock locker (_config_mutex);
+    _config_list.push_back (config);
+    return true;
+}
+
+bool
+SoftImageWarpHandler::set_trim_ratio (float ratio)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, ratio >= 0.0f && ratio < 0.5f, false,
+        "SoftImageWarpHandler(%s) trim ratio(%f) should be in [0, 0.5)",
+        XCAM_STR (get_name ()), ratio);
+
+    _trim_ratio = ratio;
+    return true;
+}
+
+XCamReturn
+SoftImageWarpHandler::warp (
+    const SmartPtr<VideoBuffer> &in,
+    SmartPtr<VideoBuffer> &out_buf)
+{
+    SmartPtr<ImageHandler::Parameters> param = new ImageHandler::Parameters (in, out_buf);
+    XCamReturn ret = execute_buffer (param, true);
+    if (ret == XCAM_RETURN_NO_ERROR && !out_buf.ptr ()) {
+        out_buf = param->out_buf;
+    }
+
+    return ret;
+}
+
+XCamReturn
+SoftImageWarpHandler::configure_resource (const SmartPtr<Parameters> &param)
+{
+    const VideoBufferInfo &in_info = param->in_buf->get_video_info ();
+    XCAM_FAIL_RETURN (
+        ERROR, in_info.format == V4L2_PIX_FMT_NV12, XCAM_RETURN_ERROR_PARAM,
+        "SoftImageWarpHandler(%s) only support format(NV12) but input format is %s",
+        XCAM_STR (get_name ()), xcam_fourcc_to_string (in_info.format));
+    XCAM_FAIL_RETURN (
+        ERROR, in_info.width >= 2 && in_info.height >= 2 && in_info.width % 2 == 0 && in_info.height % 2 == 0,
+        XCAM_RETURN_ERROR_PARAM,
+        "SoftImageWarpHandler(%s) unsupported input size(%dx%d)",
+        XCAM_STR (get_name ()), in_info.width, in_info.height);
+
+    VideoBufferInfo out_info;
+    out_info.init (
+        in_info.format, in_info.width, in_info.height,
+        XCAM_ALIGN_UP (in_info.width, XCAM_SOFT_WARP_ALIGNMENT_X),
+        XCAM_ALIGN_UP (in_info.height, XCAM_SOFT_WARP_ALIGNMENT_Y));
+    set_out_video_info (out_info);
+
+    XCAM_ASSERT (!_warp_task.ptr ());
+    _warp_task = new XCamSoftTasks::ImageWarpTask (new CbImageWarpTask (this));
+    XCAM_ASSERT (_warp_task.ptr ());
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+SoftImageWarpHandler::start_work (const SmartPtr<ImageHandler::Parameters> &param)
+{
+    XCAM_ASSERT (_warp_task.ptr ());
+    XCAM_ASSERT (param->in_buf.ptr () && param->out_buf.ptr ());
+
+    {
+        SmartLock locker (_config_mutex);
+        if (!_config_list.empty ()) {
+            _cur_config = _config_list.front ();
+            _config_list.pop_front ();
+        }
+    }
+
+    SmartPtr<VideoBuffer> in_buf = param->in_buf, out_buf = param->out_buf;
+    const VideoBufferInfo &in_info = in_buf->get_video_info ();
+    const VideoBufferInfo &out_info = out_buf->get_video_info ();
+
+    SmartPtr<XCamSoftTasks::ImageWarpTask::Args> args = new XCamSoftTasks::ImageWarpTask::Args (param);
+    args->in_luma = new UcharImage (in_buf, 0);
+    args->in_uv = new Uchar2Image (in_buf, 1);
+    args->out_luma = new UcharImage (out_buf, 0);
+    args->out_uv = new Uchar2Image (out_buf, 1);
+    calc_plane_matrix (
+        _cur_config, _trim_ratio, in_info.width, in_info.height,
+        out_info.width, out_info.height, false, args->luma_mat);
+    calc_plane_matrix (
+        _cur_config, _trim_ratio, in_info.width, in_info.height,
+        out_info.width / 2, out_info.height / 2, true, args->uv_mat);
+
+    WorkSize work_unit = _warp_task->get_work_uint ();
+    WorkSize global_size (
+        xcam_ceil (out_info.width, work_unit.value[0]) / work_unit.value[0],
+        xcam_ceil (out_info.height, work_unit.value[1]) / work_unit.value[1]);
+    // full-width row bands, positions are stepped along each row
+    WorkSize local_size (
+        global_size.value[0],
+        xcam_ceil (global_size.value[1], 4) / 4);
+    _warp_task->set_local_size (local_size);
+    _warp_task->set_global_size (global_size);
+
+    param->in_buf.release ();
+    XCamReturn ret = _warp_task->work (args);
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "SoftImageWarpHandler(%s) start_work failed", XCAM_STR (get_name ()));
+
+    return ret;
+}
+
+XCamReturn
+SoftImageWarpHandler::terminate ()
+{
+    if (_warp_task.ptr ()) {
+        _warp_task->stop ();
+        _warp_task.release ();
+    }
+
+    {
+        SmartLock locker (_config_mutex);
+        _config_list.clear ();
+    }
+    init_identity_config (_cur_config);
+    return SoftHandler::terminate ();
+}
+
+void
+SoftImageWarpHandler::warp_task_done (
+    const SmartPtr<Worker> &worker, const SmartPtr<Worker::Arguments> &base, const XCamReturn error)
+{
+    XCAM_UNUSED (worker);
+    XCAM_ASSERT (worker.ptr () == _warp_task.ptr ());
+
+    SmartPtr<XCamSoftTasks::ImageWarpTask::Args> args = base.dynamic_cast_ptr<XCamSoftTasks::ImageWarpTask::Args> ();
+    XCAM_ASSERT (args.ptr ());
+
+    const SmartPtr<ImageHandler::Parameters> param = args->get_param ();
+    if (!check_work_continue (param, error))
+        return;
+
+    work_well_done (param, error);
+}
+
+SmartPtr<SoftHandler>
+create_soft_image_warp_handler ()
+{
+    SmartPtr<SoftImageWarpHandler> warp = new SoftImageWarpHandler ();
+    XCAM_ASSERT (warp.ptr ());
+
+    return warp;
+}
+
+}
@@ -0,0 +1,83 @@
+/*
+ * soft_image_warp_handler.h - soft image warp handler class
+ *
+ *  Copyright (c) 2017 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#ifndef XCAM_SOFT_IMAGE_WARP_HANDLER_H
+#define XCAM_SOFT_IMAGE_WARP_HANDLER_H
+
+#include <xcam_std.h>
+#include <xcam_mutex.h>
+#include <base/xcam_smart_result.h>
+#include <soft/soft_handler.h>
+
+namespace XCam {
+
+namespace XCamSoftTasks {
+class ImageWarpTask;
+};
+
+/* NV12 projective warp, same matrix convention as CLImageWarpHandler.
+ * proj_mat maps output pixels to input pixels of a frame_width x frame_height image.
+ * queued configs are consumed one per frame, the last one is kept when queue is empty.
+ */
+class SoftImageWarpHandler
+    : public SoftHandler
+{
+    typedef std::list<XCamDVSResult> WarpConfigList;
+
+public:
+    SoftImageWarpHandler (const char *name = "SoftImageWarpHandler");
+    ~SoftImageWarpHandler ();
+
+    bool set_warp_config (const XCamDVSResult &config);
+    bool set_trim_ratio (float ratio);
+    float get_trim_ratio () const {
+        return _trim_ratio;
+    }
+
+    XCamReturn warp (
+        const SmartPtr<VideoBuffer> &in,
+        SmartPtr<VideoBuffer> &out_buf);
+
+    //derived from SoftHandler
+    virtual XCamReturn terminate ();
+
+    void warp_task_done (
+        const SmartPtr<Worker> &worker, const SmartPtr<Worker::Arguments> &args, const XCamReturn error);
+
+protected:
+    //derived from SoftHandler
+    XCamReturn configure_resource (const SmartPtr<Parameters> &param);
+    XCamReturn start_work (const SmartPtr<Parameters> &param);
+
+private:
+    XCAM_DEAD_COPY (SoftImageWarpHandler);
+
+private:
+    float                                   _trim_ratio;
+    Mutex                                   _config_mutex;
+    WarpConfigList                          _config_list;
+    XCamDVSResult                           _cur_config;
+    SmartPtr<XCamSoftTasks::ImageWarpTask>  _warp_task;
+};
+
+extern SmartPtr<SoftHandler> create_soft_image_warp_handler ();
+
+}
+#endif //XCAM_SOFT_IMAGE_WARP_HANDLER_H
@@ -0,0 +1,163 @@
+/*
+ * soft_image_warp_tasks_priv.cpp - soft image warp tasks implementation
+ *
+ *  Copyright (c) 2017 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#include "soft_image_warp_tasks_priv.h"
+
+#define FIX_BITS XCAM_SOFT_WARP_FIX_BITS
+#define FIX_ONE (1 << FIX_BITS)
+#define FIX_MASK (FIX_ONE - 1)
+#define FIX_ROUND (1 << (FIX_BITS * 2 - 1))
+
+namespace XCam {
+
+namespace XCamSoftTasks {
+
+// homogeneous source position of the first pixel in row, doubles keep the stepping error small
+static inline void
+row_origin (const float *m, const uint32_t x, const uint32_t y, double *base)
+{
+    base[0] = (double)m[0] * x + (double)m[1] * y + m[2];
+    base[1] = (double)m[3] * x + (double)m[4] * y + m[5];
+    base[2] = (double)m[6] * x + (double)m[7] * y + m[8];
+}
+
+static inline void
+step_origin (const float *m, const uint32_t n, double *base)
+{
+    base[0] += (double)m[0] * n;
+    base[1] += (double)m[3] * n;
+    base[2] += (double)m[6] * n;
+}
+
+// N source positions in Q8, clamped to edge
+template <uint32_t N>
+static inline void
+calc_positions (
+    const double *base, const float *m, const float max_x, const float max_y,
+    int32_t *pos_x, int32_t *pos_y)
+{
+    const float bx = base[0], by = base[1], bw = base[2];
+    for (uint32_t i = 0; i < N; ++i) {
+        float sx = bx + m[0] * i;
+        float sy = by + m[3] * i;
+        float sw = bw + m[6] * i;
+        float inv_w = (sw != 0.0f) ? 1.0f / sw : 0.0f;
+        sx = XCAM_CLAMP (sx * inv_w, 0.0f, max_x);
+        sy = XCAM_CLAMP (sy * inv_w, 0.0f, max_y);
+        pos_x[i] = (int32_t)(sx * FIX_ONE + 0.5f);
+        pos_y[i] = (int32_t)(sy * FIX_ONE + 0.5f);
+    }
+}
+
+static inline int32_t
+bilinear (
+    const int32_t p00, const int32_t p01, const int32_t p10, const int32_t p11,
+    const int32_t fx, const int32_t fy)
+{
+    int32_t top = (p00 << FIX_BITS) + (p01 - p00) * fx;
+    int32_t bottom = (p10 << FIX_BITS) + (p11 - p10) * fx;
+    return ((top << FIX_BITS) + (bottom - top) * fy + FIX_ROUND) >> (FIX_BITS * 2);
+}
+
+template <uint32_t N>
+static inline void
+gather_luma (
+    const UcharImage *in, const int32_t *pos_x, const int32_t *pos_y, Uchar *out)
+{
+    const int32_t max_x = in->get_width () - 1;
+    const int32_t max_y = in->get_height () - 1;
+
+    for (uint32_t i = 0; i < N; ++i) {
+        int32_t x0 = pos_x[i] >> FIX_BITS, y0 = pos_y[i] >> FIX_BITS;
+        int32_t x1 = x0 + (x0 < max_x), y1 = y0 + (y0 < max_y);
+        const Uchar *row0 = in->get_buf_ptr (0, y0), *row1 = in->get_buf_ptr (0, y1);
+        out[i] = (Uchar)bilinear (
+                     row0[x0], row0[x1], row1[x0], row1[x1], pos_x[i] & FIX_MASK, pos_y[i] & FIX_MASK);
+    }
+}
+
+template <uint32_t N>
+static inline void
+gather_uv (
+    const Uchar2Image *in, const int32_t *pos_x, const int32_t *pos_y, Uchar2 *out)
+{
+    const int32_t max_x = in->get_width () - 1;
+    const int32_t max_y = in->get_height () - 1;
+
+    for (uint32_t i = 0; i < N; ++i) {
+        int32_t x0 = pos_x[i] >> FIX_BITS, y0 = pos_y[i] >> FIX_BITS;
+        int32_t x1 = x0 + (x0 < max_x), y1 = y0 + (y0 < max_y);
+        int32_t fx = pos_x[i] & FIX_MASK, fy = pos_y[i] & FIX_MASK;
+        const Uchar2 *row0 = in->get_buf_ptr (0, y0), *row1 = in->get_buf_ptr (0, y1);
+        out[i].x = (Uchar)bilinear (row0[x0].x, row0[x1].x, row1[x0].x, row1[x1].x, fx, fy);
+        out[i].y = (Uchar)bilinear (row0[x0].y, row0[x1].y, row1[x0].y, row1[x1].y, fx, fy);
+    }
+}
+
+XCamReturn
+ImageWarpTask::work_range (const SmartPtr<Arguments> &base, const WorkRange &range)
+{
+    SmartPtr<ImageWarpTask::Args> args = base.dynamic_cast_ptr<ImageWarpTask::Args> ();
+    XCAM_ASSERT (args.ptr ());
+    UcharImage *in_luma = args->in_luma.ptr (), *out_luma = args->out_luma.ptr ();
+    Uchar2Image *in_uv = args->in_uv.ptr (), *out_uv = args->out_uv.ptr ();
+    XCAM_ASSERT (in_luma && in_uv);
+    XCAM_ASSERT (out_luma && out_uv);
+
+    const float *luma_mat = args->luma_mat, *uv_mat = args->uv_mat;
+    const float luma_max_x = in_luma->get_width () - 1.0f, luma_max_y = in_luma->get_height () - 1.0f;
+    const float uv_max_x = in_uv->get_width () - 1.0f, uv_max_y = in_uv->get_height () - 1.0f;
+
+    int32_t pos_x[8], pos_y[8];
+    Uchar luma[8];
+    Uchar2 uv[4];
+    double origin[3];
+
+    for (uint32_t y = range.pos[1]; y < range.pos[1] + range.pos_len[1]; ++y) {
+        for (uint32_t line = 0; line < 2; ++line) {
+            uint32_t out_y = y * 2 + line;
+            row_origin (luma_mat, range.pos[0] * 8, out_y, origin);
+            for (uint32_t x = range.pos[0]; x < range.pos[0] + range.pos_len[0]; ++x) {
+                calc_positions<8> (origin, luma_mat, luma_max_x, luma_max_y, pos_x, pos_y);
+                gather_luma<8> (in_luma, pos_x, pos_y, luma);
+                out_luma->write_array_no_check<8> (x * 8, out_y, luma);
+                step_origin (luma_mat, 8, origin);
+            }
+        }
+
+        row_origin (uv_mat, range.pos[0] * 4, y, origin);
+        for (uint32_t x = range.pos[0]; x < range.pos[0] + range.pos_len[0]; ++x) {
+            calc_positions<4> (origin, uv_mat, uv_max_x, uv_max_y, pos_x, pos_y);
+            gather_uv<4> (in_uv, pos_x, pos_y, uv);
+            out_uv->write_array_no_check<4> (x * 4, y, uv);
+            step_origin (uv_mat, 4, origin);
+        }
+    }
+
+    XCAM_LOG_DEBUG (
+        "ImageWarpTask work on range:[x:%d, width:%d, y:%d, height:%d]",
+        range.pos[0], range.pos_len[0], range.pos[1], range.pos_len[1]);
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+}
+
+}
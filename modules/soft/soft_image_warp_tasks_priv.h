@@ -0,0 +1,73 @@
+/*
+ * soft_image_warp_tasks_priv.h - soft image warp tasks
+ *
+ *  Copyright (c) 2017 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#ifndef XCAM_SOFT_IMAGE_WARP_TASKS_PRIV_H
+#define XCAM_SOFT_IMAGE_WARP_TASKS_PRIV_H
+
+#include <xcam_std.h>
+#include <soft/soft_worker.h>
+#include <soft/soft_image.h>
+#include <soft/soft_handler.h>
+
+// bilinear weights and source positions are in Q8
+#define XCAM_SOFT_WARP_FIX_BITS 8
+
+namespace XCam {
+
+namespace XCamSoftTasks {
+
+/* each work unit warps 8x2 luma pixels and 4x1 UV pixels.
+ * source positions are stepped along the output row, only the start of each 8 pixels
+ * block is derived from the row origin, so there is no matrix multiply per pixel.
+ */
+class ImageWarpTask
+    : public SoftWorker
+{
+public:
+    struct Args : SoftArgs {
+        SmartPtr<UcharImage>        in_luma, out_luma;
+        SmartPtr<Uchar2Image>       in_uv, out_uv;
+        float                       luma_mat[9];
+        float                       uv_mat[9];
+
+        Args (const SmartPtr<ImageHandler::Parameters> &param)
+            : SoftArgs (param)
+        {
+            xcam_mem_clear (luma_mat);
+            xcam_mem_clear (uv_mat);
+        }
+    };
+
+public:
+    explicit ImageWarpTask (const SmartPtr<Worker::Callback> &cb)
+        : SoftWorker ("ImageWarpTask", cb)
+    {
+        set_work_uint (8, 2);
+    }
+
+private:
+    virtual XCamReturn work_range (const SmartPtr<Arguments> &args, const WorkRange &range);
+};
+
+}
+
+}
+
+#endif //XCAM_SOFT_IMAGE_WARP_TASKS_PRIV_H
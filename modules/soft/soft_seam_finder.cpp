@@ -0,0 +1,182 @@
+/*
+ * soft_seam_finder.cpp - soft seam finder implementation
+ *
+ *  Copyright (c) 2017 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#include "soft_seam_finder.h"
+#include <float.h>
+#include <math.h>
+
+// cost of moving seam one column away from last seam
+#define SEAM_TEMPORAL_WEIGHT 4.0f
+// weight of new seam in temporal smoothing
+#define SEAM_SMOOTH_FACTOR 0.25f
+// mask seam positions are compared in 1/4 pixel
+#define SEAM_MASK_PRECISION 4.0f
+
+namespace XCam {
+
+SoftSeamFinder::SoftSeamFinder (uint32_t band_width)
+    : _band_width (band_width)
+    , _scale (1)
+{
+    XCAM_ASSERT (band_width > 0);
+}
+
+void
+SoftSeamFinder::reset ()
+{
+    _seam.clear ();
+    _mask_seam.clear ();
+}
+
+XCamReturn
+SoftSeamFinder::find_seam (
+    const UcharImage *luma0, const UcharImage *luma1,
+    uint32_t width, uint32_t height, uint32_t scale)
+{
+    XCAM_ASSERT (luma0 && luma1 && scale);
+    uint32_t margin = (_band_width / 2 + scale - 1) / scale + 1;
+
+    XCAM_FAIL_RETURN (
+        ERROR,
+        height > 0 && width > margin * 2 &&
+        width <= luma0->get_width () && width <= luma1->get_width () &&
+        height <= luma0->get_height () && height <= luma1->get_height (),
+        XCAM_RETURN_ERROR_PARAM,
+        "seam finder failed, size(%dx%d) invalid, margin:%d", width, height, margin);
+
+    if (_seam.size () != height || _scale != scale)
+        reset ();
+    _scale = scale;
+
+    _acc_cost.resize (width * height);
+    _path.resize (width * height);
+
+    for (uint32_t y = 0; y < height; ++y) {
+        const Uchar *line0 = luma0->get_buf_ptr (0, y);
+        const Uchar *line1 = luma1->get_buf_ptr (0, y);
+        float *acc = &_acc_cost[y * width];
+        const float *last_acc = (y > 0) ? &_acc_cost[(y - 1) * width] : NULL;
+        int8_t *path = &_path[y * width];
+
+        for (uint32_t x = 0; x < width; ++x) {
+            path[x] = 0;
+            if (x < margin || x >= width - margin) {
+                acc[x] = FLT_MAX;
+                continue;
+            }
+
+            float cost = abs ((int32_t)line0[x] - (int32_t)line1[x]);
+            if (!_seam.empty ())
+                cost += SEAM_TEMPORAL_WEIGHT * fabs (x - _seam[y]);
+
+            if (last_acc) {
+                float min_acc = last_acc[x];
+                if (last_acc[x - 1] < min_acc) {
+                    min_acc = last_acc[x - 1];
+                    path[x] = -1;
+                }
+                if (last_acc[x + 1] < min_acc) {
+                    min_acc = last_acc[x + 1];
+                    path[x] = 1;
+                }
+                cost += min_acc;
+            }
+            acc[x] = cost;
+        }
+    }
+
+    const float *last_line = &_acc_cost[(height - 1) * width];
+    int32_t pos = margin;
+    for (uint32_t x = margin; x < width - margin; ++x) {
+        if (last_line[x] < last_line[pos])
+            pos = x;
+    }
+
+    std::vector<float> seam (height);
+    for (int32_t y = height - 1; y >= 0; --y) {
+        seam[y] = pos;
+        pos += _path[y * width + pos];
+    }
+
+    if (_seam.empty ()) {
+        _seam.swap (seam);
+    } else {
+        for (uint32_t y = 0; y < height; ++y)
+            _seam[y] += (seam[y] - _seam[y]) * SEAM_SMOOTH_FACTOR;
+    }
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+uint32_t
+SoftSeamFinder::update_mask (const SmartPtr<UcharImage> &last, SmartPtr<UcharImage> &mask)
+{
+    XCAM_ASSERT (last.ptr () && last->is_valid ());
+    if (_seam.empty ())
+        return 0;
+
+    uint32_t width = last->get_width ();
+    uint32_t height = last->get_height ();
+    uint32_t seam_height = _seam.size ();
+    std::vector<float> row_seam (height);
+    uint32_t changed = 0;
+
+    if (_mask_seam.size () != height)
+        _mask_seam.assign (height, INT32_MIN);
+
+    for (uint32_t y = 0; y < height; ++y) {
+        // seam of mask row is interpolated between seam level rows
+        float pos = XCAM_CLAMP ((y + 0.5f) / _scale - 0.5f, 0.0f, seam_height - 1.0f);
+        uint32_t top = (uint32_t)pos;
+        uint32_t bottom = XCAM_MIN (top + 1, seam_height - 1);
+        float seam = _seam[top] + (_seam[bottom] - _seam[top]) * (pos - top);
+
+        row_seam[y] = (seam + 0.5f) * _scale - 0.5f;
+        if ((int32_t)(row_seam[y] * SEAM_MASK_PRECISION + 0.5f) != _mask_seam[y])
+            ++changed;
+    }
+
+    if (!changed)
+        return 0;
+
+    mask = new UcharImage (width, height, last->get_pitch ());
+    XCAM_FAIL_RETURN (
+        ERROR, mask.ptr () && mask->is_valid (), 0,
+        "seam finder allocate mask(%dx%d) failed", width, height);
+    memcpy (mask->get_buf_ptr (0, 0), last->get_buf_ptr (0, 0), last->get_pitch () * height);
+
+    float half_band = _band_width / 2.0f;
+    for (uint32_t y = 0; y < height; ++y) {
+        int32_t mask_seam = (int32_t)(row_seam[y] * SEAM_MASK_PRECISION + 0.5f);
+        if (mask_seam == _mask_seam[y])
+            continue;
+
+        _mask_seam[y] = mask_seam;
+        Uchar *line = mask->get_buf_ptr (0, y);
+        for (uint32_t x = 0; x < width; ++x) {
+            float weight = (row_seam[y] + half_band - x) / _band_width;
+            line[x] = (Uchar)(XCAM_CLAMP (weight, 0.0f, 1.0f) * 255.0f + 0.5f);
+        }
+    }
+
+    return changed;
+}
+
+}
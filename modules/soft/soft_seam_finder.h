@@ -0,0 +1,64 @@
+/*
+ * soft_seam_finder.h - soft seam finder class
+ *
+ *  Copyright (c) 2017 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#ifndef XCAM_SOFT_SEAM_FINDER_H
+#define XCAM_SOFT_SEAM_FINDER_H
+
+#include <xcam_std.h>
+#include <soft/soft_image.h>
+
+namespace XCam {
+
+/* vertical seam of two overlapped images by dynamic programming, seam moves at most one
+ * column per row, the cost is luma difference plus distance to the last seam.
+ * seam is found on a scaled down level and smoothed over frames, then converted to a blend mask
+ * of full level, which is 255 on the left of seam, 0 on the right and linear in the band between.
+ */
+class SoftSeamFinder
+{
+public:
+    explicit SoftSeamFinder (uint32_t band_width);
+
+    void reset ();
+
+    // scale is the ratio of mask level to seam level
+    XCamReturn find_seam (
+        const UcharImage *luma0, const UcharImage *luma1,
+        uint32_t width, uint32_t height, uint32_t scale);
+
+    // only rows whose seam moved are rewritten, into a copy of last mask,
+    // returns the changed row count, mask is untouched if nothing changed
+    uint32_t update_mask (const SmartPtr<UcharImage> &last, SmartPtr<UcharImage> &mask);
+
+private:
+    XCAM_DEAD_COPY (SoftSeamFinder);
+
+private:
+    uint32_t                _band_width;
+    uint32_t                _scale;
+    std::vector<float>      _seam;
+    std::vector<float>      _acc_cost;
+    std::vector<int8_t>     _path;
+    std::vector<int32_t>    _mask_seam;
+};
+
+}
+
+#endif //XCAM_SOFT_SEAM_FINDER_H
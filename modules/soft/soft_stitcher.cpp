@@ -21,12 +21,16 @@
 #include "soft_stitcher.h"
 #include "soft_blender.h"
 #include "soft_geo_mapper.h"
+#include "soft_geo_tasks_priv.h"
 #include "soft_video_buf_allocator.h"
 #include "interface/feature_match.h"
 #include "surview_fisheye_dewarp.h"
+#include "geo_map_table_cache.h"
 #include "soft_copy_task.h"
 #include "xcam_utils.h"
 #include <map>
+#include <list>
+#include <float.h>
 
 #define ENABLE_FEATURE_MATCH HAVE_OPENCV
 
@@ -35,6 +39,9 @@
 #ifndef ANDROID
 #include <opencv2/core/ocl.hpp>
 #endif
+
+// feature match runs on blender gauss level of this level if preview is disabled
+#define SOFT_STITCHER_FM_LEVEL 1
 #endif
 
 #define SOFT_STITCHER_ALIGNMENT_X 8
@@ -43,6 +50,27 @@
 #define MAP_FACTOR_X  16
 #define MAP_FACTOR_Y  16
 
+// row bands of each camera's dewarp table built in parallel
+#define SOFT_STITCHER_TABLE_BANDS 4
+
+// fused tiles engine, copy areas are cut into vertical tiles of this width,
+// tiles are spread over work items in turn
+#define SOFT_STITCHER_TILE_WIDTH 128
+#define SOFT_STITCHER_TILE_ITEMS 8
+
+// static scene, input images are compared with last rendered content in blocks of this size
+#define SOFT_STITCHER_STATIC_BLOCK 32
+
+// viewport maps kept for recently rendered poses
+#define SOFT_STITCHER_MAX_VIEWPORTS 8
+
+// adaptive blend, smaller side of the last pyramid level is not less than this size,
+// luma difference is compared in blocks, blend band is not narrower than min width
+#define SOFT_STITCHER_MIN_LEVEL_SIZE 8
+#define SOFT_STITCHER_BLEND_BLOCK 16
+#define SOFT_STITCHER_BLEND_DIFF_WEIGHT 4.0f
+#define SOFT_STITCHER_MIN_BLEND_WIDTH 16
+
 #define DUMP_STITCHER 0
 
 namespace XCam {
@@ -68,6 +96,8 @@ namespace SoftSitcherPriv {
 DECLARE_HANDLER_CALLBACK (CbGeoMap, SoftStitcher, dewarp_done);
 DECLARE_HANDLER_CALLBACK (CbBlender, SoftStitcher, blender_done);
 DECLARE_WORK_CALLBACK (CbCopyTask, SoftStitcher, copy_task_done);
+DECLARE_WORK_CALLBACK (CbTableTask, SoftStitcher, table_task_done);
+DECLARE_WORK_CALLBACK (CbTileTask, SoftStitcher, tile_task_done);
 
 struct BlenderParam
     : SoftBlender::BlenderParam
@@ -127,22 +157,42 @@ struct Overlap {
     SmartPtr<SoftBlender>        blender;
     BlenderParams                param_map;
 
+    // fused tiles engine, serializes tiles of this overlap on the blender
+    Mutex                        blend_mutex;
+
+    // chosen on the first blend, guarded by blend_mutex
+    SoftStitcher::OverlapBlendInfo  blend_info;
+
+    // blender output level buffers of last blended frame, read only
+    Mutex                        level_mutex;
+    SmartPtr<VideoBuffer>        gauss_bufs[SoftBlender::BufIdxCount];
+    SmartPtr<VideoBuffer>        blended_buf;
+
     SmartPtr<BlenderParam> find_blender_param_in_map (
         const SmartPtr<SoftStitcher::StitcherParam> &key,
         const uint32_t idx);
 };
 
+typedef XCamSoftTasks::FisheyeTableTask::Args TableArgs;
+
 struct FisheyeDewarp {
     SmartPtr<SoftGeoMapper>      dewarp;
     SmartPtr<BufferPool>         buf_pool;
     Factor                       left_match_factor, right_match_factor;
 
+    SmartPtr<XCamSoftTasks::FisheyeTableTask>  table_task;
+    SmartPtr<TableArgs>                        pending_table;
+
     bool set_dewarp_factor ();
-    XCamReturn set_dewarp_geo_table (
-        SmartPtr<SoftGeoMapper> mapper,
+    XCamReturn start_table_task (
+        uint32_t idx,
         const CameraInfo &cam_info,
         const Stitcher::RoundViewSlice &view_slice,
         const BowlDataConfig &bowl);
+    XCamReturn set_cached_geo_table (
+        SmartPtr<SoftGeoMapper> mapper,
+        const Stitcher::RoundViewSlice &view_slice,
+        const SmartPtr<GeoMapTableCache> &cache, uint32_t idx);
 };
 
 struct Copier {
@@ -155,12 +205,95 @@ struct Copier {
 };
 typedef std::vector<Copier>    Copiers;
 
+struct StitchTile {
+    uint32_t    idx;         // camera index of copy tile, overlap index of overlap tile
+    bool        is_overlap;
+    Rect        in_area;     // area in round view slice, only for copy tile
+    Rect        out_area;
+    // static scene, input blocks read by the tile, [0] of camera idx, [1] of next camera for overlap tile
+    Rect        in_blocks[2];
+};
+typedef std::vector<StitchTile>    StitchTiles;
+
+struct TileArgs
+    : SoftArgs
+{
+    std::vector<SmartPtr<UcharImage> >     in_luma;
+    std::vector<SmartPtr<Uchar2Image> >    in_uv;
+    std::vector<SmartPtr<Float2Image> >    luts;
+    std::vector<Float2>                    factors;
+
+    // static scene, tiles marked in skip are copied from last_out, skip is empty on full frame
+    uint32_t                               frame;
+    SmartPtr<VideoBuffer>                  last_out;
+    std::vector<uint8_t>                   skip;
+
+    TileArgs (const SmartPtr<ImageHandler::Parameters> &param, uint32_t camera_num)
+        : SoftArgs (param)
+        , in_luma (camera_num)
+        , in_uv (camera_num)
+        , luts (camera_num)
+        , factors (camera_num)
+        , frame (0)
+    {}
+};
+
+// static scene, input content of last rendered frame and blocks changed in current frame
+struct StaticInput {
+    SmartPtr<UcharImage>     ref_luma;
+    SmartPtr<Uchar2Image>    ref_uv;
+    uint32_t                 blocks_x, blocks_y;
+    std::vector<uint8_t>     dirty;
+    // tile footprints were calculated with this table
+    SmartPtr<Float2Image>    lut;
+
+    StaticInput () : blocks_x (0), blocks_y (0) {}
+    bool is_dirty (const Rect &blocks) const;
+};
+
+struct Viewport {
+    ViewportPose                        pose;
+    uint32_t                            width, height;
+    SmartPtr<Stitcher::ViewportMap>     map;
+    SmartPtr<BufferPool>                pool;
+};
+typedef std::list<Viewport>    Viewports;
+
+class StitcherImpl;
+
+/* work item x stitches tiles x, x + items, x + 2 * items, ...
+ * global size (items, ceil (tile_num / items)), local size (1, ceil (tile_num / items))
+ */
+class TileTask
+    : public SoftWorker
+{
+public:
+    TileTask (StitcherImpl *impl, const SmartPtr<Worker::Callback> &cb)
+        : SoftWorker ("StitchTileTask", cb)
+        , _impl (impl)
+    {
+        set_work_uint (1, 1);
+    }
+
+private:
+    virtual XCamReturn work_range (const SmartPtr<Arguments> &args, const WorkRange &range);
+
+private:
+    StitcherImpl    *_impl;
+};
+
 class StitcherImpl {
     friend class XCam::SoftStitcher;
 
 public:
     StitcherImpl (SoftStitcher *handler)
-        : _stitcher (handler)
+        : _table_remain (0)
+        , _table_error (XCAM_RETURN_NO_ERROR)
+        , _table_ready (false)
+        , _tile_frame (0)
+        , _skipped_tiles (0)
+        , _total_tiles (0)
+        , _stitcher (handler)
     {}
 
     XCamReturn init_config (uint32_t count);
@@ -178,13 +311,35 @@ public:
         const uint32_t idx, const SmartPtr<VideoBuffer> &buf);
 
     XCamReturn start_single_blender (const uint32_t idx, const SmartPtr<BlenderParam> &param);
+    XCamReturn config_overlap_blend (
+        const uint32_t idx,
+        const SmartPtr<VideoBuffer> &left_buf, const Rect &left_area,
+        const SmartPtr<VideoBuffer> &right_buf, const Rect &right_area);
+    bool get_overlap_blend_info (const uint32_t idx, SoftStitcher::OverlapBlendInfo &info);
     XCamReturn stop ();
 
+    XCamReturn start_tile_works (const SmartPtr<SoftStitcher::StitcherParam> &param);
+    XCamReturn stitch_tile (const SmartPtr<TileArgs> &args, uint32_t tile_idx);
+    uint32_t get_tile_num () const {
+        return _tiles.size ();
+    }
+    void keep_last_output (const SmartPtr<TileArgs> &args);
+    float get_tile_skip_ratio ();
+
+    XCamReturn render_viewport (
+        const ViewportPose &pose, uint32_t width, uint32_t height,
+        const VideoBufferList &in_bufs, SmartPtr<VideoBuffer> &out_buf);
+    void clear_viewports ();
+
     XCamReturn fisheye_dewarp_to_table ();
+    XCamReturn update_geo_tables ();
+    void table_work_done (const SmartPtr<TableArgs> &args, const XCamReturn error);
     XCamReturn feature_match (
         const SmartPtr<VideoBuffer> &left_buf,
         const SmartPtr<VideoBuffer> &right_buf,
-        const uint32_t idx);
+        const uint32_t idx, const uint32_t level);
+    void keep_overlap_levels (const uint32_t idx, const SmartPtr<SoftBlender::BlenderParam> &param);
+    XCamReturn render_preview (const SmartPtr<VideoBuffer> &out_buf, SmartPtr<VideoBuffer> &preview);
 
     bool get_and_reset_feature_match_factors (uint32_t idx, Factor &left, Factor &right);
 
@@ -192,22 +347,67 @@ private:
     SmartPtr<SoftGeoMapper> create_geo_mapper (const Stitcher::RoundViewSlice &view_slice);
 
     XCamReturn init_fisheye (uint32_t idx);
+    BowlDataConfig get_dewarp_bowl (const Stitcher::RoundViewSlice &view_slice);
+    uint64_t calc_table_cache_key ();
+    bool load_cached_tables (const SmartPtr<GeoMapTableCache> &cache);
+    XCamReturn start_table_works (const SmartPtr<GeoMapTableCache> &cache);
+    void dec_table_works (uint32_t count, const XCamReturn error);
+    XCamReturn wait_table_works ();
+    XCamReturn apply_pending_tables ();
     bool init_dewarp_factors (uint32_t idx);
     XCamReturn create_copier (Stitcher::CopyArea area);
+    XCamReturn init_tiles ();
+    XCamReturn map_copy_tile (const SmartPtr<TileArgs> &args, const StitchTile &tile);
+    XCamReturn blend_overlap_tile (const SmartPtr<TileArgs> &args, const StitchTile &tile);
+    XCamReturn copy_last_tile (const SmartPtr<TileArgs> &args, const StitchTile &tile);
+    void mark_static_tiles (const SmartPtr<TileArgs> &args);
+    bool update_static_input (uint32_t idx, const SmartPtr<TileArgs> &args);
+    void calc_tile_footprints (uint32_t idx, const SmartPtr<TileArgs> &args);
+    bool get_viewport (const ViewportPose &pose, uint32_t width, uint32_t height, Viewport &viewport);
 
     void calc_factors (
         const uint32_t &idx, const Factor &last_left_factor, const Factor &last_right_factor,
         Factor &cur_left, Factor &cur_right);
 
 private:
-    FisheyeDewarp           _fisheye [XCAM_STITCH_MAX_CAMERAS];
-    Overlap                 _overlaps [XCAM_STITCH_MAX_CAMERAS];
+    // sized by camera num in init_config
+    std::vector<FisheyeDewarp>  _fisheye;
+    std::vector<Overlap>        _overlaps;
     Copiers                 _copiers;
     SmartPtr<BufferPool>    _dewarp_pool;
 
+    StitchTiles             _tiles;
+    SmartPtr<TileTask>      _tile_task;
+    // dewarped overlap crops of both sides, shared by all overlaps
+    SmartPtr<BufferPool>    _tile_pool;
+    Mutex                   _tile_buf_mutex;
+
     Mutex                   _map_mutex;
     BlendCopyTaskNums       _task_counts;
 
+    // dewarp tables are built by table tasks, then swapped in all together
+    Mutex                          _table_mutex;
+    Cond                           _table_cond;
+    uint32_t                       _table_remain;
+    XCamReturn                     _table_error;
+    bool                           _table_ready;
+    SmartPtr<GeoMapTableCache>     _pending_cache;
+
+    // static scene, inputs are only touched in start_tile_works,
+    // _last_out is the output of latest started frame once it is done
+    std::vector<StaticInput>   _static_inputs;
+    Mutex                   _static_mutex;
+    SmartPtr<VideoBuffer>   _last_out;
+    uint32_t                _tile_frame;
+    uint64_t                _skipped_tiles;
+    uint64_t                _total_tiles;
+
+    SmartPtr<BufferPool>    _preview_pool;
+
+    // most recently used first
+    Mutex                   _viewport_mutex;
+    Viewports               _viewports;
+
     SoftStitcher           *_stitcher;
 };
 
@@ -269,30 +469,65 @@ StitcherImpl::init_dewarp_factors (uint32_t idx)
     return true;
 }
 
+static void
+get_geo_table_size (const Stitcher::RoundViewSlice &view_slice, uint32_t &width, uint32_t &height)
+{
+    width = view_slice.width / MAP_FACTOR_X;
+    width = XCAM_ALIGN_UP (width, 4);
+    height = view_slice.height / MAP_FACTOR_Y;
+    height = XCAM_ALIGN_UP (height, 2);
+}
+
 XCamReturn
-FisheyeDewarp::set_dewarp_geo_table (
-    SmartPtr<SoftGeoMapper> mapper,
+FisheyeDewarp::start_table_task (
+    uint32_t idx,
     const CameraInfo &cam_info,
     const Stitcher::RoundViewSlice &view_slice,
     const BowlDataConfig &bowl)
 {
-    PolyFisheyeDewarp fd;
-    fd.set_intrinsic_param (cam_info.calibration.intrinsic);
-    fd.set_extrinsic_param (cam_info.calibration.extrinsic);
+    XCAM_ASSERT (table_task.ptr ());
+
+    SmartPtr<PolyFisheyeDewarp> fd = new PolyFisheyeDewarp;
+    fd->set_intrinsic_param (cam_info.calibration.intrinsic);
+    fd->set_extrinsic_param (cam_info.calibration.extrinsic);
 
+    SmartPtr<TableArgs> args = new TableArgs (idx);
+    args->dewarp = fd;
+    get_geo_table_size (view_slice, args->table_width, args->table_height);
+    args->table.resize (args->table_width * args->table_height);
+    args->image_width = view_slice.width;
+    args->image_height = view_slice.height;
+    args->bowl = bowl;
+
+    WorkSize global_size (1, args->table_height);
+    WorkSize local_size (
+        1, xcam_ceil (args->table_height, SOFT_STITCHER_TABLE_BANDS) / SOFT_STITCHER_TABLE_BANDS);
+    table_task->set_local_size (local_size);
+    table_task->set_global_size (global_size);
+
+    return table_task->work (args);
+}
+
+XCamReturn
+FisheyeDewarp::set_cached_geo_table (
+    SmartPtr<SoftGeoMapper> mapper,
+    const Stitcher::RoundViewSlice &view_slice,
+    const SmartPtr<GeoMapTableCache> &cache, uint32_t idx)
+{
     uint32_t table_width, table_height;
-    table_width = view_slice.width / MAP_FACTOR_X;
-    table_width = XCAM_ALIGN_UP (table_width, 4);
-    table_height = view_slice.height / MAP_FACTOR_Y;
-    table_height = XCAM_ALIGN_UP (table_height, 2);
-    SurViewFisheyeDewarp::MapTable map_table(table_width * table_height);
-    fd.fisheye_dewarp (
-        map_table, table_width, table_height,
-        view_slice.width, view_slice.height, bowl);
-
-    XCAM_FAIL_RETURN (
-        ERROR, mapper->set_lookup_table (map_table.data (), table_width, table_height),
-        XCAM_RETURN_ERROR_UNKNOWN, "set fisheye dewarp lookup table failed");
+    get_geo_table_size (view_slice, table_width, table_height);
+
+    uint32_t cached_width = 0, cached_height = 0;
+    const PointFloat2 *table = cache->get_table (idx, cached_width, cached_height);
+    XCAM_FAIL_RETURN (
+        WARNING, table && cached_width == table_width && cached_height == table_height,
+        XCAM_RETURN_ERROR_PARAM,
+        "cached dewarp table(idx:%d) size(%dx%d) mismatch, expect:%dx%d",
+        idx, cached_width, cached_height, table_width, table_height);
+
+    XCAM_FAIL_RETURN (
+        ERROR, mapper->set_lookup_table (table, table_width, table_height),
+        XCAM_RETURN_ERROR_UNKNOWN, "set cached fisheye dewarp lookup table failed");
     return XCAM_RETURN_NO_ERROR;
 }
 
@@ -347,6 +582,13 @@ StitcherImpl::init_fisheye (uint32_t idx)
     fisheye.dewarp = create_geo_mapper (view_slice);;
     fisheye.dewarp->set_callback (dewarp_cb);
 
+    fisheye.table_task = new XCamSoftTasks::FisheyeTableTask (new CbTableTask (_stitcher));
+    XCAM_ASSERT (fisheye.table_task.ptr ());
+
+    // fused tiles engine dewarps into output and overlap crops, no slice buffers
+    if (_stitcher->get_stitch_engine () == StitchEngineFusedTiles)
+        return XCAM_RETURN_NO_ERROR;
+
     VideoBufferInfo buf_info;
     buf_info.init (
         V4L2_PIX_FMT_NV12, view_slice.width, view_slice.height,
@@ -385,12 +627,128 @@ StitcherImpl::create_copier (Stitcher::CopyArea area)
     return XCAM_RETURN_NO_ERROR;
 }
 
+XCamReturn
+StitcherImpl::init_tiles ()
+{
+    uint32_t camera_num = _stitcher->get_camera_num ();
+    uint32_t out_width, out_height;
+    _stitcher->get_output_size (out_width, out_height);
+
+    XCAM_FAIL_RETURN (
+        ERROR, _stitcher->get_scale_mode () == ScaleSingleConst, XCAM_RETURN_ERROR_PARAM,
+        "soft-stitcher:%s fused tiles engine only supports ScaleSingleConst", XCAM_STR (_stitcher->get_name ()));
+
+    _tiles.clear ();
+    uint32_t max_overlap_width = 0, max_overlap_height = 0;
+
+    // overlap tiles are heavier, put them first to start early on different work items
+    for (uint32_t i = 0; i < camera_num; ++i) {
+        const Stitcher::ImageOverlapInfo &overlap_info = _stitcher->get_overlap (i);
+        XCAM_FAIL_RETURN (
+            ERROR,
+            overlap_info.left.pos_x % 2 == 0 && overlap_info.left.pos_y % 2 == 0 &&
+            overlap_info.right.pos_x % 2 == 0 && overlap_info.right.pos_y % 2 == 0,
+            XCAM_RETURN_ERROR_PARAM,
+            "soft-stitcher:%s overlap(idx:%d) is not aligned to 2", XCAM_STR (_stitcher->get_name ()), i);
+
+        StitchTile tile;
+        tile.idx = i;
+        tile.is_overlap = true;
+        tile.out_area = overlap_info.out_area;
+        _tiles.push_back (tile);
+
+        uint32_t width = XCAM_MAX (overlap_info.left.width, overlap_info.right.width);
+        uint32_t height = XCAM_MAX (overlap_info.left.height, overlap_info.right.height);
+        max_overlap_width = XCAM_MAX (max_overlap_width, width);
+        max_overlap_height = XCAM_MAX (max_overlap_height, height);
+
+        SmartPtr<SoftBlender> &blender = _overlaps[i].blender;
+        blender->set_output_size (out_width, out_height);
+        blender->set_merge_window (overlap_info.out_area);
+        blender->set_input_valid_area (Rect (0, 0, overlap_info.left.width, overlap_info.left.height), 0);
+        blender->set_input_valid_area (Rect (0, 0, overlap_info.right.width, overlap_info.right.height), 1);
+        blender->set_input_merge_area (Rect (0, 0, overlap_info.left.width, overlap_info.left.height), 0);
+        blender->set_input_merge_area (Rect (0, 0, overlap_info.right.width, overlap_info.right.height), 1);
+    }
+
+    const Stitcher::CopyAreaArray &areas = _stitcher->get_copy_area ();
+    for (uint32_t i = 0; i < areas.size (); ++i) {
+        const Stitcher::CopyArea &area = areas[i];
+        XCAM_FAIL_RETURN (
+            ERROR,
+            area.in_idx < camera_num &&
+            area.in_area.width == area.out_area.width && area.in_area.height == area.out_area.height &&
+            area.in_area.pos_x % 2 == 0 && area.in_area.pos_y % 2 == 0 &&
+            area.out_area.pos_x % 2 == 0 && area.out_area.pos_y % 2 == 0,
+            XCAM_RETURN_ERROR_PARAM,
+            "soft-stitcher:%s copy area (idx:%d) is invalid for tiles", XCAM_STR (_stitcher->get_name ()), area.in_idx);
+
+        for (int32_t x = 0; x < area.out_area.width; x += SOFT_STITCHER_TILE_WIDTH) {
+            StitchTile tile;
+            tile.idx = area.in_idx;
+            tile.is_overlap = false;
+            tile.in_area = area.in_area;
+            tile.in_area.pos_x += x;
+            tile.in_area.width = XCAM_MIN (SOFT_STITCHER_TILE_WIDTH, area.in_area.width - x);
+            tile.out_area = area.out_area;
+            tile.out_area.pos_x += x;
+            tile.out_area.width = tile.in_area.width;
+            _tiles.push_back (tile);
+        }
+    }
+
+    _tile_task = new TileTask (this, new CbTileTask (_stitcher));
+    XCAM_ASSERT (_tile_task.ptr ());
+
+    uint32_t items = XCAM_MIN ((uint32_t)SOFT_STITCHER_TILE_ITEMS, (uint32_t)_tiles.size ());
+    uint32_t tiles_per_item = xcam_ceil (_tiles.size (), items) / items;
+    _tile_task->set_global_size (WorkSize (items, tiles_per_item));
+    _tile_task->set_local_size (WorkSize (1, tiles_per_item));
+
+    // each work item blends one overlap at a time with 2 buffers,
+    // so the pool is bounded by work items instead of camera num
+    VideoBufferInfo buf_info;
+    buf_info.init (
+        V4L2_PIX_FMT_NV12, max_overlap_width, max_overlap_height,
+        XCAM_ALIGN_UP (max_overlap_width, SOFT_STITCHER_ALIGNMENT_X),
+        XCAM_ALIGN_UP (max_overlap_height, SOFT_STITCHER_ALIGNMENT_Y));
+    uint32_t tile_bufs = 2 * XCAM_MIN (items, camera_num);
+
+    _tile_pool = new SoftVideoBufAllocator (buf_info);
+    XCAM_ASSERT (_tile_pool.ptr ());
+    XCAM_FAIL_RETURN (
+        ERROR, _tile_pool->reserve (tile_bufs), XCAM_RETURN_ERROR_MEM,
+        "soft-stitcher:%s reserve overlap tile buffer pool(w:%d,h:%d,count:%d) failed",
+        XCAM_STR (_stitcher->get_name ()), buf_info.width, buf_info.height, tile_bufs);
+
+    XCAM_LOG_INFO (
+        "soft-stitcher:%s fused tiles engine, tile num:%d, work items:%d",
+        XCAM_STR (_stitcher->get_name ()), (uint32_t)_tiles.size (), items);
+    return XCAM_RETURN_NO_ERROR;
+}
+
 XCamReturn
 StitcherImpl::init_config (uint32_t count)
 {
     XCamReturn ret = XCAM_RETURN_NO_ERROR;
+    bool fused_tiles = (_stitcher->get_stitch_engine () == StitchEngineFusedTiles);
+
+    // fused tiles engine blends synchronously inside tile works, no callback needed
+    SmartPtr<ImageHandler::Callback> blender_cb;
+    if (!fused_tiles)
+        blender_cb = new CbBlender (_stitcher);
 
-    SmartPtr<ImageHandler::Callback> blender_cb = new CbBlender (_stitcher);
+    // blender levels are kept for preview and feature match
+    uint32_t output_level = _stitcher->get_preview_level ();
+#if ENABLE_FEATURE_MATCH
+    if (!output_level && !fused_tiles)
+        output_level = SOFT_STITCHER_FM_LEVEL;
+#endif
+
+    std::vector<FisheyeDewarp> fisheye (count);
+    std::vector<Overlap> overlaps (count);
+    _fisheye.swap (fisheye);
+    _overlaps.swap (overlaps);
     for (uint32_t i = 0; i < count; ++i) {
         ret = init_fisheye (i);
         XCAM_FAIL_RETURN (
@@ -413,16 +771,52 @@ StitcherImpl::init_config (uint32_t count)
 #else
         config.max_track_error = 3600.0f;
 #endif
+        // matcher works on gauss level of overlap, distances are scaled down too
+        float fm_scale = 1.0f / (1 << output_level);
+        config.sitch_min_width = (int)(config.sitch_min_width * fm_scale);
+        config.delta_mean_offset *= fm_scale;
+        config.recur_offset_error *= fm_scale;
+        config.max_adjusted_offset *= fm_scale;
+        config.max_valid_offset_y *= fm_scale;
         _overlaps[i].matcher->set_config (config);
         _overlaps[i].matcher->set_fm_index (i);
 #endif
 
         _overlaps[i].blender = create_soft_blender ().dynamic_cast_ptr<SoftBlender>();
         XCAM_ASSERT (_overlaps[i].blender.ptr ());
-        _overlaps[i].blender->set_callback (blender_cb);
+        _overlaps[i].blender->enable_seam (_stitcher->get_need_seam ());
+        _overlaps[i].blender->set_output_level (output_level);
+        if (blender_cb.ptr ())
+            _overlaps[i].blender->set_callback (blender_cb);
         _overlaps[i].param_map.clear ();
     }
 
+    if (_stitcher->get_preview_level ()) {
+        uint32_t width, height;
+        _stitcher->get_output_size (width, height);
+        uint32_t level = _stitcher->get_preview_level ();
+        width = XCAM_ALIGN_UP (xcam_ceil (width, 1 << level) >> level, 2);
+        height = XCAM_ALIGN_UP (xcam_ceil (height, 1 << level) >> level, 2);
+
+        VideoBufferInfo info;
+        info.init (V4L2_PIX_FMT_NV12, width, height);
+        _preview_pool = new SoftVideoBufAllocator (info);
+        XCAM_ASSERT (_preview_pool.ptr ());
+        XCAM_FAIL_RETURN (
+            ERROR, _preview_pool->reserve (2), XCAM_RETURN_ERROR_MEM,
+            "soft-stitcher:%s reserve preview buffer pool(w:%d,h:%d) failed",
+            XCAM_STR (_stitcher->get_name ()), width, height);
+    }
+
+    if (fused_tiles)
+        return init_tiles ();
+
+    if (_stitcher->get_static_scene ()) {
+        XCAM_LOG_WARNING (
+            "soft-stitcher:%s static scene only works with fused tiles engine, ignored",
+            XCAM_STR (_stitcher->get_name ()));
+    }
+
     Stitcher::CopyAreaArray areas = _stitcher->get_copy_area ();
     uint32_t size = areas.size ();
     for (uint32_t i = 0; i < size; ++i) {
@@ -473,35 +867,379 @@ StitcherImpl::dec_task_count (const SmartPtr<SoftStitcher::StitcherParam> &param
     return 0;
 }
 
-XCamReturn
-StitcherImpl::fisheye_dewarp_to_table ()
+BowlDataConfig
+StitcherImpl::get_dewarp_bowl (const Stitcher::RoundViewSlice &view_slice)
+{
+    BowlDataConfig bowl = _stitcher->get_bowl_config ();
+    bowl.angle_start = view_slice.hori_angle_start;
+    bowl.angle_end = format_angle (view_slice.hori_angle_start + view_slice.hori_angle_range);
+    if (bowl.angle_end < bowl.angle_start)
+        bowl.angle_start -= 360.0f;
+
+    return bowl;
+}
+
+uint64_t
+StitcherImpl::calc_table_cache_key ()
 {
     uint32_t camera_num = _stitcher->get_camera_num ();
+    uint32_t out_width, out_height;
+    _stitcher->get_output_size (out_width, out_height);
+    GeoMapScaleMode scale_mode = _stitcher->get_scale_mode ();
+
+    uint64_t key = GeoMapTableCache::hash_value (camera_num);
+    key = GeoMapTableCache::hash_value (out_width, key);
+    key = GeoMapTableCache::hash_value (out_height, key);
+    key = GeoMapTableCache::hash_value (scale_mode, key);
     for (uint32_t i = 0; i < camera_num; ++i) {
         CameraInfo cam_info;
         _stitcher->get_camera_info (i, cam_info);
-        Stitcher::RoundViewSlice view_slice = _stitcher->get_round_view_slice (i);
+        const Stitcher::RoundViewSlice &view_slice = _stitcher->get_round_view_slice (i);
+        BowlDataConfig bowl = get_dewarp_bowl (view_slice);
 
-        BowlDataConfig bowl = _stitcher->get_bowl_config ();
-        bowl.angle_start = view_slice.hori_angle_start;
-        bowl.angle_end = format_angle (view_slice.hori_angle_start + view_slice.hori_angle_range);
+        key = GeoMapTableCache::hash_value (cam_info.calibration.intrinsic, key);
+        key = GeoMapTableCache::hash_value (cam_info.calibration.extrinsic, key);
+        key = GeoMapTableCache::hash_value (view_slice, key);
+        key = GeoMapTableCache::hash_value (bowl, key);
+    }
 
-        uint32_t out_width, out_height;
-        _stitcher->get_output_size (out_width, out_height);
+    return key;
+}
+
+bool
+StitcherImpl::load_cached_tables (const SmartPtr<GeoMapTableCache> &cache)
+{
+    uint32_t camera_num = _stitcher->get_camera_num ();
+    if (!cache->load (_stitcher->get_table_cache_path ()))
+        return false;
+
+    XCAM_FAIL_RETURN (
+        WARNING, cache->get_table_num () == camera_num, false,
+        "stitcher:%s cached table num(%d) mismatch camera num(%d)",
+        XCAM_STR (_stitcher->get_name ()), cache->get_table_num (), camera_num);
+
+    for (uint32_t i = 0; i < camera_num; ++i) {
+        const Stitcher::RoundViewSlice &view_slice = _stitcher->get_round_view_slice (i);
+        XCamReturn ret = _fisheye[i].set_cached_geo_table (_fisheye[i].dewarp, view_slice, cache, i);
+        if (!xcam_ret_is_ok (ret))
+            return false;
+    }
+
+    XCAM_LOG_INFO (
+        "stitcher:%s dewarp tables loaded from cache:%s",
+        XCAM_STR (_stitcher->get_name ()), _stitcher->get_table_cache_path ());
+    return true;
+}
+
+XCamReturn
+StitcherImpl::start_table_works (const SmartPtr<GeoMapTableCache> &cache)
+{
+    uint32_t camera_num = _stitcher->get_camera_num ();
+    {
+        SmartLock locker (_table_mutex);
+        XCAM_FAIL_RETURN (
+            WARNING, !_table_remain, XCAM_RETURN_ERROR_ORDER,
+            "stitcher:%s dewarp tables are still in building", XCAM_STR (_stitcher->get_name ()));
+
+        _table_remain = camera_num;
+        _table_error = XCAM_RETURN_NO_ERROR;
+        _table_ready = false;
+        _pending_cache = cache;
+        for (uint32_t i = 0; i < camera_num; ++i)
+            _fisheye[i].pending_table.release ();
+    }
+
+    for (uint32_t i = 0; i < camera_num; ++i) {
+        CameraInfo cam_info;
+        _stitcher->get_camera_info (i, cam_info);
+        const Stitcher::RoundViewSlice &view_slice = _stitcher->get_round_view_slice (i);
+        BowlDataConfig bowl = get_dewarp_bowl (view_slice);
 
-        _fisheye[i].dewarp->set_output_size (view_slice.width, view_slice.height);
-        if (bowl.angle_end < bowl.angle_start)
-            bowl.angle_start -= 360.0f;
         XCAM_LOG_INFO (
             "soft-stitcher:%s camera(idx:%d) info (angle start:%.2f, range:%.2f), bowl info (angle start%.2f, end:%.2f)",
             XCAM_STR (_stitcher->get_name ()), i,
             view_slice.hori_angle_start, view_slice.hori_angle_range,
             bowl.angle_start, bowl.angle_end);
-        XCamReturn ret = _fisheye[i].set_dewarp_geo_table (_fisheye[i].dewarp, cam_info, view_slice, bowl);
+
+        XCamReturn ret = _fisheye[i].start_table_task (i, cam_info, view_slice, bowl);
+        if (!xcam_ret_is_ok (ret)) {
+            // callbacks of this and following cameras will never come
+            dec_table_works (camera_num - i, ret);
+            XCAM_LOG_ERROR (
+                "stitcher:%s start dewarp table task failed, idx:%d.", XCAM_STR (_stitcher->get_name ()), i);
+            return ret;
+        }
+    }
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+void
+StitcherImpl::dec_table_works (uint32_t count, const XCamReturn error)
+{
+    std::vector<SmartPtr<TableArgs> > tables;
+    SmartPtr<GeoMapTableCache> cache;
+    {
+        SmartLock locker (_table_mutex);
+        XCAM_ASSERT (_table_remain >= count);
+
+        if (!xcam_ret_is_ok (error))
+            _table_error = error;
+
+        // the last table work fills and saves cache before tables get ready, keeps file writing out of frame path
+        if (_table_remain != count || !xcam_ret_is_ok (_table_error) || !_pending_cache.ptr ()) {
+            _table_remain -= count;
+            if (_table_remain == 0) {
+                _table_ready = xcam_ret_is_ok (_table_error);
+                _table_cond.broadcast ();
+            }
+            return;
+        }
+
+        cache = _pending_cache;
+        _pending_cache.release ();
+        for (uint32_t i = 0; i < _stitcher->get_camera_num (); ++i)
+            tables.push_back (_fisheye[i].pending_table);
+    }
+
+    for (uint32_t i = 0; i < tables.size (); ++i) {
+        XCAM_ASSERT (tables[i].ptr ());
+        cache->add_table (tables[i]->table.data (), tables[i]->table_width, tables[i]->table_height);
+    }
+    cache->save (_stitcher->get_table_cache_path ());
+
+    SmartLock locker (_table_mutex);
+    _table_remain -= count;
+    _table_ready = true;
+    _table_cond.broadcast ();
+}
+
+void
+StitcherImpl::table_work_done (const SmartPtr<TableArgs> &args, const XCamReturn error)
+{
+    XCAM_ASSERT (args.ptr () && args->idx < _fisheye.size ());
+    {
+        SmartLock locker (_table_mutex);
+        if (xcam_ret_is_ok (error))
+            _fisheye[args->idx].pending_table = args;
+    }
+
+    dec_table_works (1, error);
+}
+
+XCamReturn
+StitcherImpl::wait_table_works ()
+{
+    SmartLock locker (_table_mutex);
+    while (_table_remain)
+        _table_cond.wait (_table_mutex);
+
+    return _table_error;
+}
+
+XCamReturn
+StitcherImpl::apply_pending_tables ()
+{
+    uint32_t camera_num = _stitcher->get_camera_num ();
+    std::vector<SmartPtr<TableArgs> > tables (camera_num);
+    {
+        SmartLock locker (_table_mutex);
+        if (!_table_ready)
+            return XCAM_RETURN_NO_ERROR;
+
+        _table_ready = false;
+        for (uint32_t i = 0; i < camera_num; ++i) {
+            tables[i] = _fisheye[i].pending_table;
+            _fisheye[i].pending_table.release ();
+        }
+    }
+
+    for (uint32_t i = 0; i < camera_num; ++i) {
+        XCAM_ASSERT (tables[i].ptr ());
+        const TableArgs &table = *tables[i].ptr ();
         XCAM_FAIL_RETURN (
-            ERROR, xcam_ret_is_ok (ret), ret,
+            ERROR, _fisheye[i].dewarp->set_lookup_table (table.table.data (), table.table_width, table.table_height),
+            XCAM_RETURN_ERROR_UNKNOWN,
             "stitcher:%s set dewarp geo table failed, idx:%d.", XCAM_STR (_stitcher->get_name ()), i);
+    }
+
+    XCAM_LOG_INFO ("stitcher:%s dewarp tables updated", XCAM_STR (_stitcher->get_name ()));
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+StitcherImpl::fisheye_dewarp_to_table ()
+{
+    uint32_t camera_num = _stitcher->get_camera_num ();
+    for (uint32_t i = 0; i < camera_num; ++i) {
+        const Stitcher::RoundViewSlice &view_slice = _stitcher->get_round_view_slice (i);
+        _fisheye[i].dewarp->set_output_size (view_slice.width, view_slice.height);
+    }
+
+    SmartPtr<GeoMapTableCache> cache;
+    if (_stitcher->get_table_cache_path ()) {
+        uint64_t key = calc_table_cache_key ();
+        if (load_cached_tables (new GeoMapTableCache (key)))
+            return XCAM_RETURN_NO_ERROR;
+
+        cache = new GeoMapTableCache (key);
+    }
 
+    XCamReturn ret = start_table_works (cache);
+    if (xcam_ret_is_ok (ret))
+        ret = wait_table_works ();
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "stitcher:%s build dewarp geo tables failed", XCAM_STR (_stitcher->get_name ()));
+
+    return apply_pending_tables ();
+}
+
+XCamReturn
+StitcherImpl::update_geo_tables ()
+{
+    XCAM_FAIL_RETURN (
+        ERROR, !_fisheye.empty () && _fisheye[0].table_task.ptr (), XCAM_RETURN_ERROR_ORDER,
+        "stitcher:%s update geo tables failed, stitcher was not configured", XCAM_STR (_stitcher->get_name ()));
+
+    SmartPtr<GeoMapTableCache> cache;
+    if (_stitcher->get_table_cache_path ())
+        cache = new GeoMapTableCache (calc_table_cache_key ());
+
+    return start_table_works (cache);
+}
+
+static inline bool
+is_same_viewport (const Viewport &viewport, const ViewportPose &pose, uint32_t width, uint32_t height)
+{
+    return viewport.width == width && viewport.height == height &&
+           viewport.pose.position.x == pose.position.x && viewport.pose.position.y == pose.position.y &&
+           viewport.pose.position.z == pose.position.z && viewport.pose.yaw == pose.yaw &&
+           viewport.pose.pitch == pose.pitch && viewport.pose.fov == pose.fov;
+}
+
+bool
+StitcherImpl::get_viewport (const ViewportPose &pose, uint32_t width, uint32_t height, Viewport &viewport)
+{
+    {
+        SmartLock locker (_viewport_mutex);
+        for (Viewports::iterator i = _viewports.begin (); i != _viewports.end (); ++i) {
+            if (is_same_viewport (*i, pose, width, height)) {
+                _viewports.splice (_viewports.begin (), _viewports, i);
+                viewport = _viewports.front ();
+                return true;
+            }
+        }
+    }
+
+    // calculated out of lock, other viewports keep rendering
+    SmartPtr<Stitcher::ViewportMap> map = new Stitcher::ViewportMap;
+    XCamReturn ret = _stitcher->calc_viewport_map (pose, width, height, *map.ptr ());
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), false,
+        "soft-stitcher:%s calculate viewport map(%dx%d) failed", XCAM_STR (_stitcher->get_name ()), width, height);
+
+    VideoBufferInfo info;
+    info.init (V4L2_PIX_FMT_NV12, width, height, XCAM_ALIGN_UP (width, SOFT_STITCHER_ALIGNMENT_X), height);
+    SmartPtr<BufferPool> pool = new SoftVideoBufAllocator (info);
+    XCAM_ASSERT (pool.ptr ());
+    XCAM_FAIL_RETURN (
+        ERROR, pool->reserve (2), false,
+        "soft-stitcher:%s reserve viewport buffer pool(w:%d,h:%d) failed",
+        XCAM_STR (_stitcher->get_name ()), width, height);
+
+    viewport.pose = pose;
+    viewport.width = width;
+    viewport.height = height;
+    viewport.map = map;
+    viewport.pool = pool;
+
+    SmartLock locker (_viewport_mutex);
+    _viewports.push_front (viewport);
+    if (_viewports.size () > SOFT_STITCHER_MAX_VIEWPORTS)
+        _viewports.pop_back ();
+
+    return true;
+}
+
+void
+StitcherImpl::clear_viewports ()
+{
+    SmartLock locker (_viewport_mutex);
+    _viewports.clear ();
+}
+
+static inline bool
+is_inside_image (const PointFloat2 &pos, uint32_t width, uint32_t height)
+{
+    return pos.x >= 0.0f && pos.y >= 0.0f && pos.x < width - 1.0f && pos.y < height - 1.0f;
+}
+
+XCamReturn
+StitcherImpl::render_viewport (
+    const ViewportPose &pose, uint32_t width, uint32_t height,
+    const VideoBufferList &in_bufs, SmartPtr<VideoBuffer> &out_buf)
+{
+    uint32_t camera_num = _stitcher->get_camera_num ();
+    XCAM_FAIL_RETURN (
+        ERROR, in_bufs.size () >= camera_num && width % 2 == 0 && height % 2 == 0, XCAM_RETURN_ERROR_PARAM,
+        "soft-stitcher:%s render viewport(%dx%d) failed, need even size and %d input buffers",
+        XCAM_STR (_stitcher->get_name ()), width, height, camera_num);
+
+    Viewport viewport;
+    XCAM_FAIL_RETURN (
+        ERROR, get_viewport (pose, width, height, viewport), XCAM_RETURN_ERROR_PARAM,
+        "soft-stitcher:%s render viewport failed, no viewport map", XCAM_STR (_stitcher->get_name ()));
+
+    if (!out_buf.ptr ()) {
+        out_buf = viewport.pool->get_buffer ();
+        XCAM_FAIL_RETURN (
+            ERROR, out_buf.ptr (), XCAM_RETURN_ERROR_MEM,
+            "soft-stitcher:%s get viewport buffer failed", XCAM_STR (_stitcher->get_name ()));
+    }
+
+    const VideoBufferInfo &out_info = out_buf->get_video_info ();
+    XCAM_FAIL_RETURN (
+        ERROR, out_info.format == V4L2_PIX_FMT_NV12 && out_info.width == width && out_info.height == height,
+        XCAM_RETURN_ERROR_PARAM,
+        "soft-stitcher:%s render viewport failed, output buffer must be NV12 of %dx%d",
+        XCAM_STR (_stitcher->get_name ()), width, height);
+
+    std::vector<SmartPtr<UcharImage> > in_luma (camera_num);
+    std::vector<SmartPtr<Uchar2Image> > in_uv (camera_num);
+    VideoBufferList::const_iterator iter = in_bufs.begin ();
+    for (uint32_t i = 0; i < camera_num; ++i, ++iter) {
+        in_luma[i] = new UcharImage (*iter, 0);
+        in_uv[i] = new Uchar2Image (*iter, 1);
+    }
+    UcharImage out_luma (out_buf, 0);
+    Uchar2Image out_uv (out_buf, 1);
+
+    // only fisheye pixels landing in the viewport are sampled, chroma follows top-left luma pixel
+    const Stitcher::ViewportPoint *points = viewport.map->data ();
+    for (uint32_t y = 0; y < out_info.height; y += 2) {
+        for (uint32_t x = 0; x < out_info.width; x += 2) {
+            for (uint32_t j = 0; j < 4; ++j) {
+                const Stitcher::ViewportPoint &point = points[(y + j / 2) * out_info.width + x + j % 2];
+                Uchar luma = 0;
+                if (point.cam_idx != INVALID_INDEX) {
+                    const UcharImage *image = in_luma[point.cam_idx].ptr ();
+                    if (is_inside_image (point.pos, image->get_width (), image->get_height ()))
+                        luma = convert_to_uchar (image->read_interpolate_data<float> (point.pos.x, point.pos.y));
+                }
+                out_luma.write_data_no_check (x + j % 2, y + j / 2, luma);
+            }
+
+            const Stitcher::ViewportPoint &point = points[y * out_info.width + x];
+            Uchar2 uv (128, 128);
+            if (point.cam_idx != INVALID_INDEX) {
+                const Uchar2Image *image = in_uv[point.cam_idx].ptr ();
+                PointFloat2 pos (point.pos.x / 2.0f, point.pos.y / 2.0f);
+                if (is_inside_image (pos, image->get_width (), image->get_height ()))
+                    uv = convert_to_uchar2 (image->read_interpolate_data<Float2> (pos.x, pos.y));
+            }
+            out_uv.write_data_no_check (x / 2, y / 2, uv);
+        }
     }
 
     return XCAM_RETURN_NO_ERROR;
@@ -513,6 +1251,17 @@ StitcherImpl::start_dewarp_works (const SmartPtr<SoftStitcher::StitcherParam> &p
     uint32_t camera_num = _stitcher->get_camera_num ();
     Factor cur_left, cur_right;
 
+    XCAM_FAIL_RETURN (
+        ERROR, param->in_buf_num >= camera_num, XCAM_RETURN_ERROR_PARAM,
+        "soft-stitcher:%s input buffer num(%d) less than camera num(%d)",
+        XCAM_STR (_stitcher->get_name ()), param->in_buf_num, camera_num);
+
+    // tables rebuilt in background take effect on all cameras from this frame
+    XCamReturn ret = apply_pending_tables ();
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "soft-stitcher:%s apply updated dewarp tables failed", XCAM_STR (_stitcher->get_name ()));
+
     for (uint32_t i = 0; i < camera_num; ++i) {
         SmartPtr<VideoBuffer> out_buf = _fisheye[i].buf_pool->get_buffer ();
         SmartPtr<HandlerParam> dewarp_params = new HandlerParam (i);
@@ -521,7 +1270,7 @@ StitcherImpl::start_dewarp_works (const SmartPtr<SoftStitcher::StitcherParam> &p
         dewarp_params->stitch_param = param;
 
         init_dewarp_factors (i);
-        XCamReturn ret = _fisheye[i].dewarp->execute_buffer (dewarp_params, false);
+        ret = _fisheye[i].dewarp->execute_buffer (dewarp_params, false);
         XCAM_FAIL_RETURN (
             ERROR, xcam_ret_is_ok (ret), ret,
             "soft-stitcher:%s fisheye dewarp buffer failed", XCAM_STR (_stitcher->get_name ()));
@@ -552,22 +1301,23 @@ XCamReturn
 StitcherImpl::feature_match (
     const SmartPtr<VideoBuffer> &left_buf,
     const SmartPtr<VideoBuffer> &right_buf,
-    const uint32_t idx)
+    const uint32_t idx, const uint32_t level)
 {
     const Stitcher::ImageOverlapInfo overlap_info = _stitcher->get_overlap (idx);
     Rect left_ovlap = overlap_info.left;
     Rect right_ovlap = overlap_info.right;
     const VideoBufferInfo left_buf_info = left_buf->get_video_info ();
 
-    left_ovlap.pos_y = left_ovlap.height / 5;
-    left_ovlap.height = left_ovlap.height / 2;
-    right_ovlap.pos_y = right_ovlap.height / 5;
-    right_ovlap.height = right_ovlap.height / 2;
+    // buffers are blender gauss levels of overlap areas, scaled down by 2^level
+    Rect left_crop (
+        0, (left_ovlap.height / 5) >> level, left_ovlap.width >> level, (left_ovlap.height / 2) >> level);
+    Rect right_crop (
+        0, (right_ovlap.height / 5) >> level, right_ovlap.width >> level, (right_ovlap.height / 2) >> level);
 
     _overlaps[idx].matcher->reset_offsets ();
     _overlaps[idx].matcher->optical_flow_feature_match (
-        left_buf, right_buf, left_ovlap, right_ovlap, left_buf_info.width);
-    float left_offsetx = _overlaps[idx].matcher->get_current_left_offset_x ();
+        left_buf, right_buf, left_crop, right_crop, left_buf_info.width);
+    float left_offsetx = _overlaps[idx].matcher->get_current_left_offset_x () * (1 << level);
     Factor left_factor, right_factor;
 
     uint32_t left_idx = idx;
@@ -613,10 +1363,137 @@ StitcherImpl::start_single_blender (
     blender->set_input_valid_area (overlap_info.right, 1);
     blender->set_input_merge_area (overlap_info.left, 0);
     blender->set_input_merge_area (overlap_info.right, 1);
+
+    XCamReturn ret = config_overlap_blend (
+        idx, param->in_buf, overlap_info.left, param->in1_buf, overlap_info.right);
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "soft-stitcher:%s config overlap(idx:%d) blend failed", XCAM_STR (_stitcher->get_name ()), idx);
+
     return blender->execute_buffer (param, false);
 }
 
-XCamReturn
+static void
+calc_adaptive_blend (
+    const UcharImage &luma0, const UcharImage &luma1, uint32_t min_levels,
+    uint32_t &levels, uint32_t &blend_width)
+{
+    uint32_t width = luma0.get_width ();
+    uint32_t height = luma0.get_height ();
+    XCAM_ASSERT (width == luma1.get_width () && height == luma1.get_height ());
+
+    uint32_t max_levels = 1;
+    while ((XCAM_MIN (width, height) >> (max_levels + 1)) >= SOFT_STITCHER_MIN_LEVEL_SIZE)
+        ++max_levels;
+
+    // low frequency difference of two inputs, mean of block mean differences
+    float diff = 0.0f;
+    uint32_t blocks = 0;
+    for (uint32_t by = 0; by + SOFT_STITCHER_BLEND_BLOCK <= height; by += SOFT_STITCHER_BLEND_BLOCK)
+        for (uint32_t bx = 0; bx + SOFT_STITCHER_BLEND_BLOCK <= width; bx += SOFT_STITCHER_BLEND_BLOCK) {
+            int32_t sum = 0;
+            for (uint32_t y = by; y < by + SOFT_STITCHER_BLEND_BLOCK; ++y) {
+                const Uchar *line0 = luma0.get_buf_ptr (bx, y);
+                const Uchar *line1 = luma1.get_buf_ptr (bx, y);
+                for (uint32_t x = 0; x < SOFT_STITCHER_BLEND_BLOCK; ++x)
+                    sum += (int32_t)line0[x] - (int32_t)line1[x];
+            }
+            diff += fabs (sum / (float)(SOFT_STITCHER_BLEND_BLOCK * SOFT_STITCHER_BLEND_BLOCK));
+            ++blocks;
+        }
+    diff = blocks ? diff / blocks : 0.0f;
+
+    // texture of two inputs, mean gradient sampled on even pixels
+    uint64_t grad_sum = 0, grad_count = 0;
+    for (uint32_t y = 0; y + 1 < height; y += 2) {
+        const Uchar *lines[2][2] = {
+            {luma0.get_buf_ptr (0, y), luma0.get_buf_ptr (0, y + 1)},
+            {luma1.get_buf_ptr (0, y), luma1.get_buf_ptr (0, y + 1)}
+        };
+        for (uint32_t x = 0; x + 1 < width; x += 2)
+            for (uint32_t i = 0; i < 2; ++i) {
+                grad_sum += abs ((int32_t)lines[i][0][x + 1] - (int32_t)lines[i][0][x]) +
+                            abs ((int32_t)lines[i][1][x] - (int32_t)lines[i][0][x]);
+                grad_count += 2;
+            }
+    }
+    float grad = grad_count ? (float)grad_sum / grad_count : 0.0f;
+
+    // deep levels blend low frequencies over wide bands, needed only if inputs differ in
+    // brightness or color more than their texture hides, band at level 0 narrows with depth
+    uint32_t wanted = 1 + (uint32_t)ceilf (log2f (1.0f + SOFT_STITCHER_BLEND_DIFF_WEIGHT * diff / (1.0f + grad)));
+    levels = XCAM_MAX (XCAM_CLAMP (wanted, 1u, max_levels), min_levels);
+    blend_width = width / 2 * XCAM_MIN (levels, max_levels) / max_levels;
+    blend_width = XCAM_CLAMP (blend_width, (uint32_t)SOFT_STITCHER_MIN_BLEND_WIDTH, width / 2);
+
+    XCAM_LOG_DEBUG (
+        "adaptive blend, diff:%.2f grad:%.2f, levels:%d(max:%d) blend width:%d",
+        diff, grad, levels, max_levels, blend_width);
+}
+
+XCamReturn
+StitcherImpl::config_overlap_blend (
+    const uint32_t idx,
+    const SmartPtr<VideoBuffer> &left_buf, const Rect &left_area,
+    const SmartPtr<VideoBuffer> &right_buf, const Rect &right_area)
+{
+    Overlap &overlap = _overlaps[idx];
+    SmartLock locker (overlap.blend_mutex);
+    if (overlap.blend_info.pyr_levels)
+        return XCAM_RETURN_NO_ERROR;
+
+    const Rect &merge = _stitcher->get_overlap (idx).out_area;
+    SoftStitcher::OverlapBlendInfo info;
+    info.pyr_levels = overlap.blender->get_pyr_levels ();
+    info.blend_width = merge.width / 2;
+
+    if (_stitcher->get_adaptive_blend ()) {
+        XCAM_ASSERT (left_area.width == right_area.width && left_area.height == right_area.height);
+        const VideoBufferInfo &left_info = left_buf->get_video_info ();
+        const VideoBufferInfo &right_info = right_buf->get_video_info ();
+        UcharImage left_luma (
+            left_buf, left_area.width, left_area.height, left_info.strides[0],
+            left_info.offsets[0] + left_area.pos_x + left_area.pos_y * left_info.strides[0]);
+        UcharImage right_luma (
+            right_buf, right_area.width, right_area.height, right_info.strides[0],
+            right_info.offsets[0] + right_area.pos_x + right_area.pos_y * right_info.strides[0]);
+
+        calc_adaptive_blend (
+            left_luma, right_luma, overlap.blender->get_output_level (), info.pyr_levels, info.blend_width);
+        XCAM_FAIL_RETURN (
+            ERROR,
+            overlap.blender->set_pyr_levels (info.pyr_levels) &&
+            overlap.blender->set_blend_width (info.blend_width),
+            XCAM_RETURN_ERROR_PARAM,
+            "soft-stitcher:%s set overlap(idx:%d) pyramid levels(%d) and blend width(%d) failed",
+            XCAM_STR (_stitcher->get_name ()), idx, info.pyr_levels, info.blend_width);
+    }
+
+    for (uint32_t level = 0; level <= info.pyr_levels; ++level)
+        info.cost += (uint64_t)(merge.width >> level) * (merge.height >> level) * 3;
+
+    XCAM_LOG_INFO (
+        "soft-stitcher:%s overlap(idx:%d) pyramid levels:%d, blend width:%d, cost:%" PRIu64 " pixels",
+        XCAM_STR (_stitcher->get_name ()), idx, info.pyr_levels, info.blend_width, info.cost);
+
+    overlap.blend_info = info;
+    return XCAM_RETURN_NO_ERROR;
+}
+
+bool
+StitcherImpl::get_overlap_blend_info (const uint32_t idx, SoftStitcher::OverlapBlendInfo &info)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, idx < _overlaps.size (), false,
+        "soft-stitcher:%s get overlap blend info failed, idx(%d) out of range",
+        XCAM_STR (_stitcher->get_name ()), idx);
+
+    SmartLock locker (_overlaps[idx].blend_mutex);
+    info = _overlaps[idx].blend_info;
+    return info.pyr_levels > 0;
+}
+
+XCamReturn
 StitcherImpl::start_overlap_tasks (
     const SmartPtr<SoftStitcher::StitcherParam> &param,
     const uint32_t idx, const SmartPtr<VideoBuffer> &buf)
@@ -660,22 +1537,7 @@ StitcherImpl::start_overlap_tasks (
             "soft-stitcher:%s blend overlap idx:%d failed", XCAM_STR (_stitcher->get_name ()), pre_idx);
     }
 
-#if ENABLE_FEATURE_MATCH
-    //start feature match
-    if (cur_param.ptr ()) {
-        ret = feature_match (cur_param->in_buf, cur_param->in1_buf, idx);
-        XCAM_FAIL_RETURN (
-            ERROR, xcam_ret_is_ok (ret), ret,
-            "soft-stitcher:%s feature-match overlap idx:%d failed", XCAM_STR (_stitcher->get_name ()), idx);
-    }
-
-    if (prev_param.ptr ()) {
-        ret = feature_match (prev_param->in_buf, prev_param->in1_buf, pre_idx);
-        XCAM_FAIL_RETURN (
-            ERROR, xcam_ret_is_ok (ret), ret,
-            "soft-stitcher:%s feature-match overlap idx:%d failed", XCAM_STR (_stitcher->get_name ()), pre_idx);
-    }
-#endif
+    // feature match starts on blender gauss levels once blender is done
     return XCAM_RETURN_NO_ERROR;
 }
 
@@ -735,11 +1597,606 @@ StitcherImpl::start_copy_tasks (
     return XCAM_RETURN_NO_ERROR;
 }
 
+XCamReturn
+StitcherImpl::start_tile_works (const SmartPtr<SoftStitcher::StitcherParam> &param)
+{
+    XCAM_ASSERT (_tile_task.ptr ());
+    uint32_t camera_num = _stitcher->get_camera_num ();
+
+    XCAM_FAIL_RETURN (
+        ERROR, param->in_buf_num >= camera_num, XCAM_RETURN_ERROR_PARAM,
+        "soft-stitcher:%s input buffer num(%d) less than camera num(%d)",
+        XCAM_STR (_stitcher->get_name ()), param->in_buf_num, camera_num);
+
+    // tables rebuilt in background take effect on all cameras from this frame
+    XCamReturn ret = apply_pending_tables ();
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "soft-stitcher:%s apply updated dewarp tables failed", XCAM_STR (_stitcher->get_name ()));
+
+    SmartPtr<TileArgs> args = new TileArgs (param, camera_num);
+    for (uint32_t i = 0; i < camera_num; ++i) {
+        const Stitcher::RoundViewSlice &view_slice = _stitcher->get_round_view_slice (i);
+        args->in_luma[i] = new UcharImage (param->in_bufs[i], 0);
+        args->in_uv[i] = new Uchar2Image (param->in_bufs[i], 1);
+        args->luts[i] = _fisheye[i].dewarp->get_lookup_table ();
+        XCAM_ASSERT (args->luts[i].ptr ());
+
+        // same as GeoMapper::auto_calculate_factors if factors were not set
+        Float2 &factors = args->factors[i];
+        _fisheye[i].dewarp->get_factors (factors.x, factors.y);
+        if (XCAM_DOUBLE_EQUAL_AROUND (factors.x, 0.0f) || XCAM_DOUBLE_EQUAL_AROUND (factors.y, 0.0f)) {
+            factors.x = (view_slice.width - 1.0f) / (args->luts[i]->get_width () - 1.0f);
+            factors.y = (view_slice.height - 1.0f) / (args->luts[i]->get_height () - 1.0f);
+        }
+    }
+
+    if (_stitcher->get_static_scene ())
+        mark_static_tiles (args);
+
+    return _tile_task->work (args);
+}
+
+bool
+StaticInput::is_dirty (const Rect &blocks) const
+{
+    for (int32_t y = blocks.pos_y; y < blocks.pos_y + blocks.height; ++y) {
+        const uint8_t *line = &dirty[y * blocks_x];
+        for (int32_t x = blocks.pos_x; x < blocks.pos_x + blocks.width; ++x) {
+            if (line[x])
+                return true;
+        }
+    }
+    return false;
+}
+
+// input blocks covering all pixels map_area reads for area, plus one pixel for bilinear
+static Rect
+calc_footprint_blocks (
+    const Float2Image &lut, const Float2 &factors, const Rect &area,
+    uint32_t view_width, uint32_t view_height, uint32_t in_width, uint32_t in_height)
+{
+    Float2 out_center ((view_width - 1.0f ) / 2.0f, (view_height - 1.0f ) / 2.0f);
+    Float2 lut_center ((lut.get_width () - 1.0f) / 2.0f, (lut.get_height () - 1.0f) / 2.0f);
+    int32_t lut_w = lut.get_width (), lut_h = lut.get_height ();
+
+    // map_area writes 8x2 blocks
+    float end_x = area.pos_x + XCAM_ALIGN_UP (area.width, 8) - 1.0f;
+    float end_y = area.pos_y + XCAM_ALIGN_UP (area.height, 2) - 1.0f;
+    int32_t lut_x0 = XCAM_CLAMP ((int32_t)floorf ((area.pos_x - out_center.x) / factors.x + lut_center.x), 0, lut_w - 1);
+    int32_t lut_y0 = XCAM_CLAMP ((int32_t)floorf ((area.pos_y - out_center.y) / factors.y + lut_center.y), 0, lut_h - 1);
+    int32_t lut_x1 = XCAM_CLAMP ((int32_t)floorf ((end_x - out_center.x) / factors.x + lut_center.x) + 1, 0, lut_w - 1);
+    int32_t lut_y1 = XCAM_CLAMP ((int32_t)floorf ((end_y - out_center.y) / factors.y + lut_center.y) + 1, 0, lut_h - 1);
+
+    float min_x = FLT_MAX, min_y = FLT_MAX, max_x = -FLT_MAX, max_y = -FLT_MAX;
+    for (int32_t y = lut_y0; y <= lut_y1; ++y) {
+        const Float2 *line = lut.get_buf_ptr (0, y);
+        for (int32_t x = lut_x0; x <= lut_x1; ++x) {
+            min_x = XCAM_MIN (min_x, line[x].x);
+            min_y = XCAM_MIN (min_y, line[x].y);
+            max_x = XCAM_MAX (max_x, line[x].x);
+            max_y = XCAM_MAX (max_y, line[x].y);
+        }
+    }
+
+    int32_t x0 = XCAM_CLAMP ((int32_t)floorf (min_x) - 1, 0, (int32_t)in_width - 1);
+    int32_t y0 = XCAM_CLAMP ((int32_t)floorf (min_y) - 1, 0, (int32_t)in_height - 1);
+    int32_t x1 = XCAM_CLAMP ((int32_t)ceilf (max_x) + 1, 0, (int32_t)in_width - 1);
+    int32_t y1 = XCAM_CLAMP ((int32_t)ceilf (max_y) + 1, 0, (int32_t)in_height - 1);
+
+    Rect blocks;
+    blocks.pos_x = x0 / SOFT_STITCHER_STATIC_BLOCK;
+    blocks.pos_y = y0 / SOFT_STITCHER_STATIC_BLOCK;
+    blocks.width = x1 / SOFT_STITCHER_STATIC_BLOCK - blocks.pos_x + 1;
+    blocks.height = y1 / SOFT_STITCHER_STATIC_BLOCK - blocks.pos_y + 1;
+    return blocks;
+}
+
+void
+StitcherImpl::calc_tile_footprints (uint32_t idx, const SmartPtr<TileArgs> &args)
+{
+    uint32_t camera_num = _stitcher->get_camera_num ();
+    uint32_t in_width = args->in_luma[idx]->get_width ();
+    uint32_t in_height = args->in_luma[idx]->get_height ();
+    const Stitcher::RoundViewSlice &view_slice = _stitcher->get_round_view_slice (idx);
+    const Float2Image &lut = *args->luts[idx].ptr ();
+    const Float2 &factors = args->factors[idx];
+
+    for (uint32_t i = 0; i < _tiles.size (); ++i) {
+        StitchTile &tile = _tiles[i];
+        if (!tile.is_overlap) {
+            if (tile.idx == idx)
+                tile.in_blocks[0] = calc_footprint_blocks (
+                    lut, factors, tile.in_area, view_slice.width, view_slice.height, in_width, in_height);
+            continue;
+        }
+
+        const Stitcher::ImageOverlapInfo &overlap_info = _stitcher->get_overlap (tile.idx);
+        if (tile.idx == idx)
+            tile.in_blocks[0] = calc_footprint_blocks (
+                lut, factors, overlap_info.left, view_slice.width, view_slice.height, in_width, in_height);
+        if ((tile.idx + 1) % camera_num == idx)
+            tile.in_blocks[1] = calc_footprint_blocks (
+                lut, factors, overlap_info.right, view_slice.width, view_slice.height, in_width, in_height);
+    }
+}
+
+// sum of absolute differences, plain loops are vectorized by compiler
+static inline uint32_t
+calc_block_sad (const Uchar *cur, uint32_t cur_pitch, const Uchar *ref, uint32_t ref_pitch, uint32_t bytes, uint32_t rows)
+{
+    uint32_t sad = 0;
+    for (uint32_t y = 0; y < rows; ++y, cur += cur_pitch, ref += ref_pitch) {
+        for (uint32_t x = 0; x < bytes; ++x)
+            sad += abs ((int32_t)cur[x] - (int32_t)ref[x]);
+    }
+    return sad;
+}
+
+static inline void
+copy_block (const Uchar *cur, uint32_t cur_pitch, Uchar *ref, uint32_t ref_pitch, uint32_t bytes, uint32_t rows)
+{
+    for (uint32_t y = 0; y < rows; ++y, cur += cur_pitch, ref += ref_pitch)
+        memcpy (ref, cur, bytes);
+}
+
+bool
+StitcherImpl::update_static_input (uint32_t idx, const SmartPtr<TileArgs> &args)
+{
+    StaticInput &input = _static_inputs[idx];
+    const UcharImage &luma = *args->in_luma[idx].ptr ();
+    const Uchar2Image &uv = *args->in_uv[idx].ptr ();
+    uint32_t width = luma.get_width (), height = luma.get_height ();
+    bool reset = false;
+
+    if (!input.ref_luma.ptr () ||
+            input.ref_luma->get_width () != width || input.ref_luma->get_height () != height) {
+        input.ref_luma = new UcharImage (width, height);
+        input.ref_uv = new Uchar2Image (uv.get_width (), uv.get_height ());
+        input.blocks_x = xcam_ceil (width, SOFT_STITCHER_STATIC_BLOCK) / SOFT_STITCHER_STATIC_BLOCK;
+        input.blocks_y = xcam_ceil (height, SOFT_STITCHER_STATIC_BLOCK) / SOFT_STITCHER_STATIC_BLOCK;
+        input.dirty.assign (input.blocks_x * input.blocks_y, 1);
+        input.lut.release ();
+        reset = true;
+    }
+
+    if (input.lut.ptr () != args->luts[idx].ptr ()) {
+        input.lut = args->luts[idx];
+        calc_tile_footprints (idx, args);
+        reset = true;
+    }
+
+    UcharImage &ref_luma = *input.ref_luma.ptr ();
+    Uchar2Image &ref_uv = *input.ref_uv.ptr ();
+    uint32_t threshold = _stitcher->get_static_threshold ();
+    for (uint32_t by = 0; by < input.blocks_y; ++by)
+        for (uint32_t bx = 0; bx < input.blocks_x; ++bx)
+        {
+            uint32_t x = bx * SOFT_STITCHER_STATIC_BLOCK, y = by * SOFT_STITCHER_STATIC_BLOCK;
+            uint32_t bytes = XCAM_MIN ((uint32_t)SOFT_STITCHER_STATIC_BLOCK, width - x);
+            uint32_t rows = XCAM_MIN ((uint32_t)SOFT_STITCHER_STATIC_BLOCK, height - y);
+            uint32_t uv_rows = XCAM_MIN (rows / 2, uv.get_height () - y / 2);
+            const Uchar *cur_y = luma.get_buf_ptr (x, y);
+            const Uchar *cur_uv = (const Uchar *)uv.get_buf_ptr (x / 2, y / 2);
+            Uchar *ref_y = ref_luma.get_buf_ptr (x, y);
+            Uchar *ref_c = (Uchar *)ref_uv.get_buf_ptr (x / 2, y / 2);
+
+            bool dirty = reset;
+            if (!dirty) {
+                uint32_t sad = calc_block_sad (cur_y, luma.get_pitch (), ref_y, ref_luma.get_pitch (), bytes, rows);
+                sad += calc_block_sad (cur_uv, uv.get_pitch (), ref_c, ref_uv.get_pitch (), bytes, uv_rows);
+                dirty = (sad > threshold * (rows + uv_rows) * bytes);
+            }
+
+            input.dirty[by * input.blocks_x + bx] = dirty;
+            if (dirty) {
+                copy_block (cur_y, luma.get_pitch (), ref_y, ref_luma.get_pitch (), bytes, rows);
+                copy_block (cur_uv, uv.get_pitch (), ref_c, ref_uv.get_pitch (), bytes, uv_rows);
+            }
+        }
+
+    return reset;
+}
+
+void
+StitcherImpl::mark_static_tiles (const SmartPtr<TileArgs> &args)
+{
+    uint32_t camera_num = _stitcher->get_camera_num ();
+    const SmartPtr<VideoBuffer> &out_buf = args->get_param ()->out_buf;
+    SmartPtr<VideoBuffer> last_out;
+    {
+        SmartLock locker (_static_mutex);
+        last_out = _last_out;
+        _last_out.release ();
+        args->frame = ++_tile_frame;
+    }
+
+    // whole frame is rendered if last output is missing or any table or input size changed
+    bool full = !last_out.ptr () ||
+                last_out->get_video_info ().width != out_buf->get_video_info ().width ||
+                last_out->get_video_info ().height != out_buf->get_video_info ().height;
+
+    if (_static_inputs.size () != camera_num)
+        std::vector<StaticInput> (camera_num).swap (_static_inputs);
+    for (uint32_t i = 0; i < camera_num; ++i) {
+        if (update_static_input (i, args))
+            full = true;
+    }
+
+    uint32_t skipped = 0;
+    if (!full) {
+        args->skip.resize (_tiles.size ());
+        for (uint32_t i = 0; i < _tiles.size (); ++i) {
+            const StitchTile &tile = _tiles[i];
+            bool dirty = _static_inputs[tile.idx].is_dirty (tile.in_blocks[0]);
+            if (tile.is_overlap && !dirty)
+                dirty = _static_inputs[(tile.idx + 1) % camera_num].is_dirty (tile.in_blocks[1]);
+
+            args->skip[i] = !dirty;
+            skipped += args->skip[i];
+        }
+        args->last_out = last_out;
+    }
+
+    SmartLock locker (_static_mutex);
+    _skipped_tiles += skipped;
+    _total_tiles += _tiles.size ();
+    XCAM_LOG_DEBUG (
+        "soft-stitcher:%s frame:%d skipped tiles:%d/%d",
+        XCAM_STR (_stitcher->get_name ()), args->frame, skipped, (uint32_t)_tiles.size ());
+}
+
+void
+StitcherImpl::keep_last_output (const SmartPtr<TileArgs> &args)
+{
+    SmartLock locker (_static_mutex);
+    // an earlier frame done late doesn't match current input blocks
+    if (args->frame == _tile_frame)
+        _last_out = args->get_param ()->out_buf;
+}
+
+float
+StitcherImpl::get_tile_skip_ratio ()
+{
+    SmartLock locker (_static_mutex);
+    return _total_tiles ? (float)_skipped_tiles / _total_tiles : 0.0f;
+}
+
+XCamReturn
+StitcherImpl::copy_last_tile (const SmartPtr<TileArgs> &args, const StitchTile &tile)
+{
+    const SmartPtr<VideoBuffer> &out_buf = args->get_param ()->out_buf;
+    const SmartPtr<VideoBuffer> &last_out = args->last_out;
+    if (out_buf.ptr () == last_out.ptr ())
+        return XCAM_RETURN_NO_ERROR;
+
+    const Rect &area = tile.out_area;
+    const VideoBufferInfo &out_info = out_buf->get_video_info ();
+    const VideoBufferInfo &last_info = last_out->get_video_info ();
+    UcharImage out_luma (
+        out_buf, area.width, area.height, out_info.strides[0],
+        out_info.offsets[0] + area.pos_x + area.pos_y * out_info.strides[0]);
+    Uchar2Image out_uv (
+        out_buf, area.width / 2, area.height / 2, out_info.strides[1],
+        out_info.offsets[1] + area.pos_x + area.pos_y / 2 * out_info.strides[1]);
+    UcharImage last_luma (
+        last_out, area.width, area.height, last_info.strides[0],
+        last_info.offsets[0] + area.pos_x + area.pos_y * last_info.strides[0]);
+    Uchar2Image last_uv (
+        last_out, area.width / 2, area.height / 2, last_info.strides[1],
+        last_info.offsets[1] + area.pos_x + area.pos_y / 2 * last_info.strides[1]);
+
+    for (int32_t y = 0; y < area.height; ++y)
+        memcpy (out_luma.get_buf_ptr (0, y), last_luma.get_buf_ptr (0, y), area.width);
+    for (int32_t y = 0; y < area.height / 2; ++y)
+        memcpy (
+            (uint8_t *)out_uv.get_buf_ptr (0, y), (const uint8_t *)last_uv.get_buf_ptr (0, y),
+            area.width / 2 * sizeof (Uchar2));
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+StitcherImpl::map_copy_tile (const SmartPtr<TileArgs> &args, const StitchTile &tile)
+{
+    const SmartPtr<VideoBuffer> &out_buf = args->get_param ()->out_buf;
+    const VideoBufferInfo &out_info = out_buf->get_video_info ();
+    const Stitcher::RoundViewSlice &view_slice = _stitcher->get_round_view_slice (tile.idx);
+    const Rect &out_area = tile.out_area;
+
+    UcharImage out_luma (
+        out_buf, out_area.width, out_area.height, out_info.strides[0],
+        out_info.offsets[0] + out_area.pos_x + out_area.pos_y * out_info.strides[0]);
+    Uchar2Image out_uv (
+        out_buf, out_area.width / 2, out_area.height / 2, out_info.strides[1],
+        out_info.offsets[1] + out_area.pos_x + out_area.pos_y / 2 * out_info.strides[1]);
+
+    // remap writes 8x2 luma blocks, map into output directly if tile is aligned,
+    // otherwise into a scratch to keep neighbor tiles untouched
+    if (out_area.width % 8 == 0 && out_area.height % 2 == 0) {
+        XCamSoftTasks::GeoMapTask::map_area (
+            args->in_luma[tile.idx].ptr (), args->in_uv[tile.idx].ptr (), &out_luma, &out_uv,
+            args->luts[tile.idx].ptr (), args->factors[tile.idx],
+            tile.in_area, view_slice.width, view_slice.height);
+        return XCAM_RETURN_NO_ERROR;
+    }
+
+    uint32_t aligned_width = XCAM_ALIGN_UP (out_area.width, 8);
+    uint32_t aligned_height = XCAM_ALIGN_UP (out_area.height, 2);
+    UcharImage tile_luma (aligned_width, aligned_height);
+    Uchar2Image tile_uv (aligned_width / 2, aligned_height / 2);
+    XCAM_FAIL_RETURN (
+        ERROR, tile_luma.is_valid () && tile_uv.is_valid (), XCAM_RETURN_ERROR_MEM,
+        "soft-stitcher:%s allocate tile scratch(w:%d, h:%d) failed",
+        XCAM_STR (_stitcher->get_name ()), aligned_width, aligned_height);
+
+    XCamSoftTasks::GeoMapTask::map_area (
+        args->in_luma[tile.idx].ptr (), args->in_uv[tile.idx].ptr (), &tile_luma, &tile_uv,
+        args->luts[tile.idx].ptr (), args->factors[tile.idx],
+        tile.in_area, view_slice.width, view_slice.height);
+
+    for (int32_t y = 0; y < out_area.height; ++y)
+        memcpy (out_luma.get_buf_ptr (0, y), tile_luma.get_buf_ptr (0, y), out_area.width);
+    for (int32_t y = 0; y < out_area.height / 2; ++y)
+        memcpy ((uint8_t *)out_uv.get_buf_ptr (0, y), (const uint8_t *)tile_uv.get_buf_ptr (0, y),
+                out_area.width / 2 * sizeof (Uchar2));
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+StitcherImpl::blend_overlap_tile (const SmartPtr<TileArgs> &args, const StitchTile &tile)
+{
+    Overlap &overlap = _overlaps[tile.idx];
+    const Stitcher::ImageOverlapInfo &overlap_info = _stitcher->get_overlap (tile.idx);
+    const uint32_t idxs[2] = {tile.idx, (tile.idx + 1) % _stitcher->get_camera_num ()};
+    const Rect *areas[2] = {&overlap_info.left, &overlap_info.right};
+    SmartPtr<VideoBuffer> bufs[2];
+
+    {
+        // waits if all tile buffers are in use, peak buffers don't grow with camera num.
+        // both buffers are taken under lock, work items never hold one each and wait for a second
+        SmartLock locker (_tile_buf_mutex);
+        for (uint32_t i = 0; i < 2; ++i) {
+            bufs[i] = _tile_pool->get_buffer ();
+            XCAM_FAIL_RETURN (
+                ERROR, bufs[i].ptr (), XCAM_RETURN_ERROR_MEM,
+                "soft-stitcher:%s get overlap(idx:%d) tile buffer failed", XCAM_STR (_stitcher->get_name ()), tile.idx);
+        }
+    }
+
+    for (uint32_t i = 0; i < 2; ++i) {
+        const Stitcher::RoundViewSlice &view_slice = _stitcher->get_round_view_slice (idxs[i]);
+        UcharImage luma (bufs[i], 0);
+        Uchar2Image uv (bufs[i], 1);
+        XCamSoftTasks::GeoMapTask::map_area (
+            args->in_luma[idxs[i]].ptr (), args->in_uv[idxs[i]].ptr (), &luma, &uv,
+            args->luts[idxs[i]].ptr (), args->factors[idxs[i]],
+            *areas[i], view_slice.width, view_slice.height);
+    }
+
+    XCamReturn ret = config_overlap_blend (
+        tile.idx, bufs[0], Rect (0, 0, areas[0]->width, areas[0]->height),
+        bufs[1], Rect (0, 0, areas[1]->width, areas[1]->height));
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "soft-stitcher:%s config overlap(idx:%d) blend failed", XCAM_STR (_stitcher->get_name ()), tile.idx);
+
+    SmartPtr<SoftBlender::BlenderParam> blend_param =
+        new SoftBlender::BlenderParam (bufs[0], bufs[1], args->get_param ()->out_buf);
+    XCAM_ASSERT (blend_param.ptr ());
+
+    // a handler only tracks one synchronous call at a time
+    SmartLock locker (overlap.blend_mutex);
+    ret = overlap.blender->execute_buffer (blend_param, true);
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "soft-stitcher:%s blend overlap(idx:%d) tile failed", XCAM_STR (_stitcher->get_name ()), tile.idx);
+
+    keep_overlap_levels (tile.idx, blend_param);
+    return XCAM_RETURN_NO_ERROR;
+}
+
+void
+StitcherImpl::keep_overlap_levels (const uint32_t idx, const SmartPtr<SoftBlender::BlenderParam> &param)
+{
+    if (!_overlaps[idx].blender->get_output_level ())
+        return;
+
+    Overlap &overlap = _overlaps[idx];
+    SmartLock locker (overlap.level_mutex);
+    overlap.gauss_bufs[SoftBlender::Idx0] = param->gauss_bufs[SoftBlender::Idx0];
+    overlap.gauss_bufs[SoftBlender::Idx1] = param->gauss_bufs[SoftBlender::Idx1];
+    overlap.blended_buf = param->blended_buf;
+}
+
+static inline void
+get_level_range (int32_t pos, int32_t length, uint32_t shift, int32_t &start, int32_t &end)
+{
+    int32_t round = (1 << shift) - 1;
+    start = (pos + round) >> shift;
+    end = (pos + length + round) >> shift;
+}
+
+// pixels of preview area are averaged over their 2^level blocks of output
+static void
+scale_down_area (
+    const UcharImage &in_luma, const Uchar2Image &in_uv,
+    UcharImage &out_luma, Uchar2Image &out_uv, const Rect &area, uint32_t level)
+{
+    int32_t size = 1 << level;
+    int32_t x0, x1, y0, y1;
+
+    get_level_range (area.pos_x, area.width, level, x0, x1);
+    get_level_range (area.pos_y, area.height, level, y0, y1);
+    x1 = XCAM_MIN (x1, (int32_t)out_luma.get_width ());
+    y1 = XCAM_MIN (y1, (int32_t)out_luma.get_height ());
+    for (int32_t y = y0; y < y1; ++y) {
+        Uchar *out = out_luma.get_buf_ptr (0, y);
+        int32_t rows = XCAM_MIN (size, (int32_t)in_luma.get_height () - (y << level));
+        for (int32_t x = x0; x < x1; ++x) {
+            int32_t cols = XCAM_MIN (size, (int32_t)in_luma.get_width () - (x << level));
+            uint32_t sum = 0;
+            for (int32_t i = 0; i < rows; ++i) {
+                const Uchar *in = in_luma.get_buf_ptr (x << level, (y << level) + i);
+                for (int32_t j = 0; j < cols; ++j)
+                    sum += in[j];
+            }
+            out[x] = (rows > 0 && cols > 0) ? (sum + rows * cols / 2) / (rows * cols) : 0;
+        }
+    }
+
+    get_level_range (area.pos_x, area.width, level + 1, x0, x1);
+    get_level_range (area.pos_y, area.height, level + 1, y0, y1);
+    x1 = XCAM_MIN (x1, (int32_t)out_uv.get_width ());
+    y1 = XCAM_MIN (y1, (int32_t)out_uv.get_height ());
+    for (int32_t y = y0; y < y1; ++y) {
+        Uchar2 *out = out_uv.get_buf_ptr (0, y);
+        int32_t rows = XCAM_MIN (size, (int32_t)in_uv.get_height () - (y << level));
+        for (int32_t x = x0; x < x1; ++x) {
+            int32_t cols = XCAM_MIN (size, (int32_t)in_uv.get_width () - (x << level));
+            uint32_t sum_u = 0, sum_v = 0;
+            for (int32_t i = 0; i < rows; ++i) {
+                const Uchar2 *in = in_uv.get_buf_ptr (x << level, (y << level) + i);
+                for (int32_t j = 0; j < cols; ++j) {
+                    sum_u += in[j].x;
+                    sum_v += in[j].y;
+                }
+            }
+            uint32_t count = (rows > 0 && cols > 0) ? rows * cols : 1;
+            out[x].x = (sum_u + count / 2) / count;
+            out[x].y = (sum_v + count / 2) / count;
+        }
+    }
+}
+
+// pixels of preview area are taken from blender level buffer of the area
+static void
+copy_level_area (
+    const UcharImage &level_luma, const Uchar2Image &level_uv,
+    UcharImage &out_luma, Uchar2Image &out_uv, const Rect &area, uint32_t level)
+{
+    int32_t x0, x1, y0, y1;
+
+    get_level_range (area.pos_x, area.width, level, x0, x1);
+    get_level_range (area.pos_y, area.height, level, y0, y1);
+    x1 = XCAM_MIN (x1, (int32_t)out_luma.get_width ());
+    y1 = XCAM_MIN (y1, (int32_t)out_luma.get_height ());
+    for (int32_t y = y0; y < y1; ++y) {
+        int32_t level_y = XCAM_MIN (((y << level) - area.pos_y) >> level, (int32_t)level_luma.get_height () - 1);
+        const Uchar *in = level_luma.get_buf_ptr (0, level_y);
+        Uchar *out = out_luma.get_buf_ptr (0, y);
+        for (int32_t x = x0; x < x1; ++x)
+            out[x] = in[XCAM_MIN (((x << level) - area.pos_x) >> level, (int32_t)level_luma.get_width () - 1)];
+    }
+
+    level += 1;
+    get_level_range (area.pos_x, area.width, level, x0, x1);
+    get_level_range (area.pos_y, area.height, level, y0, y1);
+    x1 = XCAM_MIN (x1, (int32_t)out_uv.get_width ());
+    y1 = XCAM_MIN (y1, (int32_t)out_uv.get_height ());
+    for (int32_t y = y0; y < y1; ++y) {
+        int32_t level_y = XCAM_MIN (((y << level) - area.pos_y) >> level, (int32_t)level_uv.get_height () - 1);
+        const Uchar2 *in = level_uv.get_buf_ptr (0, level_y);
+        Uchar2 *out = out_uv.get_buf_ptr (0, y);
+        for (int32_t x = x0; x < x1; ++x)
+            out[x] = in[XCAM_MIN (((x << level) - area.pos_x) >> level, (int32_t)level_uv.get_width () - 1)];
+    }
+}
+
+XCamReturn
+StitcherImpl::render_preview (const SmartPtr<VideoBuffer> &out_buf, SmartPtr<VideoBuffer> &preview)
+{
+    uint32_t level = _stitcher->get_preview_level ();
+    XCAM_FAIL_RETURN (
+        ERROR, level && _preview_pool.ptr (), XCAM_RETURN_ERROR_ORDER,
+        "soft-stitcher:%s render preview failed, preview was not enabled or stitcher was not configured",
+        XCAM_STR (_stitcher->get_name ()));
+    XCAM_FAIL_RETURN (
+        ERROR, out_buf.ptr (), XCAM_RETURN_ERROR_PARAM,
+        "soft-stitcher:%s render preview failed, output buffer is empty", XCAM_STR (_stitcher->get_name ()));
+
+    if (!preview.ptr ()) {
+        preview = _preview_pool->get_buffer ();
+        XCAM_FAIL_RETURN (
+            ERROR, preview.ptr (), XCAM_RETURN_ERROR_MEM,
+            "soft-stitcher:%s get preview buffer failed", XCAM_STR (_stitcher->get_name ()));
+    }
+
+    UcharImage in_luma (out_buf, 0);
+    Uchar2Image in_uv (out_buf, 1);
+    UcharImage out_luma (preview, 0);
+    Uchar2Image out_uv (preview, 1);
+
+    const Stitcher::CopyAreaArray &areas = _stitcher->get_copy_area ();
+    for (uint32_t i = 0; i < areas.size (); ++i)
+        scale_down_area (in_luma, in_uv, out_luma, out_uv, areas[i].out_area, level);
+
+    // overlaps are blended on pyramid already, no need to scale again
+    for (uint32_t i = 0; i < _overlaps.size (); ++i) {
+        const Rect &area = _stitcher->get_overlap (i).out_area;
+        SmartPtr<VideoBuffer> blended;
+        {
+            SmartLock locker (_overlaps[i].level_mutex);
+            blended = _overlaps[i].blended_buf;
+        }
+
+        if (!blended.ptr ()) {
+            scale_down_area (in_luma, in_uv, out_luma, out_uv, area, level);
+            continue;
+        }
+
+        UcharImage level_luma (blended, 0);
+        Uchar2Image level_uv (blended, 1);
+        copy_level_area (level_luma, level_uv, out_luma, out_uv, area, level);
+    }
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+StitcherImpl::stitch_tile (const SmartPtr<TileArgs> &args, uint32_t tile_idx)
+{
+    XCAM_ASSERT (tile_idx < _tiles.size ());
+    const StitchTile &tile = _tiles[tile_idx];
+
+    if (!args->skip.empty () && args->skip[tile_idx])
+        return copy_last_tile (args, tile);
+
+    if (tile.is_overlap)
+        return blend_overlap_tile (args, tile);
+
+    return map_copy_tile (args, tile);
+}
+
+XCamReturn
+TileTask::work_range (const SmartPtr<Arguments> &base, const WorkRange &range)
+{
+    SmartPtr<TileArgs> args = base.dynamic_cast_ptr<TileArgs> ();
+    XCAM_ASSERT (args.ptr ());
+
+    uint32_t items = get_global_size ().value[0];
+    uint32_t tile_num = _impl->get_tile_num ();
+    for (uint32_t y = range.pos[1]; y < range.pos[1] + range.pos_len[1]; ++y)
+        for (uint32_t x = range.pos[0]; x < range.pos[0] + range.pos_len[0]; ++x)
+        {
+            uint32_t tile_idx = y * items + x;
+            if (tile_idx >= tile_num)
+                continue;
+
+            XCamReturn ret = _impl->stitch_tile (args, tile_idx);
+            XCAM_FAIL_RETURN (
+                ERROR, xcam_ret_is_ok (ret), ret,
+                "StitchTileTask stitch tile(idx:%d) failed", tile_idx);
+        }
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
 XCamReturn
 StitcherImpl::stop ()
 {
-    uint32_t cam_num = _stitcher->get_camera_num ();
-    for (uint32_t i = 0; i < cam_num; ++i) {
+    for (uint32_t i = 0; i < _fisheye.size (); ++i) {
         if (_fisheye[i].dewarp.ptr ()) {
             _fisheye[i].dewarp->terminate ();
             _fisheye[i].dewarp.release ();
@@ -747,6 +2204,11 @@ StitcherImpl::stop ()
         if (_fisheye[i].buf_pool.ptr ()) {
             _fisheye[i].buf_pool->stop ();
         }
+        if (_fisheye[i].table_task.ptr ()) {
+            _fisheye[i].table_task->stop ();
+            _fisheye[i].table_task.release ();
+        }
+        _fisheye[i].pending_table.release ();
 
         if (_overlaps[i].blender.ptr ()) {
             _overlaps[i].blender->terminate ();
@@ -754,6 +2216,20 @@ StitcherImpl::stop ()
         }
     }
 
+    if (_tile_pool.ptr ())
+        _tile_pool->stop ();
+    if (_preview_pool.ptr ())
+        _preview_pool->stop ();
+
+    {
+        SmartLock locker (_static_mutex);
+        _last_out.release ();
+    }
+    if (_tile_task.ptr ()) {
+        _tile_task->stop ();
+        _tile_task.release ();
+    }
+
     for (Copiers::iterator i_copy = _copiers.begin (); i_copy != _copiers.end (); ++i_copy) {
         Copier &copy = *i_copy;
         if (copy.copy_task.ptr ()) {
@@ -773,6 +2249,11 @@ StitcherImpl::stop ()
 SoftStitcher::SoftStitcher (const char *name)
     : SoftHandler (name)
     , Stitcher (SOFT_STITCHER_ALIGNMENT_X, SOFT_STITCHER_ALIGNMENT_Y)
+    , _engine (StitchEngineStaged)
+    , _static_scene (false)
+    , _static_threshold (0)
+    , _preview_level (0)
+    , _adaptive_blend (false)
 {
     SmartPtr<SoftSitcherPriv::StitcherImpl> impl = new SoftSitcherPriv::StitcherImpl (this);
     XCAM_ASSERT (impl.ptr ());
@@ -802,7 +2283,8 @@ SoftStitcher::stitch_buffers (const VideoBufferList &in_bufs, SmartPtr<VideoBuff
     for (VideoBufferList::const_iterator i = in_bufs.begin(); i != in_bufs.end (); ++i) {
         SmartPtr<VideoBuffer> buf = *i;
         XCAM_ASSERT (buf.ptr ());
-        param->in_bufs[count++] = buf;
+        param->in_bufs.push_back (buf);
+        ++count;
     }
     param->in_buf_num = count;
     XCamReturn ret = execute_buffer (param, true);
@@ -812,6 +2294,89 @@ SoftStitcher::stitch_buffers (const VideoBufferList &in_bufs, SmartPtr<VideoBuff
     return ret;
 }
 
+bool
+SoftStitcher::set_stitch_engine (StitchEngine engine)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, _impl->_fisheye.empty (), false,
+        "soft-stitcher:%s set stitch engine failed, stitcher was already configured", XCAM_STR (get_name ()));
+
+    _engine = engine;
+    return true;
+}
+
+bool
+SoftStitcher::set_static_scene (bool enable, uint32_t threshold)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, _impl->_fisheye.empty (), false,
+        "soft-stitcher:%s set static scene failed, stitcher was already configured", XCAM_STR (get_name ()));
+
+    _static_scene = enable;
+    _static_threshold = threshold;
+    return true;
+}
+
+float
+SoftStitcher::get_tile_skip_ratio () const
+{
+    return _impl->get_tile_skip_ratio ();
+}
+
+bool
+SoftStitcher::set_adaptive_blend (bool enable)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, _impl->_fisheye.empty (), false,
+        "soft-stitcher:%s set adaptive blend failed, stitcher was already configured", XCAM_STR (get_name ()));
+
+    _adaptive_blend = enable;
+    return true;
+}
+
+bool
+SoftStitcher::get_overlap_blend_info (uint32_t idx, OverlapBlendInfo &info) const
+{
+    return _impl->get_overlap_blend_info (idx, info);
+}
+
+bool
+SoftStitcher::set_preview_level (uint32_t level)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, _impl->_fisheye.empty (), false,
+        "soft-stitcher:%s set preview level failed, stitcher was already configured", XCAM_STR (get_name ()));
+    XCAM_FAIL_RETURN (
+        ERROR, level <= XCAM_SOFT_PYRAMID_DEFAULT_LEVEL, false,
+        "soft-stitcher:%s set preview level failed, level(%d) > blender pyramid levels(%d)",
+        XCAM_STR (get_name ()), level, XCAM_SOFT_PYRAMID_DEFAULT_LEVEL);
+
+    _preview_level = level;
+    return true;
+}
+
+XCamReturn
+SoftStitcher::render_preview (const SmartPtr<VideoBuffer> &out_buf, SmartPtr<VideoBuffer> &preview)
+{
+    return _impl->render_preview (out_buf, preview);
+}
+
+XCamReturn
+SoftStitcher::update_geo_tables ()
+{
+    // calibration or bowl changed, viewport maps are out of date too
+    _impl->clear_viewports ();
+    return _impl->update_geo_tables ();
+}
+
+XCamReturn
+SoftStitcher::render_viewport (
+    const ViewportPose &pose, uint32_t width, uint32_t height,
+    const VideoBufferList &in_bufs, SmartPtr<VideoBuffer> &out_buf)
+{
+    return _impl->render_viewport (pose, width, height, in_bufs, out_buf);
+}
+
 XCamReturn
 SoftStitcher::terminate ()
 {
@@ -894,6 +2459,23 @@ SoftStitcher::blender_done (
     stitcher_dump_buf (blender_param->out_buf, blender_param->idx, "stitcher-blend");
     XCAM_LOG_INFO ("blender:(%s) overlap:%d done", XCAM_STR (handler->get_name ()), blender_param->idx);
 
+    _impl->keep_overlap_levels (blender_param->idx, blender_param);
+
+#if ENABLE_FEATURE_MATCH
+    SmartPtr<SoftBlender> blender = handler.dynamic_cast_ptr<SoftBlender> ();
+    XCAM_ASSERT (blender.ptr ());
+    XCamReturn ret = _impl->feature_match (
+        blender_param->gauss_bufs[SoftBlender::Idx0], blender_param->gauss_bufs[SoftBlender::Idx1],
+        blender_param->idx, blender->get_output_level ());
+    if (!xcam_ret_is_ok (ret)) {
+        XCAM_LOG_ERROR (
+            "soft-stitcher:%s feature-match overlap idx:%d failed", XCAM_STR (get_name ()), blender_param->idx);
+        _impl->remove_task_count (param);
+        work_broken (param, ret);
+        return;
+    }
+#endif
+
     if (_impl->dec_task_count (param) == 0) {
         work_well_done (param, error);
     }
@@ -924,6 +2506,43 @@ SoftStitcher::copy_task_done (
     }
 }
 
+void
+SoftStitcher::table_task_done (
+    const SmartPtr<Worker> &worker,
+    const SmartPtr<Worker::Arguments> &base, const XCamReturn error)
+{
+    XCAM_UNUSED (worker);
+
+    SmartPtr<SoftSitcherPriv::TableArgs> args = base.dynamic_cast_ptr<SoftSitcherPriv::TableArgs> ();
+    XCAM_ASSERT (args.ptr ());
+
+    if (!xcam_ret_is_ok (error)) {
+        XCAM_LOG_ERROR ("soft-stitcher:%s camera(idx:%d) dewarp table failed", XCAM_STR (get_name ()), args->idx);
+    }
+    _impl->table_work_done (args, error);
+}
+
+void
+SoftStitcher::tile_task_done (
+    const SmartPtr<Worker> &worker,
+    const SmartPtr<Worker::Arguments> &base, const XCamReturn error)
+{
+    XCAM_UNUSED (worker);
+
+    SmartPtr<SoftSitcherPriv::TileArgs> args = base.dynamic_cast_ptr<SoftSitcherPriv::TileArgs> ();
+    XCAM_ASSERT (args.ptr ());
+    const SmartPtr<ImageHandler::Parameters> param = args->get_param ();
+    XCAM_ASSERT (param.ptr ());
+
+    if (!check_work_continue (param, error))
+        return;
+
+    stitcher_dump_buf (param->out_buf, 0, "stitcher-tiles");
+    if (_static_scene)
+        _impl->keep_last_output (args);
+    work_well_done (param, error);
+}
+
 XCamReturn
 SoftStitcher::configure_resource (const SmartPtr<Parameters> &param)
 {
@@ -992,6 +2611,14 @@ SoftStitcher::start_work (const SmartPtr<Parameters> &base)
         "soft_stitcher:%s start_work failed, params(in_buf_num) in_bufs are set",
         XCAM_STR (get_name ()));
 
+    if (_engine == StitchEngineFusedTiles) {
+        XCamReturn ret = _impl->start_tile_works (param);
+        XCAM_FAIL_RETURN (
+            ERROR, xcam_ret_is_ok (ret), ret,
+            "soft_stitcher:%s start tile works failed", XCAM_STR (get_name ()));
+        return ret;
+    }
+
     XCamReturn ret = start_task_count (param);
     XCAM_FAIL_RETURN (
         ERROR, xcam_ret_is_ok (ret), XCAM_RETURN_ERROR_PARAM,
@@ -1010,9 +2637,12 @@ SoftStitcher::start_work (const SmartPtr<Parameters> &base)
 }
 
 SmartPtr<Stitcher>
-Stitcher::create_soft_stitcher ()
+Stitcher::create_soft_stitcher (StitchEngine engine)
 {
-    return new SoftStitcher;
+    SmartPtr<SoftStitcher> stitcher = new SoftStitcher;
+    XCAM_ASSERT (stitcher.ptr ());
+    stitcher->set_stitch_engine (engine);
+    return stitcher;
 }
 
 }
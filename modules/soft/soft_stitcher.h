@@ -32,6 +32,8 @@ class StitcherImpl;
 class CbGeoMap;
 class CbBlender;
 class CbCopyTask;
+class CbTableTask;
+class CbTileTask;
 };
 
 class SoftStitcher
@@ -42,13 +44,15 @@ class SoftStitcher
     friend class SoftSitcherPriv::CbGeoMap;
     friend class SoftSitcherPriv::CbBlender;
     friend class SoftSitcherPriv::CbCopyTask;
+    friend class SoftSitcherPriv::CbTableTask;
+    friend class SoftSitcherPriv::CbTileTask;
 
 public:
     struct StitcherParam
         : ImageHandler::Parameters
     {
         uint32_t in_buf_num;
-        SmartPtr<VideoBuffer> in_bufs[XCAM_STITCH_MAX_CAMERAS];
+        std::vector<SmartPtr<VideoBuffer> > in_bufs;
 
         StitcherParam ()
             : Parameters (NULL, NULL)
@@ -56,10 +60,68 @@ public:
         {}
     };
 
+    struct OverlapBlendInfo {
+        uint32_t pyr_levels;
+        uint32_t blend_width;
+        // pixels of both inputs over all pyramid levels, luma and chroma
+        uint64_t cost;
+
+        OverlapBlendInfo ()
+            : pyr_levels (0)
+            , blend_width (0)
+            , cost (0)
+        {}
+    };
+
 public:
     explicit SoftStitcher (const char *name = "SoftStitcher");
     ~SoftStitcher ();
 
+    // select before the first stitch_buffers, fused tiles engine only supports ScaleSingleConst
+    bool set_stitch_engine (StitchEngine engine);
+    StitchEngine get_stitch_engine () const {
+        return _engine;
+    }
+
+    // fused tiles engine only, select before the first stitch_buffers.
+    // a tile is re-rendered only if its input blocks changed, otherwise it is copied from last output,
+    // threshold is mean absolute difference per byte of a changed block, 0 means any change
+    bool set_static_scene (bool enable, uint32_t threshold = 0);
+    bool get_static_scene () const {
+        return _static_scene;
+    }
+    uint32_t get_static_threshold () const {
+        return _static_threshold;
+    }
+    // skipped tiles ratio of all frames in static scene
+    float get_tile_skip_ratio () const;
+
+    // pyramid depth and blend width of each overlap are chosen from its size and content of the first frame,
+    // otherwise all overlaps use XCAM_SOFT_PYRAMID_DEFAULT_LEVEL and half of merge width, select before the first stitch_buffers
+    bool set_adaptive_blend (bool enable);
+    bool get_adaptive_blend () const {
+        return _adaptive_blend;
+    }
+    // valid after the first blend of overlap(idx)
+    bool get_overlap_blend_info (uint32_t idx, OverlapBlendInfo &info) const;
+
+    // preview is the output scaled down by 2^level, level is in [1, XCAM_SOFT_PYRAMID_DEFAULT_LEVEL],
+    // 0 disables, select before the first stitch_buffers
+    bool set_preview_level (uint32_t level);
+    uint32_t get_preview_level () const {
+        return _preview_level;
+    }
+    // preview of out_buf from last stitch_buffers, rendered in caller's thread,
+    // overlaps are taken from blender pyramid levels, only copy areas are scaled down
+    XCamReturn render_preview (const SmartPtr<VideoBuffer> &out_buf, SmartPtr<VideoBuffer> &preview);
+
+    // interface derive from Stitcher
+    virtual XCamReturn update_geo_tables ();
+    // rendered in caller's thread, independent of stitch_buffers
+    virtual XCamReturn render_viewport (
+        const ViewportPose &pose, uint32_t width, uint32_t height,
+        const VideoBufferList &in_bufs, SmartPtr<VideoBuffer> &out_buf);
+
     //derived from SoftHandler
     virtual XCamReturn terminate ();
 
@@ -84,9 +146,20 @@ private:
     void copy_task_done (
         const SmartPtr<Worker> &worker,
         const SmartPtr<Worker::Arguments> &base, const XCamReturn error);
+    void table_task_done (
+        const SmartPtr<Worker> &worker,
+        const SmartPtr<Worker::Arguments> &base, const XCamReturn error);
+    void tile_task_done (
+        const SmartPtr<Worker> &worker,
+        const SmartPtr<Worker::Arguments> &base, const XCamReturn error);
 
 private:
     SmartPtr<SoftSitcherPriv::StitcherImpl> _impl;
+    StitchEngine                            _engine;
+    bool                                    _static_scene;
+    uint32_t                                _static_threshold;
+    uint32_t                                _preview_level;
+    bool                                    _adaptive_blend;
 };
 
 }
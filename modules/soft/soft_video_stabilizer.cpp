@@ -0,0 +1,213 @@
+/*
+ * soft_video_stabilizer.cpp - soft digital video stabilization using IMU
+ *
+ *  Copyright (c) 2017 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#include "soft_video_stabilizer.h"
+
+#define XCAM_SOFT_STAB_DEFAULT_RADIUS 15
+#define XCAM_SOFT_STAB_DEFAULT_STDEV 10.0f
+
+namespace XCam {
+
+SoftVideoStabilizer::SoftVideoStabilizer (const char *name)
+    : SoftImageWarpHandler (name)
+    , _input_frame_id (-1)
+    , _filter_radius (XCAM_SOFT_STAB_DEFAULT_RADIUS)
+{
+    _projector = new ImageProjector ();
+    _motion_filter = new MotionFilter (_filter_radius, XCAM_SOFT_STAB_DEFAULT_STDEV);
+
+    CoordinateSystemConv world_to_device (AXIS_X, AXIS_MINUS_Z, AXIS_NONE);
+    CoordinateSystemConv device_to_image (AXIS_X, AXIS_Y, AXIS_Y);
+    align_coordinate_system (world_to_device, device_to_image);
+
+    xcam_mem_clear (_frame_ts);
+}
+
+SoftVideoStabilizer::~SoftVideoStabilizer ()
+{
+    _input_buf_list.clear ();
+}
+
+void
+SoftVideoStabilizer::reset_counter ()
+{
+    XCAM_LOG_DEBUG ("SoftVideoStabilizer(%s) reset counter", XCAM_STR (get_name ()));
+
+    _input_frame_id = -1;
+    xcam_mem_clear (_frame_ts);
+    _device_pose[0].clear ();
+    _device_pose[1].clear ();
+    _motions.clear ();
+    _input_buf_list.clear ();
+}
+
+XCamReturn
+SoftVideoStabilizer::set_sensor_calibration (CalibrationParams &params)
+{
+    XCAM_ASSERT (_projector.ptr ());
+    return _projector->set_sensor_calibration (params);
+}
+
+XCamReturn
+SoftVideoStabilizer::set_camera_intrinsics (
+    double focal_x,
+    double focal_y,
+    double offset_x,
+    double offset_y,
+    double skew)
+{
+    XCAM_ASSERT (_projector.ptr ());
+    return _projector->set_camera_intrinsics (focal_x, focal_y, offset_x, offset_y, skew);
+}
+
+XCamReturn
+SoftVideoStabilizer::align_coordinate_system (
+    CoordinateSystemConv &world_to_device,
+    CoordinateSystemConv &device_to_image)
+{
+    _world_to_device = world_to_device;
+    _device_to_image = device_to_image;
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+SoftVideoStabilizer::set_motion_filter (uint32_t radius, float stdev)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, radius > 0, XCAM_RETURN_ERROR_PARAM,
+        "SoftVideoStabilizer(%s) filter radius should be positive", XCAM_STR (get_name ()));
+
+    XCAM_ASSERT (_motion_filter.ptr ());
+    _filter_radius = radius;
+    _motion_filter->set_filters (radius, stdev);
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+SoftVideoStabilizer::stabilize (
+    const SmartPtr<VideoBuffer> &in,
+    SmartPtr<VideoBuffer> &out_buf)
+{
+    return warp (in, out_buf);
+}
+
+Mat3d
+SoftVideoStabilizer::analyze_motion (
+    int64_t frame0_ts,
+    DevicePoseList &pose0_list,
+    int64_t frame1_ts,
+    DevicePoseList &pose1_list)
+{
+    if (pose0_list.empty () || pose1_list.empty ()) {
+        return Mat3d ();
+    }
+    XCAM_ASSERT (frame0_ts < frame1_ts);
+
+    Mat3d ext0 = _projector->calc_camera_extrinsics (frame0_ts, pose0_list);
+    Mat3d ext1 = _projector->calc_camera_extrinsics (frame1_ts, pose1_list);
+
+    Mat3d extrinsic0 = _projector->align_coordinate_system (_world_to_device, ext0, _device_to_image);
+    Mat3d extrinsic1 = _projector->align_coordinate_system (_world_to_device, ext1, _device_to_image);
+
+    return _projector->calc_projective (extrinsic0, extrinsic1);
+}
+
+XCamReturn
+SoftVideoStabilizer::start_work (const SmartPtr<ImageHandler::Parameters> &param)
+{
+    XCAM_ASSERT (param->in_buf.ptr ());
+    SmartPtr<VideoBuffer> input = param->in_buf;
+
+    _input_buf_list.push_back (input);
+    _input_frame_id++;
+
+    uint32_t cur = _input_frame_id % 2, prev = (_input_frame_id + 1) % 2;
+    _frame_ts[cur] = input->get_timestamp ();
+
+    SmartPtr<DevicePose> data = input->find_typed_metadata<DevicePose> ();
+    while (data.ptr ()) {
+        _device_pose[cur].push_back (data);
+        input->remove_metadata (data);
+        data = input->find_typed_metadata<DevicePose> ();
+    }
+
+    if (_input_frame_id > 0) {
+        Mat3d homography = analyze_motion (
+                               _frame_ts[prev], _device_pose[prev], _frame_ts[cur], _device_pose[cur]);
+
+        if (_motions.size () >= 2 * _filter_radius + 1) {
+            _motions.pop_front ();
+        }
+        _motions.push_back (homography);
+        _device_pose[prev].clear ();
+    }
+
+    if (_input_frame_id < (int64_t)_filter_radius) {
+        // no output until the filter window is half filled
+        work_well_done (param, XCAM_RETURN_BYPASS);
+        return XCAM_RETURN_NO_ERROR;
+    }
+
+    int64_t stab_frame_id = _input_frame_id - _filter_radius;
+    int32_t stab_pos = XCAM_MIN (stab_frame_id, (int64_t)_filter_radius + 1);
+    XCAM_LOG_DEBUG (
+        "SoftVideoStabilizer input id(%" PRId64 "), stab id(%" PRId64 "), stab pos(%d), filter radius(%d)",
+        _input_frame_id, stab_frame_id, stab_pos, _filter_radius);
+
+    Mat3d proj_mat = _motion_filter->stabilize (stab_pos, _motions, _input_frame_id);
+    Mat3d proj_inv_mat = proj_mat.inverse ();
+
+    const VideoBufferInfo &in_info = input->get_video_info ();
+    XCamDVSResult warp_config;
+    xcam_mem_clear (warp_config);
+    warp_config.frame_id = stab_frame_id;
+    warp_config.frame_width = in_info.width;
+    warp_config.frame_height = in_info.height;
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) {
+            warp_config.proj_mat[i * 3 + j] = proj_inv_mat (i, j);
+        }
+    }
+    set_warp_config (warp_config);
+
+    // warp the delayed frame, buffers after it stay in the filter window
+    param->in_buf = _input_buf_list.front ();
+    _input_buf_list.pop_front ();
+
+    return SoftImageWarpHandler::start_work (param);
+}
+
+XCamReturn
+SoftVideoStabilizer::terminate ()
+{
+    reset_counter ();
+    return SoftImageWarpHandler::terminate ();
+}
+
+SmartPtr<SoftHandler>
+create_soft_video_stabilizer ()
+{
+    SmartPtr<SoftVideoStabilizer> stabilizer = new SoftVideoStabilizer ();
+    XCAM_ASSERT (stabilizer.ptr ());
+
+    return stabilizer;
+}
+
+}
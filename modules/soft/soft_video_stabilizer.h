@@ -0,0 +1,102 @@
+/*
+ * soft_video_stabilizer.h - soft digital video stabilization using IMU
+ *
+ *  Copyright (c) 2017 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#ifndef XCAM_SOFT_VIDEO_STABILIZER_H
+#define XCAM_SOFT_VIDEO_STABILIZER_H
+
+#include <xcam_std.h>
+#include <meta_data.h>
+#include <vec_mat.h>
+#include <image_projector.h>
+#include <soft/soft_image_warp_handler.h>
+
+namespace XCam {
+
+/* CPU counterpart of CLVideoStabilizer.
+ * DevicePose metadata of each input buffer is analyzed by ImageProjector, motions are smoothed
+ * by MotionFilter and the frame filter_radius behind the input is warped.
+ * the first filter_radius frames return XCAM_RETURN_BYPASS without output,
+ * upstream buffer pool needs at least filter_radius + 1 more buffers than usual.
+ */
+class SoftVideoStabilizer
+    : public SoftImageWarpHandler
+{
+    typedef std::list<SmartPtr<VideoBuffer>> VideoBufferList;
+
+public:
+    SoftVideoStabilizer (const char *name = "SoftVideoStabilizer");
+    ~SoftVideoStabilizer ();
+
+    void reset_counter ();
+
+    XCamReturn set_sensor_calibration (CalibrationParams &params);
+    XCamReturn set_camera_intrinsics (
+        double focal_x,
+        double focal_y,
+        double offset_x,
+        double offset_y,
+        double skew);
+
+    XCamReturn align_coordinate_system (
+        CoordinateSystemConv &world_to_device,
+        CoordinateSystemConv &device_to_image);
+
+    XCamReturn set_motion_filter (uint32_t radius, float stdev);
+    uint32_t filter_radius () const {
+        return _filter_radius;
+    };
+
+    XCamReturn stabilize (
+        const SmartPtr<VideoBuffer> &in,
+        SmartPtr<VideoBuffer> &out_buf);
+
+    //derived from SoftImageWarpHandler
+    virtual XCamReturn terminate ();
+
+protected:
+    //derived from SoftImageWarpHandler
+    XCamReturn start_work (const SmartPtr<Parameters> &param);
+
+private:
+    Mat3d analyze_motion (
+        int64_t frame0_ts,
+        DevicePoseList &pose0_list,
+        int64_t frame1_ts,
+        DevicePoseList &pose1_list);
+
+    XCAM_DEAD_COPY (SoftVideoStabilizer);
+
+private:
+    SmartPtr<ImageProjector> _projector;
+    SmartPtr<MotionFilter>   _motion_filter;
+    CoordinateSystemConv     _world_to_device;
+    CoordinateSystemConv     _device_to_image;
+    int64_t                  _input_frame_id;
+    int64_t                  _frame_ts[2];
+    DevicePoseList           _device_pose[2];
+    std::list<Mat3d>         _motions; //motions[i] calculated from frame i to i+1
+    uint32_t                 _filter_radius;
+    VideoBufferList          _input_buf_list;
+};
+
+extern SmartPtr<SoftHandler> create_soft_video_stabilizer ();
+
+}
+#endif //XCAM_SOFT_VIDEO_STABILIZER_H
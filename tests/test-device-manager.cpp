@@ -46,6 +46,7 @@
 #include "drm_display.h"
 #endif
 #include "fake_poll_thread.h"
+#include "multi_poll_thread.h"
 #include "image_file_handle.h"
 #include <base/xcam_3a_types.h>
 #include <unistd.h>
@@ -143,7 +144,12 @@ private:
 void
 MainDeviceManager::handle_message (const SmartPtr<XCamMessage> &msg)
 {
-    XCAM_UNUSED (msg);
+    // finite fake source replay is done
+    if (msg->msg_id == XCAM_MESSAGE_SOURCE_DONE) {
+        SmartLock locker (g_mutex);
+        g_stop = true;
+        g_cond.broadcast ();
+    }
 }
 
 void
@@ -228,6 +234,274 @@ MainDeviceManager::open_file ()
     }
 }
 
+/* stand-in of a streaming camera, buffers are host memory and a pipe carries frame ready events,
+ * so it is polled and dequeued like a real device
+ */
+class FakeStreamDevice
+    : public FakeV4l2Device
+{
+public:
+    FakeStreamDevice ()
+        : _ready_fd (-1)
+        , _sequence (0)
+        , _device_dropped (0)
+    {}
+    ~FakeStreamDevice () {
+        if (_ready_fd >= 0)
+            ::close (_ready_fd);
+    }
+
+    XCamReturn open_stream () {
+        int fds[2];
+        XCamReturn ret = open ();
+        if (ret != XCAM_RETURN_NO_ERROR || pipe (fds) < 0)
+            return XCAM_RETURN_ERROR_FILE;
+        ::close (_fd);
+        _fd = fds[0];
+        _ready_fd = fds[1];
+        return XCAM_RETURN_NO_ERROR;
+    }
+
+    // frame captured at timestamp, dropped by device if no buffer was queued
+    void capture_frame (int64_t timestamp) {
+        SmartLock locker (_mutex);
+        if (_queued.empty ()) {
+            ++_device_dropped;
+            return;
+        }
+        struct v4l2_buffer buf;
+        xcam_mem_clear (buf);
+        buf.index = _queued.front ();
+        buf.timestamp.tv_sec = timestamp / 1000000;
+        buf.timestamp.tv_usec = timestamp % 1000000;
+        buf.sequence = _sequence++;
+        _queued.pop_front ();
+        _done.push_back (buf);
+        _delivered.push_back (timestamp);
+
+        char event = 1;
+        if (write (_ready_fd, &event, 1) != 1)
+            XCAM_LOG_WARNING ("fake stream device signal frame failed");
+    }
+
+    uint32_t get_device_dropped () {
+        SmartLock locker (_mutex);
+        return _device_dropped;
+    }
+    // timestamps of frames captured into buffers
+    std::vector<int64_t> get_delivered () {
+        SmartLock locker (_mutex);
+        return _delivered;
+    }
+
+    int io_control (int cmd, void *arg) {
+        SmartLock locker (_mutex);
+        switch ((uint32_t)cmd) {
+        case VIDIOC_QBUF:
+            _queued.push_back (((struct v4l2_buffer *)arg)->index);
+            break;
+        case VIDIOC_DQBUF: {
+            char event;
+            if (_done.empty () || read (_fd, &event, 1) != 1)
+                return -1;
+            struct v4l2_buffer *buf = (struct v4l2_buffer *)arg;
+            *buf = _done.front ();
+            _done.pop_front ();
+            break;
+        }
+        case VIDIOC_STREAMOFF:
+            _queued.clear ();
+            break;
+        default:
+            return FakeV4l2Device::io_control (cmd, arg);
+        }
+        return 0;
+    }
+
+protected:
+    virtual XCamReturn allocate_buffer (
+        SmartPtr<V4l2Buffer> &buf, const struct v4l2_format &format, const uint32_t index) {
+        struct v4l2_buffer v4l2_buf;
+        xcam_mem_clear (v4l2_buf);
+        v4l2_buf.index = index;
+        v4l2_buf.type = _capture_buf_type;
+        v4l2_buf.memory = V4L2_MEMORY_MMAP;
+        v4l2_buf.length = format.fmt.pix.bytesperline * format.fmt.pix.height;
+
+        if (_memory.size () <= index)
+            _memory.resize (index + 1);
+        _memory[index].resize (v4l2_buf.length);
+        v4l2_buf.m.userptr = (uintptr_t) _memory[index].data ();
+        buf = new V4l2Buffer (v4l2_buf, format);
+        return XCAM_RETURN_NO_ERROR;
+    }
+
+private:
+    int                                  _ready_fd;
+    uint32_t                             _sequence;
+    uint32_t                             _device_dropped;
+    std::list<uint32_t>                  _queued;
+    std::list<struct v4l2_buffer>        _done;
+    std::vector<int64_t>                 _delivered;
+    std::vector<std::vector<uint8_t>>    _memory;
+    Mutex                                _mutex;
+};
+
+// cameras of a rig capture every frame period with small skews, the last camera loses every 5th frame
+class FakeRigProducer
+    : public Thread
+{
+public:
+    static const int64_t frame_duration = 33333; // us
+    static const int64_t camera_skew = 1000; // us
+    static const uint32_t lost_interval = 5;
+
+    FakeRigProducer (std::vector<SmartPtr<FakeStreamDevice>> &devices, uint32_t frame_count)
+        : Thread ("fake_rig_producer")
+        , _devices (devices)
+        , _frame_count (frame_count)
+        , _frame_idx (0)
+    {}
+
+protected:
+    virtual bool loop () {
+        if (_frame_idx >= _frame_count)
+            return false;
+
+        for (uint32_t i = 0; i < _devices.size (); ++i) {
+            if (i == _devices.size () - 1 && _frame_idx % lost_interval == lost_interval - 1)
+                continue;
+            _devices[i]->capture_frame (_frame_idx * frame_duration + i * camera_skew);
+        }
+        ++_frame_idx;
+        ::usleep (2000);
+        return true;
+    }
+
+private:
+    std::vector<SmartPtr<FakeStreamDevice>>   _devices;
+    uint32_t                                  _frame_count;
+    uint32_t                                  _frame_idx;
+};
+
+class FrameSetChecker
+    : public FrameSetCallback
+{
+public:
+    FrameSetChecker (uint32_t device_count, int64_t tolerance)
+        : _device_count (device_count)
+        , _tolerance (tolerance)
+        , _last_frame (-1)
+        , _sets (0)
+        , _errors (0)
+    {}
+
+    XCamReturn frame_set_ready (VideoBufferList &bufs) {
+        int64_t oldest = bufs.front ()->get_timestamp ();
+        int64_t newest = oldest;
+        for (VideoBufferList::iterator i = bufs.begin (); i != bufs.end (); ++i) {
+            oldest = XCAM_MIN (oldest, (*i)->get_timestamp ());
+            newest = XCAM_MAX (newest, (*i)->get_timestamp ());
+        }
+        int64_t frame = oldest / FakeRigProducer::frame_duration;
+
+        if (bufs.size () != _device_count || newest - oldest > _tolerance || frame <= _last_frame) {
+            XCAM_LOG_ERROR (
+                "frame set(buffers:%d, ts:%" PRId64 "-%" PRId64 ") is not aligned",
+                (int)bufs.size (), oldest, newest);
+            ++_errors;
+        }
+        _last_frame = frame;
+        ++_sets;
+        return XCAM_RETURN_NO_ERROR;
+    }
+    XCamReturn frame_set_failed (int64_t timestamp, const char *msg) {
+        XCAM_UNUSED (timestamp);
+        XCAM_LOG_ERROR ("frame set failed: %s", XCAM_STR (msg));
+        ++_errors;
+        return XCAM_RETURN_NO_ERROR;
+    }
+
+    uint32_t get_sets () const {
+        return _sets;
+    }
+    uint32_t get_errors () const {
+        return _errors;
+    }
+
+private:
+    uint32_t   _device_count;
+    int64_t    _tolerance;
+    int64_t    _last_frame;
+    uint32_t   _sets;
+    uint32_t   _errors;
+};
+
+static int
+run_fake_rig (uint32_t camera_count, uint32_t frame_count)
+{
+    const uint32_t buffer_count = 4;
+    const int64_t tolerance = FakeRigProducer::camera_skew * camera_count;
+    std::vector<SmartPtr<FakeStreamDevice>> devices;
+    SmartPtr<MultiPollThread> poll_thread = new MultiPollThread ();
+    FrameSetChecker checker (camera_count, tolerance);
+    XCamReturn ret = XCAM_RETURN_NO_ERROR;
+
+    for (uint32_t i = 0; i < camera_count; ++i) {
+        SmartPtr<FakeStreamDevice> device = new FakeStreamDevice ();
+        device->set_buffer_count (buffer_count);
+        ret = device->open_stream ();
+        CHECK (ret, "fake stream device(%d) open failed", i);
+        ret = device->set_format (640, 480, V4L2_PIX_FMT_NV12, V4L2_FIELD_NONE, 640 * 3 / 2);
+        CHECK (ret, "fake stream device(%d) set format failed", i);
+        ret = device->start ();
+        CHECK (ret, "fake stream device(%d) start failed", i);
+        devices.push_back (device);
+        poll_thread->add_capture_device (device);
+    }
+    poll_thread->set_frame_set_callback (&checker);
+    poll_thread->set_sync_tolerance (tolerance);
+    // device buffers bound pending frames, so aligner never drops a frame all cameras delivered
+    poll_thread->set_max_pending (buffer_count);
+
+    ret = poll_thread->start ();
+    CHECK (ret, "multi poll thread start failed");
+
+    SmartPtr<FakeRigProducer> producer = new FakeRigProducer (devices, frame_count);
+    producer->start ();
+    while (producer->is_running ())
+        ::usleep (10000);
+    ::usleep (100000);
+
+    poll_thread->stop ();
+    // a frame makes a set only if every camera delivered it
+    uint32_t device_dropped = 0;
+    std::vector<uint32_t> frame_cameras (frame_count, 0);
+    for (uint32_t i = 0; i < camera_count; ++i) {
+        device_dropped += devices[i]->get_device_dropped ();
+        std::vector<int64_t> delivered = devices[i]->get_delivered ();
+        for (uint32_t j = 0; j < delivered.size (); ++j)
+            ++frame_cameras[delivered[j] / FakeRigProducer::frame_duration];
+        devices[i]->stop ();
+        devices[i]->close ();
+    }
+
+    uint32_t expected = 0;
+    for (uint32_t i = 0; i < frame_count; ++i) {
+        if (frame_cameras[i] == camera_count)
+            ++expected;
+    }
+    printf ("cameras:%d frame sets:%d(expected:%d) dropped:%d, device dropped:%d\n",
+            camera_count, checker.get_sets (), expected,
+            (int)poll_thread->get_dropped_count (), device_dropped);
+
+    CHECK_EXP (checker.get_errors () == 0, "fake rig got %d unaligned frame sets", checker.get_errors ());
+    CHECK_EXP (
+        checker.get_sets () == expected,
+        "fake rig frame sets(%d) don't match expected(%d)", checker.get_sets (), expected);
+    return 0;
+}
+
 #define V4L2_CAPTURE_MODE_STILL   0x2000
 #define V4L2_CAPTURE_MODE_VIDEO   0x4000
 #define V4L2_CAPTURE_MODE_PREVIEW 0x8000
@@ -273,7 +547,8 @@ void print_help (const char *bin_name)
             "\t -H image_height specify image height, default is [1080]\n"
             "\t -d cap_mode     specify capture mode\n"
             "\t                 cap_mode select from [video, still], default is [video]\n"
-            "\t -i frame_save   specify the frame count to save, default is 0 which means endless\n"
+            "\t -i frame_save   specify the frame count to save, default is 0 which means endless,\n"
+            "\t                 the test exits after a finite replay\n"
             "\t -p preview on   enable local display, need root privilege\n"
             "\t --usb           specify node for usb camera device, enables capture path through USB camera \n"
             "\t                 specify [/dev/video4, /dev/video5] depending on which node USB camera is attached\n"
@@ -281,6 +556,10 @@ void print_help (const char *bin_name)
             "\t                 select from [primary, overlay], default is [primary]\n"
             "\t --sync          set analyzer in sync mode\n"
             "\t -r raw_input    specify the path of raw image as fake source instead of live camera\n"
+            "\t --fake-fps      specify frame rate of fake source, default is 0 which means as fast as possible\n"
+            "\t --fake-loop     specify loop count of fake source, default is 0 which means endless,\n"
+            "\t                 the test exits after a finite replay\n"
+            "\t --fake-rig      specify camera count of a fake rig, checks frame sets of multi poll thread and exits\n"
             "\t -h              help\n"
 #if HAVE_LIBCL
             "CL features:\n"
@@ -367,6 +646,9 @@ int main (int argc, char *argv[])
     uint32_t frame_width = 1920;
     uint32_t frame_height = 1080;
     std::string path_to_fake;
+    double fake_fps = 0.0;
+    uint32_t fake_loop = 0;
+    uint32_t fake_rig_cameras = 0;
 
     int opt;
     const char *short_opts = "sca:n:m:f:W:H:d:b:pi:e:r:h";
@@ -385,6 +667,9 @@ int main (int argc, char *argv[])
         {"capture", required_argument, NULL, 'C'},
         {"pipeline", required_argument, NULL, 'P'},
         {"disable-post", no_argument, NULL, 'O'},
+        {"fake-fps", required_argument, NULL, 'R'},
+        {"fake-loop", required_argument, NULL, 'l'},
+        {"fake-rig", required_argument, NULL, 'M'},
         {0, 0, 0, 0},
     };
 
@@ -635,6 +920,21 @@ int main (int argc, char *argv[])
             path_to_fake = optarg;
             break;
         }
+        case 'R': {
+            XCAM_ASSERT (optarg);
+            fake_fps = atof (optarg);
+            break;
+        }
+        case 'l': {
+            XCAM_ASSERT (optarg);
+            fake_loop = atoi (optarg);
+            break;
+        }
+        case 'M': {
+            XCAM_ASSERT (optarg);
+            fake_rig_cameras = atoi (optarg);
+            break;
+        }
         case 'p': {
 #if HAVE_LIBDRM
             need_display = true;
@@ -654,6 +954,9 @@ int main (int argc, char *argv[])
         }
     }
 
+    if (fake_rig_cameras)
+        return run_fake_rig (fake_rig_cameras, 100);
+
     SmartPtr<MainDeviceManager> device_manager = new MainDeviceManager ();
     device_manager->enable_save_file (save_file);
     device_manager->set_interval (interval_frames);
@@ -878,7 +1181,10 @@ int main (int argc, char *argv[])
     if (have_usbcam) {
         poll_thread = new PollThread ();
     } else if (path_to_fake.c_str ()) {
-        poll_thread = new FakePollThread (path_to_fake.c_str ());
+        SmartPtr<FakePollThread> fake_poll_thread = new FakePollThread (path_to_fake.c_str ());
+        fake_poll_thread->set_frame_rate (fake_fps);
+        fake_poll_thread->set_loop_count (fake_loop);
+        poll_thread = fake_poll_thread;
     }
 #if HAVE_IA_AIQ
     else {
@@ -903,7 +1209,7 @@ int main (int argc, char *argv[])
     }
 #endif
 
-    // wait for interruption
+    // wait for interruption or end of fake source
     {
         SmartLock locker (g_mutex);
         while (!g_stop)
@@ -912,6 +1218,12 @@ int main (int argc, char *argv[])
 
     ret = device_manager->stop();
     CHECK_CONTINUE (ret, "device manager stop failed");
+
+    DeviceFrameStats frame_stats;
+    device_manager->get_frame_stats (frame_stats);
+    printf ("frames captured:%d dropped:%d processed:%d, latency avg:%.2fms max:%.2fms\n",
+            frame_stats.captured_count, frame_stats.dropped_count, frame_stats.processed_count,
+            frame_stats.avg_latency / 1000.0, frame_stats.max_latency / 1000.0);
     device->close ();
 #if HAVE_IA_AIQ
     event_device->close ();
@@ -153,6 +153,8 @@ void usage(const char* arg0)
             "\t--save-free-view    optional, save rectified(free) view videos. default: no\n"
             "\t--framerate         optional, framerate of saved video, default: 30.0\n"
             "\t--loop              optional, how many loops need to run for performance test, default: 1\n"
+            "\t--async-write       optional, save output as NV12 in a writer thread with a queue of N buffers\n"
+            "\t                    instead of video, default: 0(disabled)\n"
             "\t--help              usage\n",
             arg0);
 }
@@ -200,6 +202,7 @@ int main (int argc, char *argv[])
     bool save_top_view = false;
     bool save_free_view = false;
     double framerate = 30.0;
+    uint32_t write_queue_depth = 0;
 
     const char *file_in_name[XCAM_STITCH_FISHEYE_MAX_NUM] = {NULL};
     const char *file_out_name = NULL;
@@ -231,6 +234,7 @@ int main (int argc, char *argv[])
         {"save-free-view", no_argument, NULL, 'v'},
         {"framerate", required_argument, NULL, 'f'},
         {"loop", required_argument, NULL, 'l'},
+        {"async-write", required_argument, NULL, 'a'},
         {"help", no_argument, NULL, 'e'},
         {NULL, 0, NULL, 0},
     };
@@ -330,6 +334,9 @@ int main (int argc, char *argv[])
         case 'l':
             loop = atoi(optarg);
             break;
+        case 'a':
+            write_queue_depth = atoi (optarg);
+            break;
         case 'e':
             usage (argv[0]);
             return -1;
@@ -372,7 +379,7 @@ int main (int argc, char *argv[])
     // }
 
 #if !HAVE_OPENCV
-    if (need_save_output) {
+    if (need_save_output && !write_queue_depth) {
         XCAM_LOG_WARNING ("non-OpenCV mode, can't save video to file:%s", XCAM_STR (file_out_name));
         need_save_output = false;
     }
@@ -408,6 +415,7 @@ int main (int argc, char *argv[])
     printf ("save free-view file:\t%s\n", save_free_view ? rectified_view_filename : "NO");
     printf ("framerate:\t\t%.3lf\n", framerate);
     printf ("loop count:\t\t%d\n", loop);
+    printf ("async write:\t\t%d\n", write_queue_depth);
     printf ("-----------------------------------\n");
 
     context = CLDevice::instance ()->get_context ();
@@ -473,11 +481,18 @@ int main (int argc, char *argv[])
         CHECK (ret, "open %s failed", file_in_name[i]);
     }
 
+    if (need_save_output && write_queue_depth) {
+        ret = file_out.open (file_out_name, "wb");
+        CHECK (ret, "open %s failed", file_out_name);
+        ret = file_out.start_async_write (write_queue_depth);
+        CHECK (ret, "start async write of %s failed", file_out_name);
+    }
+
 #if HAVE_OPENCV
     cv::VideoWriter writer;
     cv::VideoWriter top_view_writer;
     cv::VideoWriter rectified_view_writer;
-    if (need_save_output) {
+    if (need_save_output && !write_queue_depth) {
         cv::Size dst_size = cv::Size (output_width, output_height);
         if (!writer.open (file_out_name, CV_FOURCC('X', '2', '6', '4'), framerate, dst_size)) {
             XCAM_LOG_ERROR ("open file %s failed", file_out_name);
@@ -545,7 +560,7 @@ int main (int argc, char *argv[])
             CHECK (ret, "image_360 stitch execute failed");
 
 #if HAVE_OPENCV
-            if (need_save_output) {
+            if (need_save_output && !write_queue_depth) {
                 cv::Mat out_mat;
                 convert_to_mat (output_buf, out_mat);
                 writer.write (out_mat);
@@ -575,11 +590,23 @@ int main (int argc, char *argv[])
 #endif
                 ensure_gpu_buffer_done (output_buf);
 
+            if (need_save_output && write_queue_depth) {
+                ret = file_out.write_buf (output_buf);
+                CHECK (ret, "write output to %s failed", file_out_name);
+                // queued buffer is saved later, stitcher allocates a new output buffer for next frame
+                output_buf.release ();
+            }
+
             frame_id++;
             FPS_CALCULATION (image_stitching, XCAM_OBJ_DUR_FRAME_NUM);
         } while (true);
     }
 
+    if (need_save_output && write_queue_depth) {
+        printf ("write stalls:\t\t%d\n", file_out.get_write_stalls ());
+        CHECK (file_out.close (), "save file(%s) failed", file_out_name);
+    }
+
     return 0;
 }
 
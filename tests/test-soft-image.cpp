@@ -23,7 +23,15 @@
 #include <buffer_pool.h>
 #include <image_handler.h>
 #include <image_file_handle.h>
+#include <raw_container_file.h>
 #include <soft/soft_video_buf_allocator.h>
+#include <soft/soft_csc_handler.h>
+#include <soft/soft_bayer_pipe_handler.h>
+#include <soft/soft_3d_denoise_handler.h>
+#include <soft/soft_image_warp_handler.h>
+#include <soft/soft_video_stabilizer.h>
+#include <soft/soft_3a_stats_handler.h>
+#include <soft/soft_stitcher.h>
 #include <interface/blender.h>
 #include <interface/geo_mapper.h>
 #include <interface/stitcher.h>
@@ -45,6 +53,10 @@
 
 #define XCAM_TEST_MAX_STR_SIZE 1024
 
+#define STAB_FILTER_RADIUS 4
+#define STAB_FILTER_STDEV 2.0f
+#define STAB_FRAME_DURATION 33333 // us
+
 #define MAP_WIDTH 3
 #define MAP_HEIGHT 4
 
@@ -62,6 +74,13 @@ enum SoftType {
     SoftTypeBlender,
     SoftTypeRemap,
     SoftTypeStitch,
+    SoftTypeCsc,
+    SoftTypeBayerPipe,
+    SoftTypeDenoise3D,
+    SoftTypeWarp,
+    SoftTypeStabilize,
+    SoftType3aStats,
+    SoftTypePack,
 };
 
 #define RUN_N(statement, loop, msg, ...) \
@@ -102,6 +121,12 @@ public:
         return _buf;
     }
 
+    // reads images of camera from a shared container instead of own file
+    void set_container (const SmartPtr<RawContainerFile> &container, uint32_t camera) {
+        _container = container;
+        _camera = camera;
+    }
+
     void set_mapper (SmartPtr<GeoMapper> mapper) {
         _mapper = mapper;
     }
@@ -110,6 +135,11 @@ public:
     }
 
     XCamReturn open_file (const char *option);
+    XCamReturn map_file ();
+    XCamReturn start_async_write (uint32_t queue_depth);
+    uint32_t get_write_stalls () const {
+        return _file.get_write_stalls ();
+    }
     XCamReturn close_file ();
     XCamReturn rewind_file ();
 
@@ -133,6 +163,9 @@ private:
     SmartPtr<VideoBuffer> _buf;
 
     ImageFileHandle       _file;
+    SmartPtr<RawContainerFile> _container;
+    uint32_t              _camera;
+    uint32_t              _frame_idx;
     SmartPtr<BufferPool>  _pool;
     SmartPtr<GeoMapper>   _mapper;
 #if XCAM_TEST_OPENCV
@@ -146,6 +179,8 @@ SoftElement::SoftElement (const char *file_name, uint32_t width, uint32_t height
     : _file_name (NULL)
     , _width (width)
     , _height (height)
+    , _camera (0)
+    , _frame_idx (0)
 {
     if (file_name)
         _file_name = strndup (file_name, XCAM_TEST_MAX_STR_SIZE);
@@ -171,6 +206,9 @@ SoftElement::set_buf_size (uint32_t width, uint32_t height)
 XCamReturn
 SoftElement::open_file (const char *option)
 {
+    if (_container.ptr ())
+        return XCAM_RETURN_NO_ERROR;
+
     if (_file.open (_file_name, option) != XCAM_RETURN_NO_ERROR) {
         XCAM_LOG_ERROR ("open %s failed.", _file_name);
         return XCAM_RETURN_ERROR_FILE;
@@ -179,6 +217,22 @@ SoftElement::open_file (const char *option)
     return XCAM_RETURN_NO_ERROR;
 }
 
+XCamReturn
+SoftElement::map_file ()
+{
+    // container is always mapped
+    if (_container.ptr ())
+        return XCAM_RETURN_NO_ERROR;
+
+    return _file.map_file ();
+}
+
+XCamReturn
+SoftElement::start_async_write (uint32_t queue_depth)
+{
+    return _file.start_async_write (queue_depth);
+}
+
 XCamReturn
 SoftElement::close_file ()
 {
@@ -188,6 +242,11 @@ SoftElement::close_file ()
 XCamReturn
 SoftElement::rewind_file ()
 {
+    if (_container.ptr ()) {
+        _frame_idx = 0;
+        return XCAM_RETURN_NO_ERROR;
+    }
+
     return _file.rewind ();
 }
 
@@ -210,6 +269,14 @@ SoftElement::create_buf_pool (const VideoBufferInfo &info, uint32_t count)
 XCamReturn
 SoftElement::read_buf ()
 {
+    if (_container.ptr ())
+        return _container->read_frame (_frame_idx++, _camera, _buf);
+
+    // mapped input buffers alias file pages, nothing to copy;
+    // padded layouts are copied row by row from the mapped file below
+    if (_file.is_mapped () && ImageFileHandle::is_packed_layout (_pool->get_video_info ()))
+        return _file.read_mapped_buf (_pool->get_video_info (), _buf);
+
     _buf = _pool->get_buffer (_pool);
     XCAM_ASSERT (_buf.ptr ());
 
@@ -218,7 +285,12 @@ SoftElement::read_buf ()
 
 XCamReturn
 SoftElement::write_buf () {
-    return _file.write_buf (_buf);
+    XCamReturn ret = _file.write_buf (_buf);
+
+    // queued buffer is saved later, handlers allocate a new output buffer for next frame
+    if (_file.is_async_write ())
+        _buf.release ();
+    return ret;
 }
 
 #if XCAM_TEST_OPENCV
@@ -301,6 +373,27 @@ parse_camera_info (const char *path, uint32_t idx, CameraInfo &info, uint32_t ca
     return 0;
 }
 
+// rig other than front/right/rear/left, front camera rotated around bowl center
+static int
+ring_camera_info (const char *path, uint32_t idx, CameraInfo &info, uint32_t camera_count)
+{
+    if (parse_camera_info (path, 0, info, 4) != 0)
+        return -1;
+
+    float angle = idx * 360.0f / camera_count;
+    float radian = degree2radian (angle);
+    ExtrinsicParameter &extrinsic = info.calibration.extrinsic;
+    float trans_x = extrinsic.trans_x - TEST_CAMERA_POSITION_OFFSET_X;
+    float trans_y = extrinsic.trans_y;
+    extrinsic.trans_x = trans_x * cos (radian) + trans_y * sin (radian) + TEST_CAMERA_POSITION_OFFSET_X;
+    extrinsic.trans_y = trans_y * cos (radian) - trans_x * sin (radian);
+    extrinsic.yaw -= angle;
+
+    info.angle_range = 360.0f / camera_count * 1.5f;
+    info.round_angle_start = angle - info.angle_range / 2.0f;
+    return 0;
+}
+
 static void
 combine_name (const char *orig_name, const char *embedded_str, char *new_name)
 {
@@ -326,13 +419,17 @@ add_element (SoftElements &elements, const char *element_name, uint32_t width, u
 }
 
 static XCamReturn
-elements_open_file (const SoftElements &elements, const char *option, const bool &nv12_output)
+elements_open_file (
+    const SoftElements &elements, const char *option, const bool &nv12_output, uint32_t write_queue_depth)
 {
     XCamReturn ret = XCAM_RETURN_NO_ERROR;
 
     for (uint32_t i = 0; i < elements.size (); ++i) {
-        if (nv12_output)
+        if (nv12_output) {
             ret = elements[i]->open_file (option);
+            if (ret == XCAM_RETURN_NO_ERROR && write_queue_depth)
+                ret = elements[i]->start_async_write (write_queue_depth);
+        }
 #if XCAM_TEST_OPENCV
         else
             ret = elements[i]->cv_open_writer ();
@@ -486,12 +583,73 @@ remap_topview_buf (const SmartPtr<SoftElement> &stitch, const SmartPtr<SoftEleme
     return XCAM_RETURN_NO_ERROR;
 }
 
+static SmartPtr<Stitcher>
+create_stitcher (
+    StitchEngine engine, const std::vector<CameraInfo> &cam_info,
+    uint32_t output_width, uint32_t output_height, GeoMapScaleMode scale_mode,
+    bool need_seam, bool adaptive_blend)
+{
+    SmartPtr<Stitcher> stitcher = Stitcher::create_soft_stitcher (engine);
+    XCAM_ASSERT (stitcher.ptr ());
+    stitcher->set_need_seam (need_seam);
+    if (adaptive_blend) {
+        SmartPtr<SoftStitcher> soft_stitcher = stitcher.dynamic_cast_ptr<SoftStitcher> ();
+        XCAM_ASSERT (soft_stitcher.ptr ());
+        soft_stitcher->set_adaptive_blend (true);
+    }
+
+    uint32_t camera_count = cam_info.size ();
+    stitcher->set_camera_num (camera_count);
+    for (uint32_t i = 0; i < camera_count; ++i) {
+        stitcher->set_camera_info (i, cam_info[i]);
+    }
+
+    BowlDataConfig bowl;
+    bowl.wall_height = 3000.0f;
+    bowl.ground_length = 2000.0f;
+    //bowl.a = 5000.0f;
+    //bowl.b = 3600.0f;
+    //bowl.c = 3000.0f;
+    bowl.angle_start = 0.0f;
+    bowl.angle_end = 360.0f;
+    stitcher->set_bowl_config (bowl);
+    stitcher->set_output_size (output_width, output_height);
+    stitcher->set_scale_mode (scale_mode);
+
+    return stitcher;
+}
+
+static bool
+is_same_nv12_buf (const SmartPtr<VideoBuffer> &buf0, const SmartPtr<VideoBuffer> &buf1)
+{
+    const VideoBufferInfo &info0 = buf0->get_video_info ();
+    const VideoBufferInfo &info1 = buf1->get_video_info ();
+    if (info0.width != info1.width || info0.height != info1.height)
+        return false;
+
+    const uint8_t *mem0 = buf0->map ();
+    const uint8_t *mem1 = buf1->map ();
+    bool same = (mem0 && mem1);
+    for (uint32_t y = 0; same && y < info0.height; ++y)
+        same = !memcmp (mem0 + info0.offsets[0] + y * info0.strides[0],
+                        mem1 + info1.offsets[0] + y * info1.strides[0], info0.width);
+    for (uint32_t y = 0; same && y < info0.height / 2; ++y)
+        same = !memcmp (mem0 + info0.offsets[1] + y * info0.strides[1],
+                        mem1 + info1.offsets[1] + y * info1.strides[1], info0.width);
+    buf0->unmap ();
+    buf1->unmap ();
+
+    return same;
+}
+
 static int
 run_stitcher (
     const SmartPtr<Stitcher> &stitcher,
     const SoftElements &ins, const SoftElements &outs,
-    bool nv12_output, bool save_output, int loop)
+    bool nv12_output, bool save_output, int loop, const ViewportPose *viewport, uint32_t camera_count,
+    bool preview, const SmartPtr<Stitcher> &ref_stitcher)
 {
+    uint32_t frame_idx = 0;
     XCamReturn ret = XCAM_RETURN_NO_ERROR;
     CHECK (check_elements (ins), "invalid input elements");
     CHECK (check_elements (outs), "invalid output elements");
@@ -516,14 +674,41 @@ run_stitcher (
             if (ret == XCAM_RETURN_BYPASS)
                 break;
 
+            // cameras more than input files share the buffers in turn
+            for (uint32_t i = ins.size (); i < camera_count; ++i)
+                in_buffers.push_back (ins[i % ins.size ()]->get_buf ());
+
             CHECK (
                 stitcher->stitch_buffers (in_buffers, outs[0]->get_buf ()),
                 "stitch buffer failed.");
 
+            if (ref_stitcher.ptr ()) {
+                SmartPtr<VideoBuffer> ref_buf;
+                CHECK (ref_stitcher->stitch_buffers (in_buffers, ref_buf), "reference stitch buffer failed.");
+                CHECK_EXP (
+                    is_same_nv12_buf (outs[0]->get_buf (), ref_buf),
+                    "stitched frame(%d) differs from reference engine output", frame_idx);
+            }
+            ++frame_idx;
+
             if (save_output) {
                 if (check_element (outs, 1)) {
                     CHECK (remap_topview_buf (outs[0], outs[1]), "run topview failed");
                 }
+                if (viewport && check_element (outs, 2)) {
+                    CHECK (
+                        stitcher->render_viewport (
+                            *viewport, outs[2]->get_width (), outs[2]->get_height (), in_buffers, outs[2]->get_buf ()),
+                        "render viewport failed");
+                }
+                uint32_t preview_idx = viewport ? 3 : 2;
+                if (preview && check_element (outs, preview_idx)) {
+                    SmartPtr<SoftStitcher> soft_stitcher = stitcher.dynamic_cast_ptr<SoftStitcher> ();
+                    XCAM_ASSERT (soft_stitcher.ptr ());
+                    CHECK (
+                        soft_stitcher->render_preview (outs[0]->get_buf (), outs[preview_idx]->get_buf ()),
+                        "render preview failed");
+                }
 
                 write_image (ins, outs, nv12_output);
             }
@@ -535,16 +720,81 @@ run_stitcher (
     return 0;
 }
 
+// camera shakes around vertical axis, one pose per frame
+static SmartPtr<DevicePose>
+create_shake_pose (uint32_t frame_idx)
+{
+    SmartPtr<DevicePose> pose = new DevicePose ();
+    XCAM_ASSERT (pose.ptr ());
+
+    const double angle = degree2radian (0.5 * sin (frame_idx * 1.7));
+    pose->orientation[1] = sin (angle / 2.0);
+    pose->orientation[3] = cos (angle / 2.0);
+    pose->timestamp = (int64_t)frame_idx * STAB_FRAME_DURATION;
+    return pose;
+}
+
+static int
+run_stabilizer (
+    const SmartPtr<SoftVideoStabilizer> &stabilizer,
+    const SoftElements &ins, const SoftElements &outs, bool save_output, int loop)
+{
+    CHECK (check_elements (ins), "invalid input elements");
+    CHECK (check_elements (outs), "invalid output elements");
+
+    while (loop--) {
+        CHECK (ins[0]->rewind_file (), "rewind buffer from file(%s) failed", ins[0]->get_file_name ());
+        stabilizer->reset_counter ();
+
+        uint32_t frame_idx = 0, out_count = 0;
+        XCamReturn ret = XCAM_RETURN_NO_ERROR;
+        while ((ret = ins[0]->read_buf ()) != XCAM_RETURN_BYPASS) {
+            CHECK (ret, "read buffer from file(%s) failed.", ins[0]->get_file_name ());
+
+            SmartPtr<VideoBuffer> &in_buf = ins[0]->get_buf ();
+            SmartPtr<DevicePose> pose = create_shake_pose (frame_idx);
+            in_buf->set_timestamp (pose->timestamp);
+            in_buf->add_metadata (pose);
+
+            ret = stabilizer->stabilize (in_buf, outs[0]->get_buf ());
+            // output is delayed by filter radius
+            if (frame_idx < STAB_FILTER_RADIUS) {
+                CHECK_EXP (ret == XCAM_RETURN_BYPASS, "stabilizer output frame(%d) before filter window filled", frame_idx);
+            } else {
+                CHECK (ret, "stabilize frame(%d) failed", frame_idx);
+                CHECK_EXP (outs[0]->get_buf ().ptr (), "stabilizer gave no output of frame(%d)", frame_idx);
+                ++out_count;
+                if (save_output)
+                    outs[0]->write_buf ();
+            }
+            ++frame_idx;
+            FPS_CALCULATION (soft-stabilizer, XCAM_OBJ_DUR_FRAME_NUM);
+        }
+
+        printf ("stabilized %d of %d frames, filter radius:%d\n", out_count, frame_idx, STAB_FILTER_RADIUS);
+    }
+
+    return 0;
+}
+
 static void usage(const char* arg0)
 {
     printf ("Usage:\n"
             "%s --type TYPE--input0 file0 --input1 file1 --output file\n"
-            "\t--type              processing type, selected from: blend, remap, stitch, ...\n"
+            "\t--type              processing type, selected from: blend, remap, stitch, csc, bayer, denoise, warp, stabilize,\n"
+            "\t                    stats, ...\n"
+            "\t--                  [csc]: convert input(NV12) to output(RGBA) in input size\n"
+            "\t--                  [bayer]: convert input(SGRBG8) to output(NV12) in input size\n"
             "\t--                  [stitch]: read calibration files from exported path $FISHEYE_CONFIG_PATH\n"
+            "\t--                  [stabilize]: stabilize frames of input0 under a synthetic camera shake, the first\n"
+            "\t--                  4 frames only fill the motion filter\n"
+            "\t--                  [pack]: pack frames of inputs as cameras into output raw container, a container\n"
+            "\t--                  given as the only input provides all cameras and input size to other types\n"
             "\t--input0            input image(NV12)\n"
             "\t--input1            input image(NV12)\n"
             "\t--input2            input image(NV12)\n"
             "\t--input3            input image(NV12)\n"
+            "\t--input             input image(NV12), can be repeated to add more inputs after input0~3\n"
             "\t--output            output image(NV12)\n"
             "\t--in-w              optional, input width, default: 1920\n"
             "\t--in-h              optional, input height, default: 1080\n"
@@ -554,8 +804,25 @@ static void usage(const char* arg0)
             "\t--topview-h         optional, output height, default: 720\n"
             "\t--scale-mode        optional, scaling mode for geometric mapping,\n"
             "\t                    select from [singleconst/dualconst/dualcurve], default: singleconst\n"
+            "\t--table-cache       optional, [stitch]: file to load/save dewarp tables, default: disabled\n"
+            "\t--engine            optional, [stitch]: stitch engine, select from [staged/tiles], default: staged\n"
+            "\t--camera-num        optional, [stitch]: camera number, cameras other than 4 are a ring of front camera\n"
+            "\t                    and share input files in turn, default: input file number\n"
+            "\t--check-engine      optional, [stitch]: compare every frame with the output of the other engine,\n"
+            "\t                    select from [true/false], default: false\n"
+            "\t--viewport          optional, [stitch]: also render a viewport looking to yaw degree, default: disabled\n"
+            "\t--static-scene      optional, [stitch]: tiles engine re-renders changed tiles only, value is change threshold\n"
+            "\t                    of mean absolute difference, default: disabled\n"
+            "\t--preview           optional, [stitch]: also render a preview scaled down by 2^level, select from [1, 3],\n"
+            "\t                    default: disabled\n"
+            "\t--adaptive-blend    optional, [stitch]: pyramid depth and blend width of each overlap follow its content,\n"
+            "\t                    select from [true/false], default: false\n"
+            "\t--seam              optional, [stitch]: blend around a found seam, select from [true/false], default: false\n"
             "\t--save              optional, save file or not, select from [true/false], default: true\n"
             "\t--loop              optional, how many loops need to run, default: 1\n"
+            "\t--mmap              optional, map input files and use file pages as input buffers,\n"
+            "\t                    select from [true/false], default: false\n"
+            "\t--async-write       optional, save output in a writer thread with a queue of N buffers, default: 0(disabled)\n"
             "\t--help              usage\n",
             arg0);
 }
@@ -570,6 +837,19 @@ int main (int argc, char *argv[])
     uint32_t topview_height = 720;
     SoftType type = SoftTypeNone;
     GeoMapScaleMode scale_mode = ScaleSingleConst;
+    const char *table_cache = NULL;
+    StitchEngine engine = StitchEngineStaged;
+    bool need_seam = false;
+    bool adaptive_blend = false;
+    int static_threshold = -1;
+    uint32_t preview_level = 0;
+    bool need_viewport = false;
+    uint32_t camera_num = 0;
+    bool check_engine = false;
+    ViewportPose viewport;
+    viewport.position = PointFloat3 (0.0f, 0.0f, 1500.0f);
+    viewport.pitch = -30.0f;
+    viewport.fov = 100.0f;
 
     SoftElements ins;
     SoftElements outs;
@@ -577,6 +857,8 @@ int main (int argc, char *argv[])
     int loop = 1;
     bool save_output = true;
     bool nv12_output = true;
+    bool map_input = false;
+    uint32_t write_queue_depth = 0;
 
     const struct option long_opts[] = {
         {"type", required_argument, NULL, 't'},
@@ -584,6 +866,7 @@ int main (int argc, char *argv[])
         {"input1", required_argument, NULL, 'j'},
         {"input2", required_argument, NULL, 'k'},
         {"input3", required_argument, NULL, 'l'},
+        {"input", required_argument, NULL, 'i'},
         {"output", required_argument, NULL, 'o'},
         {"in-w", required_argument, NULL, 'w'},
         {"in-h", required_argument, NULL, 'h'},
@@ -592,8 +875,19 @@ int main (int argc, char *argv[])
         {"topview-w", required_argument, NULL, 'P'},
         {"topview-h", required_argument, NULL, 'V'},
         {"scale-mode", required_argument, NULL, 'S'},
+        {"table-cache", required_argument, NULL, 'T'},
+        {"engine", required_argument, NULL, 'E'},
+        {"seam", required_argument, NULL, 'M'},
+        {"adaptive-blend", required_argument, NULL, 'A'},
+        {"static-scene", required_argument, NULL, 'K'},
+        {"preview", required_argument, NULL, 'R'},
+        {"viewport", required_argument, NULL, 'v'},
+        {"camera-num", required_argument, NULL, 'N'},
+        {"check-engine", required_argument, NULL, 'C'},
         {"save", required_argument, NULL, 's'},
         {"loop", required_argument, NULL, 'L'},
+        {"mmap", required_argument, NULL, 'm'},
+        {"async-write", required_argument, NULL, 'a'},
         {"help", no_argument, NULL, 'e'},
         {NULL, 0, NULL, 0},
     };
@@ -609,6 +903,20 @@ int main (int argc, char *argv[])
                 type = SoftTypeRemap;
             else if (!strcasecmp (optarg, "stitch"))
                 type = SoftTypeStitch;
+            else if (!strcasecmp (optarg, "csc"))
+                type = SoftTypeCsc;
+            else if (!strcasecmp (optarg, "bayer"))
+                type = SoftTypeBayerPipe;
+            else if (!strcasecmp (optarg, "denoise"))
+                type = SoftTypeDenoise3D;
+            else if (!strcasecmp (optarg, "warp"))
+                type = SoftTypeWarp;
+            else if (!strcasecmp (optarg, "stabilize"))
+                type = SoftTypeStabilize;
+            else if (!strcasecmp (optarg, "stats"))
+                type = SoftType3aStats;
+            else if (!strcasecmp (optarg, "pack"))
+                type = SoftTypePack;
             else {
                 XCAM_LOG_ERROR ("unknown type:%s", optarg);
                 usage (argv[0]);
@@ -668,12 +976,56 @@ int main (int argc, char *argv[])
                 return -1;
             }
             break;
+        case 'T':
+            table_cache = optarg;
+            break;
+        case 'E':
+            XCAM_ASSERT (optarg);
+            if (!strcasecmp (optarg, "staged"))
+                engine = StitchEngineStaged;
+            else if (!strcasecmp (optarg, "tiles"))
+                engine = StitchEngineFusedTiles;
+            else {
+                XCAM_LOG_ERROR ("stitch engine unknown: %s", optarg);
+                usage (argv[0]);
+                return -1;
+            }
+            break;
+        case 'C':
+            XCAM_ASSERT (optarg);
+            check_engine = (strcasecmp (optarg, "true") == 0 ? true : false);
+            break;
+        case 'N':
+            camera_num = atoi (optarg);
+            break;
+        case 'v':
+            need_viewport = true;
+            viewport.yaw = atof (optarg);
+            break;
+        case 'R':
+            preview_level = atoi (optarg);
+            break;
+        case 'K':
+            static_threshold = atoi (optarg);
+            break;
+        case 'M':
+            need_seam = (strcasecmp (optarg, "true") == 0 ? true : false);
+            break;
+        case 'A':
+            adaptive_blend = (strcasecmp (optarg, "true") == 0 ? true : false);
+            break;
         case 's':
             save_output = (strcasecmp (optarg, "false") == 0 ? false : true);
             break;
         case 'L':
             loop = atoi(optarg);
             break;
+        case 'm':
+            map_input = (strcasecmp (optarg, "true") == 0 ? true : false);
+            break;
+        case 'a':
+            write_queue_depth = atoi (optarg);
+            break;
         default:
             XCAM_LOG_ERROR ("getopt_long return unknown value:%c", opt);
             usage (argv[0]);
@@ -700,6 +1052,24 @@ int main (int argc, char *argv[])
         return -1;
     }
 
+    SmartPtr<RawContainerFile> in_container;
+    if (ins.size () == 1 && RawContainerFile::is_container (ins[0]->get_file_name ())) {
+        std::string container_name (ins[0]->get_file_name ());
+        in_container = new RawContainerFile ();
+        CHECK (in_container->open_container (container_name.c_str ()), "open container(%s) failed", container_name.c_str ());
+        input_width = in_container->get_video_info ().width;
+        input_height = in_container->get_video_info ().height;
+
+        ins.clear ();
+        for (uint32_t i = 0; i < in_container->get_camera_count (); ++i) {
+            SmartPtr<SoftElement> element = new SoftElement (container_name.c_str ());
+            element->set_container (in_container, i);
+            ins.push_back (element);
+        }
+        printf ("input container:\t%d cameras, %d frames\n",
+                in_container->get_camera_count (), in_container->get_frame_count ());
+    }
+
     for (uint32_t i = 0; i < ins.size (); ++i) {
         printf ("input%d file:\t\t%s\n", i, ins[i]->get_file_name ());
     }
@@ -714,22 +1084,37 @@ int main (int argc, char *argv[])
             ((scale_mode == ScaleDualConst) ? "dualconst" : "dualcurve"));
     printf ("save output:\t\t%s\n", save_output ? "true" : "false");
     printf ("loop count:\t\t%d\n", loop);
+    printf ("map input:\t\t%s\n", map_input ? "true" : "false");
+    printf ("write queue depth:\t%d\n", write_queue_depth);
 
     VideoBufferInfo in_info, out_info;
-    in_info.init (V4L2_PIX_FMT_NV12, input_width, input_height);
+    in_info.init (
+        (type == SoftTypeBayerPipe ? V4L2_PIX_FMT_SGRBG8 : V4L2_PIX_FMT_NV12),
+        input_width, input_height);
     out_info.init (V4L2_PIX_FMT_NV12, output_width, output_height);
+    CHECK_EXP (
+        !in_container.ptr () || in_container->get_video_info ().format == in_info.format,
+        "input container format(%s) is not supported", xcam_fourcc_to_string (in_container->get_video_info ().format));
 
     for (uint32_t i = 0; i < ins.size (); ++i) {
         ins[i]->set_buf_size (input_width, input_height);
-        CHECK (ins[i]->create_buf_pool (in_info, 6), "create buffer pool failed");
+        // stabilizer holds the frames of its filter window
+        uint32_t buf_count = (type == SoftTypeStabilize ? STAB_FILTER_RADIUS + 6 : 6);
+        CHECK (ins[i]->create_buf_pool (in_info, buf_count), "create buffer pool failed");
         CHECK (ins[i]->open_file ("rb"), "open file(%s) failed", ins[i]->get_file_name ());
+        if (map_input) {
+            CHECK (ins[i]->map_file (), "map file(%s) failed", ins[i]->get_file_name ());
+        }
     }
 
     outs[0]->set_buf_size (output_width, output_height);
-    if (save_output) {
+    if (save_output && type != SoftTypePack) {
         CHECK (ensure_output_format (outs[0]->get_file_name (), type, nv12_output), "unsupported output format");
         if (nv12_output) {
             CHECK (outs[0]->open_file ("wb"), "open file(%s) failed", outs[0]->get_file_name ());
+            if (write_queue_depth) {
+                CHECK (outs[0]->start_async_write (write_queue_depth), "start async write failed");
+            }
         }
     }
 
@@ -766,14 +1151,114 @@ int main (int argc, char *argv[])
             outs[0]->write_buf ();
         break;
     }
+    case SoftTypeCsc: {
+        SmartPtr<SoftHandler> handler = create_soft_csc_handler (SoftCscTypeNV12ToRGBA);
+        SmartPtr<SoftCscHandler> csc = handler.dynamic_cast_ptr<SoftCscHandler> ();
+        XCAM_ASSERT (csc.ptr ());
+
+        CHECK (ins[0]->read_buf(), "read buffer from file(%s) failed.", ins[0]->get_file_name ());
+        RUN_N (csc->convert (ins[0]->get_buf (), outs[0]->get_buf ()), loop, "csc buffer failed.");
+        if (save_output)
+            outs[0]->write_buf ();
+        break;
+    }
+    case SoftTypeBayerPipe: {
+        SmartPtr<SoftHandler> handler = create_soft_bayer_pipe_handler ();
+        SmartPtr<SoftBayerPipeHandler> bayer_pipe = handler.dynamic_cast_ptr<SoftBayerPipeHandler> ();
+        XCAM_ASSERT (bayer_pipe.ptr ());
+
+        CHECK (ins[0]->read_buf(), "read buffer from file(%s) failed.", ins[0]->get_file_name ());
+        RUN_N (bayer_pipe->process (ins[0]->get_buf (), outs[0]->get_buf ()), loop, "bayer pipe buffer failed.");
+        if (save_output)
+            outs[0]->write_buf ();
+        break;
+    }
+    case SoftTypeDenoise3D: {
+        SmartPtr<SoftHandler> handler = create_soft_3d_denoise_handler (2);
+        SmartPtr<Soft3DDenoiseHandler> denoise = handler.dynamic_cast_ptr<Soft3DDenoiseHandler> ();
+        XCAM_ASSERT (denoise.ptr ());
+
+        CHECK (ins[0]->read_buf(), "read buffer from file(%s) failed.", ins[0]->get_file_name ());
+        RUN_N (denoise->denoise (ins[0]->get_buf (), outs[0]->get_buf ()), loop, "3d denoise buffer failed.");
+        if (save_output)
+            outs[0]->write_buf ();
+        break;
+    }
+    case SoftTypeWarp: {
+        SmartPtr<SoftHandler> handler = create_soft_image_warp_handler ();
+        SmartPtr<SoftImageWarpHandler> warper = handler.dynamic_cast_ptr<SoftImageWarpHandler> ();
+        XCAM_ASSERT (warper.ptr ());
+
+        // rotate 2 degrees around image center
+        const double angle = degree2radian (2.0);
+        const double cx = input_width / 2.0, cy = input_height / 2.0;
+        XCamDVSResult config;
+        xcam_mem_clear (config);
+        config.frame_width = input_width;
+        config.frame_height = input_height;
+        config.proj_mat[0] = cos (angle);
+        config.proj_mat[1] = -sin (angle);
+        config.proj_mat[2] = cx - cx * cos (angle) + cy * sin (angle);
+        config.proj_mat[3] = sin (angle);
+        config.proj_mat[4] = cos (angle);
+        config.proj_mat[5] = cy - cx * sin (angle) - cy * cos (angle);
+        config.proj_mat[8] = 1.0;
+        warper->set_warp_config (config);
+
+        CHECK (ins[0]->read_buf(), "read buffer from file(%s) failed.", ins[0]->get_file_name ());
+        RUN_N (warper->warp (ins[0]->get_buf (), outs[0]->get_buf ()), loop, "image warp buffer failed.");
+        if (save_output)
+            outs[0]->write_buf ();
+        break;
+    }
+    case SoftTypeStabilize: {
+        SmartPtr<SoftHandler> handler = create_soft_video_stabilizer ();
+        SmartPtr<SoftVideoStabilizer> stabilizer = handler.dynamic_cast_ptr<SoftVideoStabilizer> ();
+        XCAM_ASSERT (stabilizer.ptr ());
+
+        // pinhole camera of 60 degrees horizontal field of view
+        const double focal = input_width / (2.0 * tan (degree2radian (30.0)));
+        stabilizer->set_camera_intrinsics (focal, focal, input_width / 2.0, input_height / 2.0, 0.0);
+
+        CoordinateSystemConv world_to_device (AXIS_X, AXIS_MINUS_Z, AXIS_NONE);
+        CoordinateSystemConv device_to_image (AXIS_X, AXIS_Y, AXIS_Y);
+        stabilizer->align_coordinate_system (world_to_device, device_to_image);
+        stabilizer->set_motion_filter (STAB_FILTER_RADIUS, STAB_FILTER_STDEV);
+
+        CHECK (run_stabilizer (stabilizer, ins, outs, save_output, loop), "run stabilizer failed");
+        break;
+    }
+    case SoftType3aStats: {
+        SmartPtr<SoftHandler> handler = create_soft_3a_stats_handler ();
+        SmartPtr<Soft3aStatsHandler> stats_handler = handler.dynamic_cast_ptr<Soft3aStatsHandler> ();
+        XCAM_ASSERT (stats_handler.ptr ());
+
+        SmartPtr<X3aStats> stats;
+        CHECK (ins[0]->read_buf(), "read buffer from file(%s) failed.", ins[0]->get_file_name ());
+        RUN_N (stats_handler->calculate (ins[0]->get_buf (), stats), loop, "3a stats calculation failed.");
+
+        XCam3AStats *stats_ptr = stats->get_stats ();
+        const XCamGridStat &center = stats_ptr->stats[
+                                         stats_ptr->info.height / 2 * stats_ptr->info.aligned_width + stats_ptr->info.width / 2];
+        printf ("3a stats grid(%dx%d), center avg y:%d r:%d gr:%d gb:%d b:%d\n",
+                stats_ptr->info.width, stats_ptr->info.height,
+                center.avg_y, center.avg_r, center.avg_gr, center.avg_gb, center.avg_b);
+        break;
+    }
     case SoftTypeStitch: {
-        CHECK_EXP (ins.size () >= 2 && ins.size () <= 4, "stitcher need at 2~4 input files.");
+        CHECK_EXP (
+            ins.size () >= 2 && ins.size () <= XCAM_STITCH_MAX_CAMERAS,
+            "stitcher need at 2~%d input files.", XCAM_STITCH_MAX_CAMERAS);
 
-        uint32_t camera_count = ins.size ();
-        SmartPtr<Stitcher> stitcher = Stitcher::create_soft_stitcher ();
-        XCAM_ASSERT (stitcher.ptr ());
+        uint32_t camera_count = camera_num ? camera_num : ins.size ();
+        CHECK_EXP (
+            camera_count >= ins.size () && camera_count <= XCAM_STITCH_MAX_CAMERAS,
+            "camera num(%d) should be in [input file num, %d]", camera_count, XCAM_STITCH_MAX_CAMERAS);
+        CHECK_EXP (
+            !check_engine || static_threshold <= 0,
+            "static scene with change threshold doesn't match the other engine, can't be checked");
 
-        CameraInfo cam_info[4];
+        std::vector<CameraInfo> cam_info (camera_count);
         const char *fisheye_config_path = getenv (FISHEYE_CONFIG_ENV_VAR);
         if (!fisheye_config_path)
             fisheye_config_path = FISHEYE_CONFIG_PATH;
@@ -781,7 +1266,10 @@ int main (int argc, char *argv[])
         XCAM_LOG_INFO ("calibration config path:%s", XCAM_STR (fisheye_config_path));
 
         for (uint32_t i = 0; i < camera_count; ++i) {
-            if (parse_camera_info (fisheye_config_path, i, cam_info[i], camera_count) != 0) {
+            int ret = (camera_count != 4) ?
+                      ring_camera_info (fisheye_config_path, i, cam_info[i], camera_count) :
+                      parse_camera_info (fisheye_config_path, i, cam_info[i], camera_count);
+            if (ret != 0) {
                 XCAM_LOG_ERROR ("parse fisheye dewarp info(idx:%d) failed.", i);
                 return -1;
             }
@@ -795,32 +1283,90 @@ int main (int argc, char *argv[])
                 bowl_coord_offset);
         }
 
-        stitcher->set_camera_num (camera_count);
-        for (uint32_t i = 0; i < camera_count; ++i) {
-            stitcher->set_camera_info (i, cam_info[i]);
+        SmartPtr<Stitcher> stitcher = create_stitcher (
+                                          engine, cam_info, output_width, output_height, scale_mode,
+                                          need_seam, adaptive_blend);
+        XCAM_ASSERT (stitcher.ptr ());
+        if (static_threshold >= 0) {
+            SmartPtr<SoftStitcher> soft_stitcher = stitcher.dynamic_cast_ptr<SoftStitcher> ();
+            XCAM_ASSERT (soft_stitcher.ptr ());
+            soft_stitcher->set_static_scene (true, static_threshold);
+        }
+        if (preview_level) {
+            SmartPtr<SoftStitcher> soft_stitcher = stitcher.dynamic_cast_ptr<SoftStitcher> ();
+            XCAM_ASSERT (soft_stitcher.ptr ());
+            CHECK_EXP (soft_stitcher->set_preview_level (preview_level), "set preview level failed");
         }
 
-        BowlDataConfig bowl;
-        bowl.wall_height = 3000.0f;
-        bowl.ground_length = 2000.0f;
-        //bowl.a = 5000.0f;
-        //bowl.b = 3600.0f;
-        //bowl.c = 3000.0f;
-        bowl.angle_start = 0.0f;
-        bowl.angle_end = 360.0f;
-        stitcher->set_bowl_config (bowl);
-        stitcher->set_output_size (output_width, output_height);
-        stitcher->set_scale_mode (scale_mode);
+        SmartPtr<Stitcher> ref_stitcher;
+        if (check_engine) {
+            ref_stitcher = create_stitcher (
+                               engine == StitchEngineStaged ? StitchEngineFusedTiles : StitchEngineStaged,
+                               cam_info, output_width, output_height, scale_mode, need_seam, adaptive_blend);
+            XCAM_ASSERT (ref_stitcher.ptr ());
+        }
+        stitcher->set_table_cache_path (table_cache);
 
         if (save_output) {
             add_element (outs, "topview", topview_width, topview_height);
-            elements_open_file (outs, "wb", nv12_output);
+            if (need_viewport)
+                add_element (outs, "viewport", topview_width, topview_height);
+            if (preview_level)
+                add_element (
+                    outs, "preview",
+                    XCAM_ALIGN_UP (xcam_ceil (output_width, 1 << preview_level) >> preview_level, 2),
+                    XCAM_ALIGN_UP (xcam_ceil (output_height, 1 << preview_level) >> preview_level, 2));
+            elements_open_file (outs, "wb", nv12_output, write_queue_depth);
 
             create_topview_mapper (stitcher, outs[0], outs[1]);
         }
         CHECK_EXP (
-            run_stitcher (stitcher, ins, outs, nv12_output, save_output, loop) == 0,
+            run_stitcher (stitcher, ins, outs, nv12_output, save_output, loop,
+                          need_viewport ? &viewport : NULL, camera_count, preview_level > 0, ref_stitcher) == 0,
             "run stitcher failed.");
+
+        if (check_engine)
+            printf ("stitched frames are identical to the other engine\n");
+        if (static_threshold >= 0) {
+            SmartPtr<SoftStitcher> soft_stitcher = stitcher.dynamic_cast_ptr<SoftStitcher> ();
+            printf ("static scene skipped tiles ratio: %.3f\n", soft_stitcher->get_tile_skip_ratio ());
+        }
+        if (adaptive_blend) {
+            SmartPtr<SoftStitcher> soft_stitcher = stitcher.dynamic_cast_ptr<SoftStitcher> ();
+            SoftStitcher::OverlapBlendInfo info;
+            for (uint32_t i = 0; i < camera_count; ++i) {
+                if (soft_stitcher->get_overlap_blend_info (i, info))
+                    printf ("overlap(idx:%d) pyramid levels:%d, blend width:%d, cost:%" PRIu64 " pixels\n",
+                            i, info.pyr_levels, info.blend_width, info.cost);
+            }
+        }
+        break;
+    }
+
+    case SoftTypePack: {
+        SmartPtr<RawContainerFile> container = new RawContainerFile ();
+        CHECK (
+            container->create (outs[0]->get_file_name (), in_info, ins.size ()),
+            "create container(%s) failed", outs[0]->get_file_name ());
+
+        VideoBufferList frame;
+        XCamReturn ret = XCAM_RETURN_NO_ERROR;
+        while (true) {
+            frame.clear ();
+            for (uint32_t i = 0; i < ins.size (); ++i) {
+                ret = ins[i]->read_buf ();
+                if (ret == XCAM_RETURN_BYPASS)
+                    break;
+                CHECK (ret, "read buffer from file(%s) failed.", ins[i]->get_file_name ());
+                frame.push_back (ins[i]->get_buf ());
+            }
+            if (ret == XCAM_RETURN_BYPASS)
+                break;
+            CHECK (container->write_frame (frame), "write frame to container(%s) failed", outs[0]->get_file_name ());
+        }
+
+        printf ("packed %d frames of %d cameras\n", container->get_frame_count (), (int)ins.size ());
+        CHECK (container->close (), "close container(%s) failed", outs[0]->get_file_name ());
         break;
     }
 
@@ -831,5 +1377,12 @@ int main (int argc, char *argv[])
     }
     }
 
+    if (save_output && nv12_output && write_queue_depth) {
+        for (uint32_t i = 0; i < outs.size (); ++i) {
+            printf ("output%d write stalls:\t%d\n", i, outs[i]->get_write_stalls ());
+            CHECK (outs[i]->close_file (), "save file(%s) failed", outs[i]->get_file_name ());
+        }
+    }
+
     return 0;
 }
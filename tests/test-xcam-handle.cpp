@@ -0,0 +1,525 @@
+/*
+ * test-xcam-handle.cpp - test xcam handle of C API, asynchronous processing and soft contexts
+ *
+ *  Copyright (c) 2017 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#include "test_common.h"
+#include "context_priv.h"
+#include <xcam_handle.h>
+#include <poll.h>
+#include <unistd.h>
+#include <getopt.h>
+
+using namespace XCam;
+
+#define DONE_WAIT_TIME (5 * 1000 * 1000) // us
+
+#define STITCH_INPUT_WIDTH 1920
+#define STITCH_INPUT_HEIGHT 1080
+#define STITCH_CAMERA_NUM 4
+
+#define BLEND_INPUT_WIDTH 640
+#define BLEND_INPUT_HEIGHT 480
+#define BLEND_MERGE_WIDTH 160
+#define BLEND_LUMA_VALUE 100
+
+// jobs carry no buffers, ext_in tags the submission
+class FakeContext
+    : public ContextBase
+{
+public:
+    FakeContext (uint32_t depth, uint32_t delay_us)
+        : ContextBase (HandleTypeNone)
+        , _delay_us (delay_us)
+    {
+        _async_depth = depth;
+    }
+
+    virtual XCamReturn init_handler () {
+        return XCAM_RETURN_NO_ERROR;
+    }
+    virtual bool is_handler_ready () const {
+        return true;
+    }
+    virtual XCamReturn execute (VideoBufferList &bufs_in, SmartPtr<VideoBuffer> &buf_out) {
+        XCAM_UNUSED (bufs_in);
+        XCAM_UNUSED (buf_out);
+        if (_delay_us)
+            usleep (_delay_us);
+        return XCAM_RETURN_NO_ERROR;
+    }
+
+private:
+    uint32_t     _delay_us;
+};
+
+static SmartPtr<ContextJob>
+create_job (XCamVideoBuffer *tag)
+{
+    SmartPtr<ContextJob> job = new ContextJob;
+    XCAM_ASSERT (job.ptr ());
+    job->ext_in = tag;
+    return job;
+}
+
+static bool
+is_fd_readable (int fd, int timeout_ms)
+{
+    struct pollfd poll_fd;
+    xcam_mem_clear (poll_fd);
+    poll_fd.fd = fd;
+    poll_fd.events = POLLIN;
+    return ::poll (&poll_fd, 1, timeout_ms) == 1 && (poll_fd.revents & POLLIN);
+}
+
+struct PollJobs {
+    FakeContext                       *context;
+    std::vector<XCamVideoBuffer>      *tags;
+    bool                               wait_fd;
+    uint32_t                           done;
+    bool                               in_order;
+};
+
+static void *
+poll_jobs (void *data)
+{
+    PollJobs *poll = (PollJobs *)data;
+    int fd = poll->context->get_event_fd ();
+
+    while (poll->done < poll->tags->size ()) {
+        // readable event fd promises a done job
+        if (poll->wait_fd && !is_fd_readable (fd, DONE_WAIT_TIME / 1000))
+            break;
+
+        SmartPtr<ContextJob> job;
+        if (poll->context->poll (job, poll->wait_fd ? 0 : DONE_WAIT_TIME / 1000) != XCAM_RETURN_NO_ERROR)
+            break;
+        if (job->ext_in != &(*poll->tags)[poll->done])
+            poll->in_order = false;
+        ++poll->done;
+    }
+    return NULL;
+}
+
+// poll thread races with submit and worker thread, event fd count has to match done jobs
+// whether poll waits on event fd or in poll itself
+static int
+test_poll (uint32_t job_count, uint32_t depth, uint32_t delay_us, bool wait_fd)
+{
+    FakeContext *context = new FakeContext (depth, delay_us);
+    std::vector<XCamVideoBuffer> tags (job_count);
+    PollJobs poll = {context, &tags, wait_fd, 0, true};
+
+    CHECK_EXP (context->get_event_fd () >= 0, "context create event fd failed");
+
+    pthread_t poll_thread;
+    CHECK_EXP (
+        pthread_create (&poll_thread, NULL, poll_jobs, &poll) == 0,
+        "create poll thread failed");
+    for (uint32_t i = 0; i < job_count; ++i) {
+        CHECK (context->submit (create_job (&tags[i])), "submit job(%d) failed", i);
+    }
+    pthread_join (poll_thread, NULL);
+
+    CHECK_EXP (
+        poll.done == job_count, "polled %d of %d jobs, event fd missed done jobs", poll.done, job_count);
+    CHECK_EXP (poll.in_order, "jobs were not polled in submission order");
+    CHECK_EXP (
+        !is_fd_readable (context->get_event_fd (), 0),
+        "event fd is still readable after all jobs were polled");
+
+    SmartPtr<ContextJob> job;
+    CHECK_EXP (
+        context->poll (job, 0) == XCAM_RETURN_ERROR_TIMEOUT,
+        "poll returned a job which was never submitted");
+
+    delete context;
+    printf (
+        "poll(%s): %d jobs of depth %d done in order, event fd matches\n",
+        wait_fd ? "event fd" : "blocking", job_count, depth);
+    return 0;
+}
+
+struct ResubmitJobs {
+    FakeContext                       *context;
+    std::vector<XCamVideoBuffer>      *tags;
+    uint32_t                           submitted;
+    uint32_t                           done;
+    bool                               in_order;
+    Mutex                              mutex;
+    Cond                               cond;
+};
+
+static void
+resubmit_done (
+    XCamHandle *handle, XCamVideoBuffer *buf_in, XCamVideoBuffer *buf_out, XCamReturn error, void *user_data)
+{
+    XCAM_UNUSED (buf_out);
+    ResubmitJobs *jobs = (ResubmitJobs *)user_data;
+    XCAM_ASSERT (HANDLE_CAST (jobs->context) == handle);
+
+    // callback runs in worker thread, submit of next job must not wait for this one
+    if (jobs->submitted < jobs->tags->size ()) {
+        XCamVideoBuffer *tag = &(*jobs->tags)[jobs->submitted++];
+        if (jobs->context->submit (create_job (tag)) != XCAM_RETURN_NO_ERROR)
+            XCAM_LOG_ERROR ("resubmit job in done callback failed");
+    }
+
+    SmartLock locker (jobs->mutex);
+    if (error != XCAM_RETURN_NO_ERROR || buf_in != &(*jobs->tags)[jobs->done])
+        jobs->in_order = false;
+    ++jobs->done;
+    jobs->cond.broadcast ();
+}
+
+static int
+test_callback_resubmit (uint32_t job_count, uint32_t depth)
+{
+    FakeContext *context = new FakeContext (depth, 0);
+    std::vector<XCamVideoBuffer> tags (job_count);
+    ResubmitJobs jobs;
+    jobs.context = context;
+    jobs.tags = &tags;
+    jobs.submitted = 0;
+    jobs.done = 0;
+    jobs.in_order = true;
+
+    CHECK (
+        context->set_done_callback (resubmit_done, &jobs),
+        "set done callback failed");
+
+    // callback keeps depth jobs in flight
+    uint32_t first_count = XCAM_MIN (depth, job_count);
+    jobs.submitted = first_count;
+    for (uint32_t i = 0; i < first_count; ++i) {
+        CHECK (context->submit (create_job (&tags[i])), "submit job(%d) failed", i);
+    }
+
+    {
+        SmartLock locker (jobs.mutex);
+        while (jobs.done < job_count) {
+            // context is leaked on failure, worker thread may be stuck in submit
+            CHECK_EXP (
+                jobs.cond.timedwait (jobs.mutex, DONE_WAIT_TIME) == 0,
+                "done callback stuck after %d of %d jobs", jobs.done, job_count);
+        }
+    }
+    CHECK_EXP (jobs.in_order, "done callbacks were not called in submission order");
+
+    delete context;
+    printf ("callback: %d jobs of depth %d resubmitted from done callback\n", job_count, depth);
+    return 0;
+}
+
+// host memory of caller, handle wraps it in place as XCAM_MEM_TYPE_CPU
+struct HostBuffer {
+    XCamVideoBuffer        base;
+    std::vector<uint8_t>  *data;
+};
+
+static uint8_t *
+host_buf_map (XCamVideoBuffer *buf)
+{
+    return &(*((HostBuffer *)buf)->data)[0];
+}
+
+static void
+host_buf_unmap (XCamVideoBuffer *buf)
+{
+    XCAM_UNUSED (buf);
+}
+
+static void
+init_host_buf (HostBuffer &buf, std::vector<uint8_t> &data, uint32_t width, uint32_t height)
+{
+    VideoBufferInfo info;
+    info.init (V4L2_PIX_FMT_NV12, width, height);
+    data.resize (info.size);
+
+    xcam_mem_clear (buf.base);
+    buf.base.info = info;
+    buf.base.mem_type = XCAM_MEM_TYPE_CPU;
+    buf.base.map = host_buf_map;
+    buf.base.unmap = host_buf_unmap;
+    buf.data = &data;
+}
+
+// luma gradient keeps every camera area different, chroma is neutral
+static void
+fill_host_buf (HostBuffer &buf, uint32_t seed, bool gradient)
+{
+    const VideoBufferInfo &info = *((const VideoBufferInfo *)&buf.base.info);
+    uint8_t *ptr = host_buf_map (&buf.base);
+
+    for (uint32_t i = 0; i < info.components; ++i) {
+        VideoBufferPlanarInfo planar;
+        info.get_planar_info (planar, i);
+        for (uint32_t y = 0; y < planar.height; ++y) {
+            uint8_t *line = ptr + info.offsets[i] + y * info.strides[i];
+            for (uint32_t x = 0; x < planar.width * planar.pixel_bytes; ++x)
+                line[x] = (i > 0) ? 128 : (gradient ? (uint8_t)(x + y + seed * 64) : (uint8_t)seed);
+        }
+    }
+}
+
+static bool
+is_same_image (XCamVideoBuffer *buf0, XCamVideoBuffer *buf1)
+{
+    const VideoBufferInfo &info0 = *((const VideoBufferInfo *)&buf0->info);
+    const VideoBufferInfo &info1 = *((const VideoBufferInfo *)&buf1->info);
+    if (info0.format != info1.format || info0.width != info1.width || info0.height != info1.height)
+        return false;
+
+    uint8_t *ptr0 = xcam_video_buffer_map (buf0);
+    uint8_t *ptr1 = xcam_video_buffer_map (buf1);
+    bool same = (ptr0 && ptr1);
+    for (uint32_t i = 0; same && i < info0.components; ++i) {
+        VideoBufferPlanarInfo planar;
+        info0.get_planar_info (planar, i);
+        for (uint32_t y = 0; same && y < planar.height; ++y) {
+            same = !memcmp (
+                       ptr0 + info0.offsets[i] + y * info0.strides[i],
+                       ptr1 + info1.offsets[i] + y * info1.strides[i],
+                       planar.width * planar.pixel_bytes);
+        }
+    }
+    xcam_video_buffer_unmap (buf0);
+    xcam_video_buffer_unmap (buf1);
+    return same;
+}
+
+static bool
+has_calibration_files (const char *path)
+{
+    char file_path[XCAM_MAX_STR_SIZE] = {'\0'};
+    snprintf (file_path, XCAM_MAX_STR_SIZE, "%s/intrinsic_camera_front.txt", path);
+    if (access (file_path, F_OK) == 0)
+        return true;
+
+    snprintf (file_path, XCAM_MAX_STR_SIZE, "%s/intrinsic_camera_0.txt", path);
+    return access (file_path, F_OK) == 0;
+}
+
+static XCamHandle *
+create_stitch_handle (const char *calib_path, const char *engine, bool alloc_out_buf)
+{
+    char width[16], height[16], camera_num[16];
+    snprintf (width, sizeof (width), "%d", STITCH_INPUT_WIDTH);
+    snprintf (height, sizeof (height), "%d", STITCH_INPUT_HEIGHT);
+    snprintf (camera_num, sizeof (camera_num), "%d", STITCH_CAMERA_NUM);
+
+    XCamHandle *handle = xcam_create_handle ("SoftStitch");
+    if (!handle)
+        return NULL;
+
+    if (xcam_handle_set_parameters (
+                handle, "width", width, "height", height, "camera-num", camera_num,
+                "calib-path", calib_path, "engine", engine,
+                "alloc-out-buf", alloc_out_buf ? "true" : "false", NULL) != XCAM_RETURN_NO_ERROR ||
+            xcam_handle_init (handle) != XCAM_RETURN_NO_ERROR) {
+        xcam_destroy_handle (handle);
+        return NULL;
+    }
+    return handle;
+}
+
+// staged engine allocates output, fused tiles engine writes caller's output in place,
+// both of them have to give the same panorama
+static int
+test_soft_stitch (const char *calib_path)
+{
+    if (!has_calibration_files (calib_path)) {
+        printf ("SoftStitch: no calibration files in %s, skipped\n", calib_path);
+        return 0;
+    }
+
+    std::vector<HostBuffer> ins (STITCH_CAMERA_NUM);
+    std::vector<std::vector<uint8_t> > in_data (STITCH_CAMERA_NUM);
+    XCamVideoBuffer *bufs_in[STITCH_CAMERA_NUM];
+    for (uint32_t i = 0; i < STITCH_CAMERA_NUM; ++i) {
+        init_host_buf (ins[i], in_data[i], STITCH_INPUT_WIDTH, STITCH_INPUT_HEIGHT);
+        fill_host_buf (ins[i], i, true);
+        bufs_in[i] = &ins[i].base;
+    }
+
+    XCamHandle *staged = create_stitch_handle (calib_path, "staged", true);
+    CHECK_EXP (staged, "create SoftStitch handle(engine:staged) failed");
+
+    XCamVideoBuffer *allocated_out = NULL;
+    CHECK (
+        xcam_handle_execute_multi (staged, bufs_in, STITCH_CAMERA_NUM, &allocated_out),
+        "SoftStitch(engine:staged) execute failed");
+    CHECK_EXP (allocated_out, "SoftStitch(engine:staged) didn't allocate output");
+
+    XCamVideoBufferInfo out_info = allocated_out->info;
+    CHECK_EXP (
+        out_info.format == V4L2_PIX_FMT_NV12 && out_info.width == STITCH_INPUT_WIDTH &&
+        out_info.height == XCAM_ALIGN_UP (STITCH_INPUT_WIDTH / 2, 16),
+        "SoftStitch output(fmt:%s, %dx%d) isn't the default NV12 panorama",
+        xcam_fourcc_to_string (out_info.format), out_info.width, out_info.height);
+
+    HostBuffer host_out;
+    std::vector<uint8_t> out_data;
+    init_host_buf (host_out, out_data, out_info.width, out_info.height);
+    XCamVideoBuffer *buf_out = &host_out.base;
+
+    XCamHandle *tiles = create_stitch_handle (calib_path, "tiles", false);
+    CHECK_EXP (tiles, "create SoftStitch handle(engine:tiles) failed");
+    CHECK (
+        xcam_handle_execute_multi (tiles, bufs_in, STITCH_CAMERA_NUM, &buf_out),
+        "SoftStitch(engine:tiles) execute failed");
+    CHECK_EXP (buf_out == &host_out.base, "SoftStitch(engine:tiles) didn't write caller's output");
+
+    CHECK_EXP (
+        is_same_image (allocated_out, &host_out.base),
+        "SoftStitch outputs of staged and tiles engines are different");
+
+    // black output would match as well
+    fill_host_buf (host_out, 0, false);
+    CHECK_EXP (!is_same_image (allocated_out, &host_out.base), "SoftStitch output is blank");
+
+    xcam_video_buffer_unref (allocated_out);
+    xcam_handle_uinit (staged);
+    xcam_destroy_handle (staged);
+    xcam_handle_uinit (tiles);
+    xcam_destroy_handle (tiles);
+
+    printf (
+        "SoftStitch: %d cameras of %dx%d stitched to %dx%d, engines match\n",
+        STITCH_CAMERA_NUM, STITCH_INPUT_WIDTH, STITCH_INPUT_HEIGHT, out_info.width, out_info.height);
+    return 0;
+}
+
+// blend of two flat images of the same luma keeps it flat
+static int
+test_soft_blend ()
+{
+    char width[16], height[16], merge_width[16];
+    snprintf (width, sizeof (width), "%d", BLEND_INPUT_WIDTH);
+    snprintf (height, sizeof (height), "%d", BLEND_INPUT_HEIGHT);
+    snprintf (merge_width, sizeof (merge_width), "%d", BLEND_MERGE_WIDTH);
+
+    XCamHandle *handle = xcam_create_handle ("SoftBlend");
+    CHECK_EXP (handle, "create SoftBlend handle failed");
+    CHECK (
+        xcam_handle_set_parameters (
+            handle, "width", width, "height", height, "merge-width", merge_width,
+            "alloc-out-buf", "true", NULL),
+        "SoftBlend set parameters failed");
+    CHECK (xcam_handle_init (handle), "SoftBlend init failed");
+
+    HostBuffer ins[2];
+    std::vector<uint8_t> in_data[2];
+    XCamVideoBuffer *bufs_in[2];
+    for (uint32_t i = 0; i < 2; ++i) {
+        init_host_buf (ins[i], in_data[i], BLEND_INPUT_WIDTH, BLEND_INPUT_HEIGHT);
+        fill_host_buf (ins[i], BLEND_LUMA_VALUE, false);
+        bufs_in[i] = &ins[i].base;
+    }
+
+    XCamVideoBuffer *buf_out = NULL;
+    CHECK (xcam_handle_execute_multi (handle, bufs_in, 2, &buf_out), "SoftBlend execute failed");
+    CHECK_EXP (buf_out, "SoftBlend didn't allocate output");
+
+    XCamVideoBufferInfo out_info = buf_out->info;
+    CHECK_EXP (
+        out_info.width == BLEND_INPUT_WIDTH * 2 - BLEND_MERGE_WIDTH && out_info.height == BLEND_INPUT_HEIGHT,
+        "SoftBlend output(%dx%d) doesn't match inputs", out_info.width, out_info.height);
+
+    HostBuffer expected;
+    std::vector<uint8_t> expected_data;
+    init_host_buf (expected, expected_data, out_info.width, out_info.height);
+    fill_host_buf (expected, BLEND_LUMA_VALUE, false);
+    CHECK_EXP (is_same_image (buf_out, &expected.base), "SoftBlend output of flat inputs isn't flat");
+
+    xcam_video_buffer_unref (buf_out);
+    xcam_handle_uinit (handle);
+    xcam_destroy_handle (handle);
+
+    printf ("SoftBlend: 2 inputs of %dx%d blended to %dx%d\n",
+            BLEND_INPUT_WIDTH, BLEND_INPUT_HEIGHT, out_info.width, out_info.height);
+    return 0;
+}
+
+void usage(const char* arg0)
+{
+    printf ("Usage:\n"
+            "%s --jobs NUM\n"
+            "\t--jobs              optional, jobs of each test, default: 64\n"
+            "\t--calib-path        optional, calibration files of SoftStitch\n"
+            "\t                    default: $FISHEYE_CONFIG_PATH or %s, skipped if not found\n"
+            "\t--help              usage\n",
+            arg0, FISHEYE_CONFIG_PATH);
+}
+
+int main (int argc, char *argv[])
+{
+    uint32_t job_count = 64;
+    const char *calib_path = getenv (FISHEYE_CONFIG_ENV_VAR);
+    if (!calib_path)
+        calib_path = FISHEYE_CONFIG_PATH;
+
+    const struct option long_opts[] = {
+        {"jobs", required_argument, NULL, 'j'},
+        {"calib-path", required_argument, NULL, 'c'},
+        {"help", no_argument, NULL, 'h'},
+        {NULL, 0, NULL, 0},
+    };
+
+    int opt = -1;
+    while ((opt = getopt_long(argc, argv, "", long_opts, NULL)) != -1) {
+        switch (opt) {
+        case 'j':
+            job_count = atoi (optarg);
+            break;
+        case 'c':
+            calib_path = optarg;
+            break;
+        case 'h':
+            usage (argv[0]);
+            return 0;
+        default:
+            XCAM_LOG_ERROR ("getopt_long return unknown value:%c", opt);
+            usage (argv[0]);
+            return -1;
+        }
+    }
+
+    if (optind < argc) {
+        XCAM_LOG_ERROR ("unknown option %s", argv[optind]);
+        usage (argv[0]);
+        return -1;
+    }
+    CHECK_EXP (job_count > 0, "job number should be positive");
+
+    printf ("jobs:\t\t%d\n", job_count);
+    printf ("calib path:\t%s\n", calib_path);
+
+    for (uint32_t i = 0; i < 2; ++i) {
+        bool wait_fd = (i == 0);
+        if (test_poll (job_count, 1, 0, wait_fd) || test_poll (job_count, 2, 0, wait_fd) ||
+                test_poll (job_count, 4, 100, wait_fd))
+            return -1;
+    }
+    if (test_callback_resubmit (job_count, 1) || test_callback_resubmit (job_count, 3))
+        return -1;
+    if (test_soft_stitch (calib_path) || test_soft_blend ())
+        return -1;
+
+    return 0;
+}
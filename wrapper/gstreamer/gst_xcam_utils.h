@@ -21,6 +21,9 @@
 #ifndef GST_XCAM_UTILS_H
 #define GST_XCAM_UTILS_H
 
+#include <gst/gst.h>
+#include <gst/video/video.h>
+#include <xcam_mutex.h>
 #include "dma_video_buffer.h"
 
 class DmaGstBuffer
@@ -45,4 +48,159 @@ private:
     GstBuffer *_gst_buf;
 };
 
+// plane layout is taken from video meta of gst_buf if it has one
+inline bool
+gst_xcam_get_buffer_info (const GstVideoInfo *gst_info, GstBuffer *gst_buf, XCam::VideoBufferInfo &info)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, GST_VIDEO_INFO_FORMAT (gst_info) == GST_VIDEO_FORMAT_NV12, false,
+        "gst xcam buffer info only supports NV12");
+
+    if (!info.init (V4L2_PIX_FMT_NV12, GST_VIDEO_INFO_WIDTH (gst_info), GST_VIDEO_INFO_HEIGHT (gst_info)))
+        return false;
+
+    GstVideoMeta *meta = gst_buf ? gst_buffer_get_video_meta (gst_buf) : NULL;
+    for (uint32_t i = 0; i < GST_VIDEO_INFO_N_PLANES (gst_info); ++i) {
+        info.strides[i] = meta ? meta->stride[i] : GST_VIDEO_INFO_PLANE_STRIDE (gst_info, i);
+        info.offsets[i] = meta ? meta->offset[i] : GST_VIDEO_INFO_PLANE_OFFSET (gst_info, i);
+    }
+    info.aligned_width = info.strides[0];
+    info.aligned_height = (info.offsets[1] - info.offsets[0]) / info.strides[0];
+    info.size = gst_buf ? gst_buffer_get_size (gst_buf) : GST_VIDEO_INFO_SIZE (gst_info);
+    return true;
+}
+
+/* frame of a system memory GstBuffer used by xcam handlers in place, strides and offsets
+ * are those of the frame, mapped on first map () and unmapped when released
+ */
+class GstFrameVideoBuffer
+    : public XCam::VideoBuffer
+{
+public:
+    GstFrameVideoBuffer (
+        const GstVideoInfo *gst_info, const XCam::VideoBufferInfo &info,
+        GstBuffer *gst_buf, GstMapFlags flags = GST_MAP_READ)
+        : XCam::VideoBuffer (info)
+        , _gst_info (*gst_info)
+        , _gst_buf (gst_buf)
+        , _flags (flags)
+        , _data (NULL)
+    {
+        gst_buffer_ref (_gst_buf);
+    }
+
+    ~GstFrameVideoBuffer () {
+        if (_data)
+            gst_video_frame_unmap (&_frame);
+        gst_buffer_unref (_gst_buf);
+    }
+
+    virtual uint8_t *map () {
+        XCam::SmartLock locker (_mutex);
+        if (_data)
+            return _data;
+
+        if (!gst_video_frame_map (&_frame, &_gst_info, _gst_buf, _flags)) {
+            XCAM_LOG_WARNING ("gst frame video buffer map frame failed");
+            return NULL;
+        }
+
+        // xcam buffers address planes by offsets from one pointer
+        const XCam::VideoBufferInfo &info = get_video_info ();
+        uint8_t *data = (uint8_t *)GST_VIDEO_FRAME_PLANE_DATA (&_frame, 0) - info.offsets[0];
+        for (uint32_t i = 0; i < GST_VIDEO_FRAME_N_PLANES (&_frame); ++i) {
+            if ((uint8_t *)GST_VIDEO_FRAME_PLANE_DATA (&_frame, i) != data + info.offsets[i] ||
+                    GST_VIDEO_FRAME_PLANE_STRIDE (&_frame, i) != (gint)info.strides[i]) {
+                XCAM_LOG_WARNING ("gst frame video buffer planes(idx:%d) are not in one memory", i);
+                gst_video_frame_unmap (&_frame);
+                return NULL;
+            }
+        }
+
+        _data = data;
+        return _data;
+    }
+    virtual bool unmap () {
+        return true;
+    }
+    virtual int get_fd () {
+        return -1;
+    }
+
+private:
+    XCAM_DEAD_COPY (GstFrameVideoBuffer);
+
+private:
+    GstVideoInfo    _gst_info;
+    GstVideoFrame   _frame;
+    GstBuffer      *_gst_buf;
+    GstMapFlags     _flags;
+    uint8_t        *_data;
+    XCam::Mutex     _mutex;
+};
+
+// wraps gst_buf in place, NULL if its format isn't supported
+inline XCam::SmartPtr<XCam::VideoBuffer>
+gst_xcam_wrap_gst_buffer (const GstVideoInfo *gst_info, GstBuffer *gst_buf, GstMapFlags flags = GST_MAP_READ)
+{
+    XCam::VideoBufferInfo info;
+    if (!gst_xcam_get_buffer_info (gst_info, gst_buf, info))
+        return NULL;
+
+    return new GstFrameVideoBuffer (gst_info, info, gst_buf, flags);
+}
+
+inline void
+gst_xcam_release_video_buffer (gpointer data)
+{
+    XCam::SmartPtr<XCam::VideoBuffer> *buf = (XCam::SmartPtr<XCam::VideoBuffer> *)data;
+    (*buf)->unmap ();
+    delete buf;
+}
+
+/* GstBuffer sharing memory of xcam buf, buf is referenced until GstBuffer is freed,
+ * a buffer from BufferPool goes back to its pool then
+ */
+inline GstBuffer *
+gst_xcam_wrap_video_buffer (const XCam::SmartPtr<XCam::VideoBuffer> &buf)
+{
+    XCAM_ASSERT (buf.ptr ());
+    const XCam::VideoBufferInfo &info = buf->get_video_info ();
+    XCAM_FAIL_RETURN (
+        ERROR, info.format == V4L2_PIX_FMT_NV12, NULL,
+        "gst xcam wrap video buffer only supports NV12");
+
+    uint8_t *data = buf->map ();
+    XCAM_FAIL_RETURN (ERROR, data, NULL, "gst xcam wrap video buffer map failed");
+
+    GstBuffer *gst_buf = gst_buffer_new_wrapped_full (
+                             (GstMemoryFlags)0, data, info.size, 0, info.size,
+                             new XCam::SmartPtr<XCam::VideoBuffer> (buf), gst_xcam_release_video_buffer);
+    XCAM_ASSERT (gst_buf);
+
+    gsize offsets[GST_VIDEO_MAX_PLANES];
+    gint strides[GST_VIDEO_MAX_PLANES];
+    for (uint32_t i = 0; i < info.components; ++i) {
+        offsets[i] = info.offsets[i];
+        strides[i] = info.strides[i];
+    }
+    gst_buffer_add_video_meta_full (
+        gst_buf, GST_VIDEO_FRAME_FLAG_NONE, GST_VIDEO_FORMAT_NV12,
+        info.width, info.height, info.components, offsets, strides);
+
+    return gst_buf;
+}
+
+// whether buf can be read by an element not supporting video meta
+inline bool
+gst_xcam_is_default_layout (const GstVideoInfo *gst_info, const XCam::VideoBufferInfo &info)
+{
+    for (uint32_t i = 0; i < GST_VIDEO_INFO_N_PLANES (gst_info); ++i) {
+        if ((gint)info.strides[i] != GST_VIDEO_INFO_PLANE_STRIDE (gst_info, i) ||
+                info.offsets[i] != GST_VIDEO_INFO_PLANE_OFFSET (gst_info, i))
+            return false;
+    }
+    return true;
+}
+
 #endif // GST_XCAM_UTILS_H
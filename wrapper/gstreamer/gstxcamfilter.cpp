@@ -20,9 +20,12 @@
 
 #include "gstxcamfilter.h"
 #include "gstxcambuffermeta.h"
+#include "gstxcamvideopool.h"
 
 #include <gst/gstmeta.h>
 #include <gst/allocators/gstdmabuf.h>
+#include <ocl/cl_device.h>
+#include <ocl/cl_video_buffer.h>
 
 using namespace XCam;
 using namespace GstXCam;
@@ -218,6 +221,8 @@ static GstCaps *gst_xcam_filter_transform_caps (
     GstBaseTransform *trans, GstPadDirection direction, GstCaps *caps, GstCaps *filter);
 static gboolean gst_xcam_filter_set_caps (GstBaseTransform *trans, GstCaps *incaps, GstCaps *outcaps);
 static gboolean gst_xcam_filter_stop (GstBaseTransform *trans);
+static gboolean gst_xcam_filter_propose_allocation (GstBaseTransform *trans, GstQuery *decide_query, GstQuery *query);
+static gboolean gst_xcam_filter_decide_allocation (GstBaseTransform *trans, GstQuery *query);
 static void gst_xcam_filter_before_transform (GstBaseTransform *trans, GstBuffer *buffer);
 static GstFlowReturn gst_xcam_filter_prepare_output_buffer (GstBaseTransform * trans, GstBuffer *input, GstBuffer **outbuf);
 static GstFlowReturn gst_xcam_filter_transform (GstBaseTransform *trans, GstBuffer *inbuf, GstBuffer *outbuf);
@@ -335,6 +340,8 @@ gst_xcam_filter_class_init (GstXCamFilterClass *class_self)
     basetrans_class->stop = GST_DEBUG_FUNCPTR (gst_xcam_filter_stop);
     basetrans_class->transform_caps = GST_DEBUG_FUNCPTR (gst_xcam_filter_transform_caps);
     basetrans_class->set_caps = GST_DEBUG_FUNCPTR (gst_xcam_filter_set_caps);
+    basetrans_class->propose_allocation = GST_DEBUG_FUNCPTR (gst_xcam_filter_propose_allocation);
+    basetrans_class->decide_allocation = GST_DEBUG_FUNCPTR (gst_xcam_filter_decide_allocation);
     basetrans_class->before_transform = GST_DEBUG_FUNCPTR (gst_xcam_filter_before_transform);
     basetrans_class->prepare_output_buffer = GST_DEBUG_FUNCPTR (gst_xcam_filter_prepare_output_buffer);
     basetrans_class->transform = GST_DEBUG_FUNCPTR (gst_xcam_filter_transform);
@@ -361,6 +368,9 @@ gst_xcam_filter_init (GstXCamFilter *xcamfilter)
 
     xcamfilter->delay_buf_num = DEFAULT_DELAY_BUFFER_NUM;
     xcamfilter->cached_buf_num = 0;
+    xcamfilter->need_copy = FALSE;
+    xcamfilter->allocator = NULL;
+    xcamfilter->sink_pool = NULL;
 
     XCAM_CONSTRUCTOR (xcamfilter->pipe_manager, SmartPtr<MainPipeManager>);
     SmartPtr<MainPipeManager> pipe_manager = new MainPipeManager;
@@ -375,6 +385,8 @@ gst_xcam_filter_finalize (GObject *object)
 
     if (xcamfilter->allocator)
         gst_object_unref (xcamfilter->allocator);
+    if (xcamfilter->sink_pool)
+        gst_object_unref (xcamfilter->sink_pool);
 
     xcamfilter->pipe_manager.release ();
     XCAM_DESTRUCTOR (xcamfilter->pipe_manager, SmartPtr<MainPipeManager>);
@@ -604,6 +616,11 @@ gst_xcam_filter_stop (GstBaseTransform *trans)
     if (pipe_manager.ptr ())
         pipe_manager->stop ();
 
+    if (xcamfilter->sink_pool) {
+        gst_object_unref (xcamfilter->sink_pool);
+        xcamfilter->sink_pool = NULL;
+    }
+
     return true;
 }
 
@@ -764,9 +781,56 @@ gst_xcam_filter_set_caps (GstBaseTransform *trans, GstCaps *incaps, GstCaps *out
         return false;
     }
 
+    // offered to upstream, so it writes frames into xcam buffers directly
+    if (xcamfilter->sink_pool)
+        gst_object_unref (xcamfilter->sink_pool);
+    xcamfilter->sink_pool = gst_xcam_video_pool_new (buf_pool, incaps, xcamfilter->buf_count);
+    if (!xcamfilter->sink_pool)
+        XCAM_LOG_WARNING ("xcamfilter create sink pool failed, upstream buffers will be wrapped or copied");
+
     return true;
 }
 
+static gboolean
+gst_xcam_filter_propose_allocation (GstBaseTransform *trans, GstQuery *decide_query, GstQuery *query)
+{
+    GstXCamFilter *xcamfilter = GST_XCAM_FILTER (trans);
+    GstCaps *caps = NULL;
+    gboolean need_pool = FALSE;
+
+    if (!GST_BASE_TRANSFORM_CLASS (parent_class)->propose_allocation (trans, decide_query, query))
+        return false;
+
+    gst_query_parse_allocation (query, &caps, &need_pool);
+    if (!need_pool || !caps || !xcamfilter->sink_pool)
+        return true;
+
+    GstStructure *config = gst_buffer_pool_get_config (xcamfilter->sink_pool);
+    GstCaps *pool_caps = NULL;
+    guint size = 0;
+    gst_buffer_pool_config_get_params (config, &pool_caps, &size, NULL, NULL);
+    gboolean same_caps = pool_caps && gst_caps_is_equal (caps, pool_caps);
+    gst_structure_free (config);
+
+    if (same_caps) {
+        gst_query_add_allocation_pool (query, xcamfilter->sink_pool, size, 0, xcamfilter->buf_count);
+        gst_query_add_allocation_meta (query, GST_VIDEO_META_API_TYPE, NULL);
+    }
+
+    return true;
+}
+
+static gboolean
+gst_xcam_filter_decide_allocation (GstBaseTransform *trans, GstQuery *query)
+{
+    GstXCamFilter *xcamfilter = GST_XCAM_FILTER (trans);
+
+    // outputs with non-default layout are copied only if downstream can't read video meta
+    xcamfilter->need_copy = !gst_query_find_allocation_meta (query, GST_VIDEO_META_API_TYPE, NULL);
+
+    return GST_BASE_TRANSFORM_CLASS (parent_class)->decide_allocation (trans, query);
+}
+
 static GstFlowReturn
 copy_gstbuf_to_xcambuf (GstVideoInfo gstinfo, GstBuffer *gstbuf, SmartPtr<VideoBuffer> xcambuf)
 {
@@ -885,6 +949,34 @@ get_dmabuf_fd (GstBuffer *buffer)
     return gst_dmabuf_memory_get_fd (mem);
 }
 
+/* upstream buffer is held until the pipeline releases it, which takes delayed buffers,
+ * only wrap it if upstream pool doesn't run out of buffers meanwhile
+ */
+static bool
+can_hold_gstbuf (GstXCamFilter *xcamfilter, GstBuffer *gstbuf)
+{
+    if (!gstbuf->pool)
+        return true;
+
+    guint max_buffers = 0;
+    GstStructure *config = gst_buffer_pool_get_config (gstbuf->pool);
+    gst_buffer_pool_config_get_params (config, NULL, NULL, NULL, &max_buffers);
+    gst_structure_free (config);
+
+    return max_buffers == 0 || max_buffers > xcamfilter->delay_buf_num + 1;
+}
+
+static SmartPtr<VideoBuffer>
+wrap_gstbuf_to_clbuf (GstVideoInfo *gstinfo, GstBuffer *gstbuf)
+{
+    SmartPtr<VideoBuffer> host_buf = gst_xcam_wrap_gst_buffer (gstinfo, gstbuf);
+    if (!host_buf.ptr ())
+        return NULL;
+
+    SmartPtr<CLContext> context = CLDevice::instance ()->get_context ();
+    return convert_host_buf_to_cl_buf (context, host_buf);
+}
+
 static void
 gst_xcam_filter_before_transform (GstBaseTransform *trans, GstBuffer *buffer)
 {
@@ -898,8 +990,13 @@ gst_xcam_filter_before_transform (GstBaseTransform *trans, GstBuffer *buffer)
         return;
 
     SmartPtr<VideoBuffer> video_buf;
+    GstXCamBufferMeta *meta = gst_buffer_get_xcam_buffer_meta (buffer);
     gint dma_fd = get_dmabuf_fd (buffer);
-    if (dma_fd >= 0) {
+    if (meta && meta->buffer.dynamic_cast_ptr<CLVideoBuffer> ().ptr ()) {
+        // written by upstream into sink pool, kernels need it unmapped
+        video_buf = meta->buffer;
+        video_buf->unmap ();
+    } else if (dma_fd >= 0) {
 #if HAVE_LIBDRM
         SmartPtr<DrmBoBufferPool> bo_buf_pool = buf_pool.dynamic_cast_ptr<DrmBoBufferPool> ();
         SmartPtr<DrmDisplay> display = bo_buf_pool->get_drm_display ();
@@ -913,13 +1010,18 @@ gst_xcam_filter_before_transform (GstBaseTransform *trans, GstBuffer *buffer)
             return;
         }
     } else {
-        video_buf = buf_pool->get_buffer (buf_pool);
-        if (!buf_pool.ptr ()) {
-            XCAM_LOG_ERROR ("xcamfilter sink-pad get buffer failed");
-            return;
-        }
+        if (xcamfilter->copy_mode == COPY_MODE_CPU && can_hold_gstbuf (xcamfilter, buffer))
+            video_buf = wrap_gstbuf_to_clbuf (&xcamfilter->gst_sink_video_info, buffer);
+
+        if (!video_buf.ptr ()) {
+            video_buf = buf_pool->get_buffer (buf_pool);
+            if (!video_buf.ptr ()) {
+                XCAM_LOG_ERROR ("xcamfilter sink-pad get buffer failed");
+                return;
+            }
 
-        copy_gstbuf_to_xcambuf (xcamfilter->gst_sink_video_info, buffer, video_buf);
+            copy_gstbuf_to_xcambuf (xcamfilter->gst_sink_video_info, buffer, video_buf);
+        }
     }
 
     if (pipe_manager->push_buffer (video_buf) != XCAM_RETURN_NO_ERROR) {
@@ -954,7 +1056,13 @@ gst_xcam_filter_prepare_output_buffer (GstBaseTransform *trans, GstBuffer *input
     }
 
     if (xcamfilter->copy_mode == COPY_MODE_CPU) {
-        ret = copy_xcambuf_to_gstbuf (xcamfilter->gst_src_video_info, video_buf, outbuf);
+        if (xcamfilter->need_copy &&
+                !gst_xcam_is_default_layout (&xcamfilter->gst_src_video_info, video_buf->get_video_info ())) {
+            ret = copy_xcambuf_to_gstbuf (xcamfilter->gst_src_video_info, video_buf, outbuf);
+        } else {
+            *outbuf = gst_xcam_wrap_video_buffer (video_buf);
+            ret = *outbuf ? GST_FLOW_OK : GST_FLOW_ERROR;
+        }
     } else if (xcamfilter->copy_mode == COPY_MODE_DMA) {
         GstAllocator *allocator = xcamfilter->allocator;
         ret = append_xcambuf_to_gstbuf (allocator, video_buf, outbuf);
@@ -91,7 +91,9 @@ struct _GstXCamFilter
 
     uint32_t                                 delay_buf_num;
     uint32_t                                 cached_buf_num;
+    gboolean                                 need_copy;
     GstAllocator                            *allocator;
+    GstBufferPool                           *sink_pool;
     GstVideoInfo                             gst_sink_video_info;
     GstVideoInfo                             gst_src_video_info;
     XCam::SmartPtr<XCam::BufferPool>         buf_pool;
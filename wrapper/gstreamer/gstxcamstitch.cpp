@@ -0,0 +1,847 @@
+/*
+ * gstxcamstitch.cpp - gst xcamstitch plugin
+ *
+ *  Copyright (c) 2017 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#include "gstxcamstitch.h"
+
+#include <image_handler.h>
+#include <calibration_parser.h>
+#include <xcam_utils.h>
+#include <xcam_obj_debug.h>
+#include <algorithm>
+#include <vector>
+
+using namespace XCam;
+using namespace GstXCam;
+
+#define DEFAULT_CALIB_PATH_ENV              "FISHEYE_CONFIG_PATH"
+#define DEFAULT_CAMERA_POSITION_OFFSET_X    2000.0f
+#define DEFAULT_SYNC_TOLERANCE              (20 * GST_MSECOND)
+// front/right/rear/left rig of default calibration files
+#define DEFAULT_CAMERA_NUM                  4
+
+#define DEFAULT_PROP_BUFFERCOUNT            8
+#define DEFAULT_PROP_IN_FLIGHT              2
+#define DEFAULT_PROP_ENGINE                 StitchEngineStaged
+#define DEFAULT_PROP_SCALE_MODE             ScaleSingleConst
+#define DEFAULT_PROP_ENABLE_SEAM            FALSE
+#define DEFAULT_PROP_SYNC_TOLERANCE         0
+
+XCAM_BEGIN_DECLARE
+
+enum {
+    PROP_0,
+    PROP_BUFFERCOUNT,
+    PROP_IN_FLIGHT,
+    PROP_ENGINE,
+    PROP_SCALE_MODE,
+    PROP_ENABLE_SEAM,
+    PROP_CALIB_PATH,
+    PROP_SYNC_TOLERANCE
+};
+
+#define GST_TYPE_XCAM_STITCH_ENGINE (gst_xcam_stitch_engine_get_type ())
+static GType
+gst_xcam_stitch_engine_get_type (void)
+{
+    static GType g_type = 0;
+    static const GEnumValue engine_types[] = {
+        {StitchEngineStaged, "Dewarp slices, then blend and copy", "staged"},
+        {StitchEngineFusedTiles, "Dewarp, blend and write output tiles", "tiles"},
+        {0, NULL, NULL}
+    };
+
+    if (g_once_init_enter (&g_type)) {
+        const GType type =
+            g_enum_register_static ("GstXCamStitchEngineType", engine_types);
+        g_once_init_leave (&g_type, type);
+    }
+
+    return g_type;
+}
+
+#define GST_TYPE_XCAM_STITCH_SCALE_MODE (gst_xcam_stitch_scale_mode_get_type ())
+static GType
+gst_xcam_stitch_scale_mode_get_type (void)
+{
+    static GType g_type = 0;
+    static const GEnumValue scale_mode_types[] = {
+        {ScaleSingleConst, "Single constant scale factor", "singleconst"},
+        {ScaleDualConst, "Dual constant scale factors", "dualconst"},
+        {ScaleDualCurve, "Dual curve scale factors", "dualcurve"},
+        {0, NULL, NULL}
+    };
+
+    if (g_once_init_enter (&g_type)) {
+        const GType type =
+            g_enum_register_static ("GstXCamStitchScaleModeType", scale_mode_types);
+        g_once_init_leave (&g_type, type);
+    }
+
+    return g_type;
+}
+
+static GstStaticPadTemplate gst_xcam_stitch_sink_factory =
+    GST_STATIC_PAD_TEMPLATE ("sink_%u",
+                             GST_PAD_SINK,
+                             GST_PAD_REQUEST,
+                             GST_STATIC_CAPS (GST_VIDEO_CAPS_MAKE ("{ NV12 }")));
+
+static GstStaticPadTemplate gst_xcam_stitch_src_factory =
+    GST_STATIC_PAD_TEMPLATE ("src",
+                             GST_PAD_SRC,
+                             GST_PAD_ALWAYS,
+                             GST_STATIC_CAPS (GST_VIDEO_CAPS_MAKE ("{ NV12 }")));
+
+GST_DEBUG_CATEGORY (gst_xcam_stitch_debug);
+#define GST_CAT_DEFAULT gst_xcam_stitch_debug
+
+#define gst_xcam_stitch_parent_class parent_class
+G_DEFINE_TYPE (GstXCamStitch, gst_xcam_stitch, GST_TYPE_AGGREGATOR);
+
+static void gst_xcam_stitch_finalize (GObject *object);
+static void gst_xcam_stitch_set_property (GObject *object, guint prop_id, const GValue *value, GParamSpec *pspec);
+static void gst_xcam_stitch_get_property (GObject *object, guint prop_id, GValue *value, GParamSpec *pspec);
+static gboolean gst_xcam_stitch_start (GstAggregator *agg);
+static gboolean gst_xcam_stitch_stop (GstAggregator *agg);
+static GstFlowReturn gst_xcam_stitch_update_src_caps (GstAggregator *agg, GstCaps *caps, GstCaps **ret);
+static gboolean gst_xcam_stitch_negotiated_src_caps (GstAggregator *agg, GstCaps *caps);
+static gboolean gst_xcam_stitch_decide_allocation (GstAggregator *agg, GstQuery *query);
+static GstFlowReturn gst_xcam_stitch_aggregate (GstAggregator *agg, gboolean timeout);
+
+XCAM_END_DECLARE
+
+static void
+gst_xcam_stitch_class_init (GstXCamStitchClass *class_self)
+{
+    GObjectClass *gobject_class;
+    GstElementClass *element_class;
+    GstAggregatorClass *aggregator_class;
+
+    gobject_class = (GObjectClass *) class_self;
+    element_class = (GstElementClass *) class_self;
+    aggregator_class = (GstAggregatorClass *) class_self;
+
+    GST_DEBUG_CATEGORY_INIT (gst_xcam_stitch_debug, "xcamstitch", 0, "LibXCam stitch plugin");
+
+    gobject_class->finalize = gst_xcam_stitch_finalize;
+    gobject_class->set_property = gst_xcam_stitch_set_property;
+    gobject_class->get_property = gst_xcam_stitch_get_property;
+
+    g_object_class_install_property (
+        gobject_class, PROP_BUFFERCOUNT,
+        g_param_spec_int ("buffercount", "buffer count", "Output buffer count",
+                          1, G_MAXINT, DEFAULT_PROP_BUFFERCOUNT,
+                          (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+
+    g_object_class_install_property (
+        gobject_class, PROP_IN_FLIGHT,
+        g_param_spec_uint ("in-flight", "in flight frames",
+                           "Frames stitched or waiting in stitcher, counted in latency",
+                           1, G_MAXUINT, DEFAULT_PROP_IN_FLIGHT,
+                           (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+
+    g_object_class_install_property (
+        gobject_class, PROP_ENGINE,
+        g_param_spec_enum ("engine", "stitch engine", "Stitch engine",
+                           GST_TYPE_XCAM_STITCH_ENGINE, DEFAULT_PROP_ENGINE,
+                           (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+
+    g_object_class_install_property (
+        gobject_class, PROP_SCALE_MODE,
+        g_param_spec_enum ("scale-mode", "scale mode", "Geometric map scale mode",
+                           GST_TYPE_XCAM_STITCH_SCALE_MODE, DEFAULT_PROP_SCALE_MODE,
+                           (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+
+    g_object_class_install_property (
+        gobject_class, PROP_ENABLE_SEAM,
+        g_param_spec_boolean ("seam", "enable seam", "Enable seam finding in overlaps",
+                              DEFAULT_PROP_ENABLE_SEAM, (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+
+    g_object_class_install_property (
+        gobject_class, PROP_CALIB_PATH,
+        g_param_spec_string ("calib-path", "calibration path",
+                             "Calibration files path, $" DEFAULT_CALIB_PATH_ENV " if not set",
+                             NULL, (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+
+    g_object_class_install_property (
+        gobject_class, PROP_SYNC_TOLERANCE,
+        g_param_spec_uint64 ("sync-tolerance", "sync tolerance",
+                             "Max running time difference of one frame set in ns, 0 is half frame duration",
+                             0, G_MAXUINT64, DEFAULT_PROP_SYNC_TOLERANCE,
+                             (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+
+    gst_element_class_set_details_simple (element_class,
+                                          "Libxcam Stitch",
+                                          "Filter/Effect/Video",
+                                          "Stitch NV12 streams of cameras into a panorama using xcam library",
+                                          "Wind Yuan <feng.yuan@intel.com>");
+
+    gst_element_class_add_static_pad_template_with_gtype (
+        element_class, &gst_xcam_stitch_src_factory, GST_TYPE_AGGREGATOR_PAD);
+    gst_element_class_add_static_pad_template_with_gtype (
+        element_class, &gst_xcam_stitch_sink_factory, GST_TYPE_AGGREGATOR_PAD);
+
+    aggregator_class->start = GST_DEBUG_FUNCPTR (gst_xcam_stitch_start);
+    aggregator_class->stop = GST_DEBUG_FUNCPTR (gst_xcam_stitch_stop);
+    aggregator_class->update_src_caps = GST_DEBUG_FUNCPTR (gst_xcam_stitch_update_src_caps);
+    aggregator_class->negotiated_src_caps = GST_DEBUG_FUNCPTR (gst_xcam_stitch_negotiated_src_caps);
+    aggregator_class->decide_allocation = GST_DEBUG_FUNCPTR (gst_xcam_stitch_decide_allocation);
+    aggregator_class->aggregate = GST_DEBUG_FUNCPTR (gst_xcam_stitch_aggregate);
+}
+
+static void
+gst_xcam_stitch_init (GstXCamStitch *xcamstitch)
+{
+    xcamstitch->buf_count = DEFAULT_PROP_BUFFERCOUNT;
+    xcamstitch->in_flight = DEFAULT_PROP_IN_FLIGHT;
+    xcamstitch->engine = DEFAULT_PROP_ENGINE;
+    xcamstitch->scale_mode = DEFAULT_PROP_SCALE_MODE;
+    xcamstitch->enable_seam = DEFAULT_PROP_ENABLE_SEAM;
+    xcamstitch->calib_path = NULL;
+    xcamstitch->sync_tolerance = DEFAULT_PROP_SYNC_TOLERANCE;
+
+    xcamstitch->need_copy = FALSE;
+    xcamstitch->camera_num = 0;
+    xcamstitch->dropped_num = 0;
+
+    XCAM_CONSTRUCTOR (xcamstitch->stitch_manager, SmartPtr<MainStitchManager>);
+    SmartPtr<MainStitchManager> stitch_manager = new MainStitchManager;
+    XCAM_ASSERT (stitch_manager.ptr ());
+    xcamstitch->stitch_manager = stitch_manager;
+}
+
+static void
+gst_xcam_stitch_finalize (GObject *object)
+{
+    GstXCamStitch *xcamstitch = GST_XCAM_STITCH (object);
+
+    g_free (xcamstitch->calib_path);
+
+    xcamstitch->stitch_manager.release ();
+    XCAM_DESTRUCTOR (xcamstitch->stitch_manager, SmartPtr<MainStitchManager>);
+
+    G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static void
+gst_xcam_stitch_set_property (GObject *object, guint prop_id, const GValue *value, GParamSpec *pspec)
+{
+    GstXCamStitch *xcamstitch = GST_XCAM_STITCH (object);
+
+    switch (prop_id) {
+    case PROP_BUFFERCOUNT:
+        xcamstitch->buf_count = g_value_get_int (value);
+        break;
+    case PROP_IN_FLIGHT:
+        xcamstitch->in_flight = g_value_get_uint (value);
+        break;
+    case PROP_ENGINE:
+        xcamstitch->engine = (StitchEngine) g_value_get_enum (value);
+        break;
+    case PROP_SCALE_MODE:
+        xcamstitch->scale_mode = (GeoMapScaleMode) g_value_get_enum (value);
+        break;
+    case PROP_ENABLE_SEAM:
+        xcamstitch->enable_seam = g_value_get_boolean (value);
+        break;
+    case PROP_CALIB_PATH:
+        g_free (xcamstitch->calib_path);
+        xcamstitch->calib_path = g_value_dup_string (value);
+        break;
+    case PROP_SYNC_TOLERANCE:
+        xcamstitch->sync_tolerance = g_value_get_uint64 (value);
+        break;
+    default:
+        G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+        break;
+    }
+}
+
+static void
+gst_xcam_stitch_get_property (GObject *object, guint prop_id, GValue *value, GParamSpec *pspec)
+{
+    GstXCamStitch *xcamstitch = GST_XCAM_STITCH (object);
+
+    switch (prop_id) {
+    case PROP_BUFFERCOUNT:
+        g_value_set_int (value, xcamstitch->buf_count);
+        break;
+    case PROP_IN_FLIGHT:
+        g_value_set_uint (value, xcamstitch->in_flight);
+        break;
+    case PROP_ENGINE:
+        g_value_set_enum (value, xcamstitch->engine);
+        break;
+    case PROP_SCALE_MODE:
+        g_value_set_enum (value, xcamstitch->scale_mode);
+        break;
+    case PROP_ENABLE_SEAM:
+        g_value_set_boolean (value, xcamstitch->enable_seam);
+        break;
+    case PROP_CALIB_PATH:
+        g_value_set_string (value, xcamstitch->calib_path);
+        break;
+    case PROP_SYNC_TOLERANCE:
+        g_value_set_uint64 (value, xcamstitch->sync_tolerance);
+        break;
+    default:
+        G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+        break;
+    }
+}
+
+static gboolean
+gst_xcam_stitch_start (GstAggregator *agg)
+{
+    GstXCamStitch *xcamstitch = GST_XCAM_STITCH (agg);
+
+    if (xcamstitch->buf_count <= xcamstitch->in_flight) {
+        XCAM_LOG_ERROR (
+            "buffer count (%d) should be greater than in-flight frames (%d)",
+            xcamstitch->buf_count, xcamstitch->in_flight);
+        return false;
+    }
+
+    SmartPtr<MainStitchManager> stitch_manager = xcamstitch->stitch_manager;
+    if (!stitch_manager->set_in_flight (xcamstitch->in_flight))
+        return false;
+
+    xcamstitch->dropped_num = 0;
+    return true;
+}
+
+static gboolean
+gst_xcam_stitch_stop (GstAggregator *agg)
+{
+    GstXCamStitch *xcamstitch = GST_XCAM_STITCH (agg);
+
+    SmartPtr<MainStitchManager> stitch_manager = xcamstitch->stitch_manager;
+    if (stitch_manager.ptr ())
+        stitch_manager->stop ();
+
+    if (xcamstitch->dropped_num)
+        XCAM_LOG_INFO ("xcamstitch dropped %d unsynchronized frames", xcamstitch->dropped_num);
+
+    return true;
+}
+
+static uint32_t
+get_sink_pad_index (GstAggregatorPad *pad)
+{
+    uint32_t index = 0;
+    const gchar *name = GST_PAD_NAME (pad);
+    if (!name || sscanf (name, "sink_%u", &index) != 1)
+        return (uint32_t)(-1);
+    return index;
+}
+
+static bool
+sink_pad_less (GstAggregatorPad *pad0, GstAggregatorPad *pad1)
+{
+    return get_sink_pad_index (pad0) < get_sink_pad_index (pad1);
+}
+
+// sink pads in index order of pad names, caller unrefs them
+static std::vector<GstAggregatorPad *>
+get_sink_pads (GstXCamStitch *xcamstitch)
+{
+    std::vector<GstAggregatorPad *> pads;
+
+    GST_OBJECT_LOCK (xcamstitch);
+    for (GList *l = GST_ELEMENT (xcamstitch)->sinkpads; l; l = l->next)
+        pads.push_back (GST_AGGREGATOR_PAD (gst_object_ref (l->data)));
+    GST_OBJECT_UNLOCK (xcamstitch);
+
+    std::sort (pads.begin (), pads.end (), sink_pad_less);
+    return pads;
+}
+
+static void
+unref_sink_pads (std::vector<GstAggregatorPad *> &pads)
+{
+    for (size_t i = 0; i < pads.size (); ++i)
+        gst_object_unref (pads[i]);
+    pads.clear ();
+}
+
+static GstFlowReturn
+gst_xcam_stitch_update_src_caps (GstAggregator *agg, GstCaps *caps, GstCaps **ret)
+{
+    GstXCamStitch *xcamstitch = GST_XCAM_STITCH (agg);
+    std::vector<GstAggregatorPad *> pads = get_sink_pads (xcamstitch);
+    GstCaps *sink_caps = pads.empty () ? NULL : gst_pad_get_current_caps (GST_PAD (pads[0]));
+    unref_sink_pads (pads);
+
+    if (!sink_caps)
+        return GST_AGGREGATOR_FLOW_NEED_DATA;
+
+    GstVideoInfo in_info;
+    gboolean parsed = gst_video_info_from_caps (&in_info, sink_caps);
+    gst_caps_unref (sink_caps);
+    if (!parsed) {
+        XCAM_LOG_ERROR ("xcamstitch parse sink caps failed");
+        return GST_FLOW_NOT_NEGOTIATED;
+    }
+
+    // output is a 2:1 panorama of input width unless downstream asks for others
+    *ret = gst_caps_truncate (gst_caps_copy (caps));
+    *ret = gst_caps_make_writable (*ret);
+    GstStructure *src_struct = gst_caps_get_structure (*ret, 0);
+    gint src_width = GST_VIDEO_INFO_WIDTH (&in_info);
+    gst_structure_fixate_field_nearest_int (src_struct, "width", src_width);
+    gst_structure_get_int (src_struct, "width", &src_width);
+    gst_structure_fixate_field_nearest_int (src_struct, "height", XCAM_ALIGN_UP (src_width / 2, 16));
+    gst_structure_fixate_field_nearest_fraction (
+        src_struct, "framerate", GST_VIDEO_INFO_FPS_N (&in_info), GST_VIDEO_INFO_FPS_D (&in_info));
+    *ret = gst_caps_fixate (*ret);
+
+    return GST_FLOW_OK;
+}
+
+// calibration files are intrinsic_camera_<idx>.txt and extrinsic_camera_<idx>.txt,
+// 4 camera rigs also take front/right/rear/left names
+static bool
+parse_camera_info (const char *path, uint32_t idx, uint32_t camera_num, CameraInfo &info)
+{
+    static const char *intrinsic_names[] = {
+        "intrinsic_camera_front.txt", "intrinsic_camera_right.txt",
+        "intrinsic_camera_rear.txt", "intrinsic_camera_left.txt"
+    };
+    static const char *extrinsic_names[] = {
+        "extrinsic_camera_front.txt", "extrinsic_camera_right.txt",
+        "extrinsic_camera_rear.txt", "extrinsic_camera_left.txt"
+    };
+    static const float viewpoints_range[] = {64.0f, 160.0f, 64.0f, 160.0f};
+
+    char intrinsic_path[XCAM_MAX_STR_SIZE] = {'\0'};
+    char extrinsic_path[XCAM_MAX_STR_SIZE] = {'\0'};
+    snprintf (intrinsic_path, XCAM_MAX_STR_SIZE, "%s/intrinsic_camera_%d.txt", path, idx);
+    snprintf (extrinsic_path, XCAM_MAX_STR_SIZE, "%s/extrinsic_camera_%d.txt", path, idx);
+    if (camera_num == DEFAULT_CAMERA_NUM && !g_file_test (intrinsic_path, G_FILE_TEST_EXISTS)) {
+        snprintf (intrinsic_path, XCAM_MAX_STR_SIZE, "%s/%s", path, intrinsic_names[idx]);
+        snprintf (extrinsic_path, XCAM_MAX_STR_SIZE, "%s/%s", path, extrinsic_names[idx]);
+    }
+
+    CalibrationParser parser;
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (parser.parse_intrinsic_file (intrinsic_path, info.calibration.intrinsic)), false,
+        "xcamstitch parse intrinsic params (%s) failed", intrinsic_path);
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (parser.parse_extrinsic_file (extrinsic_path, info.calibration.extrinsic)), false,
+        "xcamstitch parse extrinsic params (%s) failed", extrinsic_path);
+    info.calibration.extrinsic.trans_x += DEFAULT_CAMERA_POSITION_OFFSET_X;
+
+    // cameras of other rigs overlap half of their share with neighbors
+    if (camera_num == DEFAULT_CAMERA_NUM)
+        info.angle_range = viewpoints_range[idx];
+    else
+        info.angle_range = 360.0f / camera_num * 1.5f;
+    info.round_angle_start = (idx * 360.0f / camera_num) - info.angle_range / 2.0f;
+    return true;
+}
+
+static SmartPtr<Stitcher>
+create_stitcher (GstXCamStitch *xcamstitch)
+{
+    const char *calib_path = xcamstitch->calib_path;
+    if (!calib_path)
+        calib_path = g_getenv (DEFAULT_CALIB_PATH_ENV);
+    XCAM_FAIL_RETURN (
+        ERROR, calib_path, NULL,
+        "xcamstitch needs calib-path or $%s of calibration files", DEFAULT_CALIB_PATH_ENV);
+
+    uint32_t camera_num = xcamstitch->camera_num;
+    std::vector<CameraInfo> cam_info (camera_num);
+    for (uint32_t i = 0; i < camera_num; ++i) {
+        if (!parse_camera_info (calib_path, i, camera_num, cam_info[i]))
+            return NULL;
+    }
+
+    PointFloat3 bowl_coord_offset;
+    if (camera_num == DEFAULT_CAMERA_NUM) {
+        centralize_bowl_coord_from_cameras (
+            cam_info[0].calibration.extrinsic, cam_info[1].calibration.extrinsic,
+            cam_info[2].calibration.extrinsic, cam_info[3].calibration.extrinsic,
+            bowl_coord_offset);
+    } else {
+        // bowl center is the center of all cameras
+        for (uint32_t i = 0; i < camera_num; ++i) {
+            bowl_coord_offset.x += cam_info[i].calibration.extrinsic.trans_x / camera_num;
+            bowl_coord_offset.y += cam_info[i].calibration.extrinsic.trans_y / camera_num;
+        }
+        for (uint32_t i = 0; i < camera_num; ++i) {
+            cam_info[i].calibration.extrinsic.trans_x -= bowl_coord_offset.x;
+            cam_info[i].calibration.extrinsic.trans_y -= bowl_coord_offset.y;
+        }
+    }
+
+    SmartPtr<Stitcher> stitcher = Stitcher::create_soft_stitcher (xcamstitch->engine);
+    XCAM_FAIL_RETURN (ERROR, stitcher.ptr (), NULL, "xcamstitch create soft stitcher failed");
+
+    stitcher->set_camera_num (camera_num);
+    for (uint32_t i = 0; i < camera_num; ++i) {
+        stitcher->set_camera_info (i, cam_info[i]);
+    }
+
+    BowlDataConfig bowl;
+    bowl.wall_height = 3000.0f;
+    bowl.ground_length = 2000.0f;
+    bowl.angle_start = 0.0f;
+    bowl.angle_end = 360.0f;
+    stitcher->set_bowl_config (bowl);
+
+    uint32_t out_width = GST_VIDEO_INFO_WIDTH (&xcamstitch->gst_src_video_info);
+    uint32_t out_height = GST_VIDEO_INFO_HEIGHT (&xcamstitch->gst_src_video_info);
+    stitcher->set_output_size (out_width, out_height);
+    stitcher->set_scale_mode (xcamstitch->scale_mode);
+    stitcher->set_need_seam (xcamstitch->enable_seam);
+
+    // outputs are taken from stitcher's buffer pool and go back when downstream frees them
+    SmartPtr<ImageHandler> handler = stitcher.dynamic_cast_ptr<ImageHandler> ();
+    XCAM_ASSERT (handler.ptr ());
+    VideoBufferInfo out_info;
+    out_info.init (V4L2_PIX_FMT_NV12, out_width, out_height);
+    handler->set_out_video_info (out_info);
+    handler->enable_allocator (true, xcamstitch->buf_count);
+
+    XCAM_LOG_INFO ("xcamstitch output size width:%d height:%d", out_width, out_height);
+    return stitcher;
+}
+
+static gboolean
+gst_xcam_stitch_negotiated_src_caps (GstAggregator *agg, GstCaps *caps)
+{
+    GstXCamStitch *xcamstitch = GST_XCAM_STITCH (agg);
+    GstVideoInfo out_info;
+
+    if (!gst_video_info_from_caps (&out_info, caps)) {
+        XCAM_LOG_WARNING ("xcamstitch fail to parse src caps");
+        return false;
+    }
+
+    std::vector<GstAggregatorPad *> pads = get_sink_pads (xcamstitch);
+    if (pads.size () < 2 || pads.size () > XCAM_STITCH_MAX_CAMERAS) {
+        XCAM_LOG_ERROR (
+            "xcamstitch needs 2~%d sink pads of cameras, but got %d",
+            XCAM_STITCH_MAX_CAMERAS, (int)pads.size ());
+        unref_sink_pads (pads);
+        return false;
+    }
+    // pad index is camera index of calibration files
+    for (size_t i = 0; i < pads.size (); ++i) {
+        if (get_sink_pad_index (pads[i]) != i) {
+            XCAM_LOG_ERROR (
+                "xcamstitch sink pads need indices 0~%d of cameras, but got pad %s",
+                (int)pads.size () - 1, GST_PAD_NAME (pads[i]));
+            unref_sink_pads (pads);
+            return false;
+        }
+    }
+    uint32_t camera_num = pads.size ();
+
+    GstVideoInfo in_info;
+    gboolean same_caps = true;
+    for (size_t i = 0; i < pads.size () && same_caps; ++i) {
+        GstCaps *sink_caps = gst_pad_get_current_caps (GST_PAD (pads[i]));
+        GstVideoInfo pad_info;
+        same_caps = sink_caps && gst_video_info_from_caps (&pad_info, sink_caps) &&
+                    (i == 0 || gst_video_info_is_equal (&pad_info, &in_info));
+        if (i == 0)
+            in_info = pad_info;
+        if (sink_caps)
+            gst_caps_unref (sink_caps);
+    }
+    unref_sink_pads (pads);
+    XCAM_FAIL_RETURN (
+        ERROR, same_caps, false,
+        "xcamstitch sink pads need same NV12 caps");
+
+    xcamstitch->gst_sink_video_info = in_info;
+    xcamstitch->gst_src_video_info = out_info;
+    xcamstitch->camera_num = camera_num;
+
+    SmartPtr<MainStitchManager> stitch_manager = xcamstitch->stitch_manager;
+    stitch_manager->stop ();
+
+    SmartPtr<Stitcher> stitcher = create_stitcher (xcamstitch);
+    if (!stitcher.ptr ())
+        return false;
+
+    if (stitch_manager->start (stitcher) != XCAM_RETURN_NO_ERROR) {
+        XCAM_LOG_ERROR ("xcamstitch stitch manager start failed");
+        return false;
+    }
+
+    // outputs are pushed in-flight frames after their inputs
+    if (GST_VIDEO_INFO_FPS_N (&out_info) > 0 && GST_VIDEO_INFO_FPS_D (&out_info) > 0) {
+        GstClockTime latency = gst_util_uint64_scale_int (
+                                   GST_SECOND * xcamstitch->in_flight,
+                                   GST_VIDEO_INFO_FPS_D (&out_info), GST_VIDEO_INFO_FPS_N (&out_info));
+        gst_aggregator_set_latency (agg, latency, latency);
+    }
+
+    return true;
+}
+
+static gboolean
+gst_xcam_stitch_decide_allocation (GstAggregator *agg, GstQuery *query)
+{
+    GstXCamStitch *xcamstitch = GST_XCAM_STITCH (agg);
+
+    VideoBufferInfo out_info;
+    out_info.init (
+        V4L2_PIX_FMT_NV12,
+        GST_VIDEO_INFO_WIDTH (&xcamstitch->gst_src_video_info),
+        GST_VIDEO_INFO_HEIGHT (&xcamstitch->gst_src_video_info));
+
+    // stitcher strides are kept in video meta, copy only if downstream can't read them
+    xcamstitch->need_copy =
+        !gst_query_find_allocation_meta (query, GST_VIDEO_META_API_TYPE, NULL) &&
+        !gst_xcam_is_default_layout (&xcamstitch->gst_src_video_info, out_info);
+    if (xcamstitch->need_copy)
+        XCAM_LOG_WARNING ("xcamstitch downstream doesn't support video meta, outputs are copied");
+
+    return true;
+}
+
+static GstBuffer *
+copy_to_default_layout (GstVideoInfo *gst_info, GstBuffer *src_buf)
+{
+    GstBuffer *dest_buf = gst_buffer_new_allocate (NULL, GST_VIDEO_INFO_SIZE (gst_info), NULL);
+    XCAM_FAIL_RETURN (ERROR, dest_buf, NULL, "xcamstitch allocate buffer failed");
+
+    GstVideoFrame src_frame, dest_frame;
+    if (!gst_video_frame_map (&src_frame, gst_info, src_buf, GST_MAP_READ)) {
+        gst_buffer_unref (dest_buf);
+        XCAM_LOG_ERROR ("xcamstitch map output buffer failed");
+        return NULL;
+    }
+    if (!gst_video_frame_map (&dest_frame, gst_info, dest_buf, GST_MAP_WRITE)) {
+        gst_video_frame_unmap (&src_frame);
+        gst_buffer_unref (dest_buf);
+        XCAM_LOG_ERROR ("xcamstitch map copied buffer failed");
+        return NULL;
+    }
+
+    gst_video_frame_copy (&dest_frame, &src_frame);
+    gst_video_frame_unmap (&dest_frame);
+    gst_video_frame_unmap (&src_frame);
+    return dest_buf;
+}
+
+// timeout in microseconds, 0 pushes a frame only if it was done
+static GstFlowReturn
+push_done_frame (GstXCamStitch *xcamstitch, int32_t timeout)
+{
+    SmartPtr<MainStitchManager> stitch_manager = xcamstitch->stitch_manager;
+    SmartPtr<StitchFrame> frame = stitch_manager->pop_done (timeout);
+    if (!frame.ptr ())
+        return GST_FLOW_OK;
+
+    if (!xcam_ret_is_ok (frame->error) || !frame->out_buf.ptr ()) {
+        GST_ELEMENT_ERROR (xcamstitch, STREAM, FAILED, (NULL), ("stitch frame failed, error:%d", (int)frame->error));
+        return GST_FLOW_ERROR;
+    }
+
+    GstBuffer *out_buf = gst_xcam_wrap_video_buffer (frame->out_buf);
+    if (out_buf && xcamstitch->need_copy) {
+        GstBuffer *copied = copy_to_default_layout (&xcamstitch->gst_src_video_info, out_buf);
+        gst_buffer_unref (out_buf);
+        out_buf = copied;
+    }
+    if (!out_buf) {
+        GST_ELEMENT_ERROR (xcamstitch, STREAM, FAILED, (NULL), ("convert stitched frame to gst buffer failed"));
+        return GST_FLOW_ERROR;
+    }
+
+    GST_BUFFER_PTS (out_buf) = frame->pts;
+    GST_BUFFER_DURATION (out_buf) = frame->duration;
+
+    GstAggregatorPad *srcpad = GST_AGGREGATOR_PAD (GST_AGGREGATOR_SRC_PAD (xcamstitch));
+    if (GST_CLOCK_TIME_IS_VALID (frame->pts)) {
+        srcpad->segment.position = frame->pts;
+        if (GST_CLOCK_TIME_IS_VALID (frame->duration))
+            srcpad->segment.position += frame->duration;
+    }
+
+    XCAM_STATIC_FPS_CALCULATION (gstxcamstitch, XCAM_OBJ_DUR_FRAME_NUM);
+    return gst_aggregator_finish_buffer (GST_AGGREGATOR (xcamstitch), out_buf);
+}
+
+static GstFlowReturn
+drain_frames (GstXCamStitch *xcamstitch)
+{
+    SmartPtr<MainStitchManager> stitch_manager = xcamstitch->stitch_manager;
+    GstFlowReturn ret = GST_FLOW_OK;
+
+    while (ret == GST_FLOW_OK && stitch_manager->get_frame_count ())
+        ret = push_done_frame (xcamstitch, -1);
+
+    return ret;
+}
+
+static GstClockTime
+get_sync_tolerance (GstXCamStitch *xcamstitch)
+{
+    if (xcamstitch->sync_tolerance)
+        return xcamstitch->sync_tolerance;
+
+    GstVideoInfo *info = &xcamstitch->gst_sink_video_info;
+    if (GST_VIDEO_INFO_FPS_N (info) > 0 && GST_VIDEO_INFO_FPS_D (info) > 0)
+        return gst_util_uint64_scale_int (GST_SECOND / 2, GST_VIDEO_INFO_FPS_D (info), GST_VIDEO_INFO_FPS_N (info));
+
+    return DEFAULT_SYNC_TOLERANCE;
+}
+
+/* buffers on head of sink pads are one frame set if their running time are in sync tolerance of
+ * the latest one, older heads are dropped till sets match; on timeout of live sources incomplete
+ * sets are dropped.
+ */
+static GstFlowReturn
+gst_xcam_stitch_aggregate (GstAggregator *agg, gboolean timeout)
+{
+    GstXCamStitch *xcamstitch = GST_XCAM_STITCH (agg);
+    SmartPtr<MainStitchManager> stitch_manager = xcamstitch->stitch_manager;
+
+    GstFlowReturn ret = push_done_frame (xcamstitch, 0);
+    if (ret != GST_FLOW_OK)
+        return ret;
+
+    std::vector<GstAggregatorPad *> pads = get_sink_pads (xcamstitch);
+    if (pads.size () != xcamstitch->camera_num) {
+        unref_sink_pads (pads);
+        GST_ELEMENT_ERROR (xcamstitch, CORE, NEGOTIATION, (NULL), ("sink pads changed while stitching"));
+        return GST_FLOW_NOT_NEGOTIATED;
+    }
+
+    std::vector<GstClockTime> times (pads.size (), GST_CLOCK_TIME_NONE);
+    GstClockTime latest = GST_CLOCK_TIME_NONE;
+    gboolean is_eos = false, is_complete = true;
+    for (size_t i = 0; i < pads.size (); ++i) {
+        GstBuffer *buf = gst_aggregator_pad_peek_buffer (pads[i]);
+        if (!buf) {
+            is_eos = is_eos || gst_aggregator_pad_is_eos (pads[i]);
+            is_complete = false;
+            continue;
+        }
+
+        times[i] = gst_segment_to_running_time (&pads[i]->segment, GST_FORMAT_TIME, GST_BUFFER_PTS (buf));
+        if (GST_CLOCK_TIME_IS_VALID (times[i]) && (!GST_CLOCK_TIME_IS_VALID (latest) || times[i] > latest))
+            latest = times[i];
+        gst_buffer_unref (buf);
+    }
+
+    // a panorama needs all cameras
+    if (is_eos) {
+        unref_sink_pads (pads);
+        ret = drain_frames (xcamstitch);
+        return (ret == GST_FLOW_OK) ? GST_FLOW_EOS : ret;
+    }
+
+    if (!is_complete) {
+        if (timeout) {
+            for (size_t i = 0; i < pads.size (); ++i)
+                gst_aggregator_pad_drop_buffer (pads[i]);
+            ++xcamstitch->dropped_num;
+        }
+        unref_sink_pads (pads);
+        return GST_FLOW_OK;
+    }
+
+    GstClockTime tolerance = get_sync_tolerance (xcamstitch);
+    gboolean dropped = false;
+    for (size_t i = 0; i < pads.size (); ++i) {
+        if (GST_CLOCK_TIME_IS_VALID (latest) &&
+                (!GST_CLOCK_TIME_IS_VALID (times[i]) || latest - times[i] > tolerance)) {
+            gst_aggregator_pad_drop_buffer (pads[i]);
+            dropped = true;
+        }
+    }
+    if (dropped) {
+        ++xcamstitch->dropped_num;
+        unref_sink_pads (pads);
+        return GST_FLOW_OK;
+    }
+
+    // pushes the oldest frames out to keep in-flight depth
+    while (ret == GST_FLOW_OK && stitch_manager->get_frame_count () >= stitch_manager->get_in_flight ())
+        ret = push_done_frame (xcamstitch, -1);
+    if (ret != GST_FLOW_OK) {
+        unref_sink_pads (pads);
+        return ret;
+    }
+
+    SmartPtr<StitchFrame> frame = new StitchFrame;
+    XCAM_ASSERT (frame.ptr ());
+    frame->pts = latest;
+    for (size_t i = 0; i < pads.size (); ++i) {
+        GstBuffer *buf = gst_aggregator_pad_pop_buffer (pads[i]);
+        XCAM_ASSERT (buf);
+        if (i == 0)
+            frame->duration = GST_BUFFER_DURATION (buf);
+
+        SmartPtr<VideoBuffer> video_buf = gst_xcam_wrap_gst_buffer (&xcamstitch->gst_sink_video_info, buf);
+        gst_buffer_unref (buf);
+
+        if (!video_buf.ptr ()) {
+            unref_sink_pads (pads);
+            GST_ELEMENT_ERROR (xcamstitch, STREAM, FAILED, (NULL), ("wrap sink buffer(idx:%d) failed", (int)i));
+            return GST_FLOW_ERROR;
+        }
+        frame->in_bufs.push_back (video_buf);
+    }
+    unref_sink_pads (pads);
+
+    if (!GST_CLOCK_TIME_IS_VALID (frame->duration)) {
+        GstVideoInfo *info = &xcamstitch->gst_src_video_info;
+        if (GST_VIDEO_INFO_FPS_N (info) > 0 && GST_VIDEO_INFO_FPS_D (info) > 0)
+            frame->duration = gst_util_uint64_scale_int (GST_SECOND, GST_VIDEO_INFO_FPS_D (info), GST_VIDEO_INFO_FPS_N (info));
+    }
+
+    if (stitch_manager->push_frame (frame) != XCAM_RETURN_NO_ERROR) {
+        GST_ELEMENT_ERROR (xcamstitch, STREAM, FAILED, (NULL), ("push frame to stitcher failed"));
+        return GST_FLOW_ERROR;
+    }
+
+    return GST_FLOW_OK;
+}
+
+static gboolean
+gst_xcam_stitch_plugin_init (GstPlugin *xcamstitch)
+{
+    return gst_element_register (xcamstitch, "xcamstitch", GST_RANK_NONE,
+                                 GST_TYPE_XCAM_STITCH);
+}
+
+#ifndef PACKAGE
+#define PACKAGE "libxam"
+#endif
+
+GST_PLUGIN_DEFINE (
+    GST_VERSION_MAJOR,
+    GST_VERSION_MINOR,
+    xcamstitch,
+    "Libxcam stitch plugin",
+    gst_xcam_stitch_plugin_init,
+    VERSION,
+    GST_LICENSE_UNKNOWN,
+    "libxcamstitch",
+    "https://github.com/intel/libxcam"
+)
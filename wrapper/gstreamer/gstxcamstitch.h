@@ -0,0 +1,73 @@
+/*
+ * gstxcamstitch.h - gst xcamstitch plugin
+ *
+ *  Copyright (c) 2017 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#ifndef GST_XCAM_STITCH_H
+#define GST_XCAM_STITCH_H
+
+#include <gst/gst.h>
+#include <gst/video/video.h>
+#include <gst/base/gstaggregator.h>
+
+#include "main_stitch_manager.h"
+#include "gst_xcam_utils.h"
+
+XCAM_BEGIN_DECLARE
+
+#define GST_TYPE_XCAM_STITCH             (gst_xcam_stitch_get_type())
+#define GST_XCAM_STITCH(obj)             (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_XCAM_STITCH,GstXCamStitch))
+#define GST_XCAM_STITCH_CAST(obj)        ((GstXCamStitch *) obj)
+
+typedef struct _GstXCamStitch      GstXCamStitch;
+typedef struct _GstXCamStitchClass GstXCamStitchClass;
+
+/* each sink pad is one camera, sink_N takes calibration files of camera N (front/right/rear/left
+ * names also work for 4 cameras), pads have to be sink_0 ~ sink_(num - 1) of 2~XCAM_STITCH_MAX_CAMERAS,
+ * a set of buffers with same running time (in sync-tolerance) is stitched into one output.
+ */
+struct _GstXCamStitch
+{
+    GstAggregator                              aggregator;
+
+    uint32_t                                   buf_count;
+    uint32_t                                   in_flight;
+    XCam::StitchEngine                         engine;
+    XCam::GeoMapScaleMode                      scale_mode;
+    gboolean                                   enable_seam;
+    gchar                                     *calib_path;
+    guint64                                    sync_tolerance;
+
+    gboolean                                   need_copy;
+    uint32_t                                   camera_num;
+    uint32_t                                   dropped_num;
+    GstVideoInfo                               gst_sink_video_info;
+    GstVideoInfo                               gst_src_video_info;
+    XCam::SmartPtr<GstXCam::MainStitchManager> stitch_manager;
+};
+
+struct _GstXCamStitchClass
+{
+    GstAggregatorClass parent_class;
+};
+
+GType gst_xcam_stitch_get_type (void);
+
+XCAM_END_DECLARE
+
+#endif // GST_XCAM_STITCH_H
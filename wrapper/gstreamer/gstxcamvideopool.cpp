@@ -0,0 +1,221 @@
+/*
+ * gstxcamvideopool.cpp - gst buffer pool backed by xcam buffer pool
+ *
+ *  Copyright (c) 2017 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#include "gstxcamvideopool.h"
+#include "gstxcambuffermeta.h"
+#include "gst_xcam_utils.h"
+
+#include <gst/video/gstvideopool.h>
+
+using namespace XCam;
+
+XCAM_BEGIN_DECLARE
+
+GST_DEBUG_CATEGORY_STATIC (gst_xcam_video_pool_debug);
+#define GST_CAT_DEFAULT gst_xcam_video_pool_debug
+
+G_DEFINE_TYPE (GstXCamVideoPool, gst_xcam_video_pool, GST_TYPE_BUFFER_POOL);
+#define parent_class gst_xcam_video_pool_parent_class
+
+static void
+gst_xcam_video_pool_finalize (GObject *object);
+
+static const gchar **
+gst_xcam_video_pool_get_options (GstBufferPool *pool);
+
+static gboolean
+gst_xcam_video_pool_start (GstBufferPool *pool);
+
+static gboolean
+gst_xcam_video_pool_stop (GstBufferPool *pool);
+
+static gboolean
+gst_xcam_video_pool_set_config (GstBufferPool *pool, GstStructure *config);
+
+static GstFlowReturn
+gst_xcam_video_pool_acquire_buffer (
+    GstBufferPool *bpool,
+    GstBuffer **buffer,
+    GstBufferPoolAcquireParams *params);
+
+static void
+gst_xcam_video_pool_release_buffer (GstBufferPool *bpool, GstBuffer *buffer);
+
+XCAM_END_DECLARE
+
+static void
+gst_xcam_video_pool_class_init (GstXCamVideoPoolClass *class_self)
+{
+    GObjectClass *object_class;
+    GstBufferPoolClass *bufferpool_class;
+
+    object_class = G_OBJECT_CLASS (class_self);
+    bufferpool_class = GST_BUFFER_POOL_CLASS (class_self);
+
+    GST_DEBUG_CATEGORY_INIT (gst_xcam_video_pool_debug, "xcamvideopool", 0, "LibXCam video buffer pool");
+
+    object_class->finalize = gst_xcam_video_pool_finalize;
+
+    bufferpool_class->get_options = gst_xcam_video_pool_get_options;
+    bufferpool_class->start = gst_xcam_video_pool_start;
+    bufferpool_class->stop = gst_xcam_video_pool_stop;
+    bufferpool_class->set_config = gst_xcam_video_pool_set_config;
+    bufferpool_class->acquire_buffer = gst_xcam_video_pool_acquire_buffer;
+    bufferpool_class->release_buffer = gst_xcam_video_pool_release_buffer;
+}
+
+static void
+gst_xcam_video_pool_init (GstXCamVideoPool *pool)
+{
+    gst_video_info_init (&pool->gst_video_info);
+    pool->need_video_meta = FALSE;
+    XCAM_CONSTRUCTOR (pool->buf_pool, SmartPtr<BufferPool>);
+}
+
+static void
+gst_xcam_video_pool_finalize (GObject *object)
+{
+    GstXCamVideoPool *pool = GST_XCAM_VIDEO_POOL (object);
+    XCAM_ASSERT (pool);
+
+    pool->buf_pool.release ();
+    XCAM_DESTRUCTOR (pool->buf_pool, SmartPtr<BufferPool>);
+
+    G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static const gchar **
+gst_xcam_video_pool_get_options (GstBufferPool *pool)
+{
+    XCAM_UNUSED (pool);
+    static const gchar *options[] = { GST_BUFFER_POOL_OPTION_VIDEO_META, NULL };
+    return options;
+}
+
+// buffers are allocated by xcam buffer pool, nothing to preallocate or free here
+static gboolean
+gst_xcam_video_pool_start (GstBufferPool *base_pool)
+{
+    XCAM_UNUSED (base_pool);
+    return TRUE;
+}
+
+static gboolean
+gst_xcam_video_pool_stop (GstBufferPool *base_pool)
+{
+    XCAM_UNUSED (base_pool);
+    return TRUE;
+}
+
+static gboolean
+gst_xcam_video_pool_set_config (GstBufferPool *base_pool, GstStructure *config)
+{
+    GstXCamVideoPool *pool = GST_XCAM_VIDEO_POOL (base_pool);
+    GstCaps *caps = NULL;
+    GstVideoInfo gst_info;
+
+    XCAM_ASSERT (pool && pool->buf_pool.ptr ());
+    if (!gst_buffer_pool_config_get_params (config, &caps, NULL, NULL, NULL) ||
+            !caps || !gst_video_info_from_caps (&gst_info, caps)) {
+        GST_WARNING ("xcam video pool parse config caps failed");
+        return FALSE;
+    }
+
+    const VideoBufferInfo &info = pool->buf_pool->get_video_info ();
+    XCAM_FAIL_RETURN (
+        WARNING,
+        GST_VIDEO_INFO_FORMAT (&gst_info) == GST_VIDEO_FORMAT_NV12 &&
+        (uint32_t)GST_VIDEO_INFO_WIDTH (&gst_info) == info.width &&
+        (uint32_t)GST_VIDEO_INFO_HEIGHT (&gst_info) == info.height,
+        FALSE,
+        "xcam video pool caps don't match buffer pool (%dx%d)", info.width, info.height);
+
+    // without video meta, users only know the default layout of caps
+    pool->need_video_meta = gst_buffer_pool_config_has_option (config, GST_BUFFER_POOL_OPTION_VIDEO_META);
+    if (!pool->need_video_meta && !gst_xcam_is_default_layout (&gst_info, info)) {
+        GST_INFO ("xcam video pool needs video meta, buffer layout is not default");
+        return FALSE;
+    }
+
+    pool->gst_video_info = gst_info;
+    return GST_BUFFER_POOL_CLASS (parent_class)->set_config (base_pool, config);
+}
+
+static GstFlowReturn
+gst_xcam_video_pool_acquire_buffer (
+    GstBufferPool *base_pool,
+    GstBuffer **buffer,
+    GstBufferPoolAcquireParams *params)
+{
+    GstXCamVideoPool *pool = GST_XCAM_VIDEO_POOL (base_pool);
+    XCAM_ASSERT (pool);
+    SmartPtr<BufferPool> buf_pool = pool->buf_pool;
+    XCAM_ASSERT (buf_pool.ptr ());
+
+    if (params && (params->flags & GST_BUFFER_POOL_ACQUIRE_FLAG_DONTWAIT) &&
+            !buf_pool->has_free_buffers ())
+        return GST_FLOW_EOS;
+
+    // blocks until a buffer is released, NULL once buffer pool is stopped
+    SmartPtr<VideoBuffer> video_buf = buf_pool->get_buffer (buf_pool);
+    if (!video_buf.ptr ())
+        return GST_FLOW_FLUSHING;
+
+    GstBuffer *out_buf = gst_xcam_wrap_video_buffer (video_buf);
+    if (!out_buf) {
+        GST_WARNING ("xcam video pool wrap buffer failed");
+        return GST_FLOW_ERROR;
+    }
+
+    GstXCamBufferMeta *meta = gst_buffer_add_xcam_buffer_meta (out_buf, video_buf);
+    XCAM_ASSERT (meta);
+    ((GstMeta *)(meta))->flags = (GstMetaFlags)(GST_META_FLAG_POOLED | GST_META_FLAG_LOCKED);
+
+    *buffer = out_buf;
+    return GST_FLOW_OK;
+}
+
+static void
+gst_xcam_video_pool_release_buffer (GstBufferPool *base_pool, GstBuffer *buffer)
+{
+    XCAM_UNUSED (base_pool);
+    gst_buffer_unref (buffer);
+}
+
+GstBufferPool *
+gst_xcam_video_pool_new (const SmartPtr<BufferPool> &buf_pool, GstCaps *caps, guint max_buffers)
+{
+    XCAM_ASSERT (buf_pool.ptr ());
+    GstXCamVideoPool *pool = (GstXCamVideoPool *)g_object_new (GST_TYPE_XCAM_VIDEO_POOL, NULL);
+    XCAM_ASSERT (pool);
+    pool->buf_pool = buf_pool;
+
+    GstStructure *structure = gst_buffer_pool_get_config (GST_BUFFER_POOL_CAST (pool));
+    XCAM_ASSERT (structure);
+    gst_buffer_pool_config_set_params (
+        structure, caps, buf_pool->get_video_info ().size, 0, max_buffers);
+    gst_buffer_pool_config_add_option (structure, GST_BUFFER_POOL_OPTION_VIDEO_META);
+    if (!gst_buffer_pool_set_config (GST_BUFFER_POOL_CAST (pool), structure)) {
+        gst_object_unref (pool);
+        return NULL;
+    }
+
+    return GST_BUFFER_POOL (pool);
+}
@@ -0,0 +1,63 @@
+/*
+ * gstxcamvideopool.h - gst buffer pool backed by xcam buffer pool
+ *
+ *  Copyright (c) 2017 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#ifndef GST_XCAM_VIDEO_POOL_H
+#define GST_XCAM_VIDEO_POOL_H
+
+#include <gst/gst.h>
+#include <gst/video/video.h>
+#include <buffer_pool.h>
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_XCAM_VIDEO_POOL \
+  (gst_xcam_video_pool_get_type())
+#define GST_XCAM_VIDEO_POOL(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_XCAM_VIDEO_POOL,GstXCamVideoPool))
+#define GST_IS_XCAM_VIDEO_POOL(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_XCAM_VIDEO_POOL))
+
+typedef struct _GstXCamVideoPool      GstXCamVideoPool;
+typedef struct _GstXCamVideoPoolClass GstXCamVideoPoolClass;
+
+/* buffers are xcam buffers of buf_pool wrapped in place, carrying GstXCamBufferMeta and video meta,
+ * they go back to buf_pool when freed, so gst buffers are never recycled by this pool itself.
+ */
+struct _GstXCamVideoPool
+{
+    GstBufferPool                     parent;
+    GstVideoInfo                      gst_video_info;
+    gboolean                          need_video_meta;
+    XCam::SmartPtr<XCam::BufferPool>  buf_pool;
+};
+
+struct _GstXCamVideoPoolClass
+{
+    GstBufferPoolClass parent_class;
+};
+
+GType gst_xcam_video_pool_get_type (void);
+
+GstBufferPool *
+gst_xcam_video_pool_new (const XCam::SmartPtr<XCam::BufferPool> &buf_pool, GstCaps *caps, guint max_buffers);
+
+G_END_DECLS
+
+#endif // GST_XCAM_VIDEO_POOL_H
@@ -0,0 +1,169 @@
+/*
+ * main_stitch_manager.cpp - stitch manager of xcamstitch
+ *
+ *  Copyright (c) 2017 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#include "main_stitch_manager.h"
+#include <image_handler.h>
+
+#define DEFAULT_IN_FLIGHT_DEPTH 2
+
+using namespace XCam;
+
+namespace GstXCam {
+
+bool
+StitchThread::loop ()
+{
+    return _manager->stitch_frame ();
+}
+
+MainStitchManager::MainStitchManager ()
+    : _in_flight_depth (DEFAULT_IN_FLIGHT_DEPTH)
+    , _frame_count (0)
+{
+}
+
+MainStitchManager::~MainStitchManager ()
+{
+    stop ();
+}
+
+bool
+MainStitchManager::set_in_flight (uint32_t depth)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, depth > 0, false,
+        "stitch manager in-flight depth can NOT be 0");
+    XCAM_FAIL_RETURN (
+        ERROR, !_thread.ptr (), false,
+        "stitch manager set in-flight depth failed, it was already started");
+
+    _in_flight_depth = depth;
+    return true;
+}
+
+XCamReturn
+MainStitchManager::start (const SmartPtr<Stitcher> &stitcher)
+{
+    XCAM_ASSERT (stitcher.ptr ());
+    XCAM_FAIL_RETURN (
+        ERROR, !_thread.ptr (), XCAM_RETURN_ERROR_ORDER,
+        "stitch manager was already started");
+
+    _stitcher = stitcher;
+    _pending_frames.resume_pop ();
+    _done_frames.resume_pop ();
+
+    _thread = new StitchThread (this);
+    XCAM_ASSERT (_thread.ptr ());
+    if (!_thread->start ()) {
+        _thread.release ();
+        _stitcher.release ();
+        XCAM_LOG_ERROR ("stitch manager start stitch thread failed");
+        return XCAM_RETURN_ERROR_THREAD;
+    }
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+MainStitchManager::stop ()
+{
+    if (!_thread.ptr ())
+        return XCAM_RETURN_NO_ERROR;
+
+    _pending_frames.pause_pop ();
+    _done_frames.pause_pop ();
+    _thread->stop ();
+    _thread.release ();
+
+    // frames not pushed downstream are dropped
+    _pending_frames.clear ();
+    _done_frames.clear ();
+    {
+        SmartLock locker (_mutex);
+        _frame_count = 0;
+    }
+
+    SmartPtr<ImageHandler> handler = _stitcher.dynamic_cast_ptr<ImageHandler> ();
+    if (handler.ptr ())
+        handler->terminate ();
+    _stitcher.release ();
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+MainStitchManager::push_frame (const SmartPtr<StitchFrame> &frame)
+{
+    XCAM_ASSERT (frame.ptr ());
+    XCAM_FAIL_RETURN (
+        ERROR, _thread.ptr (), XCAM_RETURN_ERROR_ORDER,
+        "stitch manager push frame failed, it was not started");
+
+    {
+        SmartLock locker (_mutex);
+        XCAM_FAIL_RETURN (
+            ERROR, _frame_count < _in_flight_depth, XCAM_RETURN_ERROR_MEM,
+            "stitch manager push frame failed, %d frames in flight", _frame_count);
+        ++_frame_count;
+    }
+
+    _pending_frames.push (frame);
+    return XCAM_RETURN_NO_ERROR;
+}
+
+SmartPtr<StitchFrame>
+MainStitchManager::pop_done (int32_t timeout)
+{
+    SmartPtr<StitchFrame> frame = _done_frames.pop (timeout);
+    if (!frame.ptr ())
+        return NULL;
+
+    SmartLock locker (_mutex);
+    XCAM_ASSERT (_frame_count);
+    --_frame_count;
+    return frame;
+}
+
+uint32_t
+MainStitchManager::get_frame_count ()
+{
+    SmartLock locker (_mutex);
+    return _frame_count;
+}
+
+bool
+MainStitchManager::stitch_frame ()
+{
+    SmartPtr<StitchFrame> frame = _pending_frames.pop (-1);
+    if (!frame.ptr ())
+        return false;
+
+    frame->error = _stitcher->stitch_buffers (frame->in_bufs, frame->out_buf);
+    if (!xcam_ret_is_ok (frame->error)) {
+        XCAM_LOG_WARNING ("stitch manager stitch frame failed, error:%d", (int)frame->error);
+    }
+
+    // inputs go back to upstream as soon as possible
+    frame->in_bufs.clear ();
+    _done_frames.push (frame);
+    return true;
+}
+
+};
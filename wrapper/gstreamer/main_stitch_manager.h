@@ -0,0 +1,112 @@
+/*
+ * main_stitch_manager.h - stitch manager of xcamstitch
+ *
+ *  Copyright (c) 2017 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#ifndef XCAMSTITCH_MAIN_STITCH_MANAGER_H
+#define XCAMSTITCH_MAIN_STITCH_MANAGER_H
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <gst/gst.h>
+#include <xcam_mutex.h>
+#include <xcam_thread.h>
+#include <safe_list.h>
+#include <video_buffer.h>
+#include <interface/stitcher.h>
+
+namespace GstXCam {
+
+class MainStitchManager;
+
+struct StitchFrame {
+    XCam::VideoBufferList              in_bufs;
+    XCam::SmartPtr<XCam::VideoBuffer>  out_buf;
+    GstClockTime                       pts;
+    GstClockTime                       duration;
+    XCamReturn                         error;
+
+    StitchFrame ()
+        : pts (GST_CLOCK_TIME_NONE)
+        , duration (GST_CLOCK_TIME_NONE)
+        , error (XCAM_RETURN_NO_ERROR)
+    {}
+};
+
+class StitchThread
+    : public XCam::Thread
+{
+public:
+    StitchThread (MainStitchManager *manager)
+        : XCam::Thread ("StitchThread")
+        , _manager (manager)
+    {}
+
+protected:
+    virtual bool loop ();
+
+private:
+    MainStitchManager    *_manager;
+};
+
+/* frames are stitched one by one in a stitch thread, while aggregator collects next ones,
+ * at most in-flight frames are queued, processed or waiting to be pushed downstream.
+ */
+class MainStitchManager
+{
+    friend class StitchThread;
+
+public:
+    MainStitchManager ();
+    ~MainStitchManager ();
+
+    bool set_in_flight (uint32_t depth);
+    uint32_t get_in_flight () const {
+        return _in_flight_depth;
+    }
+
+    XCamReturn start (const XCam::SmartPtr<XCam::Stitcher> &stitcher);
+    XCamReturn stop ();
+
+    // caller pops done frames first if get_frame_count () reaches in-flight depth
+    XCamReturn push_frame (const XCam::SmartPtr<StitchFrame> &frame);
+    // timeout in microseconds, -1 waits until one is done
+    XCam::SmartPtr<StitchFrame> pop_done (int32_t timeout);
+
+    // frames pushed but not popped yet
+    uint32_t get_frame_count ();
+
+private:
+    bool stitch_frame ();
+    XCAM_DEAD_COPY (MainStitchManager);
+
+private:
+    XCam::SmartPtr<XCam::Stitcher>     _stitcher;
+    XCam::SmartPtr<StitchThread>       _thread;
+    XCam::SafeList<StitchFrame>        _pending_frames;
+    XCam::SafeList<StitchFrame>        _done_frames;
+    XCam::Mutex                        _mutex;
+    uint32_t                           _in_flight_depth;
+    uint32_t                           _frame_count;
+};
+
+};
+
+#endif // XCAMSTITCH_MAIN_STITCH_MANAGER_H
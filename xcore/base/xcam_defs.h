@@ -132,5 +132,6 @@
 #endif
 
 #define degree2radian(degree) ((degree) * XCAM_PI / 180.0f)
+#define radian2degree(radian) ((radian) * 180.0f / XCAM_PI)
 
 #endif //XCAM_DEFS_H
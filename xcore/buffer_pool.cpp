@@ -105,6 +105,13 @@ BufferPool::reserve (uint32_t max_count)
 
     SmartLock lock (_mutex);
 
+    // restart of a stopped pool, free buffers are allocated again with current video info
+    if (!_started && _allocated_num) {
+        _allocated_num -= XCAM_MIN (_allocated_num, _buf_list.size ());
+        _buf_list.clear ();
+        _buf_list.resume_pop ();
+    }
+
     for (i = _allocated_num; i < max_count; ++i) {
         SmartPtr<BufferData> new_data = allocate_data (_buffer_info);
         if (!new_data.ptr ())
@@ -192,8 +199,12 @@ BufferPool::release (SmartPtr<BufferData> &data)
 {
     {
         SmartLock lock (_mutex);
-        if (!_started)
+        if (!_started) {
+            // dropped, reserve allocates it again on restart
+            if (_allocated_num)
+                --_allocated_num;
             return;
+        }
     }
     _buf_list.push (data);
 }
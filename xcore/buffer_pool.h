@@ -89,6 +89,7 @@ public:
     virtual ~BufferPool ();
 
     bool set_video_info (const VideoBufferInfo &info);
+    // also restarts a stopped pool
     bool reserve (uint32_t max_count = 4);
     SmartPtr<VideoBuffer> get_buffer (const SmartPtr<BufferPool> &self);
     SmartPtr<VideoBuffer> get_buffer ();
@@ -24,6 +24,9 @@
 #include "x3a_image_process_center.h"
 #include "x3a_analyzer_manager.h"
 
+// capture times of frames never processed are forgotten after
+#define XCAM_MAX_PENDING_CAPTURE_TIMES 64
+
 #define XCAM_FAILED_STOP(exp, msg, ...)                 \
     if ((exp) != XCAM_RETURN_NO_ERROR) {                \
         XCAM_LOG_ERROR (msg, ## __VA_ARGS__);           \
@@ -73,9 +76,18 @@ XCamMessage::~XCamMessage ()
         xcam_free (msg);
 }
 
+static int64_t
+get_monotonic_time ()
+{
+    struct timespec now;
+    clock_gettime (CLOCK_MONOTONIC, &now);
+    return XCAM_TIMESPEC_2_USEC (now);
+}
+
 DeviceManager::DeviceManager()
     : _has_3a (true)
     , _is_running (false)
+    , _latency_sum (0)
 {
     _3a_process_center = new X3aImageProcessCenter;
     XCAM_LOG_DEBUG ("~DeviceManager construction");
@@ -222,6 +234,8 @@ DeviceManager::start ()
 
     }
 
+    reset_frame_stats ();
+
     //Initialize and start poll thread
     XCAM_ASSERT (_poll_thread.ptr ());
     _poll_thread->set_capture_device (_device);
@@ -265,6 +279,13 @@ DeviceManager::stop ()
 
     _poll_thread.release ();
 
+    DeviceFrameStats stats;
+    get_frame_stats (stats);
+    if (stats.captured_count)
+        XCAM_LOG_INFO (
+            "Device manager frames captured:%d dropped:%d processed:%d, latency avg:%" PRId64 "us max:%" PRId64 "us",
+            stats.captured_count, stats.dropped_count, stats.processed_count, stats.avg_latency, stats.max_latency);
+
     XCAM_LOG_DEBUG ("Device manager stopped");
     return XCAM_RETURN_NO_ERROR;
 }
@@ -313,9 +334,22 @@ DeviceManager::scaled_image_ready (const SmartPtr<VideoBuffer> &buffer)
 XCamReturn
 DeviceManager::poll_buffer_ready (SmartPtr<VideoBuffer> &buf)
 {
+    int64_t timestamp = buf->get_timestamp ();
+    {
+        SmartLock locker (_stats_mutex);
+        ++_frame_stats.captured_count;
+        if (_capture_times.size () >= XCAM_MAX_PENDING_CAPTURE_TIMES)
+            _capture_times.erase (_capture_times.begin ());
+        _capture_times[timestamp] = get_monotonic_time ();
+    }
+
     if (_has_3a) {
-        if (_3a_process_center->put_buffer (buf) == false)
+        if (_3a_process_center->put_buffer (buf) == false) {
+            SmartLock locker (_stats_mutex);
+            ++_frame_stats.dropped_count;
+            _capture_times.erase (timestamp);
             return XCAM_RETURN_ERROR_UNKNOWN;
+        }
     }
     return XCAM_RETURN_NO_ERROR;
 }
@@ -327,6 +361,24 @@ DeviceManager::poll_buffer_failed (int64_t timestamp, const char *msg)
     return XCAM_RETURN_NO_ERROR;
 }
 
+XCamReturn
+DeviceManager::poll_buffer_dropped (int64_t timestamp)
+{
+    XCAM_UNUSED (timestamp);
+
+    SmartLock locker (_stats_mutex);
+    ++_frame_stats.captured_count;
+    ++_frame_stats.dropped_count;
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+DeviceManager::poll_source_done ()
+{
+    post_message (XCAM_MESSAGE_SOURCE_DONE, InvalidTimestamp, "capture source done");
+    return XCAM_RETURN_NO_ERROR;
+}
+
 void
 DeviceManager::x3a_calculation_done (XAnalyzer *analyzer, X3aResultList &results)
 {
@@ -348,6 +400,21 @@ void
 DeviceManager::process_buffer_done (ImageProcessor *processor, const SmartPtr<VideoBuffer> &buf)
 {
     ImageProcessCallback::process_buffer_done (processor, buf);
+
+    {
+        SmartLock locker (_stats_mutex);
+        std::map<int64_t, int64_t>::iterator i_time = _capture_times.find (buf->get_timestamp ());
+        if (i_time != _capture_times.end ()) {
+            int64_t latency = get_monotonic_time () - i_time->second;
+            _capture_times.erase (i_time);
+
+            ++_frame_stats.processed_count;
+            _latency_sum += latency;
+            _frame_stats.avg_latency = _latency_sum / _frame_stats.processed_count;
+            _frame_stats.max_latency = XCAM_MAX (_frame_stats.max_latency, latency);
+        }
+    }
+
     handle_buffer (buf);
 }
 
@@ -363,6 +430,22 @@ DeviceManager::process_image_result_done (ImageProcessor *processor, const Smart
     ImageProcessCallback::process_image_result_done (processor, result);
 }
 
+void
+DeviceManager::get_frame_stats (DeviceFrameStats &stats)
+{
+    SmartLock locker (_stats_mutex);
+    stats = _frame_stats;
+}
+
+void
+DeviceManager::reset_frame_stats ()
+{
+    SmartLock locker (_stats_mutex);
+    _frame_stats = DeviceFrameStats ();
+    _latency_sum = 0;
+    _capture_times.clear ();
+}
+
 void
 DeviceManager::post_message (XCamMessageType type, int64_t timestamp, const char *msg)
 {
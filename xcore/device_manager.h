@@ -30,6 +30,7 @@
 #include <image_processor.h>
 #include <poll_thread.h>
 #include <stats_callback_interface.h>
+#include <map>
 
 namespace XCam {
 
@@ -40,6 +41,7 @@ enum XCamMessageType {
     XCAM_MESSAGE_STATS_ERROR,
     XCAM_MESSAGE_3A_RESULTS_OK,
     XCAM_MESSAGE_3A_RESULTS_ERROR,
+    XCAM_MESSAGE_SOURCE_DONE,
 };
 
 struct XCamMessage {
@@ -56,6 +58,25 @@ struct XCamMessage {
     XCAM_DEAD_COPY (XCamMessage);
 };
 
+/* frames from poll thread to handle_buffer (), latency in microseconds,
+ * output buffers are matched with captured ones by timestamp
+ */
+struct DeviceFrameStats {
+    uint32_t         captured_count;
+    uint32_t         dropped_count;
+    uint32_t         processed_count;
+    int64_t          avg_latency;
+    int64_t          max_latency;
+
+    DeviceFrameStats ()
+        : captured_count (0)
+        , dropped_count (0)
+        , processed_count (0)
+        , avg_latency (0)
+        , max_latency (0)
+    {}
+};
+
 class MessageThread;
 
 class DeviceManager
@@ -97,6 +118,8 @@ public:
     XCamReturn start ();
     XCamReturn stop ();
 
+    void get_frame_stats (DeviceFrameStats &stats);
+
 protected:
     virtual void handle_message (const SmartPtr<XCamMessage> &msg) = 0;
     virtual void handle_buffer (const SmartPtr<VideoBuffer> &buf) = 0;
@@ -105,6 +128,8 @@ protected:
     //virtual functions derived from PollCallback
     virtual XCamReturn poll_buffer_ready (SmartPtr<VideoBuffer> &buf);
     virtual XCamReturn poll_buffer_failed (int64_t timestamp, const char *msg);
+    virtual XCamReturn poll_buffer_dropped (int64_t timestamp);
+    virtual XCamReturn poll_source_done ();
     virtual XCamReturn x3a_stats_ready (const SmartPtr<X3aStats> &stats);
     virtual XCamReturn dvs_stats_ready ();
     virtual XCamReturn scaled_image_ready (const SmartPtr<VideoBuffer> &buffer);
@@ -120,6 +145,7 @@ protected:
 
 private:
     void post_message (XCamMessageType type, int64_t timestamp, const char *msg);
+    void reset_frame_stats ();
     XCamReturn message_loop ();
 
     XCAM_DEAD_COPY (DeviceManager);
@@ -142,6 +168,12 @@ protected:
 
     /* smart analysis */
     SmartPtr<SmartAnalyzer>         _smart_analyzer;
+
+    /* frame statistics, capture time of frames in processing by timestamp */
+    Mutex                            _stats_mutex;
+    DeviceFrameStats                 _frame_stats;
+    int64_t                          _latency_sum;
+    std::map<int64_t, int64_t>       _capture_times;
 };
 
 };
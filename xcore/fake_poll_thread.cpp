@@ -22,14 +22,41 @@
 #if HAVE_LIBDRM
 #include "drm_bo_buffer.h"
 #endif
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #define DEFAULT_FPT_BUF_COUNT 4
+#define DEFAULT_FPT_FRAME_RATE 30.0
 
 namespace XCam {
 
+static int64_t
+get_monotonic_time ()
+{
+    struct timespec now;
+    clock_gettime (CLOCK_MONOTONIC, &now);
+    return XCAM_TIMESPEC_2_USEC (now);
+}
+
 FakePollThread::FakePollThread (const char *raw_path)
     : _raw_path (NULL)
-    , _raw (NULL)
+    , _raw_fd (-1)
+    , _raw_data (NULL)
+    , _raw_size (0)
+    , _read_pos (0)
+    , _frame_size (0)
+    , _camera_idx (0)
+    , _container_pos (0)
+    , _fps (0.0)
+    , _loop_count (0)
+    , _loop_idx (0)
+    , _frame_duration (0)
+    , _start_time (0)
+    , _frame_idx (0)
+    , _emitted_count (0)
+    , _dropped_count (0)
 {
     XCAM_ASSERT (raw_path);
 
@@ -42,8 +69,79 @@ FakePollThread::~FakePollThread ()
     if (_raw_path)
         xcam_free (_raw_path);
 
-    if (_raw)
-        fclose (_raw);
+    unmap_file ();
+}
+
+bool
+FakePollThread::set_frame_rate (double fps)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, fps >= 0.0, false,
+        "FakePollThread set frame rate failed, fps(%.2f) is negative", fps);
+
+    _fps = fps;
+    return true;
+}
+
+bool
+FakePollThread::set_loop_count (uint32_t loop_count)
+{
+    _loop_count = loop_count;
+    return true;
+}
+
+bool
+FakePollThread::set_buffer_pool (const SmartPtr<BufferPool> &pool)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, !_raw_data && !_container.ptr (), false,
+        "FakePollThread set buffer pool failed, it was already started");
+
+    _buf_pool = pool;
+    return true;
+}
+
+bool
+FakePollThread::set_camera_index (uint32_t camera)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, !_raw_data && !_container.ptr (), false,
+        "FakePollThread set camera index failed, it was already started");
+
+    _camera_idx = camera;
+    return true;
+}
+
+void
+FakePollThread::unmap_file ()
+{
+    if (_raw_data) {
+        munmap (_raw_data, _raw_size);
+        _raw_data = NULL;
+    }
+    if (_raw_fd >= 0) {
+        close (_raw_fd);
+        _raw_fd = -1;
+    }
+    _raw_size = 0;
+    _container.release ();
+}
+
+XCamReturn
+FakePollThread::open_container ()
+{
+    SmartPtr<RawContainerFile> container = new RawContainerFile ();
+    XCamReturn ret = container->open_container (_raw_path);
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "FakePollThread failed to open container:%s", XCAM_STR (_raw_path));
+    XCAM_FAIL_RETURN (
+        ERROR, _camera_idx < container->get_camera_count () && container->get_frame_count (),
+        XCAM_RETURN_ERROR_PARAM,
+        "FakePollThread container:%s has no frames of camera:%d", XCAM_STR (_raw_path), _camera_idx);
+
+    _container = container;
+    return XCAM_RETURN_NO_ERROR;
 }
 
 XCamReturn
@@ -55,13 +153,47 @@ FakePollThread::start()
         XCAM_RETURN_ERROR_FILE,
         "FakePollThread failed due to raw path NULL");
 
-    _raw = fopen (_raw_path, "rb");
+    unmap_file ();
+    // pool was stopped by last stop, init_buffer_pool restarts it
+    _frame_size = 0;
+    _read_pos = 0;
+    _container_pos = 0;
+    _loop_idx = 0;
+    _frame_idx = 0;
+    _emitted_count = 0;
+    _dropped_count = 0;
+
+    if (RawContainerFile::is_container (_raw_path)) {
+        XCamReturn ret = open_container ();
+        if (!xcam_ret_is_ok (ret))
+            return ret;
+        return PollThread::start ();
+    }
+
+    _raw_fd = open (_raw_path, O_RDONLY);
     XCAM_FAIL_RETURN(
         ERROR,
-        _raw,
+        _raw_fd >= 0,
         XCAM_RETURN_ERROR_FILE,
         "FakePollThread failed to open file:%s", XCAM_STR (_raw_path));
 
+    struct stat file_stat;
+    if (fstat (_raw_fd, &file_stat) < 0 || file_stat.st_size <= 0) {
+        XCAM_LOG_ERROR ("FakePollThread failed to get size of file:%s", XCAM_STR (_raw_path));
+        unmap_file ();
+        return XCAM_RETURN_ERROR_FILE;
+    }
+
+    void *data = mmap (NULL, file_stat.st_size, PROT_READ, MAP_PRIVATE, _raw_fd, 0);
+    if (data == MAP_FAILED) {
+        XCAM_LOG_ERROR ("FakePollThread failed to map file:%s", XCAM_STR (_raw_path));
+        unmap_file ();
+        return XCAM_RETURN_ERROR_FILE;
+    }
+    _raw_data = (uint8_t *)data;
+    _raw_size = file_stat.st_size;
+    madvise (_raw_data, _raw_size, MADV_SEQUENTIAL);
+
     return PollThread::start ();
 }
 
@@ -71,38 +203,87 @@ FakePollThread::stop ()
     if (_buf_pool.ptr ())
         _buf_pool->stop ();
 
-    return PollThread::stop ();;
+    XCamReturn ret = PollThread::stop ();
+    unmap_file ();
+
+    if (_frame_idx)
+        XCAM_LOG_INFO (
+            "FakePollThread replayed %d frames, emitted:%d dropped:%d",
+            _frame_idx, _emitted_count, _dropped_count);
+    return ret;
+}
+
+// NULL if loops are done
+const uint8_t *
+FakePollThread::next_frame ()
+{
+    XCAM_ASSERT (_frame_size);
+
+    if (_container.ptr ()) {
+        if (_container_pos >= _container->get_frame_count ()) {
+            ++_loop_idx;
+            if (_loop_count && _loop_idx >= _loop_count)
+                return NULL;
+            _container_pos = 0;
+        }
+        return _container->get_image_data (_container_pos++, _camera_idx);
+    }
+
+    if (_read_pos + _frame_size > _raw_size) {
+        ++_loop_idx;
+        if (_loop_count && _loop_idx >= _loop_count)
+            return NULL;
+        _read_pos = 0;
+        XCAM_FAIL_RETURN (
+            ERROR, _frame_size <= _raw_size, NULL,
+            "FakePollThread file size(%d) is less than one frame(%d)", (int)_raw_size, (int)_frame_size);
+    }
+
+    const uint8_t *frame = _raw_data + _read_pos;
+    _read_pos += _frame_size;
+
+    // read ahead next frame while this one is copied and processed
+    size_t page_size = getpagesize ();
+    size_t ahead_pos = XCAM_ALIGN_DOWN (_read_pos, page_size);
+    if (ahead_pos < _raw_size)
+        madvise (_raw_data + ahead_pos, XCAM_MIN (_frame_size + page_size, _raw_size - ahead_pos), MADV_WILLNEED);
+
+    return frame;
 }
 
 XCamReturn
-FakePollThread::read_buf (SmartPtr<VideoBuffer> &buf)
+FakePollThread::read_buf (SmartPtr<VideoBuffer> &buf, const uint8_t *src)
 {
     uint8_t *dst = buf->map ();
     const VideoBufferInfo info = buf->get_video_info ();
     VideoBufferPlanarInfo planar;
-    XCamReturn ret = XCAM_RETURN_NO_ERROR;
+
+    XCAM_FAIL_RETURN (
+        ERROR, dst, XCAM_RETURN_ERROR_MEM,
+        "FakePollThread map buffer failed");
 
     for (uint32_t index = 0; index < info.components; index++) {
         info.get_planar_info(planar, index);
         uint32_t line_bytes = planar.width * planar.pixel_bytes;
 
         for (uint32_t i = 0; i < planar.height; i++) {
-            if (fread (dst + info.offsets [index] + i * info.strides [index], 1, line_bytes, _raw) < line_bytes) {
-                if (feof (_raw)) {
-                    fseek (_raw, 0, SEEK_SET);
-                    ret = XCAM_RETURN_BYPASS;
-                } else {
-                    XCAM_LOG_ERROR ("poll_buffer_loop failed to read file");
-                    ret = XCAM_RETURN_ERROR_FILE;
-                }
-                goto done;
-            }
+            memcpy (dst + info.offsets [index] + i * info.strides [index],
+                    src + _src_info.offsets [index] + i * _src_info.strides [index], line_bytes);
         }
     }
 
-done:
     buf->unmap ();
-    return ret;
+    return XCAM_RETURN_NO_ERROR;
+}
+
+// ends capture loop
+XCamReturn
+FakePollThread::replay_done ()
+{
+    XCAM_LOG_INFO ("FakePollThread replay done, %d loops", _loop_idx);
+    if (_poll_callback)
+        _poll_callback->poll_source_done ();
+    return XCAM_RETURN_BYPASS;
 }
 
 XCamReturn
@@ -110,23 +291,50 @@ FakePollThread::poll_buffer_loop ()
 {
     XCamReturn ret = XCAM_RETURN_NO_ERROR;
 
-    if (!_buf_pool.ptr () && init_buffer_pool () != XCAM_RETURN_NO_ERROR)
+    if (!_frame_size && init_buffer_pool () != XCAM_RETURN_NO_ERROR)
         return XCAM_RETURN_ERROR_MEM;
 
+    if (!_frame_idx)
+        _start_time = get_monotonic_time ();
+    int64_t timestamp = _frame_idx * _frame_duration;
+
+    if (_fps > 0.0) {
+        int64_t wait_time = _start_time + timestamp - get_monotonic_time ();
+        if (wait_time > 0)
+            usleep (wait_time);
+
+        // a sensor doesn't wait for consumers
+        if (!_buf_pool->has_free_buffers ()) {
+            if (!next_frame ())
+                return replay_done ();
+            ++_frame_idx;
+            ++_dropped_count;
+            if (_poll_callback)
+                _poll_callback->poll_buffer_dropped (timestamp);
+            return XCAM_RETURN_NO_ERROR;
+        }
+    }
+
     SmartPtr<VideoBuffer> buf = _buf_pool->get_buffer (_buf_pool);
     if (!buf.ptr ()) {
         XCAM_LOG_WARNING ("FakePollThread get buffer failed");
         return XCAM_RETURN_ERROR_MEM;
     }
 
-    ret = read_buf (buf);
-    if (ret == XCAM_RETURN_BYPASS) {
-        ret = read_buf (buf);
-    }
+    const uint8_t *frame = next_frame ();
+    if (!frame)
+        return replay_done ();
+
+    ret = read_buf (buf, frame);
+    buf->set_timestamp (timestamp);
+    ++_frame_idx;
 
     SmartPtr<VideoBuffer> video_buf = buf;
-    if (ret == XCAM_RETURN_NO_ERROR && _poll_callback)
-        return _poll_callback->poll_buffer_ready (video_buf);
+    if (ret == XCAM_RETURN_NO_ERROR) {
+        ++_emitted_count;
+        if (_poll_callback)
+            return _poll_callback->poll_buffer_ready (video_buf);
+    }
 
     return ret;
 }
@@ -144,16 +352,57 @@ FakePollThread::init_buffer_pool ()
     info.init(format.fmt.pix.pixelformat,
               format.fmt.pix.width,
               format.fmt.pix.height, 0, 0, 0);
+
+    VideoBufferPlanarInfo planar;
+    _frame_size = 0;
+    _src_info = info;
+    for (uint32_t index = 0; index < info.components; index++) {
+        info.get_planar_info (planar, index);
+        // headerless file frames are packed
+        _src_info.strides [index] = planar.width * planar.pixel_bytes;
+        _src_info.offsets [index] = _frame_size;
+        _frame_size += planar.width * planar.pixel_bytes * planar.height;
+    }
+
+    if (_container.ptr ()) {
+        const VideoBufferInfo &container_info = _container->get_video_info ();
+        if (container_info.format != info.format ||
+                container_info.width != info.width || container_info.height != info.height) {
+            XCAM_LOG_ERROR (
+                "FakePollThread container(%s %dx%d) doesn't match device format(%s %dx%d)",
+                xcam_fourcc_to_string (container_info.format), container_info.width, container_info.height,
+                xcam_fourcc_to_string (info.format), info.width, info.height);
+            _frame_size = 0;
+            return XCAM_RETURN_ERROR_PARAM;
+        }
+        _src_info = container_info;
+    }
+
+    double fps = _fps;
+    if (fps <= 0.0) {
+        uint32_t fps_n = 0, fps_d = 0;
+        _capture_dev->get_framerate (fps_n, fps_d);
+        fps = (fps_n && fps_d) ? (double)fps_n / fps_d : DEFAULT_FPT_FRAME_RATE;
+    }
+    _frame_duration = (int64_t)(1000000.0 / fps + 0.5);
+
+    if (!_buf_pool.ptr ()) {
 #if HAVE_LIBDRM
-    SmartPtr<DrmDisplay> drm_disp = DrmDisplay::instance ();
-    SmartPtr<BufferPool> pool = new DrmBoBufferPool (drm_disp);
-    XCAM_ASSERT (pool.ptr ());
-    _buf_pool = pool;
+        SmartPtr<DrmDisplay> drm_disp = DrmDisplay::instance ();
+        SmartPtr<BufferPool> pool = new DrmBoBufferPool (drm_disp);
+        XCAM_ASSERT (pool.ptr ());
+        _buf_pool = pool;
+#else
+        XCAM_LOG_ERROR ("FakePollThread needs a buffer pool without libdrm");
+        _frame_size = 0;
+        return XCAM_RETURN_ERROR_MEM;
+#endif
+    }
 
     if (_buf_pool->set_video_info (info) && _buf_pool->reserve (DEFAULT_FPT_BUF_COUNT))
         return XCAM_RETURN_NO_ERROR;
-#endif
 
+    _frame_size = 0;
     return XCAM_RETURN_ERROR_MEM;
 }
 
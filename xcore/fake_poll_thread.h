@@ -23,9 +23,16 @@
 
 #include <xcam_std.h>
 #include <poll_thread.h>
+#include <raw_container_file.h>
 
 namespace XCam {
 
+/* replays raw frames of a file as a capture device, the file is memory mapped and read ahead,
+ * frames are emitted at frame rate (or as fast as buffers are returned if it's 0) with synthetic
+ * timestamps, a paced frame is dropped if all buffers are still held by consumers.
+ * The file is either headerless packed frames or a RawContainerFile, images of one camera are replayed.
+ * After loop_count loops, poll_source_done () of the callback is called and capturing stops.
+ */
 class FakePollThread
     : public PollThread
 {
@@ -33,6 +40,22 @@ public:
     explicit FakePollThread (const char *raw_path);
     ~FakePollThread ();
 
+    // fps 0 emits frames as fast as possible, default 0
+    bool set_frame_rate (double fps);
+    // replay file loop_count times, 0 means endless, default 0
+    bool set_loop_count (uint32_t loop_count);
+    // optional, a DRM bo buffer pool is created if not set
+    bool set_buffer_pool (const SmartPtr<BufferPool> &pool);
+    // camera of a container file to replay, default 0
+    bool set_camera_index (uint32_t camera);
+
+    uint32_t get_emitted_count () const {
+        return _emitted_count;
+    }
+    uint32_t get_dropped_count () const {
+        return _dropped_count;
+    }
+
     virtual XCamReturn start();
     virtual XCamReturn stop ();
 
@@ -46,12 +69,33 @@ private:
         return XCAM_RETURN_ERROR_UNKNOWN;
     }
     XCamReturn init_buffer_pool ();
-    XCamReturn read_buf (SmartPtr<VideoBuffer> &buf);
+    XCamReturn open_container ();
+    const uint8_t *next_frame ();
+    XCamReturn replay_done ();
+    XCamReturn read_buf (SmartPtr<VideoBuffer> &buf, const uint8_t *src);
+    void unmap_file ();
 
 private:
     char                        *_raw_path;
-    FILE                        *_raw;
+    int                          _raw_fd;
+    uint8_t                     *_raw_data;
+    size_t                       _raw_size;
+    size_t                       _read_pos;
+    size_t                       _frame_size;
+    VideoBufferInfo              _src_info;
+    SmartPtr<RawContainerFile>   _container;
+    uint32_t                     _camera_idx;
+    uint32_t                     _container_pos;
     SmartPtr<BufferPool>         _buf_pool;
+
+    double                       _fps;
+    uint32_t                     _loop_count;
+    uint32_t                     _loop_idx;
+    int64_t                      _frame_duration;
+    int64_t                      _start_time;
+    uint32_t                     _frame_idx;
+    uint32_t                     _emitted_count;
+    uint32_t                     _dropped_count;
 };
 
 };
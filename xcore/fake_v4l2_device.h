@@ -38,7 +38,8 @@ public:
         XCAM_UNUSED (arg);
 
         int ret = 0;
-        switch (cmd) {
+        // ioctl request codes don't fit int
+        switch ((uint32_t)cmd) {
         case VIDIOC_ENUM_FMT:
             ret = -1;
             break;
@@ -37,7 +37,7 @@ public:
     }
     bool end_of_file ();
     XCamReturn open (const char *name, const char *option);
-    XCamReturn close ();
+    virtual XCamReturn close ();
     XCamReturn rewind ();
     XCamReturn get_file_size (size_t &size);
     const char* get_file_name () const {
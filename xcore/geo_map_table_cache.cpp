@@ -0,0 +1,250 @@
+/*
+ * geo_map_table_cache.cpp - geometric map table cache implementation
+ *
+ *  Copyright (c) 2017 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#include "geo_map_table_cache.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#define GEO_MAP_TABLE_CACHE_MAGIC v4l2_fourcc ('X', 'G', 'M', 'T')
+#define GEO_MAP_TABLE_CACHE_MAX_TABLES 64
+
+#define FNV_PRIME 0x100000001b3ULL
+
+namespace XCam {
+
+namespace {
+
+struct FileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t key;
+    uint32_t point_size;
+    uint32_t table_num;
+};
+
+struct TableHeader {
+    uint32_t width;
+    uint32_t height;
+    uint64_t offset;
+};
+
+}
+
+GeoMapTableCache::GeoMapTableCache (uint64_t key)
+    : _key (key)
+    , _map_data (NULL)
+    , _map_size (0)
+{
+}
+
+GeoMapTableCache::~GeoMapTableCache ()
+{
+    unload ();
+}
+
+uint64_t
+GeoMapTableCache::hash (const void *data, size_t size, uint64_t seed)
+{
+    const uint8_t *bytes = (const uint8_t *)data;
+    uint64_t value = seed;
+    for (size_t i = 0; i < size; ++i) {
+        value ^= bytes[i];
+        value *= FNV_PRIME;
+    }
+    return value;
+}
+
+bool
+GeoMapTableCache::load (const char *path)
+{
+    XCAM_ASSERT (path);
+    XCAM_FAIL_RETURN (
+        ERROR, !is_loaded () && _tables.empty (), false,
+        "geo map table cache already has tables, load(%s) failed", path);
+
+    int fd = open (path, O_RDONLY);
+    if (fd < 0) {
+        XCAM_LOG_DEBUG ("geo map table cache(%s) not found", path);
+        return false;
+    }
+
+    struct stat st;
+    if (fstat (fd, &st) < 0 || (size_t)st.st_size < sizeof (FileHeader)) {
+        XCAM_LOG_WARNING ("geo map table cache(%s) size is invalid", path);
+        ::close (fd);
+        return false;
+    }
+
+    void *ptr = mmap (NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close (fd);
+    XCAM_FAIL_RETURN (
+        WARNING, ptr != MAP_FAILED, false,
+        "geo map table cache(%s) mmap failed", path);
+
+    _map_data = (uint8_t *)ptr;
+    _map_size = st.st_size;
+
+    const FileHeader *header = (const FileHeader *)_map_data;
+    if (header->magic != GEO_MAP_TABLE_CACHE_MAGIC ||
+            header->version != XCAM_GEO_MAP_TABLE_CACHE_VERSION ||
+            header->point_size != sizeof (PointFloat2) ||
+            header->table_num == 0 || header->table_num > GEO_MAP_TABLE_CACHE_MAX_TABLES) {
+        XCAM_LOG_WARNING ("geo map table cache(%s) header mismatch, ignored", path);
+        unload ();
+        return false;
+    }
+
+    if (header->key != _key) {
+        XCAM_LOG_INFO ("geo map table cache(%s) key changed, need regenerate tables", path);
+        unload ();
+        return false;
+    }
+
+    if (_map_size < sizeof (FileHeader) + sizeof (TableHeader) * header->table_num) {
+        XCAM_LOG_WARNING ("geo map table cache(%s) truncated", path);
+        unload ();
+        return false;
+    }
+
+    const TableHeader *tables = (const TableHeader *)(_map_data + sizeof (FileHeader));
+    for (uint32_t i = 0; i < header->table_num; ++i) {
+        uint64_t bytes = (uint64_t)tables[i].width * tables[i].height * sizeof (PointFloat2);
+        if (!bytes || tables[i].offset % sizeof (float) ||
+                tables[i].offset > _map_size || bytes > _map_size - tables[i].offset) {
+            XCAM_LOG_WARNING ("geo map table cache(%s) table(idx:%d) out of range", path, i);
+            unload ();
+            return false;
+        }
+    }
+
+    XCAM_LOG_INFO ("geo map table cache(%s) loaded, table num:%d", path, header->table_num);
+    return true;
+}
+
+void
+GeoMapTableCache::unload ()
+{
+    if (_map_data) {
+        munmap (_map_data, _map_size);
+        _map_data = NULL;
+        _map_size = 0;
+    }
+}
+
+uint32_t
+GeoMapTableCache::get_table_num () const
+{
+    if (is_loaded ())
+        return ((const FileHeader *)_map_data)->table_num;
+
+    return _tables.size ();
+}
+
+const PointFloat2 *
+GeoMapTableCache::get_table (uint32_t idx, uint32_t &width, uint32_t &height) const
+{
+    XCAM_FAIL_RETURN (
+        ERROR, idx < get_table_num (), NULL,
+        "geo map table cache get table failed, idx(%d) >= table num(%d)", idx, get_table_num ());
+
+    if (!is_loaded ()) {
+        width = _tables[idx].width;
+        height = _tables[idx].height;
+        return _tables[idx].data.data ();
+    }
+
+    const TableHeader &table = ((const TableHeader *)(_map_data + sizeof (FileHeader)))[idx];
+    width = table.width;
+    height = table.height;
+    return (const PointFloat2 *)(_map_data + table.offset);
+}
+
+bool
+GeoMapTableCache::add_table (const PointFloat2 *data, uint32_t width, uint32_t height)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, !is_loaded (), false,
+        "geo map table cache is loaded from file, add table failed");
+    XCAM_FAIL_RETURN (
+        ERROR, data && width && height && _tables.size () < GEO_MAP_TABLE_CACHE_MAX_TABLES, false,
+        "geo map table cache add table failed, width:%d, height:%d", width, height);
+
+    _tables.push_back (Table ());
+    Table &table = _tables.back ();
+    table.width = width;
+    table.height = height;
+    table.data.assign (data, data + width * height);
+    return true;
+}
+
+bool
+GeoMapTableCache::save (const char *path)
+{
+    XCAM_ASSERT (path);
+    XCAM_FAIL_RETURN (
+        ERROR, !is_loaded () && !_tables.empty (), false,
+        "geo map table cache has no new tables to save");
+
+    char tmp_path[XCAM_MAX_STR_SIZE];
+    snprintf (tmp_path, sizeof (tmp_path), "%s.%d.tmp", path, getpid ());
+
+    FILE *fp = fopen (tmp_path, "wb");
+    XCAM_FAIL_RETURN (
+        WARNING, fp, false,
+        "geo map table cache open file(%s) failed", tmp_path);
+
+    FileHeader header;
+    xcam_mem_clear (header);
+    header.magic = GEO_MAP_TABLE_CACHE_MAGIC;
+    header.version = XCAM_GEO_MAP_TABLE_CACHE_VERSION;
+    header.key = _key;
+    header.point_size = sizeof (PointFloat2);
+    header.table_num = _tables.size ();
+
+    std::vector<TableHeader> table_headers (_tables.size ());
+    uint64_t offset = sizeof (FileHeader) + sizeof (TableHeader) * _tables.size ();
+    for (size_t i = 0; i < _tables.size (); ++i) {
+        table_headers[i].width = _tables[i].width;
+        table_headers[i].height = _tables[i].height;
+        table_headers[i].offset = offset;
+        offset += _tables[i].data.size () * sizeof (PointFloat2);
+    }
+
+    bool ok = (fwrite (&header, sizeof (header), 1, fp) == 1);
+    ok = ok && (fwrite (table_headers.data (), sizeof (TableHeader), table_headers.size (), fp) == table_headers.size ());
+    for (size_t i = 0; ok && i < _tables.size (); ++i) {
+        ok = (fwrite (_tables[i].data.data (), sizeof (PointFloat2), _tables[i].data.size (), fp) == _tables[i].data.size ());
+    }
+    ok = (fclose (fp) == 0) && ok;
+
+    // rename keeps readers away from a partially written file
+    if (!ok || rename (tmp_path, path) != 0) {
+        XCAM_LOG_WARNING ("geo map table cache save file(%s) failed", path);
+        unlink (tmp_path);
+        return false;
+    }
+
+    XCAM_LOG_INFO ("geo map table cache saved to %s, table num:%d", path, header.table_num);
+    return true;
+}
+
+}
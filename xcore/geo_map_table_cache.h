@@ -0,0 +1,84 @@
+/*
+ * geo_map_table_cache.h - geometric map table cache
+ *
+ *  Copyright (c) 2017 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#ifndef XCAM_GEO_MAP_TABLE_CACHE_H
+#define XCAM_GEO_MAP_TABLE_CACHE_H
+
+#include <xcam_std.h>
+#include <interface/data_types.h>
+
+#define XCAM_GEO_MAP_TABLE_CACHE_VERSION 1
+#define XCAM_GEO_MAP_TABLE_HASH_SEED 0xcbf29ce484222325ULL
+
+namespace XCam {
+
+/* binary file of geometric map tables, laid out as
+ *   FileHeader | TableHeader[table_num] | PointFloat2 table data ...
+ * the key is a hash of all parameters the tables are generated from, load() only
+ * accepts a file with same magic, version and key; tables are read through mmap directly.
+ */
+class GeoMapTableCache
+{
+public:
+    explicit GeoMapTableCache (uint64_t key);
+    ~GeoMapTableCache ();
+
+    // FNV-1a, pass the last result as seed to hash more data
+    static uint64_t hash (const void *data, size_t size, uint64_t seed = XCAM_GEO_MAP_TABLE_HASH_SEED);
+    template <typename T>
+    static uint64_t hash_value (const T &value, uint64_t seed = XCAM_GEO_MAP_TABLE_HASH_SEED) {
+        return hash (&value, sizeof (T), seed);
+    }
+
+    uint64_t get_key () const {
+        return _key;
+    }
+
+    bool load (const char *path);
+    void unload ();
+    bool is_loaded () const {
+        return _map_data != NULL;
+    }
+
+    uint32_t get_table_num () const;
+    const PointFloat2 *get_table (uint32_t idx, uint32_t &width, uint32_t &height) const;
+
+    // tables are copied, save() writes all added tables to a temporary file then renames it
+    bool add_table (const PointFloat2 *data, uint32_t width, uint32_t height);
+    bool save (const char *path);
+
+private:
+    XCAM_DEAD_COPY (GeoMapTableCache);
+
+private:
+    struct Table {
+        uint32_t                  width, height;
+        std::vector<PointFloat2>  data;
+    };
+
+    uint64_t               _key;
+    uint8_t               *_map_data;
+    size_t                 _map_size;
+    std::vector<Table>     _tables;
+};
+
+}
+
+#endif //XCAM_GEO_MAP_TABLE_CACHE_H
@@ -20,9 +20,300 @@
  */
 
 #include "image_file_handle.h"
+#include "xcam_thread.h"
+#include <sys/mman.h>
+#include <unistd.h>
 
 namespace XCam {
 
+class ImageFileMapping
+{
+public:
+    ImageFileMapping (uint8_t *data, size_t size)
+        : _data (data)
+        , _size (size)
+    {}
+    ~ImageFileMapping () {
+        munmap (_data, _size);
+    }
+
+    uint8_t *get_data () const {
+        return _data;
+    }
+    size_t get_size () const {
+        return _size;
+    }
+
+private:
+    XCAM_DEAD_COPY (ImageFileMapping);
+
+private:
+    uint8_t    *_data;
+    size_t      _size;
+};
+
+class MappedFileVideoBuffer
+    : public VideoBuffer
+{
+public:
+    MappedFileVideoBuffer (
+        const VideoBufferInfo &info, const SmartPtr<ImageFileMapping> &mapping, uint8_t *data)
+        : VideoBuffer (info)
+        , _mapping (mapping)
+        , _data (data)
+    {}
+
+    virtual uint8_t *map () {
+        return _data;
+    }
+    virtual bool unmap () {
+        return true;
+    }
+    virtual int get_fd () {
+        return -1;
+    }
+
+private:
+    XCAM_DEAD_COPY (MappedFileVideoBuffer);
+
+private:
+    SmartPtr<ImageFileMapping>    _mapping;
+    uint8_t                      *_data;
+};
+
+static size_t
+get_packed_frame_size (const VideoBufferInfo &info)
+{
+    VideoBufferPlanarInfo planar;
+    size_t size = 0;
+
+    for (uint32_t index = 0; index < info.components; index++) {
+        info.get_planar_info (planar, index);
+        size += planar.width * planar.pixel_bytes * planar.height;
+    }
+    return size;
+}
+
+bool
+ImageFileHandle::is_packed_layout (const VideoBufferInfo &info)
+{
+    VideoBufferPlanarInfo planar;
+    size_t offset = 0;
+
+    for (uint32_t index = 0; index < info.components; index++) {
+        info.get_planar_info (planar, index);
+        uint32_t line_bytes = planar.width * planar.pixel_bytes;
+        if (info.strides [index] != line_bytes || info.offsets [index] != offset)
+            return false;
+        offset += line_bytes * planar.height;
+    }
+    return offset == info.size;
+}
+
+class ImageFileWriter
+{
+    class WriteThread
+        : public Thread
+    {
+    public:
+        explicit WriteThread (ImageFileWriter *writer)
+            : Thread ("image_file_writer")
+            , _writer (writer)
+        {}
+
+    protected:
+        virtual bool loop () {
+            return _writer->write_next ();
+        }
+
+    private:
+        ImageFileWriter   *_writer;
+    };
+
+public:
+    ImageFileWriter (FILE *fp, const char *name, uint32_t queue_depth);
+    ~ImageFileWriter ();
+
+    XCamReturn start ();
+    XCamReturn stop ();
+    XCamReturn push (const SmartPtr<VideoBuffer> &buf);
+    XCamReturn flush ();
+    uint32_t get_stall_count ();
+
+private:
+    bool write_next ();
+    XCamReturn write_frame (const SmartPtr<VideoBuffer> &buf);
+
+    XCAM_DEAD_COPY (ImageFileWriter);
+
+private:
+    FILE                  *_fp;
+    const char            *_name;
+    uint32_t               _queue_depth;
+    SmartPtr<WriteThread>  _thread;
+    Mutex                  _mutex;
+    Cond                   _cond;
+    VideoBufferList        _queue;
+    bool                   _stopped;
+    XCamReturn             _error;
+    uint32_t               _stall_count;
+
+    uint8_t               *_staging;
+    size_t                 _staging_size;
+};
+
+ImageFileWriter::ImageFileWriter (FILE *fp, const char *name, uint32_t queue_depth)
+    : _fp (fp)
+    , _name (name)
+    , _queue_depth (queue_depth)
+    , _stopped (false)
+    , _error (XCAM_RETURN_NO_ERROR)
+    , _stall_count (0)
+    , _staging (NULL)
+    , _staging_size (0)
+{
+    XCAM_ASSERT (fp && queue_depth);
+}
+
+ImageFileWriter::~ImageFileWriter ()
+{
+    stop ();
+    xcam_free (_staging);
+}
+
+XCamReturn
+ImageFileWriter::start ()
+{
+    _thread = new WriteThread (this);
+    XCAM_FAIL_RETURN (
+        ERROR, _thread->start (), XCAM_RETURN_ERROR_THREAD,
+        "image file(%s) start writer thread failed", XCAM_STR (_name));
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+ImageFileWriter::stop ()
+{
+    if (!_thread.ptr ())
+        return XCAM_RETURN_NO_ERROR;
+
+    // pending buffers are still saved before the thread quits
+    XCamReturn ret = flush ();
+    {
+        SmartLock locker (_mutex);
+        _stopped = true;
+        _cond.broadcast ();
+    }
+    _thread->stop ();
+    _thread.release ();
+    return ret;
+}
+
+XCamReturn
+ImageFileWriter::push (const SmartPtr<VideoBuffer> &buf)
+{
+    SmartLock locker (_mutex);
+    if (!xcam_ret_is_ok (_error))
+        return _error;
+
+    if (_queue.size () >= _queue_depth) {
+        ++_stall_count;
+        while (_queue.size () >= _queue_depth && !_stopped)
+            _cond.wait (_mutex);
+    }
+    XCAM_FAIL_RETURN (
+        WARNING, !_stopped, XCAM_RETURN_ERROR_ORDER,
+        "image file(%s) write buf failed, writer was stopped", XCAM_STR (_name));
+
+    _queue.push_back (buf);
+    _cond.broadcast ();
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+ImageFileWriter::flush ()
+{
+    SmartLock locker (_mutex);
+    while (!_queue.empty () && !_stopped)
+        _cond.wait (_mutex);
+    return _error;
+}
+
+uint32_t
+ImageFileWriter::get_stall_count ()
+{
+    SmartLock locker (_mutex);
+    return _stall_count;
+}
+
+bool
+ImageFileWriter::write_next ()
+{
+    SmartPtr<VideoBuffer> buf;
+    {
+        SmartLock locker (_mutex);
+        while (_queue.empty () && !_stopped)
+            _cond.wait (_mutex);
+        if (_queue.empty ())
+            return false;
+        // stays queued while written, so flush also waits for it
+        buf = _queue.front ();
+    }
+
+    XCamReturn ret = write_frame (buf);
+
+    SmartLock locker (_mutex);
+    _queue.pop_front ();
+    if (!xcam_ret_is_ok (ret) && xcam_ret_is_ok (_error))
+        _error = ret;
+    _cond.broadcast ();
+    return true;
+}
+
+XCamReturn
+ImageFileWriter::write_frame (const SmartPtr<VideoBuffer> &buf)
+{
+    const VideoBufferInfo &info = buf->get_video_info ();
+    VideoBufferPlanarInfo planar;
+    size_t frame_size = get_packed_frame_size (info);
+
+    uint8_t *memory = buf->map ();
+    XCAM_FAIL_RETURN (
+        WARNING, memory, XCAM_RETURN_ERROR_MEM,
+        "image file(%s) write buf failed, map buffer failed", XCAM_STR (_name));
+
+    // rows of padded buffers are gathered, so each frame goes to disk in one large write
+    const uint8_t *data = memory;
+    if (!ImageFileHandle::is_packed_layout (info)) {
+        if (_staging_size < frame_size) {
+            xcam_free (_staging);
+            _staging = (uint8_t *) xcam_malloc (frame_size);
+            _staging_size = _staging ? frame_size : 0;
+            XCAM_FAIL_RETURN (
+                WARNING, _staging, XCAM_RETURN_ERROR_MEM,
+                "image file(%s) write buf failed, alloc staging buffer failed", XCAM_STR (_name));
+        }
+
+        uint8_t *dest = _staging;
+        for (uint32_t index = 0; index < info.components; index++) {
+            info.get_planar_info (planar, index);
+            uint32_t line_bytes = planar.width * planar.pixel_bytes;
+            for (uint32_t i = 0; i < planar.height; i++) {
+                memcpy (dest, memory + info.offsets [index] + i * info.strides [index], line_bytes);
+                dest += line_bytes;
+            }
+        }
+        data = _staging;
+    }
+
+    size_t written = fwrite (data, 1, frame_size, _fp);
+    buf->unmap ();
+    XCAM_FAIL_RETURN (
+        WARNING, written == frame_size, XCAM_RETURN_ERROR_FILE,
+        "image file(%s) write buf failed, errno:%d", XCAM_STR (_name), errno);
+    return XCAM_RETURN_NO_ERROR;
+}
+
 ImageFileHandle::ImageFileHandle ()
 {
 }
@@ -37,6 +328,21 @@ ImageFileHandle::~ImageFileHandle ()
     close ();
 }
 
+XCamReturn
+ImageFileHandle::close ()
+{
+    XCamReturn ret = XCAM_RETURN_NO_ERROR;
+    if (_writer.ptr ()) {
+        ret = _writer->stop ();
+        _writer.release ();
+    }
+
+    // buffers from read_mapped_buf still hold the mapping
+    _mapping.release ();
+    FileHandle::close ();
+    return ret;
+}
+
 XCamReturn
 ImageFileHandle::read_buf (const SmartPtr<VideoBuffer> &buf)
 {
@@ -46,6 +352,8 @@ ImageFileHandle::read_buf (const SmartPtr<VideoBuffer> &buf)
     XCamReturn ret = XCAM_RETURN_NO_ERROR;
 
     XCAM_ASSERT (is_valid ());
+    if (_mapping.ptr ())
+        return copy_mapped_buf (buf);
 
     memory = buf->map ();
     for (uint32_t index = 0; index < info.components; index++) {
@@ -76,6 +384,8 @@ ImageFileHandle::write_buf (const SmartPtr<VideoBuffer> &buf)
     XCamReturn ret = XCAM_RETURN_NO_ERROR;
 
     XCAM_ASSERT (is_valid ());
+    if (_writer.ptr ())
+        return _writer->push (buf);
 
     memory = buf->map ();
     for (uint32_t index = 0; index < info.components; index++) {
@@ -93,4 +403,177 @@ ImageFileHandle::write_buf (const SmartPtr<VideoBuffer> &buf)
     return ret;
 }
 
+XCamReturn
+ImageFileHandle::map_file ()
+{
+    XCAM_FAIL_RETURN (
+        WARNING, is_valid (), XCAM_RETURN_ERROR_PARAM,
+        "image file(%s) map failed, file is not open", XCAM_STR (get_file_name ()));
+
+    if (_mapping.ptr ())
+        return XCAM_RETURN_NO_ERROR;
+
+    size_t size = 0;
+    XCamReturn ret = get_file_size (size);
+    XCAM_FAIL_RETURN (
+        WARNING, xcam_ret_is_ok (ret), ret,
+        "image file(%s) map failed, get file size failed", XCAM_STR (get_file_name ()));
+
+    // private writable pages, consumers writing in place get copy-on-write pages
+    void *data = mmap (NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fileno (_fp), 0);
+    XCAM_FAIL_RETURN (
+        WARNING, data != MAP_FAILED, XCAM_RETURN_ERROR_FILE,
+        "image file(%s) mmap failed, errno:%d", XCAM_STR (get_file_name ()), errno);
+
+    if (madvise (data, size, MADV_SEQUENTIAL) < 0) {
+        XCAM_LOG_DEBUG ("image file(%s) madvise sequential failed, errno:%d", XCAM_STR (get_file_name ()), errno);
+    }
+
+    _mapping = new ImageFileMapping ((uint8_t *)data, size);
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+ImageFileHandle::map_next_bytes (size_t size, uint8_t *&data)
+{
+    XCAM_ASSERT (_mapping.ptr ());
+    size_t map_size = _mapping->get_size ();
+
+    // file position is kept in FILE, so rewind and fread users still work on a mapped file
+    off_t pos = ftello (_fp);
+    XCAM_FAIL_RETURN (
+        WARNING, pos >= 0, XCAM_RETURN_ERROR_FILE,
+        "image file(%s) get position failed, errno:%d", XCAM_STR (get_file_name ()), errno);
+
+    if ((size_t)pos + size > map_size) {
+        fseeko (_fp, 0, SEEK_END);
+        return XCAM_RETURN_BYPASS;
+    }
+
+    size_t next = (size_t)pos + size;
+    XCAM_FAIL_RETURN (
+        WARNING, fseeko (_fp, next, SEEK_SET) == 0, XCAM_RETURN_ERROR_FILE,
+        "image file(%s) seek failed, errno:%d", XCAM_STR (get_file_name ()), errno);
+    data = _mapping->get_data () + pos;
+
+    // read ahead pages of the next frame while this one is processed
+    if (next < map_size) {
+        static const size_t page_size = sysconf (_SC_PAGESIZE);
+        size_t start = XCAM_ALIGN_DOWN (next, page_size);
+        size_t len = XCAM_MIN (size + next - start, map_size - start);
+        madvise (_mapping->get_data () + start, len, MADV_WILLNEED);
+    }
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+uint8_t *
+ImageFileHandle::get_mapped_data (size_t offset, size_t size)
+{
+    if (!_mapping.ptr () || offset > _mapping->get_size () || size > _mapping->get_size () - offset)
+        return NULL;
+    return _mapping->get_data () + offset;
+}
+
+SmartPtr<VideoBuffer>
+ImageFileHandle::create_mapped_buf (const VideoBufferInfo &info, uint8_t *data)
+{
+    XCAM_ASSERT (_mapping.ptr ());
+    XCAM_ASSERT (data >= _mapping->get_data () && data < _mapping->get_data () + _mapping->get_size ());
+
+    return new MappedFileVideoBuffer (info, _mapping, data);
+}
+
+XCamReturn
+ImageFileHandle::copy_mapped_buf (const SmartPtr<VideoBuffer> &buf)
+{
+    const VideoBufferInfo info = buf->get_video_info ();
+    VideoBufferPlanarInfo planar;
+    uint8_t *src = NULL;
+
+    XCamReturn ret = map_next_bytes (get_packed_frame_size (info), src);
+    if (ret != XCAM_RETURN_NO_ERROR)
+        return ret;
+
+    uint8_t *memory = buf->map ();
+    XCAM_FAIL_RETURN (
+        WARNING, memory, XCAM_RETURN_ERROR_MEM,
+        "image file(%s) read buf failed, map buffer failed", XCAM_STR (get_file_name ()));
+
+    for (uint32_t index = 0; index < info.components; index++) {
+        info.get_planar_info (planar, index);
+        uint32_t line_bytes = planar.width * planar.pixel_bytes;
+        uint8_t *dest = memory + info.offsets [index];
+
+        if (info.strides [index] == line_bytes) {
+            memcpy (dest, src, line_bytes * planar.height);
+        } else {
+            for (uint32_t i = 0; i < planar.height; i++)
+                memcpy (dest + i * info.strides [index], src + i * line_bytes, line_bytes);
+        }
+        src += line_bytes * planar.height;
+    }
+    buf->unmap ();
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+ImageFileHandle::read_mapped_buf (const VideoBufferInfo &info, SmartPtr<VideoBuffer> &buf)
+{
+    XCAM_FAIL_RETURN (
+        WARNING, _mapping.ptr (), XCAM_RETURN_ERROR_ORDER,
+        "image file(%s) read mapped buf failed, file is not mapped", XCAM_STR (get_file_name ()));
+    XCAM_FAIL_RETURN (
+        WARNING, is_packed_layout (info), XCAM_RETURN_ERROR_PARAM,
+        "image file(%s) read mapped buf failed, buffer layout(%dx%d, stride:%d) is not packed",
+        XCAM_STR (get_file_name ()), info.width, info.height, info.strides [0]);
+
+    uint8_t *data = NULL;
+    XCamReturn ret = map_next_bytes (info.size, data);
+    if (ret != XCAM_RETURN_NO_ERROR)
+        return ret;
+
+    buf = create_mapped_buf (info, data);
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+ImageFileHandle::start_async_write (uint32_t queue_depth)
+{
+    XCAM_FAIL_RETURN (
+        WARNING, is_valid (), XCAM_RETURN_ERROR_PARAM,
+        "image file(%s) start async write failed, file is not open", XCAM_STR (get_file_name ()));
+    XCAM_FAIL_RETURN (
+        WARNING, queue_depth > 0, XCAM_RETURN_ERROR_PARAM,
+        "image file(%s) start async write failed, queue depth can NOT be 0", XCAM_STR (get_file_name ()));
+
+    if (_writer.ptr ())
+        return XCAM_RETURN_NO_ERROR;
+
+    SmartPtr<ImageFileWriter> writer = new ImageFileWriter (_fp, get_file_name (), queue_depth);
+    XCamReturn ret = writer->start ();
+    if (!xcam_ret_is_ok (ret))
+        return ret;
+
+    _writer = writer;
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+ImageFileHandle::flush ()
+{
+    if (_writer.ptr ())
+        return _writer->flush ();
+
+    if (!is_valid ())
+        return XCAM_RETURN_ERROR_FILE;
+    return (fflush (_fp) == 0) ? XCAM_RETURN_NO_ERROR : XCAM_RETURN_ERROR_FILE;
+}
+
+uint32_t
+ImageFileHandle::get_write_stalls () const
+{
+    return _writer.ptr () ? _writer->get_stall_count () : 0;
+}
+
 }
@@ -27,6 +27,9 @@
 
 namespace XCam {
 
+class ImageFileMapping;
+class ImageFileWriter;
+
 class ImageFileHandle
     : public FileHandle
 {
@@ -35,11 +38,50 @@ public:
     explicit ImageFileHandle (const char *name, const char *option);
     virtual ~ImageFileHandle ();
 
+    virtual XCamReturn close ();
+
     XCamReturn read_buf (const SmartPtr<VideoBuffer> &buf);
     XCamReturn write_buf (const SmartPtr<VideoBuffer> &buf);
 
+    // map the whole file opened for reading, then reads are served from file pages
+    XCamReturn map_file ();
+    bool is_mapped () const {
+        return _mapping.ptr () ? true : false;
+    }
+
+    // next frame aliasing file pages, info must be tightly packed(strides equal to line bytes),
+    // buf stays valid after file closed, otherwise use read_buf to copy into a padded buffer
+    XCamReturn read_mapped_buf (const VideoBufferInfo &info, SmartPtr<VideoBuffer> &buf);
+    // planes are contiguous and strides equal to line bytes, i.e. info fits read_mapped_buf
+    static bool is_packed_layout (const VideoBufferInfo &info);
+
+    // afterwards write_buf only queues buffer refs and a writer thread saves them in order,
+    // one write per frame; queued buffers must not be modified, write_buf blocks while
+    // queue_depth buffers are pending
+    XCamReturn start_async_write (uint32_t queue_depth = 4);
+    bool is_async_write () const {
+        return _writer.ptr () ? true : false;
+    }
+    // wait until all queued buffers are written, returns the first write error
+    XCamReturn flush ();
+    // times write_buf blocked on a full queue, i.e. disk was slower than processing
+    uint32_t get_write_stalls () const;
+
+protected:
+    XCamReturn map_next_bytes (size_t size, uint8_t *&data);
+    // NULL if [offset, offset + size) is out of mapped file
+    uint8_t *get_mapped_data (size_t offset, size_t size);
+    SmartPtr<VideoBuffer> create_mapped_buf (const VideoBufferInfo &info, uint8_t *data);
+
+private:
+    XCamReturn copy_mapped_buf (const SmartPtr<VideoBuffer> &buf);
+
 private:
     XCAM_DEAD_COPY (ImageFileHandle);
+
+private:
+    SmartPtr<ImageFileMapping>    _mapping;
+    SmartPtr<ImageFileWriter>     _writer;
 };
 
 }
@@ -21,6 +21,7 @@
 
 #include "stitcher.h"
 #include "xcam_utils.h"
+#include "surview_fisheye_dewarp.h"
 
 // angle to position, output range [-180, 180]
 #define OUT_WINDOWS_START 0.0f
@@ -79,6 +80,8 @@ split_area_by_out (
 Stitcher::Stitcher (uint32_t align_x, uint32_t align_y)
     : _is_crop_set (false)
     , _scale_mode (ScaleSingleConst)
+    , _table_cache_path (NULL)
+    , _need_seam (false)
     , _alignment_x (align_x)
     , _alignment_y (align_y)
     , _output_width (0)
@@ -95,6 +98,137 @@ Stitcher::Stitcher (uint32_t align_x, uint32_t align_y)
 
 Stitcher::~Stitcher ()
 {
+    if (_table_cache_path)
+        xcam_free (_table_cache_path);
+}
+
+bool
+Stitcher::set_table_cache_path (const char *path)
+{
+    if (_table_cache_path)
+        xcam_free (_table_cache_path);
+    _table_cache_path = path ? strndup (path, XCAM_MAX_STR_SIZE) : NULL;
+    return true;
+}
+
+XCamReturn
+Stitcher::update_geo_tables ()
+{
+    XCAM_LOG_WARNING ("stitcher: update geo tables is not supported");
+    return XCAM_RETURN_ERROR_PARAM;
+}
+
+XCamReturn
+Stitcher::render_viewport (
+    const ViewportPose &pose, uint32_t width, uint32_t height,
+    const VideoBufferList &in_bufs, SmartPtr<VideoBuffer> &out_buf)
+{
+    XCAM_UNUSED (pose);
+    XCAM_UNUSED (width);
+    XCAM_UNUSED (height);
+    XCAM_UNUSED (in_bufs);
+    XCAM_UNUSED (out_buf);
+
+    XCAM_LOG_WARNING ("stitcher: render viewport is not supported");
+    return XCAM_RETURN_ERROR_PARAM;
+}
+
+static bool
+intersect_bowl (
+    const BowlDataConfig &bowl, const PointFloat3 &origin, const PointFloat3 &dir, PointFloat3 &hit)
+{
+    // ground is the ellipse where wall meets z = 0
+    if (dir.z < 0.0f && origin.z > 0.0f) {
+        float t = -origin.z / dir.z;
+        float x = origin.x + t * dir.x;
+        float y = origin.y + t * dir.y;
+        float ground_ratio = 1.0f - bowl.center_z * bowl.center_z / (bowl.c * bowl.c);
+        if (x * x / (bowl.a * bowl.a) + y * y / (bowl.b * bowl.b) <= ground_ratio) {
+            hit = PointFloat3 (x, y, 0.0f);
+            return true;
+        }
+    }
+
+    // wall is seen from inside, take the far intersection of ellipsoid
+    float ox = origin.x / bowl.a, oy = origin.y / bowl.b, oz = (origin.z - bowl.center_z) / bowl.c;
+    float dx = dir.x / bowl.a, dy = dir.y / bowl.b, dz = dir.z / bowl.c;
+    float qa = dx * dx + dy * dy + dz * dz;
+    float qb = 2.0f * (ox * dx + oy * dy + oz * dz);
+    float qc = ox * ox + oy * oy + oz * oz - 1.0f;
+    float delta = qb * qb - 4.0f * qa * qc;
+    if (delta < 0.0f)
+        return false;
+
+    float t = (-qb + sqrtf (delta)) / (2.0f * qa);
+    if (t <= 0.0f)
+        return false;
+
+    hit = PointFloat3 (origin.x + t * dir.x, origin.y + t * dir.y, origin.z + t * dir.z);
+    return hit.z >= 0.0f && hit.z <= bowl.wall_height;
+}
+
+XCamReturn
+Stitcher::calc_viewport_map (
+    const ViewportPose &pose, uint32_t width, uint32_t height, ViewportMap &map) const
+{
+    XCAM_FAIL_RETURN (
+        ERROR, width && height && pose.fov > 0.0f && pose.fov < 180.0f, XCAM_RETURN_ERROR_PARAM,
+        "stitcher: invalid viewport(w:%d, h:%d, fov:%.2f)", width, height, pose.fov);
+    XCAM_FAIL_RETURN (
+        ERROR, _camera_num, XCAM_RETURN_ERROR_ORDER,
+        "stitcher: calculate viewport map failed, camera num was not set");
+
+    std::vector<SmartPtr<PolyFisheyeDewarp> > dewarps (_camera_num);
+    std::vector<float> center_angles (_camera_num);
+    for (uint32_t i = 0; i < _camera_num; ++i) {
+        dewarps[i] = new PolyFisheyeDewarp;
+        dewarps[i]->set_intrinsic_param (_camera_info[i].calibration.intrinsic);
+        dewarps[i]->set_extrinsic_param (_camera_info[i].calibration.extrinsic);
+        center_angles[i] = format_angle (_camera_info[i].round_angle_start + _camera_info[i].angle_range / 2.0f);
+    }
+
+    float yaw = degree2radian (pose.yaw);
+    float pitch = degree2radian (pose.pitch);
+    PointFloat3 forward (cosf (pitch) * cosf (yaw), cosf (pitch) * sinf (yaw), sinf (pitch));
+    PointFloat3 right (sinf (yaw), -cosf (yaw), 0.0f);
+    PointFloat3 up (
+        right.y * forward.z - right.z * forward.y,
+        right.z * forward.x - right.x * forward.z,
+        right.x * forward.y - right.y * forward.x);
+    float pixel_step = tanf (degree2radian (pose.fov) / 2.0f) / (width / 2.0f);
+
+    map.resize (width * height);
+    for (uint32_t row = 0; row < height; ++row) {
+        float v = ((height - 1) / 2.0f - row) * pixel_step;
+        for (uint32_t col = 0; col < width; ++col) {
+            ViewportPoint &point = map[row * width + col];
+            point.cam_idx = INVALID_INDEX;
+
+            float u = (col - (width - 1) / 2.0f) * pixel_step;
+            PointFloat3 dir (
+                forward.x + u * right.x + v * up.x,
+                forward.y + u * right.y + v * up.y,
+                forward.z + u * right.z + v * up.z);
+            PointFloat3 world;
+            if (!intersect_bowl (_bowl_config, pose.position, dir, world))
+                continue;
+
+            // same angle as bowl view, pick the camera whose slice center is nearest
+            float angle = format_angle (radian2degree (atan2f (-world.y, world.x)));
+            float min_diff = 360.0f;
+            for (uint32_t i = 0; i < _camera_num; ++i) {
+                float diff = format_angle (angle - center_angles[i]);
+                diff = XCAM_MIN (diff, 360.0f - diff);
+                if (diff < min_diff) {
+                    min_diff = diff;
+                    point.cam_idx = i;
+                }
+            }
+            dewarps[point.cam_idx]->world_to_image (world, point.pos);
+        }
+    }
+
+    return XCAM_RETURN_NO_ERROR;
 }
 
 bool
@@ -111,7 +245,17 @@ Stitcher::set_camera_num (uint32_t num)
         ERROR, num <= XCAM_STITCH_MAX_CAMERAS, false,
         "stitcher: set camera count failed, num(%d) is larger than max value(%d)",
         num, XCAM_STITCH_MAX_CAMERAS);
+    XCAM_FAIL_RETURN (
+        ERROR, !_is_round_view_set, false,
+        "stitcher: set camera count failed, round view slices were already estimated");
+
     _camera_num = num;
+    _camera_info.resize (num);
+    _round_view_slices.resize (num);
+    _overlap_info.resize (num);
+    _center_marks.resize (num);
+    _crop_info.resize (num);
+    _scale_factors.resize (num);
     return true;
 }
 
@@ -178,9 +322,9 @@ bool
 Stitcher::get_camera_info (uint32_t index, CameraInfo &info) const
 {
     XCAM_FAIL_RETURN (
-        ERROR, index < XCAM_STITCH_MAX_CAMERAS, false,
-        "stitcher: get camera info failed, index(%d) exceed max camera value(%d)",
-        index, XCAM_STITCH_MAX_CAMERAS);
+        ERROR, index < _camera_num, false,
+        "stitcher: get camera info failed, index(%d) exceed camera num(%d)",
+        index, _camera_num);
     info = _camera_info[index];
     return true;
 }
@@ -192,9 +336,8 @@ Stitcher::estimate_round_slices ()
         return XCAM_RETURN_NO_ERROR;
 
     XCAM_FAIL_RETURN (
-        ERROR, _camera_num && _camera_num < XCAM_STITCH_MAX_CAMERAS, XCAM_RETURN_ERROR_PARAM,
-        "stitcher: camera num was not set, or camera num(%d) exceed max camera value(%d)",
-        _camera_num, XCAM_STITCH_MAX_CAMERAS);
+        ERROR, _camera_num, XCAM_RETURN_ERROR_PARAM,
+        "stitcher: camera num was not set");
 
     for (uint32_t i = 0; i < _camera_num; ++i) {
         CameraInfo &cam_info = _camera_info[i];
@@ -28,7 +28,8 @@
 #include <video_buffer.h>
 
 #define XCAM_STITCH_FISHEYE_MAX_NUM    6
-#define XCAM_STITCH_MAX_CAMERAS XCAM_STITCH_FISHEYE_MAX_NUM
+// sanity limit of Stitcher, camera containers are sized by camera num
+#define XCAM_STITCH_MAX_CAMERAS 16
 #define XCAM_STITCH_MIN_SEAM_WIDTH 56
 
 #define INVALID_INDEX (uint32_t)(-1)
@@ -41,6 +42,11 @@ enum StitchResMode {
     StitchRes4K
 };
 
+enum StitchEngine {
+    StitchEngineStaged = 0,  // dewarp whole slices, then blend overlaps and copy areas
+    StitchEngineFusedTiles   // dewarp, blend and write output tiles, one tile per work item
+};
+
 struct StitchInfo {
     uint32_t merge_width[XCAM_STITCH_FISHEYE_MAX_NUM];
 
@@ -70,6 +76,22 @@ struct CameraInfo {
     float             angle_range;;
 };
 
+/*
+ * virtual pinhole camera looking at the bowl from inside
+ * yaw: degree, 0 looks along x axis(front), 90 looks along y axis(left)
+ * pitch: degree, positive looks up, -90 looks down to the ground
+ */
+struct ViewportPose {
+    PointFloat3       position; // unit mm, in bowl coordinate
+    float             yaw;
+    float             pitch;
+    float             fov;      // horizontal field of view, degree
+
+    ViewportPose ()
+        : yaw (0.0f), pitch (0.0f), fov (90.0f)
+    {}
+};
+
 class Stitcher
 {
 public:
@@ -121,11 +143,21 @@ public:
     };
     typedef std::vector<CopyArea>  CopyAreaArray;
 
+    struct ViewportPoint {
+        uint32_t       cam_idx;
+        PointFloat2    pos;
+
+        ViewportPoint ()
+            : cam_idx (INVALID_INDEX)
+        {}
+    };
+    typedef std::vector<ViewportPoint>  ViewportMap;
+
 public:
     explicit Stitcher (uint32_t align_x, uint32_t align_y = 1);
     virtual ~Stitcher ();
     static SmartPtr<Stitcher> create_ocl_stitcher ();
-    static SmartPtr<Stitcher> create_soft_stitcher ();
+    static SmartPtr<Stitcher> create_soft_stitcher (StitchEngine engine = StitchEngineStaged);
 
     bool set_bowl_config (const BowlDataConfig &config);
     const BowlDataConfig &get_bowl_config () {
@@ -166,8 +198,34 @@ public:
         return _scale_mode;
     }
 
+    // find seams in overlaps and blend around them, instead of blending the whole overlaps
+    void set_need_seam (bool need_seam) {
+        _need_seam = need_seam;
+    }
+    bool get_need_seam () const {
+        return _need_seam;
+    }
+
+    // geometric map tables are loaded from/saved to this file, NULL disables the cache
+    bool set_table_cache_path (const char *path);
+    const char *get_table_cache_path () const {
+        return _table_cache_path;
+    }
+
     virtual XCamReturn stitch_buffers (const VideoBufferList &in_bufs, SmartPtr<VideoBuffer> &out_buf) = 0;
 
+    // rebuild geometric tables after camera calibration or bowl config changed at runtime,
+    // new tables are built in background and take effect together on a following frame.
+    // output size, camera number and view angles can't be changed without a new stitcher
+    virtual XCamReturn update_geo_tables ();
+
+    // render a virtual camera view from fisheye buffers directly, without stitching the round view,
+    // out_buf is allocated if it's NULL. maps are cached per pose and size, it can be called
+    // from multiple threads for different viewports
+    virtual XCamReturn render_viewport (
+        const ViewportPose &pose, uint32_t width, uint32_t height,
+        const VideoBufferList &in_bufs, SmartPtr<VideoBuffer> &out_buf);
+
 protected:
     XCamReturn estimate_round_slices ();
     virtual XCamReturn estimate_coarse_crops ();
@@ -175,6 +233,10 @@ protected:
     XCamReturn estimate_overlap ();
     XCamReturn update_copy_areas ();
 
+    // fisheye position of each viewport pixel, pixels out of the bowl get INVALID_INDEX
+    XCamReturn calc_viewport_map (
+        const ViewportPose &pose, uint32_t width, uint32_t height, ViewportMap &map) const;
+
     const CenterMark &get_center (uint32_t idx) const {
         return _center_marks[idx];
     }
@@ -195,27 +257,29 @@ private:
     XCAM_DEAD_COPY (Stitcher);
 
 protected:
-    ImageCropInfo               _crop_info[XCAM_STITCH_MAX_CAMERAS];
+    std::vector<ImageCropInfo>  _crop_info;
     bool                        _is_crop_set;
     GeoMapScaleMode             _scale_mode;
+    char                       *_table_cache_path;
+    bool                        _need_seam;
     //update after each feature match
-    ScaleFactor                 _scale_factors[XCAM_STITCH_MAX_CAMERAS];
+    std::vector<ScaleFactor>    _scale_factors;
 
 private:
     uint32_t                    _alignment_x, _alignment_y;
     uint32_t                    _output_width, _output_height;
     float                       _out_start_angle;
     uint32_t                    _camera_num;
-    CameraInfo                  _camera_info[XCAM_STITCH_MAX_CAMERAS];
-    RoundViewSlice              _round_view_slices[XCAM_STITCH_MAX_CAMERAS];
+    std::vector<CameraInfo>     _camera_info;
+    std::vector<RoundViewSlice> _round_view_slices;
     bool                        _is_round_view_set;
 
-    ImageOverlapInfo            _overlap_info[XCAM_STITCH_MAX_CAMERAS];
+    std::vector<ImageOverlapInfo> _overlap_info;
     BowlDataConfig              _bowl_config;
     bool                        _is_overlap_set;
 
     //auto calculation
-    CenterMark                  _center_marks[XCAM_STITCH_MAX_CAMERAS];
+    std::vector<CenterMark>     _center_marks;
     bool                        _is_center_marked;
     CopyAreaArray               _copy_areas;
 };
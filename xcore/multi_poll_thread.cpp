@@ -0,0 +1,407 @@
+/*
+ * multi_poll_thread.cpp - poll thread for multiple capture devices
+ *
+ *  Copyright (c) 2017 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#include "multi_poll_thread.h"
+#include "xcam_thread.h"
+#include "v4l2_buffer_proxy.h"
+#include <sys/epoll.h>
+#include <unistd.h>
+#include <time.h>
+
+namespace XCam {
+
+FrameSetAligner::FrameSetAligner (uint32_t source_count)
+    : _pending (source_count)
+    , _tolerance (0)
+    , _max_pending (1)
+{
+}
+
+void
+FrameSetAligner::set_source_count (uint32_t count)
+{
+    clear ();
+    _pending.resize (count);
+}
+
+void
+FrameSetAligner::push (uint32_t source, const SmartPtr<VideoBuffer> &buf, DroppedFrameList &dropped)
+{
+    XCAM_ASSERT (source < _pending.size () && buf.ptr ());
+
+    VideoBufferList &pending = _pending[source];
+    while (pending.size () >= _max_pending) {
+        dropped.push_back (DroppedFrame (source, pending.front ()->get_timestamp ()));
+        pending.pop_front ();
+    }
+    pending.push_back (buf);
+}
+
+bool
+FrameSetAligner::pop_set (VideoBufferList &set, DroppedFrameList &dropped)
+{
+    if (_pending.empty ())
+        return false;
+
+    while (true) {
+        int64_t newest = 0;
+        for (uint32_t i = 0; i < _pending.size (); ++i) {
+            if (_pending[i].empty ())
+                return false;
+            int64_t ts = _pending[i].front ()->get_timestamp ();
+            if (i == 0 || ts > newest)
+                newest = ts;
+        }
+
+        // heads older than tolerance can't match newest head, nor any later buffers
+        bool aligned = true;
+        for (uint32_t i = 0; i < _pending.size (); ++i) {
+            VideoBufferList &pending = _pending[i];
+            while (!pending.empty () && pending.front ()->get_timestamp () < newest - _tolerance) {
+                dropped.push_back (DroppedFrame (i, pending.front ()->get_timestamp ()));
+                pending.pop_front ();
+                aligned = false;
+            }
+        }
+        if (!aligned)
+            continue;
+
+        for (uint32_t i = 0; i < _pending.size (); ++i) {
+            set.push_back (_pending[i].front ());
+            _pending[i].pop_front ();
+        }
+        return true;
+    }
+}
+
+void
+FrameSetAligner::clear ()
+{
+    for (uint32_t i = 0; i < _pending.size (); ++i)
+        _pending[i].clear ();
+}
+
+class MultiCaptureLoop
+    : public Thread
+{
+public:
+    MultiCaptureLoop (MultiPollThread *poll)
+        : Thread ("multi_capture_poll")
+        , _poll (poll)
+    {}
+
+protected:
+    virtual bool loop () {
+        XCamReturn ret = _poll->poll_devices (MultiPollThread::default_capture_event_timeout);
+
+        if (ret == XCAM_RETURN_NO_ERROR || ret == XCAM_RETURN_ERROR_TIMEOUT)
+            return true;
+        return false;
+    }
+
+private:
+    MultiPollThread   *_poll;
+};
+
+const int MultiPollThread::default_capture_event_timeout = 100; // ms
+const int64_t MultiPollThread::default_sync_tolerance = 5000; // us
+const uint32_t MultiPollThread::default_max_pending = 2;
+const uint32_t MultiPollThread::max_batch_count = 8;
+const uint32_t MultiPollThread::max_device_count = 16;
+const int MultiPollThread::error_retry_interval = 10; // ms
+
+static int64_t
+get_monotonic_time ()
+{
+    struct timespec ts;
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+MultiPollThread::MultiPollThread ()
+    : _callback (NULL)
+    , _epoll_fd (-1)
+    , _set_count (0)
+    , _dropped_count (0)
+{
+    SmartPtr<MultiCaptureLoop> capture_loop = new MultiCaptureLoop (this);
+    XCAM_ASSERT (capture_loop.ptr ());
+    _capture_loop = capture_loop;
+
+    _aligner.set_tolerance (default_sync_tolerance);
+    _aligner.set_max_pending (default_max_pending);
+
+    XCAM_LOG_DEBUG ("MultiPollThread constructed");
+}
+
+MultiPollThread::~MultiPollThread ()
+{
+    stop ();
+
+    XCAM_LOG_DEBUG ("~MultiPollThread destructed");
+}
+
+bool
+MultiPollThread::add_capture_device (const SmartPtr<V4l2Device> &dev)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, dev.ptr () && _epoll_fd < 0 && _devices.size () < max_device_count, false,
+        "multi poll thread add device failed, device is null, thread was started or too many devices");
+
+    _devices.push_back (dev);
+    return true;
+}
+
+bool
+MultiPollThread::set_frame_set_callback (FrameSetCallback *callback)
+{
+    XCAM_ASSERT (!_callback);
+    _callback = callback;
+    return true;
+}
+
+bool
+MultiPollThread::set_sync_tolerance (int64_t usec)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, usec >= 0 && _epoll_fd < 0, false,
+        "multi poll thread set sync tolerance(%" PRId64 ") failed", usec);
+
+    _aligner.set_tolerance (usec);
+    return true;
+}
+
+bool
+MultiPollThread::set_max_pending (uint32_t count)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, count > 0 && _epoll_fd < 0, false,
+        "multi poll thread set max pending(%d) failed", count);
+
+    _aligner.set_max_pending (count);
+    return true;
+}
+
+XCamReturn
+MultiPollThread::start ()
+{
+    XCAM_FAIL_RETURN (
+        ERROR, !_devices.empty () && _callback, XCAM_RETURN_ERROR_PARAM,
+        "multi poll thread start failed, devices or callback was not set");
+    XCAM_FAIL_RETURN (
+        ERROR, _epoll_fd < 0, XCAM_RETURN_ERROR_PARAM,
+        "multi poll thread was already started");
+
+    _epoll_fd = epoll_create1 (EPOLL_CLOEXEC);
+    XCAM_FAIL_RETURN (
+        ERROR, _epoll_fd >= 0, XCAM_RETURN_ERROR_FILE,
+        "multi poll thread create epoll failed");
+
+    for (uint32_t i = 0; i < _devices.size (); ++i) {
+        struct epoll_event event;
+        xcam_mem_clear (event);
+        event.events = EPOLLIN;
+        event.data.u32 = i;
+
+        if (epoll_ctl (_epoll_fd, EPOLL_CTL_ADD, _devices[i]->get_fd (), &event) < 0) {
+            XCAM_LOG_ERROR (
+                "multi poll thread add device(%s) to epoll failed",
+                XCAM_STR (_devices[i]->get_device_name ()));
+            stop ();
+            return XCAM_RETURN_ERROR_FILE;
+        }
+    }
+
+    _retry_time.assign (_devices.size (), 0);
+    _aligner.set_source_count (_devices.size ());
+    _set_count = 0;
+    _dropped_count = 0;
+
+    if (!_capture_loop->start ()) {
+        stop ();
+        return XCAM_RETURN_ERROR_THREAD;
+    }
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+MultiPollThread::stop ()
+{
+    _capture_loop->stop ();
+
+    // pending buffers go back to devices
+    _aligner.clear ();
+    if (_epoll_fd >= 0) {
+        ::close (_epoll_fd);
+        _epoll_fd = -1;
+    }
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+MultiPollThread::dequeue_device (uint32_t index, VideoBufferList &bufs)
+{
+    SmartPtr<V4l2Device> &dev = _devices[index];
+    XCamReturn ret = XCAM_RETURN_NO_ERROR;
+
+    // epoll reported the first buffer, the rest are taken only if ready, so dequeue never blocks
+    for (uint32_t i = 0; i < max_batch_count; ++i) {
+        if (i > 0 && dev->poll_event (0) <= 0)
+            break;
+
+        SmartPtr<V4l2Buffer> buf;
+        ret = dev->dequeue_buffer (buf);
+        if (ret != XCAM_RETURN_NO_ERROR) {
+            XCAM_LOG_WARNING ("capture device(%s) dequeue buffer failed", XCAM_STR (dev->get_device_name ()));
+            return bufs.empty () ? ret : XCAM_RETURN_NO_ERROR;
+        }
+        XCAM_ASSERT (buf.ptr ());
+        bufs.push_back (new V4l2BufferProxy (buf, dev));
+    }
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+void
+MultiPollThread::suspend_device (uint32_t index, int64_t now)
+{
+    // EPOLLERR and EPOLLHUP are reported whatever the event mask is, device has to leave epoll
+    if (epoll_ctl (_epoll_fd, EPOLL_CTL_DEL, _devices[index]->get_fd (), NULL) < 0) {
+        XCAM_LOG_WARNING (
+            "multi poll thread remove device(%s) from epoll failed",
+            XCAM_STR (_devices[index]->get_device_name ()));
+        return;
+    }
+    _retry_time[index] = now + error_retry_interval * 1000;
+}
+
+int
+MultiPollThread::resume_devices (int64_t now, int timeout_msec)
+{
+    for (uint32_t i = 0; i < _devices.size (); ++i) {
+        if (!_retry_time[i])
+            continue;
+
+        if (_retry_time[i] > now) {
+            int retry_msec = (_retry_time[i] - now + 999) / 1000;
+            if (timeout_msec < 0 || retry_msec < timeout_msec)
+                timeout_msec = retry_msec;
+            continue;
+        }
+
+        struct epoll_event event;
+        xcam_mem_clear (event);
+        event.events = EPOLLIN;
+        event.data.u32 = i;
+        if (epoll_ctl (_epoll_fd, EPOLL_CTL_ADD, _devices[i]->get_fd (), &event) < 0) {
+            XCAM_LOG_WARNING (
+                "multi poll thread add device(%s) back to epoll failed",
+                XCAM_STR (_devices[i]->get_device_name ()));
+            continue;
+        }
+        _retry_time[i] = 0;
+    }
+    return timeout_msec;
+}
+
+XCamReturn
+MultiPollThread::poll_devices (int timeout_msec)
+{
+    struct epoll_event events[max_device_count];
+    DroppedFrameList dropped;
+
+    timeout_msec = resume_devices (get_monotonic_time (), timeout_msec);
+    int count = epoll_wait (_epoll_fd, events, max_device_count, timeout_msec);
+    if (count < 0) {
+        if (errno == EINTR)
+            return XCAM_RETURN_ERROR_TIMEOUT;
+        XCAM_LOG_ERROR ("multi poll thread epoll wait failed");
+        return XCAM_RETURN_ERROR_FILE;
+    }
+
+    /* timeout */
+    if (count == 0) {
+        XCAM_LOG_DEBUG ("multi poll thread timeout and continue");
+        return XCAM_RETURN_ERROR_TIMEOUT;
+    }
+
+    int64_t now = get_monotonic_time ();
+    for (int i = 0; i < count; ++i) {
+        uint32_t index = events[i].data.u32;
+        XCAM_ASSERT (index < _devices.size ());
+
+        // e.g. vb2 reports EPOLLERR while no buffer is queued, device is retried later
+        if ((events[i].events & (EPOLLERR | EPOLLHUP)) || !(events[i].events & EPOLLIN)) {
+            XCAM_LOG_DEBUG (
+                "capture device(%s) polled error, retry in %dms",
+                XCAM_STR (_devices[index]->get_device_name ()), error_retry_interval);
+            suspend_device (index, now);
+            continue;
+        }
+
+        VideoBufferList bufs;
+        if (dequeue_device (index, bufs) != XCAM_RETURN_NO_ERROR) {
+            suspend_device (index, now);
+            continue;
+        }
+        for (VideoBufferList::iterator i_buf = bufs.begin (); i_buf != bufs.end (); ++i_buf)
+            _aligner.push (index, *i_buf, dropped);
+    }
+
+    return emit_frame_sets (dropped);
+}
+
+XCamReturn
+MultiPollThread::emit_frame_sets (DroppedFrameList &dropped)
+{
+    XCamReturn ret = XCAM_RETURN_NO_ERROR;
+    VideoBufferList set;
+
+    while (_aligner.pop_set (set, dropped)) {
+        report_dropped (dropped);
+
+        ++_set_count;
+        XCAM_ASSERT (_callback);
+        ret = _callback->frame_set_ready (set);
+        set.clear ();
+        if (ret != XCAM_RETURN_NO_ERROR) {
+            _callback->frame_set_failed (InvalidTimestamp, "frame set ready callback failed");
+            return ret;
+        }
+    }
+    report_dropped (dropped);
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+void
+MultiPollThread::report_dropped (DroppedFrameList &dropped)
+{
+    for (DroppedFrameList::iterator i = dropped.begin (); i != dropped.end (); ++i) {
+        XCAM_LOG_DEBUG ("multi poll thread dropped frame(ts:%" PRId64 ") of device:%d", i->timestamp, i->source);
+        ++_dropped_count;
+        _callback->frame_set_dropped (i->source, i->timestamp);
+    }
+    dropped.clear ();
+}
+
+};
@@ -0,0 +1,165 @@
+/*
+ * multi_poll_thread.h - poll thread for multiple capture devices
+ *
+ *  Copyright (c) 2017 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#ifndef XCAM_MULTI_POLL_THREAD_H
+#define XCAM_MULTI_POLL_THREAD_H
+
+#include <xcam_std.h>
+#include <xcam_mutex.h>
+#include <video_buffer.h>
+#include <v4l2_device.h>
+#include <vector>
+
+namespace XCam {
+
+struct DroppedFrame {
+    uint32_t    source;
+    int64_t     timestamp;
+
+    DroppedFrame (uint32_t s, int64_t ts)
+        : source (s), timestamp (ts)
+    {}
+};
+
+typedef std::list<DroppedFrame> DroppedFrameList;
+
+class FrameSetCallback
+{
+public:
+    FrameSetCallback () {}
+    virtual ~FrameSetCallback () {}
+    // one buffer of each device in device order, timestamps are within sync tolerance
+    virtual XCamReturn frame_set_ready (VideoBufferList &bufs) = 0;
+    virtual XCamReturn frame_set_failed (int64_t timestamp, const char *msg) = 0;
+    // a frame of device was dropped since no matching frames from other devices
+    virtual XCamReturn frame_set_dropped (uint32_t device, int64_t timestamp) {
+        XCAM_UNUSED (device);
+        XCAM_UNUSED (timestamp);
+        return XCAM_RETURN_NO_ERROR;
+    }
+
+private:
+    XCAM_DEAD_COPY (FrameSetCallback);
+};
+
+/* groups buffers of several sources into sets, a set takes the oldest pending buffer of each source
+ * when all of them are within tolerance of the newest one, older buffers can't be matched any more
+ * and are dropped. Pending buffers of each source are limited, since they may hold device buffers.
+ */
+class FrameSetAligner
+{
+public:
+    explicit FrameSetAligner (uint32_t source_count = 0);
+
+    void set_source_count (uint32_t count);
+    uint32_t get_source_count () const {
+        return _pending.size ();
+    }
+    void set_tolerance (int64_t usec) {
+        _tolerance = usec;
+    }
+    void set_max_pending (uint32_t count) {
+        _max_pending = (count ? count : 1);
+    }
+
+    // buffers of a source come in timestamp order
+    void push (uint32_t source, const SmartPtr<VideoBuffer> &buf, DroppedFrameList &dropped);
+    // false if no complete set, buffers dropped on the way are released and appended to dropped
+    bool pop_set (VideoBufferList &set, DroppedFrameList &dropped);
+    void clear ();
+
+private:
+    XCAM_DEAD_COPY (FrameSetAligner);
+
+private:
+    std::vector<VideoBufferList>     _pending;
+    int64_t                          _tolerance;
+    uint32_t                         _max_pending;
+};
+
+class MultiCaptureLoop;
+
+/* one thread waits on all capture devices by epoll, drains every ready device with batched
+ * dequeue, then hands timestamp aligned frame sets to callback. Devices are started by caller.
+ */
+class MultiPollThread
+{
+    friend class MultiCaptureLoop;
+public:
+    explicit MultiPollThread ();
+    virtual ~MultiPollThread ();
+
+    // before start, device order is the buffer order of frame sets
+    bool add_capture_device (const SmartPtr<V4l2Device> &dev);
+    bool set_frame_set_callback (FrameSetCallback *callback);
+    bool set_sync_tolerance (int64_t usec);
+    bool set_max_pending (uint32_t count);
+
+    uint32_t get_device_count () const {
+        return _devices.size ();
+    }
+    uint64_t get_set_count () const {
+        return _set_count;
+    }
+    uint64_t get_dropped_count () const {
+        return _dropped_count;
+    }
+
+    virtual XCamReturn start ();
+    virtual XCamReturn stop ();
+
+protected:
+    // one epoll wait, then dequeue and align buffers of ready devices
+    virtual XCamReturn poll_devices (int timeout_msec);
+    virtual XCamReturn dequeue_device (uint32_t index, VideoBufferList &bufs);
+
+private:
+    XCamReturn emit_frame_sets (DroppedFrameList &dropped);
+    void report_dropped (DroppedFrameList &dropped);
+    // failed device leaves epoll for error retry interval, others keep being polled
+    void suspend_device (uint32_t index, int64_t now);
+    // returns timeout shortened to the next retry of suspended devices
+    int resume_devices (int64_t now, int timeout_msec);
+
+private:
+    XCAM_DEAD_COPY (MultiPollThread);
+
+private:
+    static const int default_capture_event_timeout;
+    static const int64_t default_sync_tolerance;
+    static const uint32_t default_max_pending;
+    static const uint32_t max_batch_count;
+    static const uint32_t max_device_count;
+    static const int error_retry_interval;
+
+    SmartPtr<MultiCaptureLoop>             _capture_loop;
+    std::vector<SmartPtr<V4l2Device>>      _devices;
+    // monotonic time(us) to poll suspended device again, 0 if device is polled
+    std::vector<int64_t>                   _retry_time;
+    FrameSetAligner                        _aligner;
+    FrameSetCallback                      *_callback;
+    int                                    _epoll_fd;
+    uint64_t                               _set_count;
+    uint64_t                               _dropped_count;
+};
+
+};
+
+#endif //XCAM_MULTI_POLL_THREAD_H
@@ -73,6 +73,66 @@ OnceMapVideoBuffer::get_fd ()
     return -1;
 }
 
+class OnceMapExternalBuffer
+    : public OnceMapVideoBuffer
+{
+    friend SmartPtr<VideoBuffer> external_buf_to_once_map_buf (XCamVideoBuffer *buf);
+protected:
+    OnceMapExternalBuffer (const VideoBufferInfo &info, uint8_t *ptr, XCamVideoBuffer *buf);
+public:
+    virtual ~OnceMapExternalBuffer ();
+
+private:
+    XCAM_DEAD_COPY (OnceMapExternalBuffer);
+
+private:
+    XCamVideoBuffer *_external_buf;
+};
+
+OnceMapExternalBuffer::OnceMapExternalBuffer (
+    const VideoBufferInfo &info, uint8_t *ptr, XCamVideoBuffer *buf)
+    : OnceMapVideoBuffer (info, ptr)
+    , _external_buf (buf)
+{
+    if (buf->ref)
+        xcam_video_buffer_ref (buf);
+}
+
+OnceMapExternalBuffer::~OnceMapExternalBuffer ()
+{
+    if (_external_buf->unmap)
+        xcam_video_buffer_unmap (_external_buf);
+    if (_external_buf->unref && _external_buf->ref)
+        xcam_video_buffer_unref (_external_buf);
+}
+
+SmartPtr<VideoBuffer>
+external_buf_to_once_map_buf (XCamVideoBuffer *buf)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, buf && buf->map, NULL,
+        "external_buf_to_once_map_buf failed since buf or buf->map is NULL");
+
+    // keep caller's strides and offsets, planes are accessed in place
+    VideoBufferInfo buf_info;
+    XCamVideoBufferInfo &base_info = buf_info;
+    base_info = buf->info;
+    XCAM_FAIL_RETURN (
+        ERROR, buf_info.is_valid (), NULL,
+        "external_buf_to_once_map_buf failed, buffer info(fmt:%s, %dx%d) is invalid",
+        xcam_fourcc_to_string (buf_info.format), buf_info.width, buf_info.height);
+
+    uint8_t *ptr = xcam_video_buffer_map (buf);
+    XCAM_FAIL_RETURN (
+        ERROR, ptr, NULL,
+        "external_buf_to_once_map_buf failed, map buffer failed");
+
+    SmartPtr<VideoBuffer> video_buffer = new OnceMapExternalBuffer (buf_info, ptr, buf);
+    XCAM_ASSERT (video_buffer.ptr ());
+    video_buffer->set_timestamp (buf->timestamp);
+    return video_buffer;
+}
+
 SmartPtr<VideoBuffer>
 external_buf_to_once_map_buf (
     uint8_t* buf, uint32_t format,
@@ -38,6 +38,15 @@ public:
     virtual ~PollCallback() {}
     virtual XCamReturn poll_buffer_ready (SmartPtr<VideoBuffer> &buf) = 0;
     virtual XCamReturn poll_buffer_failed (int64_t timestamp, const char *msg) = 0;
+    // a frame of timestamp was dropped by the source
+    virtual XCamReturn poll_buffer_dropped (int64_t timestamp) {
+        XCAM_UNUSED (timestamp);
+        return XCAM_RETURN_NO_ERROR;
+    }
+    // source has no more frames, e.g. a finite replay is done, poll thread stops capturing
+    virtual XCamReturn poll_source_done () {
+        return XCAM_RETURN_NO_ERROR;
+    }
 
 private:
     XCAM_DEAD_COPY (PollCallback);
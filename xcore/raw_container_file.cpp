@@ -0,0 +1,400 @@
+/*
+ * raw_container_file.cpp - indexed raw video container
+ *
+ *  Copyright (c) 2017 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#include "raw_container_file.h"
+#include <unistd.h>
+
+#define RAW_CONTAINER_MAGIC "XCAMRAWC"
+#define RAW_CONTAINER_VERSION 1
+// largest common page size(arm64, ppc64), images are page aligned wherever the file is mapped
+#define RAW_CONTAINER_ALIGNMENT (64 * 1024)
+
+namespace XCam {
+
+struct RawContainerHeader {
+    char        magic [8];
+    uint32_t    version;
+    uint32_t    alignment;
+    uint32_t    camera_count;
+    uint32_t    frame_count;
+    uint32_t    format;
+    uint32_t    width;
+    uint32_t    height;
+    uint32_t    aligned_width;
+    uint32_t    aligned_height;
+    uint32_t    size;
+    uint32_t    components;
+    uint32_t    strides [XCAM_VIDEO_MAX_COMPONENTS];
+    uint32_t    offsets [XCAM_VIDEO_MAX_COMPONENTS];
+    uint32_t    reserved;
+    uint64_t    slot_size;
+    uint64_t    index_offset;
+};
+
+static bool
+is_same_layout (const VideoBufferInfo &info, const VideoBufferInfo &other)
+{
+    if (info.format != other.format || info.width != other.width || info.height != other.height ||
+            info.size != other.size || info.components != other.components)
+        return false;
+
+    for (uint32_t i = 0; i < info.components; ++i) {
+        if (info.strides [i] != other.strides [i] || info.offsets [i] != other.offsets [i])
+            return false;
+    }
+    return true;
+}
+
+// every plane of info fits in info.size, so readers can index planes by offsets and strides
+static bool
+is_valid_layout (const VideoBufferInfo &info)
+{
+    VideoBufferPlanarInfo planar;
+
+    for (uint32_t i = 0; i < info.components; ++i) {
+        if (!info.get_planar_info (planar, i) || !planar.height)
+            return false;
+
+        uint64_t line_bytes = (uint64_t)planar.width * planar.pixel_bytes;
+        if (info.strides [i] < line_bytes ||
+                info.offsets [i] + (uint64_t)info.strides [i] * (planar.height - 1) + line_bytes > info.size)
+            return false;
+    }
+    return true;
+}
+
+RawContainerFile::RawContainerFile ()
+    : _camera_count (0)
+    , _slot_size (0)
+    , _data_offset (0)
+    , _writable (false)
+{
+}
+
+RawContainerFile::~RawContainerFile ()
+{
+    close ();
+}
+
+void
+RawContainerFile::reset ()
+{
+    _info = VideoBufferInfo ();
+    _camera_count = 0;
+    _slot_size = 0;
+    _data_offset = 0;
+    _writable = false;
+    _index.clear ();
+}
+
+bool
+RawContainerFile::is_container (const char *name)
+{
+    char magic [sizeof (((RawContainerHeader *)0)->magic)];
+    FILE *fp = fopen (name, "rb");
+    if (!fp)
+        return false;
+
+    bool ret = (fread (magic, 1, sizeof (magic), fp) == sizeof (magic) &&
+                memcmp (magic, RAW_CONTAINER_MAGIC, sizeof (magic)) == 0);
+    fclose (fp);
+    return ret;
+}
+
+XCamReturn
+RawContainerFile::create (const char *name, const VideoBufferInfo &info, uint32_t camera_count)
+{
+    XCAM_FAIL_RETURN (
+        WARNING, info.is_valid () && info.components <= XCAM_VIDEO_MAX_COMPONENTS && camera_count > 0,
+        XCAM_RETURN_ERROR_PARAM,
+        "raw container(%s) create failed, invalid buffer info or camera count:%d", XCAM_STR (name), camera_count);
+
+    XCamReturn ret = open (name, "wb");
+    XCAM_FAIL_RETURN (
+        WARNING, xcam_ret_is_ok (ret), ret,
+        "raw container(%s) create failed, open file failed", XCAM_STR (name));
+
+    _info = info;
+    _camera_count = camera_count;
+    _slot_size = XCAM_ALIGN_UP ((uint64_t)info.size, RAW_CONTAINER_ALIGNMENT);
+    _data_offset = RAW_CONTAINER_ALIGNMENT;
+    _writable = true;
+
+    // header is completed when writer closes
+    ret = write_header (0);
+    if (!xcam_ret_is_ok (ret)) {
+        close ();
+        return ret;
+    }
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+RawContainerFile::open_container (const char *name)
+{
+    XCamReturn ret = open (name, "rb");
+    XCAM_FAIL_RETURN (
+        WARNING, xcam_ret_is_ok (ret), ret,
+        "raw container(%s) open failed", XCAM_STR (name));
+
+    size_t file_size = 0;
+    const RawContainerHeader *header = NULL;
+    if (!xcam_ret_is_ok (ret = map_file ()) || !xcam_ret_is_ok (ret = get_file_size (file_size)) ||
+            !(header = (const RawContainerHeader *) get_mapped_data (0, sizeof (RawContainerHeader)))) {
+        XCAM_LOG_WARNING ("raw container(%s) open failed, file is too small or not mappable", XCAM_STR (name));
+        close ();
+        return XCAM_RETURN_ERROR_FILE;
+    }
+
+    if (memcmp (header->magic, RAW_CONTAINER_MAGIC, sizeof (header->magic)) != 0 ||
+            header->version != RAW_CONTAINER_VERSION ||
+            header->alignment < sizeof (RawContainerHeader) ||
+            header->alignment % getpagesize () || header->slot_size % header->alignment ||
+            !header->camera_count || !header->size || header->slot_size < header->size ||
+            !header->components || header->components > XCAM_VIDEO_MAX_COMPONENTS) {
+        XCAM_LOG_WARNING ("raw container(%s) open failed, invalid header", XCAM_STR (name));
+        close ();
+        return XCAM_RETURN_ERROR_FILE;
+    }
+
+    // planes of a corrupt header would point out of image slots
+    if (!header->format || !header->width || !header->height ||
+            header->aligned_width < header->width || header->aligned_height < header->height ||
+            !_info.init (
+                header->format, header->width, header->height,
+                header->aligned_width, header->aligned_height) ||
+            _info.components != header->components || _info.size > header->size) {
+        XCAM_LOG_WARNING ("raw container(%s) open failed, invalid image format in header", XCAM_STR (name));
+        close ();
+        return XCAM_RETURN_ERROR_FILE;
+    }
+    _info.size = header->size;
+    for (uint32_t i = 0; i < header->components; ++i) {
+        _info.strides [i] = header->strides [i];
+        _info.offsets [i] = header->offsets [i];
+    }
+    if (!is_valid_layout (_info)) {
+        XCAM_LOG_WARNING ("raw container(%s) open failed, image planes are out of image size", XCAM_STR (name));
+        close ();
+        return XCAM_RETURN_ERROR_FILE;
+    }
+    _camera_count = header->camera_count;
+    _slot_size = header->slot_size;
+    _data_offset = header->alignment;
+
+    ret = load_index (file_size, header->index_offset, header->frame_count);
+    if (!xcam_ret_is_ok (ret)) {
+        close ();
+        return ret;
+    }
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+RawContainerFile::load_index (size_t file_size, uint64_t index_offset, uint32_t frame_count)
+{
+    uint64_t frame_bytes = (_camera_count - 1) * _slot_size + _info.size;
+    _index.clear ();
+
+    if (index_offset) {
+        const RawContainerIndex *entries =
+            (const RawContainerIndex *) get_mapped_data (index_offset, frame_count * sizeof (RawContainerIndex));
+        XCAM_FAIL_RETURN (
+            WARNING, entries, XCAM_RETURN_ERROR_FILE,
+            "raw container(%s) index of %d frames is out of file", XCAM_STR (get_file_name ()), frame_count);
+
+        for (uint32_t i = 0; i < frame_count; ++i) {
+            XCAM_FAIL_RETURN (
+                WARNING,
+                entries[i].offset >= _data_offset && entries[i].offset % _data_offset == 0 &&
+                get_mapped_data (entries[i].offset, frame_bytes),
+                XCAM_RETURN_ERROR_FILE,
+                "raw container(%s) frame:%d is out of file", XCAM_STR (get_file_name ()), i);
+        }
+        _index.assign (entries, entries + frame_count);
+        return XCAM_RETURN_NO_ERROR;
+    }
+
+    // writer didn't close, complete frames are still at fixed slots
+    XCAM_LOG_WARNING ("raw container(%s) has no index, recovering frames from slots", XCAM_STR (get_file_name ()));
+    RawContainerIndex entry;
+    entry.timestamp = InvalidTimestamp;
+    for (entry.offset = _data_offset; entry.offset + frame_bytes <= file_size;
+            entry.offset += _camera_count * _slot_size)
+        _index.push_back (entry);
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+RawContainerFile::write_header (uint64_t index_offset)
+{
+    RawContainerHeader header;
+    xcam_mem_clear (header);
+
+    memcpy (header.magic, RAW_CONTAINER_MAGIC, sizeof (header.magic));
+    header.version = RAW_CONTAINER_VERSION;
+    header.alignment = _data_offset;
+    header.camera_count = _camera_count;
+    header.frame_count = _index.size ();
+    header.format = _info.format;
+    header.width = _info.width;
+    header.height = _info.height;
+    header.aligned_width = _info.aligned_width;
+    header.aligned_height = _info.aligned_height;
+    header.size = _info.size;
+    header.components = _info.components;
+    for (uint32_t i = 0; i < _info.components; ++i) {
+        header.strides [i] = _info.strides [i];
+        header.offsets [i] = _info.offsets [i];
+    }
+    header.slot_size = _slot_size;
+    header.index_offset = index_offset;
+
+    XCAM_FAIL_RETURN (
+        WARNING, fseeko (_fp, 0, SEEK_SET) == 0, XCAM_RETURN_ERROR_FILE,
+        "raw container(%s) seek header failed, errno:%d", XCAM_STR (get_file_name ()), errno);
+    return write_file (&header, sizeof (header));
+}
+
+XCamReturn
+RawContainerFile::close ()
+{
+    XCamReturn ret = XCAM_RETURN_NO_ERROR;
+
+    if (_writable && is_valid ()) {
+        uint64_t index_offset = _data_offset + _index.size () * _camera_count * _slot_size;
+        if (fseeko (_fp, index_offset, SEEK_SET) != 0) {
+            XCAM_LOG_WARNING ("raw container(%s) seek index failed, errno:%d", XCAM_STR (get_file_name ()), errno);
+            ret = XCAM_RETURN_ERROR_FILE;
+        } else if (!_index.empty ()) {
+            ret = write_file (&_index[0], _index.size () * sizeof (RawContainerIndex));
+        }
+
+        if (xcam_ret_is_ok (ret))
+            ret = write_header (index_offset);
+    }
+
+    reset ();
+    XCamReturn close_ret = ImageFileHandle::close ();
+    return xcam_ret_is_ok (ret) ? close_ret : ret;
+}
+
+XCamReturn
+RawContainerFile::write_frame (const VideoBufferList &bufs)
+{
+    XCAM_FAIL_RETURN (
+        WARNING, _writable && is_valid (), XCAM_RETURN_ERROR_ORDER,
+        "raw container(%s) write frame failed, it was not created", XCAM_STR (get_file_name ()));
+    XCAM_FAIL_RETURN (
+        WARNING, bufs.size () == _camera_count, XCAM_RETURN_ERROR_PARAM,
+        "raw container(%s) write frame failed, %d buffers for %d cameras",
+        XCAM_STR (get_file_name ()), (int)bufs.size (), _camera_count);
+
+    RawContainerIndex entry;
+    entry.offset = _data_offset + _index.size () * _camera_count * _slot_size;
+    entry.timestamp = bufs.front ()->get_timestamp ();
+
+    uint32_t camera = 0;
+    for (VideoBufferList::const_iterator iter = bufs.begin (); iter != bufs.end (); ++iter, ++camera) {
+        const SmartPtr<VideoBuffer> &buf = *iter;
+        XCAM_FAIL_RETURN (
+            WARNING, is_same_layout (buf->get_video_info (), _info), XCAM_RETURN_ERROR_PARAM,
+            "raw container(%s) write frame failed, camera:%d buffer layout doesn't match",
+            XCAM_STR (get_file_name ()), camera);
+
+        // skipped bytes up to next slot are zero
+        XCAM_FAIL_RETURN (
+            WARNING, fseeko (_fp, entry.offset + camera * _slot_size, SEEK_SET) == 0, XCAM_RETURN_ERROR_FILE,
+            "raw container(%s) seek frame failed, errno:%d", XCAM_STR (get_file_name ()), errno);
+
+        uint8_t *memory = buf->map ();
+        XCAM_FAIL_RETURN (
+            WARNING, memory, XCAM_RETURN_ERROR_MEM,
+            "raw container(%s) write frame failed, map buffer failed", XCAM_STR (get_file_name ()));
+        XCamReturn ret = write_file (memory, _info.size);
+        buf->unmap ();
+        if (!xcam_ret_is_ok (ret))
+            return ret;
+    }
+
+    _index.push_back (entry);
+    return XCAM_RETURN_NO_ERROR;
+}
+
+const uint8_t *
+RawContainerFile::get_image_data (uint32_t index, uint32_t camera)
+{
+    if (_writable || index >= _index.size () || camera >= _camera_count)
+        return NULL;
+
+    return get_mapped_data (_index[index].offset + camera * _slot_size, _info.size);
+}
+
+int64_t
+RawContainerFile::get_timestamp (uint32_t index) const
+{
+    if (index >= _index.size ())
+        return InvalidTimestamp;
+    return _index[index].timestamp;
+}
+
+XCamReturn
+RawContainerFile::read_frame (uint32_t index, uint32_t camera, SmartPtr<VideoBuffer> &buf)
+{
+    XCAM_FAIL_RETURN (
+        WARNING, !_writable && is_mapped (), XCAM_RETURN_ERROR_ORDER,
+        "raw container(%s) read frame failed, it was not opened for reading", XCAM_STR (get_file_name ()));
+    XCAM_FAIL_RETURN (
+        WARNING, camera < _camera_count, XCAM_RETURN_ERROR_PARAM,
+        "raw container(%s) read frame failed, camera:%d is out of %d cameras",
+        XCAM_STR (get_file_name ()), camera, _camera_count);
+
+    if (index >= _index.size ())
+        return XCAM_RETURN_BYPASS;
+
+    uint8_t *data = (uint8_t *) get_image_data (index, camera);
+    XCAM_ASSERT (data);
+    buf = create_mapped_buf (_info, data);
+    buf->set_timestamp (_index[index].timestamp);
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+RawContainerFile::read_frame (uint32_t index, VideoBufferList &bufs)
+{
+    XCAM_FAIL_RETURN (
+        WARNING, !_writable && is_mapped (), XCAM_RETURN_ERROR_ORDER,
+        "raw container(%s) read frame failed, it was not opened for reading", XCAM_STR (get_file_name ()));
+
+    bufs.clear ();
+    for (uint32_t camera = 0; camera < _camera_count; ++camera) {
+        SmartPtr<VideoBuffer> buf;
+        XCamReturn ret = read_frame (index, camera, buf);
+        if (ret != XCAM_RETURN_NO_ERROR) {
+            bufs.clear ();
+            return ret;
+        }
+        bufs.push_back (buf);
+    }
+    return XCAM_RETURN_NO_ERROR;
+}
+
+}
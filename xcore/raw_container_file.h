@@ -0,0 +1,94 @@
+/*
+ * raw_container_file.h - indexed raw video container
+ *
+ *  Copyright (c) 2017 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Wind Yuan <feng.yuan@intel.com>
+ */
+
+#ifndef XCAM_RAW_CONTAINER_FILE_H
+#define XCAM_RAW_CONTAINER_FILE_H
+
+#include <xcam_std.h>
+#include <image_file_handle.h>
+#include <vector>
+
+namespace XCam {
+
+struct RawContainerIndex {
+    uint64_t    offset;
+    int64_t     timestamp;
+};
+
+/* layout: 64K of header(format, size, strides, camera count), then frames, each frame is one image
+ * per camera in camera order and every image starts on a 64K boundary(a page boundary with 4K, 16K or
+ * 64K pages), then the frame index(offset and timestamp of each frame) appended when writer closes.
+ * Images keep strides of written buffers, so reader maps the file and returns buffers aliasing file
+ * pages, frame K is located by the index in O(1).
+ * A container without index(writer didn't close) is still readable for its complete frames.
+ */
+class RawContainerFile
+    : public ImageFileHandle
+{
+public:
+    RawContainerFile ();
+    virtual ~RawContainerFile ();
+
+    static bool is_container (const char *name);
+
+    // new container for images of info from camera_count cameras
+    XCamReturn create (const char *name, const VideoBufferInfo &info, uint32_t camera_count);
+    // existing container, mapped for random access
+    XCamReturn open_container (const char *name);
+    // writer appends the index and completes header
+    virtual XCamReturn close ();
+
+    // one buffer of each camera in camera order, frame timestamp is from the first buffer
+    XCamReturn write_frame (const VideoBufferList &bufs);
+    // buffers alias file pages, BYPASS if index is out of frames
+    XCamReturn read_frame (uint32_t index, VideoBufferList &bufs);
+    XCamReturn read_frame (uint32_t index, uint32_t camera, SmartPtr<VideoBuffer> &buf);
+    const uint8_t *get_image_data (uint32_t index, uint32_t camera);
+    int64_t get_timestamp (uint32_t index) const;
+
+    const VideoBufferInfo &get_video_info () const {
+        return _info;
+    }
+    uint32_t get_camera_count () const {
+        return _camera_count;
+    }
+    uint32_t get_frame_count () const {
+        return _index.size ();
+    }
+
+private:
+    XCamReturn write_header (uint64_t index_offset);
+    XCamReturn load_index (size_t file_size, uint64_t index_offset, uint32_t frame_count);
+    void reset ();
+
+    XCAM_DEAD_COPY (RawContainerFile);
+
+private:
+    VideoBufferInfo                   _info;
+    uint32_t                          _camera_count;
+    uint64_t                          _slot_size;
+    uint64_t                          _data_offset;
+    bool                              _writable;
+    std::vector<RawContainerIndex>    _index;
+};
+
+}
+
+#endif //XCAM_RAW_CONTAINER_FILE_H
@@ -25,6 +25,7 @@ namespace XCam {
 
 SurViewFisheyeDewarp::SurViewFisheyeDewarp ()
 {
+    set_extrinsic_param (_extrinsic_param);
 }
 SurViewFisheyeDewarp::~SurViewFisheyeDewarp ()
 {
@@ -45,16 +46,24 @@ void
 SurViewFisheyeDewarp::set_extrinsic_param(const ExtrinsicParameter &extrinsic_param)
 {
     _extrinsic_param = extrinsic_param;
+
+    Mat4f rotation_tran_mat = generate_rotation_matrix( degree2radian (_extrinsic_param.roll),
+                              degree2radian (_extrinsic_param.pitch),
+                              degree2radian (_extrinsic_param.yaw));
+    rotation_tran_mat(0, 3) = _extrinsic_param.trans_x;
+    rotation_tran_mat(1, 3) = _extrinsic_param.trans_y;
+    rotation_tran_mat(2, 3) = _extrinsic_param.trans_z;
+    _world_to_cam_mat = rotation_tran_mat.inverse ();
 }
 
-IntrinsicParameter
-SurViewFisheyeDewarp::get_intrinsic_param()
+const IntrinsicParameter &
+SurViewFisheyeDewarp::get_intrinsic_param() const
 {
     return _intrinsic_param;
 }
 
-ExtrinsicParameter
-SurViewFisheyeDewarp::get_extrinsic_param()
+const ExtrinsicParameter &
+SurViewFisheyeDewarp::get_extrinsic_param() const
 {
     return _extrinsic_param;
 }
@@ -62,11 +71,6 @@ SurViewFisheyeDewarp::get_extrinsic_param()
 void
 SurViewFisheyeDewarp::fisheye_dewarp(MapTable &map_table, uint32_t table_w, uint32_t table_h, uint32_t image_w, uint32_t image_h, const BowlDataConfig &bowl_config)
 {
-    PointFloat3 world_coord;
-    PointFloat3 cam_coord;
-    PointFloat3 cam_world_coord;
-    PointFloat2 image_coord;
-
     XCAM_LOG_DEBUG ("fisheye-dewarp:\n table(%dx%d), out_size(%dx%d)"
                     "bowl(start:%.1f, end:%.1f, ground:%.2f, wall:%.2f, a:%.2f, b:%.2f, c:%.2f, center_z:%.2f )",
                     table_w, table_h, image_w, image_h,
@@ -74,43 +78,54 @@ SurViewFisheyeDewarp::fisheye_dewarp(MapTable &map_table, uint32_t table_w, uint
                     bowl_config.wall_height, bowl_config.ground_length,
                     bowl_config.a, bowl_config.b, bowl_config.c, bowl_config.center_z);
 
+    fisheye_dewarp_rows (map_table, table_w, table_h, image_w, image_h, bowl_config, 0, table_h);
+}
+
+void
+SurViewFisheyeDewarp::fisheye_dewarp_rows(
+    MapTable &map_table, uint32_t table_w, uint32_t table_h, uint32_t image_w, uint32_t image_h,
+    const BowlDataConfig &bowl_config, uint32_t row_start, uint32_t row_count) const
+{
+    PointFloat3 world_coord;
+    PointFloat2 image_coord;
+
+    XCAM_ASSERT (map_table.size () >= table_w * table_h);
+    XCAM_ASSERT (row_start + row_count <= table_h);
+
     float scale_factor_w = (float)image_w / table_w;
     float scale_factor_h = (float)image_h / table_h;
 
-    for(uint32_t row = 0; row < table_h; row++) {
+    for(uint32_t row = row_start; row < row_start + row_count; row++) {
+        PointFloat2 *line = &map_table[row * table_w];
         for(uint32_t col = 0; col < table_w; col++) {
             PointFloat2 out_pos (col * scale_factor_w, row * scale_factor_h);
             world_coord = bowl_view_image_to_world (bowl_config, image_w, image_h, out_pos);
-            cal_cam_world_coord(world_coord, cam_world_coord);
-            world_coord2cam(cam_world_coord, cam_coord);
-            cal_image_coord(cam_coord, image_coord);
+            world_to_image(world_coord, image_coord);
 
-            map_table[row * table_w + col] = image_coord;
+            line[col] = image_coord;
         }
     }
 }
 
 void
-SurViewFisheyeDewarp::cal_cam_world_coord(const PointFloat3 &world_coord, PointFloat3 &cam_world_coord)
+SurViewFisheyeDewarp::world_to_image(const PointFloat3 &world_coord, PointFloat2 &image_coord) const
 {
-    Mat4f rotation_mat = generate_rotation_matrix( degree2radian (_extrinsic_param.roll),
-                         degree2radian (_extrinsic_param.pitch),
-                         degree2radian (_extrinsic_param.yaw));
-    Mat4f rotation_tran_mat = rotation_mat;
-    rotation_tran_mat(0, 3) = _extrinsic_param.trans_x;
-    rotation_tran_mat(1, 3) = _extrinsic_param.trans_y;
-    rotation_tran_mat(2, 3) = _extrinsic_param.trans_z;
+    PointFloat3 cam_coord;
+    PointFloat3 cam_world_coord;
 
-    Mat4f world_coord_mat(Vec4f(1.0f, 0.0f, 0.0f, world_coord.x),
-                          Vec4f(0.0f, 1.0f, 0.0f, world_coord.y),
-                          Vec4f(0.0f, 0.0f, 1.0f, world_coord.z),
-                          Vec4f(0.0f, 0.0f, 0.0f, 1.0f));
+    cal_cam_world_coord(world_coord, cam_world_coord);
+    world_coord2cam(cam_world_coord, cam_coord);
+    cal_image_coord(cam_coord, image_coord);
+}
 
-    Mat4f cam_world_coord_mat = rotation_tran_mat.inverse() * world_coord_mat;
+void
+SurViewFisheyeDewarp::cal_cam_world_coord(const PointFloat3 &world_coord, PointFloat3 &cam_world_coord) const
+{
+    const Mat4f &mat = _world_to_cam_mat;
 
-    cam_world_coord.x = cam_world_coord_mat(0, 3);
-    cam_world_coord.y = cam_world_coord_mat(1, 3);
-    cam_world_coord.z = cam_world_coord_mat(2, 3);
+    cam_world_coord.x = mat(0, 0) * world_coord.x + mat(0, 1) * world_coord.y + mat(0, 2) * world_coord.z + mat(0, 3);
+    cam_world_coord.y = mat(1, 0) * world_coord.x + mat(1, 1) * world_coord.y + mat(1, 2) * world_coord.z + mat(1, 3);
+    cam_world_coord.z = mat(2, 0) * world_coord.x + mat(2, 1) * world_coord.y + mat(2, 2) * world_coord.z + mat(2, 3);
 }
 
 Mat4f
@@ -135,7 +150,7 @@ SurViewFisheyeDewarp::generate_rotation_matrix(float roll, float pitch, float ya
 }
 
 void
-SurViewFisheyeDewarp::world_coord2cam(const PointFloat3 &cam_world_coord, PointFloat3 &cam_coord)
+SurViewFisheyeDewarp::world_coord2cam(const PointFloat3 &cam_world_coord, PointFloat3 &cam_coord) const
 {
     cam_coord.x = -cam_world_coord.y;
     cam_coord.y = -cam_world_coord.z;
@@ -143,27 +158,25 @@ SurViewFisheyeDewarp::world_coord2cam(const PointFloat3 &cam_world_coord, PointF
 }
 
 void
-SurViewFisheyeDewarp::cal_image_coord(const PointFloat3 &cam_coord, PointFloat2 &image_coord)
+SurViewFisheyeDewarp::cal_image_coord(const PointFloat3 &cam_coord, PointFloat2 &image_coord) const
 {
     image_coord.x = cam_coord.x;
     image_coord.y = cam_coord.y;
 }
 
 void
-PolyFisheyeDewarp::cal_image_coord(const PointFloat3 &cam_coord, PointFloat2 &image_coord)
+PolyFisheyeDewarp::cal_image_coord(const PointFloat3 &cam_coord, PointFloat2 &image_coord) const
 {
     float dist2center = sqrt(cam_coord.x * cam_coord.x + cam_coord.y * cam_coord.y);
-    float angle = atan(cam_coord.z / dist2center);
-
-    float p = 1;
-    float poly_sum = 0;
-
-    IntrinsicParameter intrinsic_param = get_intrinsic_param();
+    const IntrinsicParameter &intrinsic_param = get_intrinsic_param();
 
     if (dist2center != 0) {
-        for (uint32_t i = 0; i < intrinsic_param.poly_length; i++) {
-            poly_sum += intrinsic_param.poly_coeff[i] * p;
-            p = p * angle;
+        float angle = atan(cam_coord.z / dist2center);
+
+        // Horner's rule on poly_coeff[0] + poly_coeff[1] * angle + poly_coeff[2] * angle^2 + ...
+        float poly_sum = 0;
+        for (int32_t i = (int32_t)intrinsic_param.poly_length - 1; i >= 0; i--) {
+            poly_sum = poly_sum * angle + intrinsic_param.poly_coeff[i];
         }
 
         float image_x = cam_coord.x * poly_sum / dist2center;
@@ -38,25 +38,37 @@ public:
 
     void fisheye_dewarp(MapTable &map_table, uint32_t table_w, uint32_t table_h, uint32_t image_w, uint32_t image_h, const BowlDataConfig &bowl_config);
 
+    // fill rows [row_start, row_start + row_count) of a pre-allocated table,
+    // it's const and can be called on different row ranges from multiple threads
+    void fisheye_dewarp_rows(
+        MapTable &map_table, uint32_t table_w, uint32_t table_h, uint32_t image_w, uint32_t image_h,
+        const BowlDataConfig &bowl_config, uint32_t row_start, uint32_t row_count) const;
+
+    // image coordinate of a point in world coordinate, unit mm
+    void world_to_image(const PointFloat3 &world_coord, PointFloat2 &image_coord) const;
+
     void set_intrinsic_param(const IntrinsicParameter &intrinsic_param);
     void set_extrinsic_param(const ExtrinsicParameter &extrinsic_param);
 
-    IntrinsicParameter get_intrinsic_param();
-    ExtrinsicParameter get_extrinsic_param();
+    const IntrinsicParameter &get_intrinsic_param() const;
+    const ExtrinsicParameter &get_extrinsic_param() const;
 
 private:
     XCAM_DEAD_COPY (SurViewFisheyeDewarp);
 
-    virtual void cal_image_coord (const PointFloat3 &cam_coord, PointFloat2 &image_coord);
+    virtual void cal_image_coord (const PointFloat3 &cam_coord, PointFloat2 &image_coord) const;
 
-    void cal_cam_world_coord (const PointFloat3 &world_coord, PointFloat3 &cam_world_coord);
-    void world_coord2cam (const PointFloat3 &cam_world_coord, PointFloat3 &cam_coord);
+    void cal_cam_world_coord (const PointFloat3 &world_coord, PointFloat3 &cam_world_coord) const;
+    void world_coord2cam (const PointFloat3 &cam_world_coord, PointFloat3 &cam_coord) const;
 
     Mat4f generate_rotation_matrix(float roll, float pitch, float yaw);
 
 private:
     IntrinsicParameter _intrinsic_param;
     ExtrinsicParameter _extrinsic_param;
+
+    // inverse of extrinsic rotation and translation, updated in set_extrinsic_param
+    Mat4f              _world_to_cam_mat;
 };
 
 class PolyFisheyeDewarp : public SurViewFisheyeDewarp
@@ -66,7 +78,7 @@ public:
     explicit PolyFisheyeDewarp ();
 
 private:
-    void cal_image_coord (const PointFloat3 &cam_coord, PointFloat2 &image_coord);
+    void cal_image_coord (const PointFloat3 &cam_coord, PointFloat2 &image_coord) const;
 
 };
 
@@ -512,6 +512,7 @@ public:
     MatrixN (VectorN<T, 2> a, VectorN<T, 2> b);
     MatrixN (VectorN<T, 3> a, VectorN<T, 3> b, VectorN<T, 3> c);
     MatrixN (VectorN<T, 4> a, VectorN<T, 4> b, VectorN<T, 4> c, VectorN<T, 4> d);
+    MatrixN (const MatrixN<T, N>& rhs);
 
     inline void zeros ();
     inline void eye ();
@@ -613,6 +614,13 @@ MatrixN<T, N>::MatrixN (VectorN<T, 4> a, VectorN<T, 4> b, VectorN<T, 4> c, Vecto
     }
 }
 
+template<class T, uint32_t N>
+MatrixN<T, N>::MatrixN (const MatrixN<T, N>& rhs) {
+    for (uint32_t i = 0; i < N * N; i++) {
+        data[i] = rhs.data[i];
+    }
+}
+
 template<class T, uint32_t N> inline
 void MatrixN<T, N>::zeros () {
     for (uint32_t i = 0; i < N * N; i++) {
@@ -23,6 +23,7 @@
 
 #include <xcam_std.h>
 #include <interface/data_types.h>
+#include <base/xcam_buffer.h>
 
 namespace XCam {
 
@@ -71,6 +72,11 @@ external_buf_to_once_map_buf (
     uint32_t aligned_width, uint32_t aligned_height,
     uint32_t size);
 
+// maps buf once and holds a reference until the returned buffer is released,
+// strides and offsets of buf are kept
+SmartPtr<VideoBuffer>
+external_buf_to_once_map_buf (XCamVideoBuffer *buf);
+
 };
 
 #endif //XCAM_UTILS_H